@@ -16,6 +16,9 @@
 #include "Gui/Windows/PropertiesWindow.h"
 #include "MDL/MdlWrapper.h"
 #include "Scene/Nodes/Material.h"
+#include "Scene/TransformHierarchy.h"
+#include "Scene/Utility/Operations.h"
+#include "Serialization/Autosave.h"
 
 namespace vtx
 {
@@ -117,9 +120,11 @@ namespace vtx
 		graph::Scene* scene = graph::Scene::get();
 		const std::shared_ptr<graph::Renderer>& renderer = scene->renderer;
 		renderer->camera->onUpdate(timeStep);
+		ops::publishPreparedMeshes();
 		//This step speed up the material computation, but is not really coherent with the rest of the code
 		graph::computeMaterialsMultiThreadCode();
-		renderer->traverse(hostVisitor);
+		graph::TransformHierarchy::get()->update(renderer);
+		renderer->traverseParallel(hostVisitor);
 		if (renderer->settings.runOnSeparateThread)
 		{
 			if (renderer->isReady())
@@ -152,6 +157,10 @@ namespace vtx
  			glfwSwapBuffers(glfwWindow);
 		}
 		windowManager->removeClosedWindows();
+		if (LoadingSaving::get().getCurrentState() == LoadingSaving::LoadSaveState::Idle)
+		{
+			serializer::Autosave::get()->update();
+		}
 		const auto time = static_cast<float>(glfwGetTime());
 		frameTime = time - lastFrameTime;
 		timeStep = std::min(frameTime, 0.0333f);
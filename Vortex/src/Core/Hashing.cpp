@@ -0,0 +1,41 @@
+#include "Hashing.h"
+#include "Utils.h"
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace utl
+{
+	uint64_t hashBytesParallel(const void* data, const size_t size)
+	{
+		constexpr size_t chunkSize      = 16ull * 1024ull * 1024ull;
+		const size_t     numberOfChunks = (size + chunkSize - 1) / chunkSize;
+		const auto*      bytes          = static_cast<const unsigned char*>(data);
+
+		std::vector<uint64_t> chunkHashes(numberOfChunks);
+		parallelFor(numberOfChunks, [&](const size_t i)
+		{
+			const size_t begin = i * chunkSize;
+			const size_t end   = std::min(begin + chunkSize, size);
+			chunkHashes[i]     = hashBytes(bytes + begin, end - begin);
+		});
+
+		uint64_t hash = hashValue(size);
+		for (const uint64_t chunkHash : chunkHashes)
+		{
+			hash = hashCombine(hash, chunkHash);
+		}
+		return hash;
+	}
+
+	uint64_t hashFile(const std::string& filePath)
+	{
+		const MappedFile file(filePath);
+		if (!file.isValid())
+		{
+			VTX_WARN("hashFile() Failed to map file {}", filePath);
+			return 0;
+		}
+
+		return hashBytesParallel(file.getData(), file.getSize());
+	}
+}
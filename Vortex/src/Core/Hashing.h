@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace utl
+{
+	constexpr uint64_t fnvOffsetBasis = 14695981039346656037ull;
+	constexpr uint64_t fnvPrime       = 1099511628211ull;
+
+	// FNV-1a over a raw memory range, seed allows to chain multiple ranges
+	inline uint64_t hashBytes(const void* data, const size_t size, uint64_t seed = fnvOffsetBasis)
+	{
+		const auto* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; ++i)
+		{
+			seed ^= bytes[i];
+			seed *= fnvPrime;
+		}
+		return seed;
+	}
+
+	template<typename T>
+	uint64_t hashValue(const T& value, const uint64_t seed = fnvOffsetBasis)
+	{
+		return hashBytes(&value, sizeof(T), seed);
+	}
+
+	inline uint64_t hashString(const std::string& string, const uint64_t seed = fnvOffsetBasis)
+	{
+		return hashBytes(string.data(), string.size(), hashValue(string.size(), seed));
+	}
+
+	template<typename T>
+	uint64_t hashVector(const std::vector<T>& vector, const uint64_t seed = fnvOffsetBasis)
+	{
+		return hashBytes(vector.data(), vector.size() * sizeof(T), hashValue(vector.size(), seed));
+	}
+
+	inline uint64_t hashCombine(const uint64_t seed, const uint64_t value)
+	{
+		return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+	}
+
+	// Hash of a large memory range, chunks are hashed on the thread pool and then combined.
+	// The result differs from hashBytes over the same range.
+	uint64_t hashBytesParallel(const void* data, size_t size);
+
+	// Hash of the file content, the file is memory mapped and hashed in chunks on the thread pool.
+	// Returns 0 if the file can't be opened.
+	uint64_t hashFile(const std::string& filePath);
+}
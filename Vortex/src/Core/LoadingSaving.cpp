@@ -6,6 +6,9 @@
 #include "Scene/Nodes/Renderer.h"
 #include "Scene/Utility/ModelLoader.h"
 #include "Scene/Utility/Operations.h"
+#include "Scene/Utility/PreparedDataStore.h"
+#include "Scene/Utility/TexturePrefetcher.h"
+#include "Serialization/Autosave.h"
 #include "Serialization/Serializer.h"
 
 namespace vtx
@@ -68,8 +71,14 @@ namespace vtx
 		{
 			const std::string   fileExtension = utl::getFileExtension(filePath);
 			graph::Scene* scene         = graph::Scene::get();
+			// The autosave snapshots belong to the scene being replaced
+			serializer::Autosave::get()->reset();
+			// Prepared data embedded in the previous scene file is released with its mapping
+			graph::PreparedDataStore::get()->clear();
+			// Images prefetched by a previous import which were never taken
+			importer::TexturePrefetcher::get()->clear();
 			// switch on file extension
-			if (fileExtension == "vtx" || fileExtension == "xml" || fileExtension == "json")
+			if (fileExtension == "vtx" || fileExtension == "vtxc" || fileExtension == "xml" || fileExtension == "json")
 			{
 				serializer::deserialize(filePath);
 			}
@@ -89,8 +98,10 @@ namespace vtx
 				{
 					scene->renderer->camera = ops::standardCamera();
 				}
+				std::shared_ptr<graph::Node> previousRoot = scene->sceneRoot;
 				scene->sceneRoot = _sceneRoot;
 				scene->renderer->sceneRoot = scene->sceneRoot;
+				ops::releaseNodes({ std::move(previousRoot) });
 
 				previousModelPath = filePath;
 			}
@@ -120,12 +131,12 @@ namespace vtx
 
 	std::vector<std::string> LoadingSaving::getSupportedLoadingFileExtensions()
 	{
-		return {"*.vtx", "*.xml", "*.json", "*.obj", "*.fbx", "*.gltf"};
+		return {"*.vtx", "*.vtxc", "*.xml", "*.json", "*.obj", "*.fbx", "*.gltf"};
 	}
 
 	std::vector<std::string> LoadingSaving::getSupportedSavingFileExtensions()
 	{
-		return {"*.vtx", "*.xml", "*.json"};
+		return {"*.vtx", "*.vtxc", "*.xml", "*.json"};
 	}
 
 	bool LoadingSaving::isLoadFileRequested()
@@ -167,6 +178,8 @@ namespace vtx
 			break;
 
 		case LoadSaveState::Loading:
+			// The data loop of this frame created the textures of the loaded scene, the images left were not used
+			importer::TexturePrefetcher::get()->clear();
 			filePathToLoad = "";
 			currentState = LoadSaveState::Idle; // Reset after operation
 			break;
@@ -135,6 +135,39 @@ namespace vtx {
 		options.LaunchParamName = "optixLaunchParams";
 		options.enableCache = true;
 
+		////////////////////////////////////////////////////////////////////////////////////
+		/////////////////// Import Options /////////////////////////////////////////////////
+		////////////////////////////////////////////////////////////////////////////////////
+		options.enableImportCache = true;
+		options.importCacheFolder = options.executablePath + "importCache/";
+		options.weldMeshesOnImport = true;
+		options.weldTolerance = 1e-5f;
+		options.weldNormalTolerance = 1e-3f;
+		options.weldTexCoordTolerance = 1e-5f;
+		options.instanceDuplicateMeshes = true;
+		options.rigidMeshInstancing = true;
+		options.nativeGltfLoader = true;
+		options.nativeObjLoader = true;
+		options.prefetchTexturesOnImport = true;
+		options.mergeIdenticalMaterials = true;
+		options.asyncMeshPreparation = true;
+		options.compactVertexFormat = false;
+		options.lightSelectionBvh = true;
+		options.envMapPrefilter = false;
+		options.envMapSamplingCache = true;
+		options.validateLightSampling = false;
+		options.samplingTableCache = true;
+		options.parallelTraversal = true;
+		options.pooledNodeAllocation = true;
+		options.parallelSceneSerialization = true;
+		options.enableAutosave = false;
+		options.autosaveInterval = 300.0f;
+		options.autosaveFolder = options.executablePath + "autosave/";
+		options.autosaveMaxDeltas = 20;
+		options.autosaveCopyBudget = 1024;
+		options.lazyMeshLoading = true;
+		options.embedPreparedData = true;
+
 		////////////////////////////////////////////////////////////////////////////////////
 		/////////////////// MDL Options ////////////////////////////////////////////////////
 		////////////////////////////////////////////////////////////////////////////////////
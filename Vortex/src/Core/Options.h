@@ -51,6 +51,39 @@ namespace vtx
 		std::string LaunchParamName;
 		bool        enableCache;
 
+		////////////////////////////////////////////////////////////////////////////////////
+		/////////////////// Import Options /////////////////////////////////////////////////
+		////////////////////////////////////////////////////////////////////////////////////
+		bool        enableImportCache;
+		std::string importCacheFolder;
+		bool        weldMeshesOnImport;
+		float       weldTolerance; // Position tolerance in scene units
+		float       weldNormalTolerance;
+		float       weldTexCoordTolerance;
+		bool        instanceDuplicateMeshes;
+		bool        rigidMeshInstancing;
+		bool        nativeGltfLoader;
+		bool        nativeObjLoader;
+		bool        prefetchTexturesOnImport;
+		bool        mergeIdenticalMaterials;
+		bool        asyncMeshPreparation;
+		bool        compactVertexFormat;
+		bool        lightSelectionBvh;
+		bool        envMapPrefilter;
+		bool        envMapSamplingCache;
+		bool        validateLightSampling;
+		bool        samplingTableCache;
+		bool        parallelTraversal;
+		bool        pooledNodeAllocation;
+		bool        parallelSceneSerialization;
+		bool        enableAutosave;
+		float       autosaveInterval; // Seconds between snapshots
+		std::string autosaveFolder;
+		int         autosaveMaxDeltas; // Deltas written before they are folded into a new base
+		int         autosaveCopyBudget; // MB of mesh arrays copied to write a base in the background, larger bases are written in place
+		bool        lazyMeshLoading; // Meshes of .vtxc scenes are read from the file on first access
+		bool        embedPreparedData; // .vtxc scenes embed light sampling tables and converted textures
+
 		////////////////////////////////////////////////////////////////////////////////////
 		/////////////////// MDL Options ////////////////////////////////////////////////////
 		////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,164 @@
+#include "PoolAllocator.h"
+#include <algorithm>
+
+namespace utl
+{
+	// Function statics, pools can be created during the static initialization of other translation units
+	static std::mutex& getPoolsMutex()
+	{
+		static auto* mutex = new std::mutex();
+		return *mutex;
+	}
+
+	static std::vector<BlockPool*>& getRegisteredPools()
+	{
+		static auto* pools = new std::vector<BlockPool*>();
+		return *pools;
+	}
+
+	BlockPool::BlockPool(const size_t blockSize, const size_t blockAlignment) :
+		blockAlignment(std::max(blockAlignment, alignof(FreeBlock)))
+	{
+		// Blocks hold the free list link while unused, and stay aligned when laid out back to back
+		const size_t size = std::max(blockSize, sizeof(FreeBlock));
+		this->blockSize   = (size + this->blockAlignment - 1) / this->blockAlignment * this->blockAlignment;
+
+		std::lock_guard<std::mutex> lock(getPoolsMutex());
+		getRegisteredPools().push_back(this);
+	}
+
+	BlockPool::~BlockPool()
+	{
+		for (const Chunk& chunk : chunks)
+		{
+			::operator delete(chunk.begin, std::align_val_t(blockAlignment));
+		}
+		std::lock_guard<std::mutex> lock(getPoolsMutex());
+		std::vector<BlockPool*>&    pools = getRegisteredPools();
+		pools.erase(std::remove(pools.begin(), pools.end(), this), pools.end());
+	}
+
+	void BlockPool::addChunk()
+	{
+		const size_t numBlocks = nextChunkBlocks;
+		nextChunkBlocks        = std::min(nextChunkBlocks * 2, maxChunkBlocks);
+
+		auto* chunk = static_cast<std::byte*>(::operator new(numBlocks * blockSize, std::align_val_t(blockAlignment)));
+		const auto position = std::lower_bound(chunks.begin(), chunks.end(), chunk, [](const Chunk& c, const std::byte* begin)
+		{
+			return c.begin < begin;
+		});
+		chunks.insert(position, Chunk{ chunk, numBlocks, 0 });
+
+		// Linked in reverse so blocks are handed out in address order
+		for (size_t i = numBlocks; i-- > 0;)
+		{
+			auto* block = reinterpret_cast<FreeBlock*>(chunk + i * blockSize);
+			block->next = freeList;
+			freeList    = block;
+		}
+		freeBlocks += numBlocks;
+	}
+
+	BlockPool::Chunk& BlockPool::findChunk(const void* block)
+	{
+		const auto next = std::upper_bound(chunks.begin(), chunks.end(), static_cast<const std::byte*>(block), [](const std::byte* address, const Chunk& c)
+		{
+			return address < c.begin;
+		});
+		return *(next - 1);
+	}
+
+	void* BlockPool::allocate()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (freeList == nullptr)
+		{
+			addChunk();
+		}
+		FreeBlock* block = freeList;
+		freeList         = block->next;
+		--freeBlocks;
+		++liveBlocks;
+		++findChunk(block).liveBlocks;
+		return block;
+	}
+
+	void BlockPool::deallocate(void* block)
+	{
+		if (block == nullptr)
+		{
+			return;
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		auto* freeBlock = static_cast<FreeBlock*>(block);
+		freeBlock->next = freeList;
+		freeList        = freeBlock;
+		++freeBlocks;
+		--liveBlocks;
+		--findChunk(block).liveBlocks;
+	}
+
+	void BlockPool::trim()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		const bool hasEmptyChunk = std::any_of(chunks.begin(), chunks.end(), [](const Chunk& chunk) { return chunk.liveBlocks == 0; });
+		if (!hasEmptyChunk)
+		{
+			return;
+		}
+
+		// The free blocks of the released chunks are unlinked, the order of the others is kept
+		FreeBlock*  kept     = nullptr;
+		FreeBlock** keptTail = &kept;
+		for (FreeBlock* block = freeList; block != nullptr;)
+		{
+			FreeBlock* next = block->next;
+			if (findChunk(block).liveBlocks != 0)
+			{
+				*keptTail = block;
+				keptTail  = &block->next;
+			}
+			else
+			{
+				--freeBlocks;
+			}
+			block = next;
+		}
+		*keptTail = nullptr;
+		freeList  = kept;
+
+		for (const Chunk& chunk : chunks)
+		{
+			if (chunk.liveBlocks == 0)
+			{
+				::operator delete(chunk.begin, std::align_val_t(blockAlignment));
+			}
+		}
+		chunks.erase(std::remove_if(chunks.begin(), chunks.end(), [](const Chunk& chunk) { return chunk.liveBlocks == 0; }), chunks.end());
+		if (chunks.empty())
+		{
+			nextChunkBlocks = firstChunkBlocks;
+		}
+	}
+
+	BlockPool::Stats BlockPool::getStats() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return { blockSize, liveBlocks, freeBlocks, chunks.size() };
+	}
+
+	std::vector<BlockPool*> BlockPool::getPools()
+	{
+		std::lock_guard<std::mutex> lock(getPoolsMutex());
+		return getRegisteredPools();
+	}
+
+	void BlockPool::trimAll()
+	{
+		for (BlockPool* pool : getPools())
+		{
+			pool->trim();
+		}
+	}
+}
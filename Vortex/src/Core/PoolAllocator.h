@@ -0,0 +1,129 @@
+#pragma once
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace utl
+{
+	// Thread safe pool of fixed size blocks. Blocks are carved from chunks of growing size, freed blocks are reused first.
+	// Chunks go back to the system when they hold no live block and the pool is trimmed, so releasing a whole scene returns
+	// its memory a few chunks at a time instead of one allocation per object, even while the next scene is alive.
+	class BlockPool
+	{
+	public:
+		struct Stats
+		{
+			size_t blockSize  = 0;
+			size_t liveBlocks = 0;
+			size_t freeBlocks = 0;
+			size_t chunks     = 0;
+		};
+
+		BlockPool(size_t blockSize, size_t blockAlignment);
+
+		BlockPool(const BlockPool&) = delete;
+		BlockPool& operator=(const BlockPool&) = delete;
+
+		~BlockPool();
+
+		void* allocate();
+
+		void deallocate(void* block);
+
+		// Releases the chunks in which no block is in use
+		void trim();
+
+		Stats getStats() const;
+
+		// Every pool created so far, pools live until the end of the program
+		static std::vector<BlockPool*> getPools();
+
+		static void trimAll();
+
+	private:
+		struct FreeBlock
+		{
+			FreeBlock* next;
+		};
+
+		struct Chunk
+		{
+			std::byte* begin;
+			size_t     numBlocks;
+			size_t     liveBlocks;
+		};
+
+		static constexpr size_t firstChunkBlocks = 64;
+		static constexpr size_t maxChunkBlocks   = 16384;
+
+		void addChunk();
+
+		// Chunk holding the block
+		Chunk& findChunk(const void* block);
+
+		size_t             blockSize;
+		size_t             blockAlignment;
+		size_t             nextChunkBlocks = firstChunkBlocks;
+		std::vector<Chunk> chunks; // Sorted by address
+		FreeBlock*         freeList   = nullptr;
+		size_t             liveBlocks = 0;
+		size_t             freeBlocks = 0;
+		mutable std::mutex mutex;
+	};
+
+	// One pool per allocated type. allocate_shared rebinds the allocator to its control block type, so the object and its
+	// control block share a single pooled block.
+	// The pools are never destroyed: objects owned by static singletons are released after static destruction begins.
+	template<typename T>
+	BlockPool& getBlockPool()
+	{
+		static BlockPool* pool = new BlockPool(sizeof(T), alignof(T));
+		return *pool;
+	}
+
+	template<typename T>
+	class PoolAllocator
+	{
+	public:
+		using value_type = T;
+
+		PoolAllocator() noexcept = default;
+
+		template<typename U>
+		PoolAllocator(const PoolAllocator<U>&) noexcept
+		{
+		}
+
+		T* allocate(const size_t count)
+		{
+			if (count != 1)
+			{
+				return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(alignof(T))));
+			}
+			return static_cast<T*>(getBlockPool<T>().allocate());
+		}
+
+		void deallocate(T* pointer, const size_t count) noexcept
+		{
+			if (count != 1)
+			{
+				::operator delete(pointer, std::align_val_t(alignof(T)));
+				return;
+			}
+			getBlockPool<T>().deallocate(pointer);
+		}
+
+		template<typename U>
+		bool operator==(const PoolAllocator<U>&) const noexcept
+		{
+			return true;
+		}
+
+		template<typename U>
+		bool operator!=(const PoolAllocator<U>&) const noexcept
+		{
+			return false;
+		}
+	};
+}
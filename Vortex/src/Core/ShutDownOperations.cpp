@@ -6,6 +6,7 @@
 #include "MDL/MdlWrapper.h"
 #include "Scene/SceneIndexManager.h"
 #include "Scene/Nodes/Renderer.h"
+#include "Serialization/Autosave.h"
 
 
 void vtx::shutDownOperations()
@@ -33,6 +34,9 @@ void vtx::shutDownOperations()
 	}
 	VTX_INFO("ShutDown: Render Threads exited");
 
+	// A snapshot may still be written on the thread pool
+	serializer::Autosave::get()->wait();
+
 	UPLOAD_BUFFERS->shutDown();
 
 	optix::shutDown();
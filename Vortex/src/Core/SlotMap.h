@@ -0,0 +1,158 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace utl
+{
+	// Index plus the generation it was handed out with. Releasing an index bumps its generation, so ids kept around after
+	// the release (or released twice) are recognized as stale even if the index has been handed out again.
+	struct SlotId
+	{
+		uint32_t id         = 0;
+		uint32_t generation = 0;
+	};
+
+	// Allocator of small, recycled indices with an optional value attached to each of them.
+	// Values are kept densely packed for contiguous iteration, index <-> value translation is O(1) in both directions.
+	// Index 0 is reserved as invalid, freed indices are handed out again lowest first to keep the index range compact.
+	template<typename T>
+	class SlotMap
+	{
+	public:
+		static constexpr uint32_t invalidDense = UINT32_MAX;
+
+		SlotId allocate()
+		{
+			uint32_t id;
+			if (freeIds.empty())
+			{
+				if (slots.empty())
+				{
+					slots.emplace_back(); // reserved invalid index
+				}
+				id = static_cast<uint32_t>(slots.size());
+				slots.emplace_back();
+			}
+			else
+			{
+				std::pop_heap(freeIds.begin(), freeIds.end(), std::greater<>());
+				id = freeIds.back();
+				freeIds.pop_back();
+			}
+			Slot& slot       = slots[id];
+			slot.isAllocated = true;
+			return { id, slot.generation };
+		}
+
+		// Frees the index and its value, returns false if the id is stale
+		bool release(const SlotId slotId)
+		{
+			if (!isAlive(slotId))
+			{
+				return false;
+			}
+			erase(slotId.id);
+			Slot& slot       = slots[slotId.id];
+			slot.isAllocated = false;
+			++slot.generation;
+			freeIds.push_back(slotId.id);
+			std::push_heap(freeIds.begin(), freeIds.end(), std::greater<>());
+			return true;
+		}
+
+		bool isAllocated(const uint32_t id) const
+		{
+			return id != 0 && id < slots.size() && slots[id].isAllocated;
+		}
+
+		bool isAlive(const SlotId slotId) const
+		{
+			return isAllocated(slotId.id) && slots[slotId.id].generation == slotId.generation;
+		}
+
+		// Current generation of an allocated index
+		SlotId getSlotId(const uint32_t id) const
+		{
+			return isAllocated(id) ? SlotId{ id, slots[id].generation } : SlotId{};
+		}
+
+		// Attaches the value to an allocated index, replacing the previous one
+		bool insert(const uint32_t id, T value)
+		{
+			if (!isAllocated(id))
+			{
+				return false;
+			}
+			Slot& slot = slots[id];
+			if (slot.dense != invalidDense)
+			{
+				values[slot.dense] = std::move(value);
+				return true;
+			}
+			slot.dense = static_cast<uint32_t>(values.size());
+			values.push_back(std::move(value));
+			denseIds.push_back(id);
+			return true;
+		}
+
+		// Detaches the value of the index, the index itself stays allocated
+		bool erase(const uint32_t id)
+		{
+			if (!isAllocated(id) || slots[id].dense == invalidDense)
+			{
+				return false;
+			}
+			// Swap with the last value to keep the storage dense
+			const uint32_t dense  = slots[id].dense;
+			const uint32_t lastId = denseIds.back();
+			if (lastId != id)
+			{
+				values[dense]       = std::move(values.back());
+				denseIds[dense]     = lastId;
+				slots[lastId].dense = dense;
+			}
+			values.pop_back();
+			denseIds.pop_back();
+			slots[id].dense = invalidDense;
+			return true;
+		}
+
+		T* find(const uint32_t id)
+		{
+			return (id < slots.size() && slots[id].dense != invalidDense) ? &values[slots[id].dense] : nullptr;
+		}
+
+		const T* find(const uint32_t id) const
+		{
+			return (id < slots.size() && slots[id].dense != invalidDense) ? &values[slots[id].dense] : nullptr;
+		}
+
+		// Dense storage, getIds()[i] is the index of getValues()[i]
+		const std::vector<T>&        getValues() const { return values; }
+		const std::vector<uint32_t>& getIds() const { return denseIds; }
+		size_t                       size() const { return values.size(); }
+
+		void reserve(const size_t capacity)
+		{
+			slots.reserve(capacity + 1);
+			values.reserve(capacity);
+			denseIds.reserve(capacity);
+		}
+
+	private:
+		struct Slot
+		{
+			uint32_t generation  = 1;
+			uint32_t dense       = invalidDense;
+			bool     isAllocated = false;
+		};
+
+		std::vector<Slot>     slots;
+		std::vector<uint32_t> freeIds; // min heap
+		std::vector<T>        values;
+		std::vector<uint32_t> denseIds;
+	};
+}
@@ -0,0 +1,141 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace vtx
+{
+	struct ParallelForState
+	{
+		std::function<void(size_t)> func;
+		size_t                      count;
+		size_t                      grainSize;
+		std::atomic<size_t>         next{ 0 };
+		std::atomic<size_t>         done{ 0 };
+		std::mutex                  mutex;
+		std::condition_variable     finished;
+
+		// Returns true if at least one chunk was processed
+		bool runChunks()
+		{
+			bool didWork = false;
+			while (true)
+			{
+				const size_t begin = next.fetch_add(grainSize);
+				if (begin >= count)
+				{
+					return didWork;
+				}
+				const size_t end = std::min(begin + grainSize, count);
+				for (size_t i = begin; i < end; ++i)
+				{
+					func(i);
+				}
+				didWork = true;
+				if (done.fetch_add(end - begin) + (end - begin) == count)
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					finished.notify_all();
+				}
+			}
+		}
+	};
+
+	ThreadPool* ThreadPool::get()
+	{
+		static ThreadPool threadPool;
+		return &threadPool;
+	}
+
+	ThreadPool::ThreadPool()
+	{
+		const unsigned int numberOfWorkers = std::max(1u, std::thread::hardware_concurrency());
+		workers.reserve(numberOfWorkers);
+		for (unsigned int i = 0; i < numberOfWorkers; ++i)
+		{
+			workers.emplace_back(&ThreadPool::workerLoop, this);
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			stop = true;
+		}
+		queueCondition.notify_all();
+		for (std::thread& worker : workers)
+		{
+			if (worker.joinable())
+			{
+				worker.join();
+			}
+		}
+	}
+
+	unsigned int ThreadPool::getNumberOfWorkers() const
+	{
+		return static_cast<unsigned int>(workers.size());
+	}
+
+	void ThreadPool::enqueue(std::function<void()> task)
+	{
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			tasks.push(std::move(task));
+		}
+		queueCondition.notify_one();
+	}
+
+	void ThreadPool::workerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(queueMutex);
+				queueCondition.wait(lock, [this] { return stop || !tasks.empty(); });
+				if (stop && tasks.empty())
+				{
+					return;
+				}
+				task = std::move(tasks.front());
+				tasks.pop();
+			}
+			task();
+		}
+	}
+
+	void ThreadPool::parallelFor(const size_t count, const std::function<void(size_t)>& func, size_t grainSize)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+		grainSize = std::max<size_t>(1, grainSize);
+		const size_t numberOfChunks = (count + grainSize - 1) / grainSize;
+		if (numberOfChunks == 1)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				func(i);
+			}
+			return;
+		}
+
+		// The state is shared with the helpers, helpers which start after all the work is done simply find nothing to do.
+		const auto state = std::make_shared<ParallelForState>();
+		state->func      = func;
+		state->count     = count;
+		state->grainSize = grainSize;
+
+		const size_t numberOfHelpers = std::min<size_t>(workers.size(), numberOfChunks - 1);
+		for (size_t i = 0; i < numberOfHelpers; ++i)
+		{
+			enqueue([state]() { state->runChunks(); });
+		}
+
+		state->runChunks();
+
+		std::unique_lock<std::mutex> lock(state->mutex);
+		state->finished.wait(lock, [&state] { return state->done.load() == state->count; });
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace vtx
+{
+	// Fixed size pool of worker threads shared by host side pre-processing (import, sampling tables, serialization).
+	// The number of workers is bounded by the hardware concurrency so that nested or concurrent users can't oversubscribe the machine.
+	class ThreadPool
+	{
+	public:
+		static ThreadPool* get();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) = delete;
+		ThreadPool& operator=(ThreadPool&&) = delete;
+
+		unsigned int getNumberOfWorkers() const;
+
+		template<typename F>
+		std::future<std::invoke_result_t<F>> submit(F&& task)
+		{
+			using ReturnType = std::invoke_result_t<F>;
+			auto packagedTask = std::make_shared<std::packaged_task<ReturnType()>>(std::forward<F>(task));
+			std::future<ReturnType> future = packagedTask->get_future();
+			enqueue([packagedTask]() { (*packagedTask)(); });
+			return future;
+		}
+
+		// Calls func(i) for every i in [0, count). The calling thread takes part in the work, and only waits for items which
+		// are already being processed by other workers, so it is safe to call parallelFor from inside a pool task.
+		void parallelFor(size_t count, const std::function<void(size_t)>& func, size_t grainSize = 1);
+
+	private:
+		ThreadPool();
+		~ThreadPool();
+
+		void enqueue(std::function<void()> task);
+		void workerLoop();
+
+		std::vector<std::thread>          workers;
+		std::queue<std::function<void()>> tasks;
+		std::mutex                        queueMutex;
+		std::condition_variable           queueCondition;
+		bool                              stop = false;
+	};
+}
+
+namespace utl
+{
+	inline void parallelFor(const size_t count, const std::function<void(size_t)>& func, const size_t grainSize = 1)
+	{
+		vtx::ThreadPool::get()->parallelFor(count, func, grainSize);
+	}
+}
@@ -203,6 +203,39 @@ namespace utl{
 	}
 
 
+	bool writeFileAtomically(const std::string& filePath, const std::function<void(std::ofstream&)>& writer)
+	{
+		const std::string tempPath = filePath + ".tmp";
+		createDirectory(filePath);
+		{
+			std::ofstream outFile(tempPath, std::ios::binary | std::ios::trunc);
+			if (!outFile)
+			{
+				VTX_WARN("Failed to open {} for writing", tempPath);
+				return false;
+			}
+			writer(outFile);
+			if (!outFile.good())
+			{
+				VTX_WARN("Failed writing {}", tempPath);
+				outFile.close();
+				std::error_code error;
+				std::filesystem::remove(tempPath, error);
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempPath, filePath, error);
+		if (error)
+		{
+			VTX_WARN("Failed to move {} to {}: {}", tempPath, filePath, error.message());
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+		return true;
+	}
+
 	std::string getDateTime()
 	{
 		SYSTEMTIME time;
@@ -248,5 +281,70 @@ namespace utl{
 
 		return oss.str();
 	}
+
+	MappedFile::MappedFile(const std::string& filePath)
+	{
+		open(filePath);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		close();
+	}
+
+	bool MappedFile::open(const std::string& filePath)
+	{
+		close();
+		// Sharing deletion lets a save replace the file while it is mapped, the view keeps the content it was opened with
+		const HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		fileHandle = file;
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+		{
+			close();
+			return false;
+		}
+		size = static_cast<size_t>(fileSize.QuadPart);
+
+		mappingHandle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mappingHandle == NULL)
+		{
+			close();
+			return false;
+		}
+
+		data = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+		if (data == nullptr)
+		{
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+		if (data != nullptr)
+		{
+			UnmapViewOfFile(data);
+			data = nullptr;
+		}
+		if (mappingHandle != nullptr)
+		{
+			CloseHandle(mappingHandle);
+			mappingHandle = nullptr;
+		}
+		if (fileHandle != nullptr)
+		{
+			CloseHandle(fileHandle);
+			fileHandle = nullptr;
+		}
+		size = 0;
+	}
 }
 
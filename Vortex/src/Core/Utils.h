@@ -2,6 +2,7 @@
 #include <string>
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include "Core/Log.h"
 #include <sstream>
 #include <stack>
@@ -39,6 +40,10 @@ namespace utl{
 
 	void copyFileToDestination(const std::string& source, const std::string& destination);
 
+	// Writes the file into a temporary file next to it which replaces filePath once complete, readers never see a partial
+	// file. The folder is created if needed. Returns false, leaving filePath untouched, if the file could not be written.
+	bool writeFileAtomically(const std::string& filePath, const std::function<void(std::ofstream&)>& writer);
+
 	template<typename T>
 	std::vector<T> binaryLoad(const int& count, const std::string & filePath)
 	{
@@ -60,4 +65,35 @@ namespace utl{
 
 		return data;
 	}
+
+	// Read only memory mapping of a whole file, the mapping is released on destruction
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		explicit MappedFile(const std::string& filePath);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool open(const std::string& filePath);
+		void close();
+
+		bool        isValid() const { return data != nullptr; }
+		const void* getData() const { return data; }
+		size_t      getSize() const { return size; }
+
+		// True if count elements of elementSize bytes starting at offset lie inside the file, without overflowing on corrupt values
+		bool containsRange(const uint64_t offset, const uint64_t count, const uint64_t elementSize) const
+		{
+			return offset <= size && (elementSize == 0 || count <= (size - offset) / elementSize);
+		}
+
+	private:
+		void*  fileHandle    = nullptr;
+		void*  mappingHandle = nullptr;
+		void*  data          = nullptr;
+		size_t size          = 0;
+	};
 }
@@ -1,7 +1,14 @@
 #include "Application.h"
+#include "Tests/Tests.h"
 
 int main(const int argc, char** argv) {
 	vtx::Log::Init();
+
+	// Tests and benchmarks run without the window and the device
+	if (argc > 1 && vtx::test::isTestCommand(argv[1])) {
+		return vtx::test::runCommand(argc, argv);
+	}
+
 	vtx::Application app = vtx::Application();
 	app.init();
 
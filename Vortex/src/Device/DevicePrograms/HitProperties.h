@@ -45,17 +45,18 @@ namespace vtx
         {
             InstanceData* instance = params->instances[instanceId];
             const GeometryData* geometry = instance->geometryData;
-            const math::vec3ui       triVerticesIndices = reinterpret_cast<math::vec3ui*>(geometry->indicesData)[triangleId];
-            graph::VertexAttributes* vertices[3]{ nullptr, nullptr, nullptr };
-            vertices[0] = &(geometry->vertexAttributeData[triVerticesIndices.x]);
-            vertices[1] = &(geometry->vertexAttributeData[triVerticesIndices.y]);
-            vertices[2] = &(geometry->vertexAttributeData[triVerticesIndices.z]);
-
-            math::vec3f ngO = math::normalize(cross(vertices[1]->position - vertices[0]->position, vertices[2]->position - vertices[0]->position));
-            const math::vec3f nsO = math::normalize(vertices[0]->normal * baricenter.x + vertices[1]->normal * baricenter.y + vertices[2]->normal * baricenter.z);
-            const math::vec3f tgO = math::normalize(vertices[0]->tangent * baricenter.x + vertices[1]->tangent * baricenter.y + vertices[2]->tangent * baricenter.z);
-            const math::vec3f btO = math::normalize(vertices[0]->bitangent * baricenter.x + vertices[1]->bitangent * baricenter.y + vertices[2]->bitangent * baricenter.z);
-            uv = vertices[0]->texCoord * baricenter.x + vertices[1]->texCoord * baricenter.y + vertices[2]->texCoord * baricenter.z;
+            const math::vec3ui       triVerticesIndices = geometry->getTriangleIndices(triangleId);
+            const graph::VertexAttributes vertices[3]{
+                geometry->getVertex(triVerticesIndices.x),
+                geometry->getVertex(triVerticesIndices.y),
+                geometry->getVertex(triVerticesIndices.z)
+            };
+
+            math::vec3f ngO = math::normalize(cross(vertices[1].position - vertices[0].position, vertices[2].position - vertices[0].position));
+            const math::vec3f nsO = math::normalize(vertices[0].normal * baricenter.x + vertices[1].normal * baricenter.y + vertices[2].normal * baricenter.z);
+            const math::vec3f tgO = math::normalize(vertices[0].tangent * baricenter.x + vertices[1].tangent * baricenter.y + vertices[2].tangent * baricenter.z);
+            const math::vec3f btO = math::normalize(vertices[0].bitangent * baricenter.x + vertices[1].bitangent * baricenter.y + vertices[2].bitangent * baricenter.z);
+            uv = vertices[0].texCoord * baricenter.x + vertices[1].texCoord * baricenter.y + vertices[2].texCoord * baricenter.z;
 
             if (dot(ngO, nsO) < 0.0f) // make sure that shading and geometry normal agree on sideness
             {
@@ -68,7 +69,7 @@ namespace vtx
             tangent = math::normalize(math::transformVector3F(*oTw, tgO));
             bitangent = math::normalize(math::transformVector3F(*oTw, btO));
 
-            position = vertices[0]->position * baricenter.x + vertices[1]->position * baricenter.y + vertices[2]->position * baricenter.z;
+            position = vertices[0].position * baricenter.x + vertices[1].position * baricenter.y + vertices[2].position * baricenter.z;
             position = math::transformPoint3F(*oTw, position);
             *outgoingDirection = position - rayOrigin;
             *distance = math::length(*outgoingDirection);
@@ -96,17 +97,18 @@ namespace vtx
         {
             InstanceData* instance = params->instances[instanceId];
             const GeometryData* geometry = instance->geometryData;
-            const math::vec3ui       triVerticesIndices = reinterpret_cast<math::vec3ui*>(geometry->indicesData)[triangleId];
-            graph::VertexAttributes* vertices[3]{ nullptr, nullptr, nullptr };
-            vertices[0] = &(geometry->vertexAttributeData[triVerticesIndices.x]);
-            vertices[1] = &(geometry->vertexAttributeData[triVerticesIndices.y]);
-            vertices[2] = &(geometry->vertexAttributeData[triVerticesIndices.z]);
-
-            math::vec3f ngO = math::normalize(cross(vertices[1]->position - vertices[0]->position, vertices[2]->position - vertices[0]->position));
-            const math::vec3f nsO = math::normalize(vertices[0]->normal * baricenter.x + vertices[1]->normal * baricenter.y + vertices[2]->normal * baricenter.z);
-            const math::vec3f tgO = math::normalize(vertices[0]->tangent * baricenter.x + vertices[1]->tangent * baricenter.y + vertices[2]->tangent * baricenter.z);
-            const math::vec3f btO = math::normalize(vertices[0]->bitangent * baricenter.x + vertices[1]->bitangent * baricenter.y + vertices[2]->bitangent * baricenter.z);
-            uv = vertices[0]->texCoord * baricenter.x + vertices[1]->texCoord * baricenter.y + vertices[2]->texCoord * baricenter.z;
+            const math::vec3ui       triVerticesIndices = geometry->getTriangleIndices(triangleId);
+            const graph::VertexAttributes vertices[3]{
+                geometry->getVertex(triVerticesIndices.x),
+                geometry->getVertex(triVerticesIndices.y),
+                geometry->getVertex(triVerticesIndices.z)
+            };
+
+            math::vec3f ngO = math::normalize(cross(vertices[1].position - vertices[0].position, vertices[2].position - vertices[0].position));
+            const math::vec3f nsO = math::normalize(vertices[0].normal * baricenter.x + vertices[1].normal * baricenter.y + vertices[2].normal * baricenter.z);
+            const math::vec3f tgO = math::normalize(vertices[0].tangent * baricenter.x + vertices[1].tangent * baricenter.y + vertices[2].tangent * baricenter.z);
+            const math::vec3f btO = math::normalize(vertices[0].bitangent * baricenter.x + vertices[1].bitangent * baricenter.y + vertices[2].bitangent * baricenter.z);
+            uv = vertices[0].texCoord * baricenter.x + vertices[1].texCoord * baricenter.y + vertices[2].texCoord * baricenter.z;
 
             if (dot(ngO, nsO) < 0.0f) // make sure that shading and geometry normal agree on sideness
             {
@@ -136,9 +138,9 @@ namespace vtx
                     shadingNormal.x, shadingNormal.y, shadingNormal.z,
                     tangent.x, tangent.y, tangent.z,
                     tgO.x, tgO.y, tgO.z,
-                    vertices[0]->tangent.x, vertices[0]->tangent.y, vertices[0]->tangent.z,
-                    vertices[1]->tangent.x, vertices[1]->tangent.y, vertices[1]->tangent.z,
-                    vertices[2]->tangent.x, vertices[2]->tangent.y, vertices[2]->tangent.z
+                    vertices[0].tangent.x, vertices[0].tangent.y, vertices[0].tangent.z,
+                    vertices[1].tangent.x, vertices[1].tangent.y, vertices[1].tangent.z,
+                    vertices[2].tangent.x, vertices[2].tangent.y, vertices[2].tangent.z
                 );
             }
 
@@ -154,12 +156,13 @@ namespace vtx
             const InstanceData* instance = params->instances[instanceId];
             const GeometryData* geometry = instance->geometryData;
             const math::affine3f& objectToWorld = instance->transform;
-            const math::vec3ui       triVerticesIndices = reinterpret_cast<math::vec3ui*>(geometry->indicesData)[triangleId];
-            graph::VertexAttributes* vertices[3]{ nullptr, nullptr, nullptr };
-            vertices[0] = &(geometry->vertexAttributeData[triVerticesIndices.x]);
-            vertices[1] = &(geometry->vertexAttributeData[triVerticesIndices.y]);
-            vertices[2] = &(geometry->vertexAttributeData[triVerticesIndices.z]);
-            const math::vec3f nsO = math::normalize(vertices[0]->normal * baricenter.x + vertices[1]->normal * baricenter.y + vertices[2]->normal * baricenter.z);
+            const math::vec3ui       triVerticesIndices = geometry->getTriangleIndices(triangleId);
+            const graph::VertexAttributes vertices[3]{
+                geometry->getVertex(triVerticesIndices.x),
+                geometry->getVertex(triVerticesIndices.y),
+                geometry->getVertex(triVerticesIndices.z)
+            };
+            const math::vec3f nsO = math::normalize(vertices[0].normal * baricenter.x + vertices[1].normal * baricenter.y + vertices[2].normal * baricenter.z);
             shadingNormal = math::normalize(math::transformNormal3F(objectToWorld, nsO));
 
         }
@@ -8,6 +8,8 @@
 #include <mi/neuraylib/target_code_types.h>
 #include "NoiseData.h"
 #include "Device/Structs/GeometryData.h"
+#include "Device/Structs/LightSelection.h"
+#include "Device/Structs/MeshLightSampling.h"
 #include "Device/Wrappers/WorkQueue.h"
 #include "NeuralNetworks/NetworkSettings.h"
 #include "Scene/DataStructs/VertexAttribute.h"
@@ -162,12 +164,6 @@ namespace vtx {
         TextureHandler*             textureHandler;
     };
 
-    struct AliasData {
-        unsigned int alias;
-        float q;
-        float pdf;
-    };
-
     struct EnvLightAttributesData
     {
         TextureData* texture;
@@ -185,10 +181,12 @@ namespace vtx {
         GeometryData*   geometryData;
         MaterialData*   materialId;
 
-        float* cdfArea;
-        uint32_t* actualTriangleIndices;
-        float           totalArea;
+        // Alias table over the emissive triangles of the mesh slot, built from object space areas and shared between instances
+        AliasData*      aliasMap;
+        uint32_t*       triangleIndices;
         int             size;
+        float           objectArea;
+        float           worldArea;
     };
 
     struct LightData
@@ -196,6 +194,7 @@ namespace vtx {
         LightType   type;
         CUdeviceptr attributes;
         bool use = false;
+        int selectionIndex = -1; // index in LaunchParams::lights, -1 if the light is not sampled
     };
 
     struct InstanceData
@@ -396,6 +395,7 @@ namespace vtx {
 		LightData*              envLight = nullptr;
 		LightData**             lights;
 		int                     numberOfLights;
+		LightSelection          lightSelection;
 
         QueuesData              queues;
 
@@ -213,7 +213,8 @@ namespace vtx
                 // If the last surface intersection was a diffuse event which was directly lit with multiple importance sampling,
                 // then calculate light emission with multiple importance sampling for this implicit light hit as well.
                 bool MiSCondition = (params->settings.renderer.samplingTechnique == S_MIS && (ewi.eventType & (mi::neuraylib::BSDF_EVENT_DIFFUSE | mi::neuraylib::BSDF_EVENT_GLOSSY)));
-                float envSamplePdf = attrib.aliasMap[y * texture->dimension.x + x].pdf;
+                // Infinite lights have the same selection probability everywhere
+                float envSamplePdf = attrib.aliasMap[y * texture->dimension.x + x].pdf * lightSelection::pdf(params->lightSelection, math::vec3f(0.0f), envLight->selectionIndex);
                 if (ewi.pdf > 0.0f && MiSCondition)
                 {
                     misWeight = utl::heuristic(ewi.pdf, envSamplePdf);
@@ -237,6 +238,18 @@ namespace vtx
         return emission;
     }
 
+    // Pdf per unit of world area of a point on a triangle of the mesh light, see meshLightSampling::areaPdf
+    __forceinline__ __device__ float meshLightAreaPdf(const MeshLightAttributesData& attributes, const LaunchParams& params, const unsigned instanceId, const unsigned triangleId)
+    {
+        const InstanceData* instance = params.instances[instanceId];
+        const GeometryData* geometry = instance->geometryData;
+        const math::vec3ui  indices  = geometry->getTriangleIndices(triangleId);
+        const math::vec3f   v0       = geometry->getVertex(indices.x).position;
+        const math::vec3f   v1       = geometry->getVertex(indices.y).position;
+        const math::vec3f   v2       = geometry->getVertex(indices.z).position;
+        return meshLightSampling::areaPdf(meshLightSampling::triangleArea(v0, v1, v2), attributes.objectArea, meshLightSampling::worldTriangleArea(instance->transform, v0, v1, v2));
+    }
+
     __forceinline__ __device__ LightSample sampleMeshLight(const LightData& light, RayWorkItem& prd, LaunchParams& params)
     {
         MeshLightAttributesData meshLightAttributes = *(MeshLightAttributesData*)(light.attributes);
@@ -244,14 +257,13 @@ namespace vtx
 
         lightSample.pdf = 0.0f;
 
-        const float* cdfArea = meshLightAttributes.cdfArea;
         const float3 sample3D = rng3(prd.seed);
 
-        // Uniformly sample the triangles over their surface area.
+        // Select the triangle proportionally to its object space area from the table shared by the instances of the mesh.
         // Note that zero-area triangles (e.g. at the poles of spheres) are automatically never sampled with this method!
-        // The cdfU is one bigger than res.y.
-        unsigned int idxTriangle = utl::binarySearchCdf(cdfArea, meshLightAttributes.size, sample3D.z);
-        idxTriangle = meshLightAttributes.actualTriangleIndices[idxTriangle];
+        float triangleProbability;
+        const int localTriangle = lightSelection::sampleAliasTable(meshLightAttributes.aliasMap, meshLightAttributes.size, sample3D.z, &triangleProbability);
+        const unsigned int idxTriangle = meshLightAttributes.triangleIndices[localTriangle];
         unsigned instanceId = meshLightAttributes.instanceId;
 
         // Barycentric coordinates.
@@ -297,12 +309,17 @@ namespace vtx
 
         if (matEval.edf.isValid)
         {
-            const float totArea = meshLightAttributes.totalArea;
+            const float totArea = meshLightAttributes.worldArea;
+            const float areaPdf = meshLightAreaPdf(meshLightAttributes, params, instanceId, idxTriangle);
+            if (areaPdf <= 0.0f)
+            {
+                return lightSample;
+            }
 
         	// Power (flux) [W] divided by light area gives radiant exitance [W/m^2].
             const float factor = (matEval.edf.mode == 0) ? matEval.opacity : matEval.opacity / totArea;
 
-            lightSample.pdf = lightSample.distance * lightSample.distance / (totArea * matEval.edf.cos); // Solid angle measure.
+            lightSample.pdf = lightSample.distance * lightSample.distance * areaPdf / matEval.edf.cos; // Solid angle measure.
             lightSample.radianceOverPdf = matEval.edf.intensity * matEval.edf.edf * (factor / lightSample.pdf);
             lightSample.isValid = true;
         }
@@ -383,10 +400,15 @@ namespace vtx
         LightSample lightSample;
         if (const int& numLights = params.numberOfLights; numLights > 0)
         {
-            //Randomly Selecting a Light
-            //TODO, I think here we can do some better selection by giving more importance to lights with greater power
-
-            const int indexLight = (1 < numLights) ? gdt::clamp(static_cast<int>(floorf(rng(prd.seed) * numLights)), 0, numLights - 1) : 0;
+            // Selecting a light proportionally to its power, or to its estimated contribution when the light bvh is used
+            float selectionPdf;
+            const int indexLight = lightSelection::sample(params.lightSelection, prd.hitProperties.position, rng(prd.seed), &selectionPdf);
+            if (indexLight < 0 || selectionPdf <= 0.0f)
+            {
+                lightSample.isValid = false;
+                lightSample.pdf = 0.0f;
+                return lightSample;
+            }
 
             const LightData& light = *(params.lights[indexLight]);
 
@@ -414,6 +436,9 @@ namespace vtx
 
             if (lightSample.isValid) // && dot(lightSample.direction, ngW) >= -0.05f)
             {
+                // The sampled emission needs to be scaled by the inverse probability of having selected this light
+                lightSample.pdf *= selectionPdf;
+                lightSample.radianceOverPdf = lightSample.radianceOverPdf / selectionPdf;
                 return lightSample;
             }
         }
@@ -794,14 +819,13 @@ namespace vtx
                     weightMis = utl::heuristic(lightSample.pdf, matEval.bsdfEvaluation.pdf);
                 }
 
-                // The sampled emission needs to be scaled by the inverse probability to have selected this light,
-                // Selecting one of many lights means the inverse of 1.0f / numLights.
+                // The inverse probability of having selected this light is already in the radianceOverPdf.
                 // This is using the path throughput before the sampling modulated it above.
                 // The bxdf from mdl already include the cosine term. We are sampling in path space so the pdf must be over Area.
                 // To handle delta lights the pdf is already incorporated into the emission, hence the radianceOverPdf.
                 // So once we multiply the throughput by it's multiplier some terms that should belong to the throughput are
                 // actually in the radianceOverPdf. This is not a problem since the path terminates after this bounce.
-                const math::vec3f throughputMultiplier = bxdf * (float)params.numberOfLights;
+                const math::vec3f throughputMultiplier = bxdf;
                 swi.radiance = prd.throughput * weightMis * throughputMultiplier * lightSample.radianceOverPdf;
                 swi.direction = lightSample.direction;
                 swi.distance = lightSample.distance - params.settings.renderer.minClamp;
@@ -832,9 +856,13 @@ namespace vtx
         if (matEval.edf.isValid)
         {
             const MeshLightAttributesData* attributes = reinterpret_cast<MeshLightAttributesData*>(prd.hitProperties.lightData->attributes);
-            const float area = attributes->totalArea;
+            const float area = attributes->worldArea;
+            const float areaPdf = meshLightAreaPdf(*attributes, params, prd.hitProperties.instanceId, prd.hitProperties.triangleId);
             // We compute the solid angle measure of selecting this light to compare with the pdf of the bsdf which is over directions.
-            matEval.edf.pdf = prd.hitDistance * prd.hitDistance / (area * matEval.edf.cos * (float)params.numberOfLights);
+            // The selection probability depends on the point the light would have been sampled from, the previous hit.
+            const math::vec3f previousPosition = prd.hitProperties.position - prd.direction * prd.hitDistance;
+            const float selectionPdf = lightSelection::pdf(params.lightSelection, previousPosition, prd.hitProperties.lightData->selectionIndex);
+            matEval.edf.pdf = prd.hitDistance * prd.hitDistance * areaPdf / matEval.edf.cos * selectionPdf;
             float misWeight = 1.0f;
             if (samplingTechnique == S_MIS && prd.eventType & (mi::neuraylib::BSDF_EVENT_DIFFUSE | mi::neuraylib::BSDF_EVENT_GLOSSY))
             {
@@ -664,7 +664,7 @@ namespace vtx::optix
 		CUDA_SYNC_CHECK();
 	}
 
-	OptixTraversableHandle createGeometryAcceleration(CUdeviceptr vertexData, uint32_t verticesNumber, uint32_t verticesStride, CUdeviceptr indexData, uint32_t indexNumber, uint32_t indicesStride)
+	OptixTraversableHandle createGeometryAcceleration(CUdeviceptr vertexData, uint32_t verticesNumber, uint32_t verticesStride, CUdeviceptr indexData, uint32_t indexNumber, uint32_t indicesStride, bool shortIndices)
 	{
 		VTX_INFO("Optix Wrapper: Computing BLAS");
 
@@ -683,7 +683,7 @@ namespace vtx::optix
 		buildInput.triangleArray.numVertices = verticesNumber;
 		buildInput.triangleArray.vertexBuffers = &vertexData;
 
-		buildInput.triangleArray.indexFormat = OPTIX_INDICES_FORMAT_UNSIGNED_INT3;
+		buildInput.triangleArray.indexFormat = shortIndices ? OPTIX_INDICES_FORMAT_UNSIGNED_SHORT3 : OPTIX_INDICES_FORMAT_UNSIGNED_INT3;
 		buildInput.triangleArray.indexStrideInBytes = indicesStride;
 		buildInput.triangleArray.numIndexTriplets = indexNumber / 3;
 		buildInput.triangleArray.indexBuffer = indexData;
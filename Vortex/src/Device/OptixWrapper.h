@@ -181,9 +181,9 @@ namespace vtx::optix
 	/*Utility to directly create a direct callable program from a function name and module*/
 	std::shared_ptr<ProgramOptix> createDcProgram(const std::shared_ptr<ModuleOptix>& module, const std::string& functionName, vtxID id = 0, const std::vector<std::string>& sbtName = {""});
 
-	/*Utility to create BLAS*/
+	/*Utility to create BLAS, vertices are float3 positions, indices are triplets of 32 or 16 bit (shortIndices) integers*/
 	OptixTraversableHandle createGeometryAcceleration(CUdeviceptr vertexData, uint32_t verticesNumber, uint32_t verticesStride, 
-													  CUdeviceptr indexData, uint32_t indexNumber, uint32_t indicesStride);
+													  CUdeviceptr indexData, uint32_t indexNumber, uint32_t indicesStride, bool shortIndices = false);
 
 	OptixInstance createInstance(uint32_t instanceId, const math::affine3f& transform, OptixTraversableHandle traversable);
 
@@ -3,6 +3,7 @@
 
 #include "Core/VortexID.h"
 #include "Scene/DataStructs/VertexAttribute.h"
+#include "Scene/DataStructs/CompactVertexAttribute.h"
 #include <optix_types.h>
 
 namespace vtx
@@ -14,6 +15,13 @@ namespace vtx
         NUM_PT
     };
 
+    enum VertexLayout {
+        VL_FULL,
+        VL_COMPACT,
+
+        NUM_VL
+    };
+
     struct GeometryData {
         PrimitiveType				type;
         OptixTraversableHandle		traversable;
@@ -24,6 +32,31 @@ namespace vtx
         size_t						numVertices;
         size_t						numIndices;
         size_t                      numFaces;
+
+        // Compact layout, vertexAttributeData and indicesData are null when it is used
+        VertexLayout                        vertexLayout;
+        graph::CompactVertexAttributes*     compactVertexData;
+        graph::CompactVertexBounds          compactBounds;
+        uint16_t*                           shortIndicesData; // used instead of indicesData for meshes with less than 65536 vertices
+
+        __inline__ __both__ math::vec3ui getTriangleIndices(const unsigned triangleId) const
+        {
+            if (shortIndicesData != nullptr)
+            {
+                const uint16_t* triangle = shortIndicesData + 3 * triangleId;
+                return math::vec3ui(triangle[0], triangle[1], triangle[2]);
+            }
+            return reinterpret_cast<math::vec3ui*>(indicesData)[triangleId];
+        }
+
+        __inline__ __both__ graph::VertexAttributes getVertex(const unsigned vertexId) const
+        {
+            if (vertexLayout == VL_COMPACT)
+            {
+                return graph::decodeVertex(compactVertexData[vertexId], compactBounds);
+            }
+            return vertexAttributeData[vertexId];
+        }
     };
 }
 
@@ -0,0 +1,424 @@
+#ifndef LIGHT_SELECTION_H
+#define LIGHT_SELECTION_H
+#pragma once
+
+#include "Core/Math.h"
+
+namespace vtx
+{
+    struct AliasData {
+        unsigned int alias;
+        float q;
+        float pdf;
+    };
+
+    // Emitter summary used to build the selection structures, in world space
+    struct LightBounds
+    {
+        math::vec3f boundsMin{ 0.0f };
+        math::vec3f boundsMax{ 0.0f };
+        math::vec3f axis{ 0.0f, 0.0f, 1.0f }; // normal cone axis
+        float       cosTheta   = -1.0f;         // cosine of the normal cone half angle, -1 for emitters facing every direction
+        float       power      = 0.0f;
+        bool        isInfinite = false;         // environment lights have no bounds and are never put in the bvh
+    };
+
+    struct LightBvhNode
+    {
+        math::vec3f boundsMin;
+        math::vec3f boundsMax;
+        math::vec3f axis;
+        float       cosTheta;
+        float       power;
+        int         children[2]; // -1 for leaves
+        int         parent;      // -1 for the root
+        int         light;       // light index for leaves
+    };
+
+    // Picks the light used for next event estimation.
+    // The alias table selects lights proportionally to their power. With the bvh the infinite lights keep their power
+    // proportional probability, while the finite ones are selected by walking the bvh with an importance which accounts
+    // for distance and orientation to the shading point.
+    struct LightSelection
+    {
+        AliasData*    aliasTable      = nullptr; // pdf holds the power proportional selection probability
+        LightBvhNode* bvhNodes        = nullptr;
+        int*          lightToLeaf     = nullptr; // bvh leaf of every light, -1 for infinite lights
+        int*          infiniteLights  = nullptr;
+        int           numLights       = 0;
+        int           numBvhNodes     = 0;
+        int           numInfiniteLights = 0;
+        float         infiniteProbability = 0.0f; // sum of the alias pdfs of the infinite lights
+        bool          useBvh          = false;
+    };
+
+    namespace lightSelection
+    {
+        // Same construction as the environment alias map, the partition buffer must hold count elements
+        __inline__ __both__ float buildAliasTable(const float* weights, const int count, AliasData* table, unsigned* partition)
+        {
+            float sum = 0.0f;
+            for (int i = 0; i < count; ++i)
+            {
+                sum += weights[i];
+            }
+            for (int i = 0; i < count; ++i)
+            {
+                // Without any power the lights are selected uniformly
+                table[i].pdf = sum > 0.0f ? weights[i] / sum : 1.0f / (float)count;
+                table[i].q = (float)count * table[i].pdf;
+                table[i].alias = i;
+            }
+
+            unsigned small = 0u;
+            unsigned large = count;
+            for (int i = 0; i < count; ++i)
+            {
+                partition[(table[i].q < 1.0f) ? (small++) : (--large)] = i;
+            }
+            for (small = 0; small < large && large < (unsigned)count; ++small)
+            {
+                const unsigned j = partition[small];
+                const unsigned k = partition[large];
+                table[j].alias = k;
+                table[k].q += table[j].q - 1.0f;
+                large = (table[k].q < 1.0f) ? (large + 1u) : large;
+            }
+            return sum;
+        }
+
+        __inline__ __both__ int sampleAliasTable(const AliasData* table, const int count, const float u, float* pdf)
+        {
+            const float scaled = u * (float)count;
+            const int   index  = math::min<int>((int)scaled, count - 1);
+            const float v      = scaled - (float)index;
+            const int   light  = (v < table[index].q) ? index : (int)table[index].alias;
+            *pdf = table[light].pdf;
+            return light;
+        }
+
+        __inline__ __both__ math::vec3f rotate(const math::vec3f& v, const math::vec3f& axis, const float angle)
+        {
+            const float s = sinf(angle);
+            const float c = cosf(angle);
+            return v * c + cross(axis, v) * s + axis * (dot(axis, v) * (1.0f - c));
+        }
+
+        __inline__ __both__ float angleBetween(const math::vec3f& a, const math::vec3f& b)
+        {
+            return acosf(fminf(fmaxf(dot(a, b), -1.0f), 1.0f));
+        }
+
+        // Smallest cone (approximately) bounding the two normal cones
+        __inline__ __both__ void unionCones(const math::vec3f& axisA, const float cosA, const math::vec3f& axisB, const float cosB, math::vec3f& axis, float& cosTheta)
+        {
+            if (cosA <= -1.0f || cosB <= -1.0f)
+            {
+                axis = axisA;
+                cosTheta = -1.0f;
+                return;
+            }
+            const float thetaA = acosf(fminf(cosA, 1.0f));
+            const float thetaB = acosf(fminf(cosB, 1.0f));
+            const float thetaD = angleBetween(axisA, axisB);
+            if (fminf(thetaD + thetaB, (float)M_PI) <= thetaA)
+            {
+                axis = axisA;
+                cosTheta = cosA;
+                return;
+            }
+            if (fminf(thetaD + thetaA, (float)M_PI) <= thetaB)
+            {
+                axis = axisB;
+                cosTheta = cosB;
+                return;
+            }
+            const float thetaO = (thetaA + thetaD + thetaB) * 0.5f;
+            const math::vec3f rotationAxis = cross(axisA, axisB);
+            if (thetaO >= (float)M_PI || dot(rotationAxis, rotationAxis) <= 0.0f)
+            {
+                axis = axisA;
+                cosTheta = -1.0f;
+                return;
+            }
+            axis = math::normalize(rotate(axisA, math::normalize(rotationAxis), thetaO - thetaA));
+            cosTheta = cosf(thetaO);
+        }
+
+        // Upper bound of the contribution of the emitters in the bounds to the point
+        __inline__ __both__ float importance(const math::vec3f& boundsMin, const math::vec3f& boundsMax, const math::vec3f& axis, const float cosTheta, const float power, const math::vec3f& point)
+        {
+            if (power <= 0.0f)
+            {
+                return 0.0f;
+            }
+            const math::vec3f center     = (boundsMin + boundsMax) * 0.5f;
+            const math::vec3f toPoint    = point - center;
+            const float       radius     = math::length(boundsMax - boundsMin) * 0.5f;
+            const float       distance2  = dot(toPoint, toPoint);
+            // Clamp the distance to the bounds size so that points inside or close to the emitters don't blow up
+            const float       clamped2   = fmaxf(distance2, radius * radius);
+            if (cosTheta <= -1.0f || distance2 <= radius * radius)
+            {
+                return power / clamped2;
+            }
+
+            const float distance = sqrtf(distance2);
+            const float cosW     = dot(axis, toPoint) / distance;
+            const float thetaW   = acosf(fminf(fmaxf(cosW, -1.0f), 1.0f));
+            const float thetaO   = acosf(fminf(cosTheta, 1.0f));
+            const float thetaB   = asinf(fminf(radius / distance, 1.0f));
+            const float theta    = fmaxf(thetaW - thetaO - thetaB, 0.0f);
+            if (theta >= (float)M_PI * 0.5f)
+            {
+                return 0.0f;
+            }
+            return power * cosf(theta) / clamped2;
+        }
+
+        __inline__ __both__ float nodeImportance(const LightBvhNode& node, const math::vec3f& point)
+        {
+            return importance(node.boundsMin, node.boundsMax, node.axis, node.cosTheta, node.power, point);
+        }
+
+        // Probability of descending in the first child, falls back to the power ratio when the point can't be reached
+        __inline__ __both__ float firstChildProbability(const LightSelection& selection, const LightBvhNode& node, const math::vec3f& point)
+        {
+            const LightBvhNode& first  = selection.bvhNodes[node.children[0]];
+            const LightBvhNode& second = selection.bvhNodes[node.children[1]];
+            const float         i0     = nodeImportance(first, point);
+            const float         i1     = nodeImportance(second, point);
+            if (i0 + i1 > 0.0f)
+            {
+                return i0 / (i0 + i1);
+            }
+            return (first.power + second.power) > 0.0f ? first.power / (first.power + second.power) : 0.5f;
+        }
+
+        __inline__ __both__ float centroid(const LightBounds& light, const int axis)
+        {
+            return (light.boundsMin[axis] + light.boundsMax[axis]) * 0.5f;
+        }
+
+        // Partial sort so that order[middle] is the median along the axis, with no element before it greater than it
+        __inline__ __both__ void nthElement(int* order, int begin, int end, const int middle, const LightBounds* lights, const int axis)
+        {
+            while (end - begin > 1)
+            {
+                const float pivot = centroid(lights[order[(begin + end) / 2]], axis);
+                int         i     = begin;
+                int         j     = end - 1;
+                while (i <= j)
+                {
+                    while (centroid(lights[order[i]], axis) < pivot) ++i;
+                    while (centroid(lights[order[j]], axis) > pivot) --j;
+                    if (i <= j)
+                    {
+                        const int tmp = order[i];
+                        order[i] = order[j];
+                        order[j] = tmp;
+                        ++i;
+                        --j;
+                    }
+                }
+                if (middle <= j)
+                {
+                    end = j + 1;
+                }
+                else if (middle >= i)
+                {
+                    begin = i;
+                }
+                else
+                {
+                    return;
+                }
+            }
+        }
+
+        // Builds the bvh over the finite lights listed in order, nodes needs room for 2 * count - 1 elements.
+        // Leaves hold a single light, internal nodes split at the centroid median along the largest axis.
+        // Returns the number of nodes.
+        __inline__ __both__ int buildBvh(const LightBounds* lights, int* order, const int count, LightBvhNode* nodes, int* lightToLeaf)
+        {
+            if (count == 0)
+            {
+                return 0;
+            }
+
+            struct Task
+            {
+                int begin;
+                int end;
+                int node;
+            };
+            Task stack[64];
+            int  stackSize = 0;
+            int  numNodes  = 1;
+            nodes[0].parent = -1;
+            stack[stackSize++] = { 0, count, 0 };
+
+            // Top down pass: split the ranges and link the nodes
+            while (stackSize > 0)
+            {
+                const Task    task = stack[--stackSize];
+                LightBvhNode& node = nodes[task.node];
+                if (task.end - task.begin == 1)
+                {
+                    const LightBounds& light = lights[order[task.begin]];
+                    node.boundsMin   = light.boundsMin;
+                    node.boundsMax   = light.boundsMax;
+                    node.axis        = light.axis;
+                    node.cosTheta    = light.cosTheta;
+                    node.power       = light.power;
+                    node.children[0] = -1;
+                    node.children[1] = -1;
+                    node.light       = order[task.begin];
+                    lightToLeaf[node.light] = task.node;
+                    continue;
+                }
+
+                math::vec3f centroidMin(FLT_MAX);
+                math::vec3f centroidMax(-FLT_MAX);
+                for (int i = task.begin; i < task.end; ++i)
+                {
+                    for (int a = 0; a < 3; ++a)
+                    {
+                        centroidMin[a] = fminf(centroidMin[a], centroid(lights[order[i]], a));
+                        centroidMax[a] = fmaxf(centroidMax[a], centroid(lights[order[i]], a));
+                    }
+                }
+                const math::vec3f extent = centroidMax - centroidMin;
+                const int         axis   = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : (extent.y >= extent.z ? 1 : 2);
+                const int         middle = (task.begin + task.end) / 2;
+                nthElement(order, task.begin, task.end, middle, lights, axis);
+
+                node.light       = -1;
+                node.children[0] = numNodes++;
+                node.children[1] = numNodes++;
+                nodes[node.children[0]].parent = task.node;
+                nodes[node.children[1]].parent = task.node;
+                // Median splits keep the depth at log2(count), far from the stack size
+                stack[stackSize++] = { task.begin, middle, node.children[0] };
+                stack[stackSize++] = { middle, task.end, node.children[1] };
+            }
+
+            // Bottom up pass: children always come after their parent
+            for (int n = numNodes - 1; n >= 0; --n)
+            {
+                LightBvhNode& node = nodes[n];
+                if (node.children[0] < 0)
+                {
+                    continue;
+                }
+                const LightBvhNode& a = nodes[node.children[0]];
+                const LightBvhNode& b = nodes[node.children[1]];
+                for (int i = 0; i < 3; ++i)
+                {
+                    node.boundsMin[i] = fminf(a.boundsMin[i], b.boundsMin[i]);
+                    node.boundsMax[i] = fmaxf(a.boundsMax[i], b.boundsMax[i]);
+                }
+                node.power = a.power + b.power;
+                if (a.power <= 0.0f)
+                {
+                    node.axis = b.axis;
+                    node.cosTheta = b.cosTheta;
+                }
+                else if (b.power <= 0.0f)
+                {
+                    node.axis = a.axis;
+                    node.cosTheta = a.cosTheta;
+                }
+                else
+                {
+                    unionCones(a.axis, a.cosTheta, b.axis, b.cosTheta, node.axis, node.cosTheta);
+                }
+            }
+            return numNodes;
+        }
+
+        // Returns the selected light index and its probability, -1 if there are no lights
+        __inline__ __both__ int sample(const LightSelection& selection, const math::vec3f& point, float u, float* pdf)
+        {
+            *pdf = 0.0f;
+            if (selection.numLights == 0)
+            {
+                return -1;
+            }
+            if (!selection.useBvh || selection.numBvhNodes == 0)
+            {
+                return sampleAliasTable(selection.aliasTable, selection.numLights, u, pdf);
+            }
+
+            if (u < selection.infiniteProbability)
+            {
+                // Infinite lights keep their power proportional probability
+                float cumulated = 0.0f;
+                for (int i = 0; i < selection.numInfiniteLights; ++i)
+                {
+                    const int light = selection.infiniteLights[i];
+                    cumulated += selection.aliasTable[light].pdf;
+                    if (u < cumulated || i == selection.numInfiniteLights - 1)
+                    {
+                        *pdf = selection.aliasTable[light].pdf;
+                        return light;
+                    }
+                }
+            }
+
+            float probability = 1.0f - selection.infiniteProbability;
+            u = fminf((u - selection.infiniteProbability) / probability, 0.99999994f);
+            int nodeIndex = 0;
+            while (selection.bvhNodes[nodeIndex].children[0] >= 0)
+            {
+                const LightBvhNode& node = selection.bvhNodes[nodeIndex];
+                const float         p0   = firstChildProbability(selection, node, point);
+                if (u < p0)
+                {
+                    u = fminf(u / p0, 0.99999994f);
+                    probability *= p0;
+                    nodeIndex = node.children[0];
+                }
+                else
+                {
+                    u = fminf((u - p0) / (1.0f - p0), 0.99999994f);
+                    probability *= 1.0f - p0;
+                    nodeIndex = node.children[1];
+                }
+            }
+            *pdf = probability;
+            return selection.bvhNodes[nodeIndex].light;
+        }
+
+        // Probability that sample() returns the light for the point
+        __inline__ __both__ float pdf(const LightSelection& selection, const math::vec3f& point, const int light)
+        {
+            if (light < 0 || light >= selection.numLights)
+            {
+                return 0.0f;
+            }
+            if (!selection.useBvh || selection.numBvhNodes == 0)
+            {
+                return selection.aliasTable[light].pdf;
+            }
+            int nodeIndex = selection.lightToLeaf[light];
+            if (nodeIndex < 0)
+            {
+                return selection.aliasTable[light].pdf;
+            }
+
+            float probability = 1.0f - selection.infiniteProbability;
+            while (selection.bvhNodes[nodeIndex].parent >= 0)
+            {
+                const int           parentIndex = selection.bvhNodes[nodeIndex].parent;
+                const LightBvhNode& parent      = selection.bvhNodes[parentIndex];
+                const float         p0          = firstChildProbability(selection, parent, point);
+                probability *= (parent.children[0] == nodeIndex) ? p0 : 1.0f - p0;
+                nodeIndex = parentIndex;
+            }
+            return probability;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef MESH_LIGHT_SAMPLING_H
+#define MESH_LIGHT_SAMPLING_H
+#pragma once
+
+#include "Core/Math.h"
+
+namespace vtx
+{
+    // The emissive triangles of a mesh material slot are selected from an alias table built once from their object space
+    // areas and shared by all the instances of the mesh. The instance transform only enters through the area of the
+    // selected triangle, so the pdf stays exact under non-uniform scale.
+    namespace meshLightSampling
+    {
+        __inline__ __both__ float triangleArea(const math::vec3f& v0, const math::vec3f& v1, const math::vec3f& v2)
+        {
+            return 0.5f * math::length(cross(v1 - v0, v2 - v0));
+        }
+
+        __inline__ __both__ float worldTriangleArea(const math::affine3f& transform, const math::vec3f& v0, const math::vec3f& v1, const math::vec3f& v2)
+        {
+            const math::vec3f e0 = math::transformVector3F(transform, v1 - v0);
+            const math::vec3f e1 = math::transformVector3F(transform, v2 - v0);
+            return 0.5f * math::length(cross(e0, e1));
+        }
+
+        // Pdf per unit of world area of a point sampled uniformly on a triangle selected proportionally to its object space area.
+        // With a rigid or uniformly scaled transform this reduces to one over the world area of the light.
+        __inline__ __both__ float areaPdf(const float objectArea, const float objectTotalArea, const float worldArea)
+        {
+            if (!(objectTotalArea > 0.0f) || !(worldArea > 0.0f))
+            {
+                return 0.0f;
+            }
+            return objectArea / (objectTotalArea * worldArea);
+        }
+
+        // Scale of the areas if the linear part of the transform is a rotation times a uniform scale, -1 otherwise
+        __inline__ __both__ float uniformAreaScale(const math::affine3f& transform, const float tolerance = 1e-4f)
+        {
+            const math::vec3f x = math::transformVector3F(transform, math::vec3f(1.0f, 0.0f, 0.0f));
+            const math::vec3f y = math::transformVector3F(transform, math::vec3f(0.0f, 1.0f, 0.0f));
+            const math::vec3f z = math::transformVector3F(transform, math::vec3f(0.0f, 0.0f, 1.0f));
+            const float       scale2 = dot(x, x);
+            if (fabsf(dot(y, y) - scale2) > tolerance * scale2 || fabsf(dot(z, z) - scale2) > tolerance * scale2 ||
+                fabsf(dot(x, y)) > tolerance * scale2 || fabsf(dot(x, z)) > tolerance * scale2 || fabsf(dot(y, z)) > tolerance * scale2)
+            {
+                return -1.0f;
+            }
+            return scale2;
+        }
+    }
+}
+
+#endif
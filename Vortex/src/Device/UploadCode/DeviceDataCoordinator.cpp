@@ -1,6 +1,7 @@
 ﻿#include "DeviceDataCoordinator.h"
 
 #include "UploadFunctions.h"
+#include "Core/Options.h"
 #include "Device/OptixWrapper.h"
 #include "Scene/Graph.h"
 #include "Scene/Scene.h"
@@ -17,46 +18,25 @@ namespace vtx::device
 	{
 		cleanDeletedNodes();
 
-		std::shared_ptr<graph::SceneIndexManager> sim = graph::Scene::getSim();
-		const std::vector<std::shared_ptr<graph::Mesh>>             meshes            = sim->getAllNodeOfType<graph::Mesh>(graph::NT_MESH);
-		for (const std::shared_ptr<graph::Mesh>& mesh : meshes)
+		// Only the nodes listed in the change journal are visited, new nodes are listed when they are recorded
+		syncCounters = {};
+		syncChangedNodes<graph::Mesh>(graph::NT_MESH);
+		syncChangedNodes<graph::Texture>(graph::NT_MDL_TEXTURE);
+		syncChangedNodes<graph::BsdfMeasurement>(graph::NT_MDL_BSDF);
+		syncChangedNodes<graph::LightProfile>(graph::NT_MDL_LIGHTPROFILE);
+		for (int type = graph::NT_SHADER_DF; type <= graph::NT_PRINCIPLED_MATERIAL; ++type)
 		{
-			syncNode(mesh);
+			markOwnersOfChangedNodes(static_cast<graph::NodeType>(type), materialOfShaderGraph);
 		}
-		const std::vector<std::shared_ptr<graph::Texture>>          textures = sim->getAllNodeOfType<graph::Texture>(graph::NT_MDL_TEXTURE);
-		for (const std::shared_ptr<graph::Texture>& texture : textures)
+		syncChangedNodes<graph::Material>(graph::NT_MATERIAL);
+		syncChangedNodes<graph::MeshLight>(graph::NT_MESH_LIGHT);
+		markOwnersOfChangedNodes(graph::NT_TRANSFORM, instanceOfTransform);
+		syncChangedNodes<graph::Instance>(graph::NT_INSTANCE);
+		syncChangedNodes<graph::EnvironmentLight>(graph::NT_ENV_LIGHT);
+		// The camera and the renderer are checked directly, groups and plain lights have no device data
+		for (const graph::NodeType type : { graph::NT_GROUP, graph::NT_LIGHT, graph::NT_CAMERA, graph::NT_RENDERER })
 		{
-			syncNode(texture);
-		}
-		const std::vector<std::shared_ptr<graph::BsdfMeasurement>>  bsdfMeasurements = sim->getAllNodeOfType<graph::BsdfMeasurement>(graph::NT_MDL_BSDF);
-		for (const std::shared_ptr<graph::BsdfMeasurement>& bsdfMeasurement : bsdfMeasurements)
-		{
-			syncNode(bsdfMeasurement);
-		}
-		const std::vector<std::shared_ptr<graph::LightProfile>>     lightProfiles = sim->getAllNodeOfType<graph::LightProfile>(graph::NT_MDL_LIGHTPROFILE);
-		for (const std::shared_ptr<graph::LightProfile>& lightProfile : lightProfiles)
-		{
-			syncNode(lightProfile);
-		}
-		const std::vector<std::shared_ptr<graph::Material>>         materials = sim->getAllNodeOfType<graph::Material>(graph::NT_MATERIAL);
-		for (const std::shared_ptr<graph::Material>& material : materials)
-		{
-			syncNode(material);
-		}
-		const std::vector<std::shared_ptr<graph::MeshLight>>        meshLights = sim->getAllNodeOfType<graph::MeshLight>(graph::NT_MESH_LIGHT);
-		for (const std::shared_ptr<graph::MeshLight>& meshLight : meshLights)
-		{
-			syncNode(meshLight);
-		}
-		const std::vector<std::shared_ptr<graph::Instance>>         instances = sim->getAllNodeOfType<graph::Instance>(graph::NT_INSTANCE);
-		for (const std::shared_ptr<graph::Instance>& instance : instances)
-		{
-			syncNode(instance);
-		}
-		const std::vector<std::shared_ptr<graph::EnvironmentLight>> environmentLights = sim->getAllNodeOfType<graph::EnvironmentLight>(graph::NT_ENV_LIGHT);
-		for (const std::shared_ptr<graph::EnvironmentLight>& environmentLight : environmentLights)
-		{
-			syncNode(environmentLight);
+			graph::Scene::getSim()->takeChangedNodes(type);
 		}
 		const std::shared_ptr<graph::Renderer> renderer = graph::Scene::get()->renderer;
 		const std::shared_ptr<graph::Camera>   camera   = renderer->camera;
@@ -66,11 +46,38 @@ namespace vtx::device
 		finalize();
 	}
 
-	void DeviceDataCoordinator::syncNode(const std::shared_ptr<graph::Instance>& instance)
+	void DeviceDataCoordinator::markOwnersOfChangedNodes(const graph::NodeType type, std::map<vtxID, vtxID>& ownerOfNode)
+	{
+		const std::shared_ptr<graph::SceneIndexManager> sim = graph::Scene::getSim();
+		for (const vtxID id : sim->takeChangedNodes(type))
+		{
+			const auto it = ownerOfNode.find(id);
+			if (it == ownerOfNode.end())
+			{
+				continue;
+			}
+			if (const std::shared_ptr<graph::Node> owner = (*sim)[it->second])
+			{
+				owner->markChanged();
+			}
+			else
+			{
+				ownerOfNode.erase(it);
+			}
+		}
+	}
+
+	bool DeviceDataCoordinator::syncNode(const std::shared_ptr<graph::Instance>& instance)
 	{
 		// If the child node is a mesh, then it's leaf therefore we can safely create the instance.
 		// This supposes that child and transform are traversed before the instance visitor is accepted.
-		if (const std::shared_ptr<graph::Mesh> meshNode = std::dynamic_pointer_cast<graph::Mesh>(instance->getChild())) {
+		if (const std::shared_ptr<graph::Mesh> meshNode = graph::nodeCast<graph::Mesh>(instance->getChild())) {
+			if (!geometryDataMap.contains(meshNode->getUID()))
+			{
+				// The mesh is still being prepared, the instance is created once its geometry is uploaded
+				return false;
+			}
+			instanceOfTransform[instance->transform->getUID()] = instance->getUID();
 			// TODO Check if meshes or material have been changed
 			if (const vtxID instanceId = instance->getUID();
 				!instanceDataMap.contains(instance->getTypeID())
@@ -99,6 +106,7 @@ namespace vtx::device
 			}
 		}
 		//popTransform();
+		return true;
 	}
 
 	void DeviceDataCoordinator::syncNode(const std::shared_ptr<graph::Transform>& transform)
@@ -109,8 +117,12 @@ namespace vtx::device
 	{
 	}
 
-	void DeviceDataCoordinator::syncNode(const std::shared_ptr<graph::Mesh>& mesh)
+	bool DeviceDataCoordinator::syncNode(const std::shared_ptr<graph::Mesh>& mesh)
 	{
+		if (!mesh->isReady())
+		{
+			return false;
+		}
 		//TODO : Check if the mesh has been updated
 		if (const vtxID meshId = mesh->getUID();
 			!geometryDataMap.contains(meshId)
@@ -127,10 +139,12 @@ namespace vtx::device
 			launchParamsData.editableHostImage().topObject = 0;
 			mesh->state.updateOnDevice = false;
 		}
+		return true;
 	}
 
-	void DeviceDataCoordinator::syncNode(const std::shared_ptr<graph::Material>& material)
+	bool DeviceDataCoordinator::syncNode(const std::shared_ptr<graph::Material>& material)
 	{
+		materialOfShaderGraph[material->materialGraph->getUID()] = material->getUID();
 		//TODO : Check if the texture has been updated
 		if (const vtxID materialId = material->getUID();
 			!materialDataMap.contains(materialId) ||
@@ -143,6 +157,7 @@ namespace vtx::device
 			material->materialGraph->resetIsShaderArgBlockUpdated();
 			ops::restartRender();
 		}
+		return true;
 	}
 
 	void DeviceDataCoordinator::syncNode(const std::shared_ptr<graph::Camera>& camera)
@@ -159,35 +174,42 @@ namespace vtx::device
 		setRendererData(renderer);
 	}
 
-	void DeviceDataCoordinator::syncNode(const std::shared_ptr<graph::Texture>& textureNode)
+	bool DeviceDataCoordinator::syncNode(const std::shared_ptr<graph::Texture>& textureNode)
 	{
 		//TODO : Check if the texture has been updated
 		if (const vtxID textureId = textureNode->getUID(); !textureDataMap.contains(textureId)) {
 			const TextureData textureData = createTextureData(textureNode);
 			textureDataMap.insert(textureNode->getUID(), textureData);
 		}
+		return true;
 	}
 
-	void DeviceDataCoordinator::syncNode(const std::shared_ptr<graph::BsdfMeasurement>& bsdfMeasurementNode)
+	bool DeviceDataCoordinator::syncNode(const std::shared_ptr<graph::BsdfMeasurement>& bsdfMeasurementNode)
 	{
 		///TODO : Check if the texture has been updated
 		if (const vtxID bsdfId = bsdfMeasurementNode->getUID(); !bsdfDataMap.contains(bsdfId)) {
 			const BsdfData bsdfData = createBsdfData(bsdfMeasurementNode);
 			bsdfDataMap.insert(bsdfId, bsdfData);
 		}
+		return true;
 	}
 
-	void DeviceDataCoordinator::syncNode(const std::shared_ptr<graph::LightProfile>& lightProfile)
+	bool DeviceDataCoordinator::syncNode(const std::shared_ptr<graph::LightProfile>& lightProfile)
 	{
 		///TODO : Check if the light Profile has been updated
 		if (const vtxID lightProfileId = lightProfile->getUID(); !lightProfileDataMap.contains(lightProfileId)) {
 			const LightProfileData lightProfileData = createLightProfileData(lightProfile);
 			lightProfileDataMap.insert(lightProfileId, lightProfileData);
 		}
+		return true;
 	}
 
-	void DeviceDataCoordinator::syncNode(const std::shared_ptr<graph::MeshLight>& meshLight)
+	bool DeviceDataCoordinator::syncNode(const std::shared_ptr<graph::MeshLight>& meshLight)
 	{
+		if (!geometryDataMap.contains(meshLight->mesh->getUID()))
+		{
+			return false;
+		}
 		//TODO : Check if the mesh has been updated
 		if (const vtxID lightId = meshLight->getUID(); !lightDataMap.contains(lightId)) {
 			LightData lightData = createMeshLightData(meshLight);
@@ -204,9 +226,10 @@ namespace vtx::device
 				lightDataMap.insert(lightId, lightData);
 			}
 		}
+		return true;
 	}
 
-	void DeviceDataCoordinator::syncNode(const std::shared_ptr<graph::EnvironmentLight>& envLight)
+	bool DeviceDataCoordinator::syncNode(const std::shared_ptr<graph::EnvironmentLight>& envLight)
 	{
 		//TODO : Check if the mesh has been updated
 		if (const vtxID lightId = envLight->getUID(); !lightDataMap.contains(lightId)) {
@@ -216,6 +239,7 @@ namespace vtx::device
 			lightDataMap.insert(lightId, lightData);
 			launchParamsData.editableHostImage().envLight = lightDataMap[lightId].getDeviceImage();
 		}
+		return true;
 	}
 	void DeviceDataCoordinator::cleanDeletedNodes()
 	{
@@ -228,9 +252,23 @@ namespace vtx::device
 		cleanDeletedNodeOfType(lightDataMap, graph::NT_MESH_LIGHT);
 		cleanDeletedNodeOfType(lightDataMap, graph::NT_ENV_LIGHT);
 		cleanDeletedNodeOfType(instanceDataMap, graph::NT_INSTANCE);
+
+		// Node types without device data, their deleted lists would otherwise grow with every released scene
+		const std::shared_ptr<graph::SceneIndexManager> sim = graph::Scene::getSim();
+		for (const graph::NodeType type : { graph::NT_GROUP, graph::NT_TRANSFORM, graph::NT_CAMERA, graph::NT_RENDERER })
+		{
+			sim->cleanDeletedNodesByType(type);
+		}
+		for (int type = graph::NT_SHADER_DF; type <= graph::NT_PRINCIPLED_MATERIAL; ++type)
+		{
+			sim->cleanDeletedNodesByType(static_cast<graph::NodeType>(type));
+		}
 	}
 	void DeviceDataCoordinator::finalize()
 	{
+		// The light bounds are in world space and the power depends on the material, moved instances and edited
+		// materials change the selection as well as added or removed lights
+		const bool isLightSelectionChanged = lightDataMap.isMapChanged || instanceDataMap.isMapChanged || materialDataMap.isMapChanged;
 		if (instanceDataMap.isMapChanged && instanceDataMap.size() != 0)
 		{
 			std::vector<InstanceData*> instances;
@@ -257,17 +295,27 @@ namespace vtx::device
 			launchParamsData.editableHostImage().instances = launchParamsData.resourceBuffers.instancesBuffer.upload(instances);
 			instanceDataMap.isMapChanged = false;
 		}
-		if (lightDataMap.isMapChanged && lightDataMap.size() != 0)
+		if (isLightSelectionChanged && lightDataMap.size() != 0)
 		{
-			std::vector<LightData*> lightData;
+			std::vector<LightData*>  lightData;
+			std::vector<LightBounds> lightBounds;
 			for (vtxID lightID : lightDataMap)
 			{
-				if (lightDataMap[lightID].getHostImage().use) // we only add the lights that are marked as lights
+				LightData& light = lightDataMap[lightID].editableHostImage();
+				if (light.use) // we only add the lights that are marked as lights
+				{
+					// The index lets implicit light hits recover their selection probability
+					light.selectionIndex = (int)lightData.size();
+					lightBounds.push_back(createLightBounds(lightID, light.type));
+					lightData.push_back(lightDataMap[lightID].getDeviceImage());
+				}
+				else
 				{
-					LightData* light = lightDataMap[lightID].getDeviceImage();
-					lightData.push_back(light);
+					light.selectionIndex = -1;
+					lightDataMap[lightID].getDeviceImage();
 				}
 			}
+			launchParamsData.editableHostImage().lightSelection = createLightSelection(lightBounds, getOptions()->lightSelectionBvh);
 			if(!lightData.empty())
 			{
 				launchParamsData.editableHostImage().lights = launchParamsData.resourceBuffers.lightsDataBuffer.upload(lightData);
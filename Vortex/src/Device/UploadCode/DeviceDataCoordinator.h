@@ -44,18 +44,57 @@ namespace vtx::device
 
 		void sync();
 
-		void syncNode(const std::shared_ptr<graph::Instance>& instance);
+		// The nodes synchronized from the change journal return false if they have to be synchronized again on the next frame
+		bool syncNode(const std::shared_ptr<graph::Instance>& instance);
 		void syncNode(const std::shared_ptr<graph::Transform>& transform);
 		void syncNode(const std::shared_ptr<graph::Group>& group);
-		void syncNode(const std::shared_ptr<graph::Mesh>& mesh);
-		void syncNode(const std::shared_ptr<graph::Material>& material);
+		bool syncNode(const std::shared_ptr<graph::Mesh>& mesh);
+		bool syncNode(const std::shared_ptr<graph::Material>& material);
 		void syncNode(const std::shared_ptr<graph::Camera>& camera);
 		void syncNode(const std::shared_ptr<graph::Renderer>& renderer);
-		void syncNode(const std::shared_ptr<graph::Texture>& textureNode);
-		void syncNode(const std::shared_ptr<graph::BsdfMeasurement>& bsdfMeasurementNode);
-		void syncNode(const std::shared_ptr<graph::LightProfile>& lightProfile);
-		void syncNode(const std::shared_ptr<graph::MeshLight>& lightNode);
-		void syncNode(const std::shared_ptr<graph::EnvironmentLight>& lightNode);
+		bool syncNode(const std::shared_ptr<graph::Texture>& textureNode);
+		bool syncNode(const std::shared_ptr<graph::BsdfMeasurement>& bsdfMeasurementNode);
+		bool syncNode(const std::shared_ptr<graph::LightProfile>& lightProfile);
+		bool syncNode(const std::shared_ptr<graph::MeshLight>& lightNode);
+		bool syncNode(const std::shared_ptr<graph::EnvironmentLight>& lightNode);
+
+		// Host side work of the last sync, an idle frame visits no node
+		struct SyncCounters
+		{
+			size_t visitedNodes = 0;
+			size_t pendingNodes = 0;
+		};
+
+		// Synchronizes the nodes of the type listed in the scene change journal, nodes which can't be synchronized yet stay listed
+		template <typename T>
+		void syncChangedNodes(const graph::NodeType type)
+		{
+			syncChangedNodes<T>(type, syncCounters, [this](const std::shared_ptr<T>& node) { return syncNode(node); });
+		}
+
+		// Same with the synchronization of a node given by the caller, it returns false if the node has to stay listed
+		template <typename T, typename SyncFunction>
+		static void syncChangedNodes(const graph::NodeType type, SyncCounters& counters, const SyncFunction& syncFunction)
+		{
+			const std::shared_ptr<graph::SceneIndexManager> sim = graph::Scene::getSim();
+			for (const vtxID id : sim->takeChangedNodes(type))
+			{
+				const std::shared_ptr<T> node = sim->getNode<T>(id);
+				if (!node)
+				{
+					continue;
+				}
+				++counters.visitedNodes;
+				if (!syncFunction(node))
+				{
+					++counters.pendingNodes;
+					node->markChanged();
+				}
+			}
+		}
+
+		// Marks the owners of the changed nodes of the type, e.g. the instance of a transform
+		void markOwnersOfChangedNodes(graph::NodeType type, std::map<vtxID, vtxID>& ownerOfNode);
 
 		template <typename T, typename B>
 		void cleanDeletedNodeOfType(DeviceDataMap<T, B>& dataMap, graph::NodeType type)
@@ -79,6 +118,13 @@ namespace vtx::device
 				{
 					launchParamsData.editableHostImage().envLight = nullptr;
 				}
+				if ((type) == graph::NT_MESH)
+				{
+					for (auto it = emissiveTriangleBuffers.begin(); it != emissiveTriangleBuffers.end();)
+					{
+						it = (it->first.first == id) ? emissiveTriangleBuffers.erase(it) : std::next(it);
+					}
+				}
 			}
 			graph::Scene::getSim()->cleanDeletedNodesByType(type);
 		}
@@ -97,6 +143,13 @@ namespace vtx::device
 		DeviceDataMap<BsdfData, BsdfBuffers>                 bsdfDataMap;
 		DeviceDataMap<LightProfileData, LightProfileBuffers> lightProfileDataMap;
 		DeviceDataMap<LightData, LightBuffers>               lightDataMap;
+		// Keyed by mesh and material slot
+		std::map<std::pair<vtxID, unsigned int>, EmissiveTriangleBuffers> emissiveTriangleBuffers;
+		// Changes of these nodes are synchronized through the node owning them, both are filled when the owner is synchronized
+		std::map<vtxID, vtxID>                               instanceOfTransform;
+		std::map<vtxID, vtxID>                               materialOfShaderGraph;
+
+		SyncCounters syncCounters;
 
 		// The following data currently does not need a map
 		// However if we want to support multiple renderers (Viewports) these should be unique to each viewport, we can map them by rendererID
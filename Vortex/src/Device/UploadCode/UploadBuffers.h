@@ -382,14 +382,24 @@ namespace vtx::device
 		}
 	};
 
-	struct LightBuffers
+	// Alias table of the emissive triangles of a mesh slot, shared by the mesh lights of all its instances
+	struct EmissiveTriangleBuffers
 	{
-		////////////////////////////////////////
-		//////////// Mesh Light ////////////////
-		////////////////////////////////////////
-		CUDABuffer areaCdfBuffer;
-		CUDABuffer actualTriangleIndices;
+		CUDABuffer aliasBuffer;
+		CUDABuffer triangleIndicesBuffer;
+
+		EmissiveTriangleBuffers() = default;
+
+		~EmissiveTriangleBuffers()
+		{
+			VTX_INFO("ShutDown: Emissive Triangle Buffers");
+			aliasBuffer.free();
+			triangleIndicesBuffer.free();
+		}
+	};
 
+	struct LightBuffers
+	{
 		////////////////////////////////////////
 		//////////// Env Light /////////////////
 		////////////////////////////////////////
@@ -408,8 +418,6 @@ namespace vtx::device
 		~LightBuffers()
 		{
 			VTX_INFO("ShutDown: Light Buffers");
-			areaCdfBuffer.free();
-			actualTriangleIndices.free();
 			attributeBuffer.free();
 			cdfUBuffer.free();
 			cdfVBuffer.free();
@@ -447,6 +455,10 @@ namespace vtx::device
 		CUDABuffer                               lightsDataBuffer;
 		CUDABuffer                               instancesBuffer;
 		CUDABuffer                               toneMapperSettingsBuffer;
+		CUDABuffer                               lightAliasBuffer;
+		CUDABuffer                               lightBvhBuffer;
+		CUDABuffer                               lightToLeafBuffer;
+		CUDABuffer                               infiniteLightsBuffer;
 	};
 
 	struct Buffers
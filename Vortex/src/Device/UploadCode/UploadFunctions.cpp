@@ -10,6 +10,8 @@
 #include "MDL/CudaLinker.h"
 #include "NeuralNetworks/Interface/NetworkInterface.h"
 #include "UploadBuffers.h"
+#include "Scene/Utility/Operations.h"
+#include <cfloat>
 
 namespace vtx::device
 {
@@ -54,7 +56,7 @@ namespace vtx::device
 					slotIds.material = materialDataMap[materialId].getDeviceImage();
 
 					if (vtxID lightId = materialSlot.meshLight->getUID(); lightDataMap.contains(lightId)) {
-						instanceData.hasEmission = std::dynamic_pointer_cast<graph::Material>(materialSlot.material)->useEmission();
+						instanceData.hasEmission = materialSlot.material->useEmission();
 						slotIds.meshLight = lightDataMap[lightId].getDeviceImage();
 					}
 
@@ -95,28 +97,36 @@ namespace vtx::device
 		LightData lightData;
 		MeshLightAttributesData meshLightData;
 
-		CUDABuffer& areaCdfBuffer = onDeviceData->lightDataMap.getResourceBuffers(meshLight->getUID()).areaCdfBuffer;
-		areaCdfBuffer.upload(meshLight->cdfAreas);
-
-		CUDABuffer& actualTriangleIndices = onDeviceData->lightDataMap.getResourceBuffers(meshLight->getUID()).actualTriangleIndices;
-		actualTriangleIndices.upload(meshLight->actualTriangleIndices);
+		// The emissive triangle tables are uploaded once per mesh slot, the mesh lights of all the instances point to them
+		const graph::EmissiveTriangles& emissiveTriangles = *meshLight->emissiveTriangles;
+		EmissiveTriangleBuffers& sharedBuffers = onDeviceData->emissiveTriangleBuffers[{ emissiveTriangles.mesh->getUID(), emissiveTriangles.materialSlot }];
+		if (sharedBuffers.aliasBuffer.bytesSize() == 0)
+		{
+			sharedBuffers.aliasBuffer.upload(emissiveTriangles.aliasMap);
+			sharedBuffers.triangleIndicesBuffer.upload(emissiveTriangles.triangleIndices);
+		}
 
 		vtxID meshId = meshLight->mesh->getUID();
 		vtxID materialId = meshLight->material->getUID();
 		GeometryData* geometryData = onDeviceData->geometryDataMap[meshId].getDeviceImage();
 		MaterialData* materialData = onDeviceData->materialDataMap[materialId].getDeviceImage();
 
+		const vtxID instanceUid = graph::Scene::getSim()->UIDfromTID(graph::NT_INSTANCE, meshLight->parentInstanceId);
+		const math::affine3f& transform = graph::Scene::getSim()->getNode<graph::Instance>(instanceUid)->transform->globalTransform;
+
 		meshLightData.instanceId                        = meshLight->parentInstanceId;
 		meshLightData.geometryData                      = geometryData;
 		meshLightData.materialId                        = materialData;
-		meshLightData.cdfArea                           = areaCdfBuffer.castedPointer<float>();
-		meshLightData.actualTriangleIndices             = actualTriangleIndices.castedPointer<uint32_t>();
-		//std::shared_ptr<graph::Instance> parentInstance = graph::Scene::getSim()->getNode<graph::Instance>(meshLight->parentInstanceId);
-		//std::shared_ptr<graph::Transform> transform     = parentInstance->transform;
-		//math::vec3f translation, scaleVector, eulerAngles;
-		//math::VectorFromAffine<math::LinearSpace3f>(transform->globalTransform, translation, scaleVector, eulerAngles);
-		meshLightData.size                              = meshLight->cdfAreas.size();
-		meshLightData.totalArea                         = meshLight->area;
+		meshLightData.aliasMap                          = sharedBuffers.aliasBuffer.castedPointer<AliasData>();
+		meshLightData.triangleIndices                   = sharedBuffers.triangleIndicesBuffer.castedPointer<uint32_t>();
+		meshLightData.size                              = (int)emissiveTriangles.triangleIndices.size();
+		meshLightData.objectArea                        = emissiveTriangles.area;
+		meshLightData.worldArea                         = emissiveTriangles.computeWorldArea(transform);
+
+		if (getOptions()->validateLightSampling)
+		{
+			meshLight->validateSampling(transform, meshLightData.worldArea);
+		}
 
 		CUDABuffer& attributeBuffer = onDeviceData->lightDataMap.getResourceBuffers(meshLight->getUID()).attributeBuffer;
 		attributeBuffer.upload(meshLightData);
@@ -151,6 +161,144 @@ namespace vtx::device
 		return lightData;
 	}
 
+	LightBounds createLightBounds(const vtxID lightId, const LightType type)
+	{
+		const math::vec3f ntscLuminance{ 0.30f, 0.59f, 0.11f };
+		LightBounds       bounds;
+
+		if (type == L_ENV)
+		{
+			const std::shared_ptr<graph::EnvironmentLight> envLight = graph::Scene::getSim()->getNode<graph::EnvironmentLight>(lightId);
+			// Radiance integrated over the sphere, createLightSelection scales it by the scene cross-section
+			bounds.isInfinite = true;
+			bounds.power      = envLight->invIntegral > 0.0f ? 1.0f / envLight->invIntegral : 0.0f;
+			return bounds;
+		}
+
+		const std::shared_ptr<graph::MeshLight> meshLight = graph::Scene::getSim()->getNode<graph::MeshLight>(lightId);
+		const vtxID instanceUid = graph::Scene::getSim()->UIDfromTID(graph::NT_INSTANCE, meshLight->parentInstanceId);
+		const math::affine3f& transform = graph::Scene::getSim()->getNode<graph::Instance>(instanceUid)->transform->globalTransform;
+		const graph::EmissiveTriangles& emissiveTriangles = *meshLight->emissiveTriangles;
+
+		bounds.boundsMin = math::vec3f(FLT_MAX);
+		bounds.boundsMax = math::vec3f(-FLT_MAX);
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			const math::vec3f p(
+				(corner & 1) ? emissiveTriangles.boundsMax.x : emissiveTriangles.boundsMin.x,
+				(corner & 2) ? emissiveTriangles.boundsMax.y : emissiveTriangles.boundsMin.y,
+				(corner & 4) ? emissiveTriangles.boundsMax.z : emissiveTriangles.boundsMin.z);
+			const math::vec3f world = math::transformPoint3F(transform, p);
+			bounds.boundsMin = min(bounds.boundsMin, world);
+			bounds.boundsMax = max(bounds.boundsMax, world);
+		}
+
+		const graph::Configuration& configuration = meshLight->material->getConfiguration();
+		if (!configuration.useBackfaceEdf)
+		{
+			bounds.axis     = math::normalize(math::transformNormal3F(transform, emissiveTriangles.normalAxis));
+			bounds.cosTheta = emissiveTriangles.normalCosTheta;
+		}
+
+		// Emission driven by textures or expressions is unknown here, such lights are treated as unit intensity
+		const float intensity = configuration.isSurfaceIntensityConstant ? dot(configuration.surfaceIntensity, ntscLuminance) : 1.0f;
+		const float worldArea = emissiveTriangles.computeWorldArea(transform);
+		const bool  isPower   = configuration.isSurfaceIntensityModeConstant && configuration.surfaceIntensityMode != 0;
+		bounds.power          = (float)M_PI * fmaxf(intensity, 0.0f) * (isPower ? 1.0f : worldArea);
+		return bounds;
+	}
+
+	LightSelection HostLightSelection::getHostView()
+	{
+		LightSelection view = selection;
+		view.aliasTable     = aliasTable.empty() ? nullptr : aliasTable.data();
+		view.bvhNodes       = bvhNodes.empty() ? nullptr : bvhNodes.data();
+		view.lightToLeaf    = lightToLeaf.empty() ? nullptr : lightToLeaf.data();
+		view.infiniteLights = infiniteLights.empty() ? nullptr : infiniteLights.data();
+		return view;
+	}
+
+	HostLightSelection buildLightSelection(std::vector<LightBounds>& lights, const bool useBvh)
+	{
+		HostLightSelection host;
+		LightSelection&    selection = host.selection;
+		const int          numLights = (int)lights.size();
+		if (numLights == 0)
+		{
+			return host;
+		}
+
+		// The environment power is its integrated radiance over a disk as big as the scene, the finite lights bounds are
+		// the best estimate of the scene size available here.
+		math::vec3f sceneMin(FLT_MAX);
+		math::vec3f sceneMax(-FLT_MAX);
+		std::vector<int> finiteLights;
+		for (int i = 0; i < numLights; ++i)
+		{
+			if (lights[i].isInfinite)
+			{
+				host.infiniteLights.push_back(i);
+				continue;
+			}
+			finiteLights.push_back(i);
+			sceneMin = min(sceneMin, lights[i].boundsMin);
+			sceneMax = max(sceneMax, lights[i].boundsMax);
+		}
+		const float sceneRadius = finiteLights.empty() ? 1.0f : fmaxf(math::length(sceneMax - sceneMin) * 0.5f, 1e-3f);
+		std::vector<float> power(numLights);
+		for (int i = 0; i < numLights; ++i)
+		{
+			if (lights[i].isInfinite)
+			{
+				lights[i].power *= (float)M_PI * sceneRadius * sceneRadius;
+			}
+			power[i] = lights[i].power;
+		}
+
+		host.aliasTable.resize(numLights);
+		std::vector<unsigned> partition(numLights);
+		lightSelection::buildAliasTable(power.data(), numLights, host.aliasTable.data(), partition.data());
+		selection.numLights = numLights;
+
+		for (const int light : host.infiniteLights)
+		{
+			selection.infiniteProbability += host.aliasTable[light].pdf;
+		}
+		selection.numInfiniteLights = (int)host.infiniteLights.size();
+
+		selection.useBvh = useBvh && !finiteLights.empty();
+		if (selection.useBvh)
+		{
+			host.bvhNodes.resize(2 * finiteLights.size() - 1);
+			host.lightToLeaf.assign(numLights, -1);
+			selection.numBvhNodes = lightSelection::buildBvh(lights.data(), finiteLights.data(), (int)finiteLights.size(), host.bvhNodes.data(), host.lightToLeaf.data());
+		}
+		return host;
+	}
+
+	LightSelection createLightSelection(std::vector<LightBounds>& lights, const bool useBvh)
+	{
+		HostLightSelection   host      = buildLightSelection(lights, useBvh);
+		LightSelection       selection = host.selection;
+		LaunchParamsBuffers& buffers   = onDeviceData->launchParamsData.resourceBuffers;
+		if (selection.numLights == 0)
+		{
+			return selection;
+		}
+
+		selection.aliasTable     = buffers.lightAliasBuffer.upload(host.aliasTable);
+		selection.infiniteLights = host.infiniteLights.empty() ? nullptr : buffers.infiniteLightsBuffer.upload(host.infiniteLights);
+		if (selection.useBvh)
+		{
+			selection.bvhNodes    = buffers.lightBvhBuffer.upload(host.bvhNodes);
+			selection.lightToLeaf = buffers.lightToLeafBuffer.upload(host.lightToLeaf);
+		}
+
+		VTX_INFO("Light selection: {} lights ({} infinite), environment probability {}, bvh {} nodes",
+				 selection.numLights, selection.numInfiniteLights, selection.infiniteProbability, selection.numBvhNodes);
+		return selection;
+	}
+
 	GeometryData createGeometryData(const std::shared_ptr<graph::Mesh>& meshNode)
 	{
 		VTX_INFO("Computing BLAS");
@@ -161,28 +309,72 @@ namespace vtx::device
 		CUDABuffer& indexBuffer = onDeviceData->geometryDataMap.getResourceBuffers(meshNode->getUID()).indexBuffer;
 		CUDABuffer& faceBuffer = onDeviceData->geometryDataMap.getResourceBuffers(meshNode->getUID()).faceBuffer;
 
-		vertexBuffer.upload(meshNode->vertices);
-		indexBuffer.upload(meshNode->indices);
 		faceBuffer.upload(meshNode->faceAttributes);
 
-
-		const CUdeviceptr vertexData = vertexBuffer.dPointer();
-		const CUdeviceptr indexData = indexBuffer.dPointer();
-
-		const OptixTraversableHandle traversable = optix::createGeometryAcceleration(vertexData,
-			static_cast<uint32_t>(meshNode->vertices.size()),
-			sizeof(graph::VertexAttributes),
-			indexData,
-			static_cast<uint32_t>(meshNode->indices.size()),
-			sizeof(vtxID) * 3);
-
-		GeometryData data;
-
+		GeometryData data{};
 		data.type = PT_TRIANGLES;
-		data.traversable = traversable;
-		data.vertexAttributeData = vertexBuffer.castedPointer<graph::VertexAttributes>();
-		data.indicesData = indexBuffer.castedPointer<vtxID>();
 		data.faceAttributeData = faceBuffer.castedPointer<graph::FaceAttributes>();
+
+		if (getOptions()->compactVertexFormat)
+		{
+			std::vector<graph::CompactVertexAttributes> compactVertices;
+			data.vertexLayout = VL_COMPACT;
+			data.compactBounds = ops::computeCompactVertexBounds(meshNode);
+			ops::encodeCompactVertices(meshNode, data.compactBounds, compactVertices);
+			vertexBuffer.upload(compactVertices);
+			data.compactVertexData = vertexBuffer.castedPointer<graph::CompactVertexAttributes>();
+
+			const bool shortIndices = ops::hasShortIndices(meshNode->vertices.size());
+			if (shortIndices)
+			{
+				const std::vector<uint16_t> indices(meshNode->indices.begin(), meshNode->indices.end());
+				indexBuffer.upload(indices);
+				data.shortIndicesData = indexBuffer.castedPointer<uint16_t>();
+			}
+			else
+			{
+				indexBuffer.upload(meshNode->indices);
+				data.indicesData = indexBuffer.castedPointer<vtxID>();
+			}
+
+			// The BLAS is built on the dequantised positions, so that hit points match the positions decoded while shading.
+			// OptiX doesn't need the vertex buffer after the build, it's released right away.
+			std::vector<math::vec3f> positions(compactVertices.size());
+			for (size_t i = 0; i < compactVertices.size(); ++i)
+			{
+				positions[i] = graph::compact::decodePosition(compactVertices[i].position, data.compactBounds);
+			}
+			CUDABuffer positionBuffer;
+			positionBuffer.upload(positions);
+
+			data.traversable = optix::createGeometryAcceleration(positionBuffer.dPointer(),
+				static_cast<uint32_t>(positions.size()),
+				sizeof(math::vec3f),
+				indexBuffer.dPointer(),
+				static_cast<uint32_t>(meshNode->indices.size()),
+				shortIndices ? sizeof(uint16_t) * 3 : sizeof(vtxID) * 3,
+				shortIndices);
+			positionBuffer.free();
+		}
+		else
+		{
+			vertexBuffer.upload(meshNode->vertices);
+			indexBuffer.upload(meshNode->indices);
+
+			const CUdeviceptr vertexData = vertexBuffer.dPointer();
+			const CUdeviceptr indexData = indexBuffer.dPointer();
+
+			data.traversable = optix::createGeometryAcceleration(vertexData,
+				static_cast<uint32_t>(meshNode->vertices.size()),
+				sizeof(graph::VertexAttributes),
+				indexData,
+				static_cast<uint32_t>(meshNode->indices.size()),
+				sizeof(vtxID) * 3);
+
+			data.vertexLayout = VL_FULL;
+			data.vertexAttributeData = vertexBuffer.castedPointer<graph::VertexAttributes>();
+			data.indicesData = indexBuffer.castedPointer<vtxID>();
+		}
 		data.numVertices = meshNode->vertices.size();
 		data.numIndices = meshNode->indices.size();
 		data.numFaces = meshNode->faceAttributes.size();
@@ -527,12 +719,13 @@ namespace vtx::device
 		CUDABuffer& albedoData = buffers.albedoData;
 		CUtexObject& evalData = buffers.evalData;
 
-		sampleData.upload(bsdfData.sampleData);
-		albedoData.upload(bsdfData.albedoData);
+		const graph::BsdfSamplingTables& tables = *bsdfData.samplingTables;
+		sampleData.upload(tables.sampleData);
+		albedoData.upload(tables.albedoData);
 
 		bsdfSamplingData.sampleData = sampleData.castedPointer<float>();
 		bsdfSamplingData.albedoData = albedoData.castedPointer<float>();
-		bsdfSamplingData.maxAlbedo = bsdfData.maxAlbedo;
+		bsdfSamplingData.maxAlbedo = tables.maxAlbedo;
 		bsdfSamplingData.angularResolution = bsdfData.angularResolution;
 		bsdfSamplingData.numChannels = bsdfData.numChannels;
 		bsdfSamplingData.invAngularResolution = math::vec2f(1.0f / static_cast<float>(bsdfData.angularResolution.x), 1.0f / static_cast<float>(bsdfData.angularResolution.y));
@@ -553,7 +746,7 @@ namespace vtx::device
 		descArray3D.Flags = 0;
 
 		std::vector<const void*> pointers;
-		pointers.push_back(bsdfData.lookupData.data());
+		pointers.push_back(tables.lookupData.data());
 
 		const CUDA_RESOURCE_DESC resourceDescription = uploadTexture(pointers, descArray3D, sizeof(float), buffers.lookUpArray);
 
@@ -615,7 +808,7 @@ namespace vtx::device
 	{
 		// Copy entire CDF data buffer to GPU
 		CUDABuffer& cdfBuffer = onDeviceData->lightProfileDataMap.getResourceBuffers(lightProfile->getUID()).cdfBuffer;
-		cdfBuffer.upload(lightProfile->lightProfileData.cdfData);
+		cdfBuffer.upload(lightProfile->lightProfileData.samplingTables->cdfData);
 
 		// --------------------------------------------------------------------------------------------
 		// Prepare evaluation data.
@@ -667,7 +860,7 @@ namespace vtx::device
 		lightProfileData.thetaPhiInvDelta.x = (lightProfileData.thetaPhiDelta.x != 0.0f) ? 1.0f / lightProfileData.thetaPhiDelta.x : 0.0f;
 		lightProfileData.thetaPhiInvDelta.y = (lightProfileData.thetaPhiDelta.y != 0.0f) ? 1.0f / lightProfileData.thetaPhiDelta.y : 0.0f;
 		lightProfileData.candelaMultiplier = static_cast<float>(lightProfile->lightProfileData.candelaMultiplier);
-		lightProfileData.totalPower = static_cast<float>(lightProfile->lightProfileData.totalPower * lightProfile->lightProfileData.candelaMultiplier);
+		lightProfileData.totalPower = static_cast<float>(lightProfile->lightProfileData.samplingTables->totalPower * lightProfile->lightProfileData.candelaMultiplier);
 
 		return lightProfileData;
 	}
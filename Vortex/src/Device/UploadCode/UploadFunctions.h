@@ -12,6 +12,29 @@ namespace vtx::device
 
 	LightData createEnvLightData(std::shared_ptr<graph::EnvironmentLight> envLight);
 
+	/*Power, world space bounds and normal cone of a sampled light*/
+	LightBounds createLightBounds(vtxID lightId, LightType type);
+
+	/*Light selection arrays on the host, selection holds the counts and probabilities and no array pointers*/
+	struct HostLightSelection
+	{
+		std::vector<AliasData>    aliasTable;
+		std::vector<LightBvhNode> bvhNodes;
+		std::vector<int>          lightToLeaf;
+		std::vector<int>          infiniteLights;
+		LightSelection            selection;
+
+		/*Selection pointing to the host arrays, valid while they are neither changed nor moved*/
+		LightSelection getHostView();
+	};
+
+	/*Scale the environment power by the scene cross-section, then build the power proportional alias table and the optional
+	light bvh over the sampled lights*/
+	HostLightSelection buildLightSelection(std::vector<LightBounds>& lights, bool useBvh);
+
+	/*Build the light selection on the host and upload it*/
+	LightSelection createLightSelection(std::vector<LightBounds>& lights, bool useBvh);
+
 	/*Create BLAS and GeometryDataStruct given vertices attributes and indices*/
 	GeometryData createGeometryData(const std::shared_ptr<graph::Mesh>& meshNode);
 
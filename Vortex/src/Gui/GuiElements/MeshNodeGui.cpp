@@ -18,6 +18,12 @@ namespace vtx::gui
 			vtxImGui::halfSpaceWidget("Node Id", ImGui::Text, std::to_string(mesh->getUID()).c_str());
 			vtxImGui::halfSpaceWidget("Number Of Vertices:", ImGui::Text, std::to_string(mesh->vertices.size()).c_str());
 			vtxImGui::halfSpaceWidget("Number Of Faces:", ImGui::Text, std::to_string((int)(mesh->indices.size()/3)).c_str());
+			const char* status = mesh->isReady() ? "Ready" : "Preparing";
+			if (mesh->getPayloadState() != graph::Mesh::PS_LOADED)
+			{
+				status = mesh->getPayloadState() == graph::Mesh::PS_DEFERRED ? "Not Loaded" : "Load Failed";
+			}
+			vtxImGui::halfSpaceWidget("Status:", ImGui::Text, status);
 			ImGui::Unindent();
 		}
 		ImGui::PopID();
@@ -3,11 +3,14 @@
 
 #include "ShaderVisitor.h"
 #include "mdlTraversal.h"
+#include "Core/Hashing.h"
 #include "Device/OptixWrapper.h"
 #include "Scene/Scene.h"
 #include "Scene/Nodes/Material.h"
 #include "Scene/Nodes/Shader/Texture.h"
 #include "Scene/Nodes/Shader/mdl/ShaderNodes.h"
+#include "Scene/Utility/PreparedDataStore.h"
+#include "Scene/Utility/TexturePrefetcher.h"
 
 namespace vtx::mdl
 {
@@ -1338,15 +1341,55 @@ namespace vtx::mdl
 					textureNode->filePath = textureNode->databaseName;
 				}
 			}
-			Handle       canvas  = make_handle<const ICanvas>(image->get_canvas(0, 0, 0));
-			//const Float32						effectiveGamma			= texture->get_effective_gamma(0, 0);
-
 			if (image->is_uvtile() || image->is_animated())
 			{
 				VTX_ERROR("MDL TEXTURE: uvtile and/or animated textures not supported! Texture name {}", textureDbName);
 				return;
 			}
 
+			// Textures of a file are keyed by its content, the converted layers may be embedded in the loaded scene
+			graph::PreparedDataStore* preparedDataStore = graph::PreparedDataStore::get();
+			textureNode->preparedKey = 0;
+			if (url != nullptr && (getOptions()->embedPreparedData || preparedDataStore->hasKind(graph::PD_TEXTURE)))
+			{
+				if (const uint64_t fileHash = utl::hashFile(url); fileHash != 0)
+				{
+					const uint64_t settingsHash = utl::hashCombine(utl::hashValue(shape), utl::hashValue(texture->get_effective_gamma(0, 0)));
+					textureNode->preparedKey = graph::PreparedDataStore::computeKey(graph::PD_TEXTURE, fileHash, settingsHash);
+				}
+			}
+
+			// Images decoded during the import are used as they are, the canvas conversion and copy are skipped
+			if (url != nullptr && shape == ITarget_code::Texture_shape_2d)
+			{
+				const std::string imageType(image->get_type(0, 0));
+				const bool        isLdr = imageType == "Rgb" || imageType == "Rgba";
+				const bool        isHdr = (imageType == "Rgbe" || imageType == "Rgb_fp" || imageType == "Color") && texture->get_effective_gamma(0, 0) == 1.0f;
+				if (isLdr || isHdr)
+				{
+					const std::shared_ptr<importer::PrefetchedImage> prefetched = importer::TexturePrefetcher::get()->take(url);
+					if (prefetched != nullptr && prefetched->isFloat == isHdr)
+					{
+						format                      = isHdr ? CU_AD_FORMAT_FLOAT : CU_AD_FORMAT_UNSIGNED_INT8;
+						pixelBytesSize              = isHdr ? sizeof(Float32) : sizeof(Uint8);
+						dimension                   = math::vec4ui(prefetched->width, prefetched->height, 0, 4);
+						textureNode->effectiveGamma = texture->get_effective_gamma(0, 0);
+						imageLayersPointers.push_back(prefetched->releasePixels());
+						state.commitTransaction();
+						return;
+					}
+				}
+			}
+
+			if (preparedDataStore->hasKind(graph::PD_TEXTURE) && textureNode->loadPreparedData())
+			{
+				state.commitTransaction();
+				return;
+			}
+
+			Handle       canvas  = make_handle<const ICanvas>(image->get_canvas(0, 0, 0));
+			//const Float32						effectiveGamma			= texture->get_effective_gamma(0, 0);
+
 			// MDL pixel types.
 			//"Sint8"      // Signed 8-bit integer
 			//"Sint32"     // Signed 32-bit integer
@@ -0,0 +1,205 @@
+#pragma once
+#ifndef COMPACTVERTEXATTRIBUTE_H
+#define COMPACTVERTEXATTRIBUTE_H
+
+#include <cstdint>
+#include <cstring>
+#include "VertexAttribute.h"
+
+namespace vtx::graph
+{
+	// Quantised counterpart of VertexAttributes, 20 bytes instead of 60:
+	// - position: 21 bits per axis relative to the mesh bounds
+	// - texCoord: u and v as half floats, the z of VertexAttributes::texCoord is always zero
+	// - normal: octahedral encoding, 16 bits per component
+	// - tangent: octahedral encoding, 15 bits per component, the top bit holds the sign of the bitangent
+	struct CompactVertexAttributes
+	{
+		uint32_t position[2];
+		uint32_t texCoord;
+		uint32_t normal;
+		uint32_t tangent;
+	};
+
+	struct CompactVertexBounds
+	{
+		math::vec3f min{ 0.0f };
+		math::vec3f extent{ 0.0f };
+	};
+
+	namespace compact
+	{
+		static constexpr uint32_t positionBits   = 21;
+		static constexpr uint32_t positionMax    = (1u << positionBits) - 1u;
+		static constexpr uint32_t normalBits     = 16;
+		static constexpr uint32_t tangentBits    = 15;
+		static constexpr uint32_t bitangentSign  = 1u << 31;
+
+		__inline__ __both__ uint32_t floatToHalf(const float value)
+		{
+			uint32_t bits;
+			memcpy(&bits, &value, sizeof(float));
+			const uint32_t sign     = (bits >> 16) & 0x8000u;
+			const int32_t  exponent = (int32_t)((bits >> 23) & 0xffu) - 127 + 15;
+			const uint32_t mantissa = bits & 0x7fffffu;
+
+			if (((bits >> 23) & 0xffu) == 0xffu)
+			{
+				return sign | 0x7c00u | (mantissa != 0u ? 0x200u : 0u); // inf or nan
+			}
+			if (exponent >= 31)
+			{
+				return sign | 0x7c00u; // overflow to inf
+			}
+			if (exponent <= 0)
+			{
+				if (exponent < -10)
+				{
+					return sign; // underflow to zero
+				}
+				// Subnormal half, round to nearest
+				const uint32_t m     = mantissa | 0x800000u;
+				const uint32_t shift = (uint32_t)(14 - exponent);
+				return sign | ((m + (1u << (shift - 1))) >> shift);
+			}
+			// Round to nearest, a mantissa carry correctly bumps the exponent
+			return (sign | ((uint32_t)exponent << 10) | (mantissa >> 13)) + ((mantissa >> 12) & 1u);
+		}
+
+		__inline__ __both__ float halfToFloat(const uint32_t half)
+		{
+			const uint32_t sign     = (half & 0x8000u) << 16;
+			uint32_t       exponent = (half >> 10) & 0x1fu;
+			uint32_t       mantissa = half & 0x3ffu;
+			uint32_t       bits;
+
+			if (exponent == 0x1fu)
+			{
+				bits = sign | 0x7f800000u | (mantissa << 13);
+			}
+			else if (exponent == 0u)
+			{
+				if (mantissa == 0u)
+				{
+					bits = sign;
+				}
+				else
+				{
+					// Normalize the subnormal half
+					exponent = 1u;
+					while ((mantissa & 0x400u) == 0u)
+					{
+						mantissa <<= 1;
+						--exponent;
+					}
+					mantissa &= 0x3ffu;
+					bits = sign | ((exponent + 127u - 15u) << 23) | (mantissa << 13);
+				}
+			}
+			else
+			{
+				bits = sign | ((exponent + 127u - 15u) << 23) | (mantissa << 13);
+			}
+			float value;
+			memcpy(&value, &bits, sizeof(float));
+			return value;
+		}
+
+		__inline__ __both__ float signNotZero(const float value)
+		{
+			return value >= 0.0f ? 1.0f : -1.0f;
+		}
+
+		// Octahedral projection of a unit vector, each component is stored as a signed normalized integer of the given bits
+		__inline__ __both__ uint32_t encodeOctahedral(const math::vec3f& v, const uint32_t bits)
+		{
+			const float l1 = fabsf(v.x) + fabsf(v.y) + fabsf(v.z);
+			if (!(l1 > 0.0f))
+			{
+				return 0u;
+			}
+			float x = v.x / l1;
+			float y = v.y / l1;
+			if (v.z < 0.0f)
+			{
+				const float ox = x;
+				x = (1.0f - fabsf(y)) * signNotZero(ox);
+				y = (1.0f - fabsf(ox)) * signNotZero(y);
+			}
+			const float    scale = (float)((1u << (bits - 1u)) - 1u);
+			const uint32_t mask  = (1u << bits) - 1u;
+			const int32_t  qx    = (int32_t)roundf(fminf(fmaxf(x, -1.0f), 1.0f) * scale);
+			const int32_t  qy    = (int32_t)roundf(fminf(fmaxf(y, -1.0f), 1.0f) * scale);
+			return ((uint32_t)qx & mask) | (((uint32_t)qy & mask) << bits);
+		}
+
+		__inline__ __both__ math::vec3f decodeOctahedral(const uint32_t encoded, const uint32_t bits)
+		{
+			const float   scale = (float)((1u << (bits - 1u)) - 1u);
+			const int32_t qx    = (int32_t)(encoded << (32u - bits)) >> (32u - bits);
+			const int32_t qy    = (int32_t)((encoded >> bits) << (32u - bits)) >> (32u - bits);
+			float         x     = fmaxf((float)qx / scale, -1.0f);
+			float         y     = fmaxf((float)qy / scale, -1.0f);
+			const float   z     = 1.0f - fabsf(x) - fabsf(y);
+			if (z < 0.0f)
+			{
+				const float ox = x;
+				x = (1.0f - fabsf(y)) * signNotZero(ox);
+				y = (1.0f - fabsf(ox)) * signNotZero(y);
+			}
+			return math::normalize(math::vec3f(x, y, z));
+		}
+
+		__inline__ __both__ void encodePosition(const math::vec3f& position, const CompactVertexBounds& bounds, uint32_t* out)
+		{
+			uint32_t q[3];
+			for (int i = 0; i < 3; ++i)
+			{
+				const float t = bounds.extent[i] > 0.0f ? (position[i] - bounds.min[i]) / bounds.extent[i] : 0.0f;
+				q[i] = (uint32_t)(fminf(fmaxf(t, 0.0f), 1.0f) * (float)positionMax + 0.5f);
+			}
+			const uint64_t packed = (uint64_t)q[0] | ((uint64_t)q[1] << positionBits) | ((uint64_t)q[2] << (2u * positionBits));
+			out[0] = (uint32_t)packed;
+			out[1] = (uint32_t)(packed >> 32);
+		}
+
+		__inline__ __both__ math::vec3f decodePosition(const uint32_t* in, const CompactVertexBounds& bounds)
+		{
+			const uint64_t packed = (uint64_t)in[0] | ((uint64_t)in[1] << 32);
+			const float    x      = (float)(uint32_t)(packed & positionMax);
+			const float    y      = (float)(uint32_t)((packed >> positionBits) & positionMax);
+			const float    z      = (float)(uint32_t)((packed >> (2u * positionBits)) & positionMax);
+			return bounds.min + math::vec3f(x, y, z) * (bounds.extent / (float)positionMax);
+		}
+	}
+
+	__inline__ __both__ CompactVertexAttributes encodeVertex(const VertexAttributes& vertex, const CompactVertexBounds& bounds)
+	{
+		CompactVertexAttributes compactVertex;
+		compact::encodePosition(vertex.position, bounds, compactVertex.position);
+		compactVertex.texCoord = compact::floatToHalf(vertex.texCoord.x) | (compact::floatToHalf(vertex.texCoord.y) << 16);
+		compactVertex.normal   = compact::encodeOctahedral(vertex.normal, compact::normalBits);
+		compactVertex.tangent  = compact::encodeOctahedral(vertex.tangent, compact::tangentBits);
+		if (math::dot(cross(vertex.normal, vertex.tangent), vertex.bitangent) < 0.0f)
+		{
+			compactVertex.tangent |= compact::bitangentSign;
+		}
+		return compactVertex;
+	}
+
+	__inline__ __both__ VertexAttributes decodeVertex(const CompactVertexAttributes& compactVertex, const CompactVertexBounds& bounds)
+	{
+		VertexAttributes vertex;
+		vertex.position   = compact::decodePosition(compactVertex.position, bounds);
+		vertex.texCoord   = math::vec3f(compact::halfToFloat(compactVertex.texCoord & 0xffffu), compact::halfToFloat(compactVertex.texCoord >> 16), 0.0f);
+		vertex.normal     = compact::decodeOctahedral(compactVertex.normal, compact::normalBits);
+		vertex.tangent    = compact::decodeOctahedral(compactVertex.tangent & ~compact::bitangentSign, compact::tangentBits);
+		vertex.bitangent  = cross(vertex.normal, vertex.tangent);
+		if ((compactVertex.tangent & compact::bitangentSign) != 0u)
+		{
+			vertex.bitangent = -vertex.bitangent;
+		}
+		return vertex;
+	}
+}
+#endif
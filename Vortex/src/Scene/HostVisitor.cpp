@@ -3,6 +3,8 @@
 #include "MDL//mdlWrapper.h"
 #include "Nodes/Instance.h"
 #include "Nodes/Mesh.h"
+#include "Core/Options.h"
+#include "Utility/Operations.h"
 
 namespace vtx
 {
@@ -16,17 +18,25 @@ namespace vtx
 	};
 
 	void HostVisitor::visit(const std::shared_ptr<graph::Mesh>& mesh) {
-		if(!mesh->status.hasFaceAttributes)
+		if (mesh->isReady() || mesh->isPreparing.load() || mesh->getPayloadState() == graph::Mesh::PS_FAILED)
 		{
-			ops::computeFaceAttributes(mesh);
+			return;
 		}
-		if(!mesh->status.hasNormals)
+		if (getOptions()->asyncMeshPreparation)
 		{
-			ops::computeVertexNormals(mesh);
+			// The mesh is uploaded by the first sync after the preparation is done
+			ops::prepareMeshAsync(mesh);
 		}
-		if(!mesh->status.hasTangents)
+		else
 		{
-			ops::computeVertexTangentSpace(mesh);
+			// Meshes shared by several subtrees can be reached by several threads during a parallel traversal
+			bool expected = false;
+			if (!mesh->isPreparing.compare_exchange_strong(expected, true))
+			{
+				return;
+			}
+			ops::prepareMesh(mesh);
+			mesh->isPreparing.store(false);
 		}
 	};
 
@@ -6,7 +6,7 @@ namespace vtx
 	class HostVisitor : public NodeVisitor {
 	public:
 		HostVisitor(){
-			collectTransforms = true;
+			// Global transforms are propagated by the TransformHierarchy
 			collectWidthsAndDepths = true;
 		};
 		void visit(const std::shared_ptr<graph::Instance>& instance) override;
@@ -21,5 +21,16 @@ namespace vtx
 		void visit(const std::shared_ptr<graph::LightProfile>& lightProfile) override;
 		void visit(const std::shared_ptr<graph::EnvironmentLight>& lightNode) override;
 		void visit(const std::shared_ptr<graph::MeshLight>& lightNode) override;
+
+		// Meshes are the only nodes the visitor changes, their preparation is claimed by a single thread
+		bool isThreadSafe() const override
+		{
+			return true;
+		}
+
+		std::unique_ptr<NodeVisitor> createSubtreeVisitor() const override
+		{
+			return std::make_unique<HostVisitor>();
+		}
 	};
 }
@@ -1,6 +1,10 @@
 #include "Node.h"
+#include <unordered_set>
 #include "Scene.h"
 #include "Traversal.h"
+#include "Core/Log.h"
+#include "Core/Options.h"
+#include "Core/ThreadPool.h"
 
 namespace vtx::graph
 {
@@ -8,15 +12,25 @@ namespace vtx::graph
 	Node::Node(const NodeType _type) : type(_type)
 	{
 		sim = Scene::getSim();
-		UID  = sim->getUID();
-		typeID = sim->getTypeId(type);
+		const utl::SlotId uidSlot = sim->allocateUID();
+		const utl::SlotId tidSlot = sim->allocateTypeId(type);
+		UID  = uidSlot.id;
+		typeID = tidSlot.id;
+		uidGeneration = uidSlot.generation;
+		typeIdGeneration = tidSlot.generation;
 		name = nodeNames[type] + "." + std::to_string(typeID);
+		state.updateOnDevice.owner = this;
+		state.isShaderArgBlockUpdated.owner = this;
 	}
 
 	Node::~Node()
 	{
-		sim->removeNodeReference(UID, typeID, type);
-		VTX_WARN("Node {} ID: {} Name: {} destroyed", nodeNames[getType()], UID, name);
+		// The ids might have been released and handed to another node already, the generations tell them apart
+		sim->removeNodeReference(utl::SlotId{ UID, uidGeneration }, utl::SlotId{ typeID, typeIdGeneration }, type);
+		if (!sim->isBulkReleasing())
+		{
+			VTX_WARN("Node {} ID: {} Name: {} destroyed", nodeNames[getType()], UID, name);
+		}
 	}
         
 	NodeType Node::getType() const {
@@ -32,6 +46,27 @@ namespace vtx::graph
 		return typeID;
 	}
 
+	void Node::markChanged() const
+	{
+		sim->markChanged(type, utl::SlotId{ UID, uidGeneration });
+	}
+
+	JournaledFlag& JournaledFlag::operator=(const bool raised)
+	{
+		value = raised;
+		if (raised && owner != nullptr)
+		{
+			owner->markChanged();
+		}
+		return *this;
+	}
+
+	void reportNodeCastMismatch(const Node& node, const char* className, const bool isDynamicCastValid)
+	{
+		VTX_ERROR("Node {} ID: {} Name: {} is {}a {} but its node type says otherwise, check the NodeTypeRange of the class",
+				  nodeNames[node.getType()], node.getUID(), node.name, isDynamicCastValid ? "" : "not ", className);
+	}
+
 	void Node::setUID(vtxID id)
 	{
 		UID = id;
@@ -54,16 +89,196 @@ namespace vtx::graph
 
 		traverseChildren(visitor);
 
-		if (!state.isInitialized)
+		initialize(visitor.isSubtreeVisitor);
+
+		accept(visitor);
+
+		visitor.visitEnd(as<Node>());
+
+	}
+
+	void Node::initialize(const bool isConcurrent)
+	{
+		if (state.isInitialized)
+		{
+			return;
+		}
+		if (!isConcurrent)
 		{
 			init();
 			state.isInitialized = true;
+			return;
 		}
 
-		accept(visitor);
+		// The first caller runs init, the others only wait for this node
+		std::thread::id noThread;
+		if (initializingThread.compare_exchange_strong(noThread, std::this_thread::get_id()))
+		{
+			if (!state.isInitialized)
+			{
+				init();
+				state.isInitialized = true;
+			}
+			initializingThread.store(std::thread::id());
+			return;
+		}
+		VTX_ASSERT_CLOSE(noThread != std::this_thread::get_id(), "Node {}: init recursed into the initialization of the same node", UID);
+		while (!state.isInitialized && initializingThread.load() != std::thread::id())
+		{
+			std::this_thread::yield();
+		}
+	}
 
-		visitor.visitEnd(as<Node>());
+	namespace
+	{
+		void initializeSubtree(const std::shared_ptr<Node>& node, std::unordered_set<vtxID>& visited)
+		{
+			if (!visited.insert(node->getUID()).second)
+			{
+				return;
+			}
+			for (const std::shared_ptr<Node>& child : node->getChildren())
+			{
+				if (child)
+				{
+					initializeSubtree(child, visited);
+				}
+			}
+			if (node->state.isInitialized)
+			{
+				return;
+			}
+			node->initialize();
+			for (const std::shared_ptr<Node>& child : node->getChildren())
+			{
+				if (child)
+				{
+					initializeSubtree(child, visited);
+				}
+			}
+		}
+
+		struct SubtreeTask
+		{
+			std::vector<NodeVisitor::TreePositionEntry> precedingEntries; // Top level nodes visited before the subtree
+			std::shared_ptr<Node>                      root;
+			std::unique_ptr<NodeVisitor>               visitor;
+		};
+
+		void traverseTopLevels(const std::shared_ptr<Node>& node, NodeVisitor& visitor, const std::unordered_set<vtxID>& topLevelNodes,
+							   std::vector<SubtreeTask>& tasks, std::vector<std::shared_ptr<Node>>& acceptOrder)
+		{
+			visitor.visitBegin(node);
+			for (const std::shared_ptr<Node>& child : node->getChildren())
+			{
+				if (!child)
+				{
+					continue;
+				}
+				if (topLevelNodes.count(child->getUID()) != 0)
+				{
+					traverseTopLevels(child, visitor, topLevelNodes, tasks, acceptOrder);
+					continue;
+				}
+				std::unique_ptr<NodeVisitor> subtreeVisitor = visitor.forkSubtree();
+				if (!subtreeVisitor)
+				{
+					child->traverse(visitor);
+					continue;
+				}
+				SubtreeTask& task = tasks.emplace_back();
+				task.precedingEntries.swap(visitor.treePositionEntries);
+				task.root    = child;
+				task.visitor = std::move(subtreeVisitor);
+			}
+			acceptOrder.push_back(node);
+			visitor.visitEnd(node);
+		}
+	}
+
+	void Node::initializeSubtree()
+	{
+		std::unordered_set<vtxID> visited;
+		graph::initializeSubtree(as<Node>(), visited);
+	}
+
+	void Node::traverseParallel(NodeVisitor& visitor)
+	{
+		if (!visitor.isThreadSafe() || !getOptions()->parallelTraversal)
+		{
+			traverse(visitor);
+			return;
+		}
+
+		// Initialization mutates nodes (e.g. a material creates its textures) which the subtree traversals read without
+		// locks, so pending nodes are initialized before forking. Nodes created during the traversal still initialize
+		// concurrently, each one once.
+		if (InitializedFlag::getPendingCount() > 0)
+		{
+			initializeSubtree();
+		}
+
+		// The top levels are expanded until there are enough subtrees to keep the pool busy
+		constexpr int maxTopLevels = 6;
+		const size_t targetSubtrees = 4 * static_cast<size_t>(ThreadPool::get()->getNumberOfWorkers() + 1);
+		std::unordered_set<vtxID> topLevelNodes;
+		std::vector<std::shared_ptr<Node>> frontier{ as<Node>() };
+		for (int level = 0; level < maxTopLevels && !frontier.empty(); ++level)
+		{
+			std::vector<std::shared_ptr<Node>> children;
+			for (const std::shared_ptr<Node>& node : frontier)
+			{
+				if (!topLevelNodes.insert(node->getUID()).second)
+				{
+					continue;
+				}
+				for (const std::shared_ptr<Node>& child : node->getChildren())
+				{
+					if (child)
+					{
+						children.push_back(child);
+					}
+				}
+			}
+			if (children.size() >= targetSubtrees)
+			{
+				break;
+			}
+			frontier.swap(children);
+		}
+
+		const bool wasDeferring = visitor.isDeferringTreePositions;
+		visitor.isDeferringTreePositions = visitor.collectWidthsAndDepths;
+		std::vector<SubtreeTask>           tasks;
+		std::vector<std::shared_ptr<Node>> acceptOrder;
+		traverseTopLevels(as<Node>(), visitor, topLevelNodes, tasks, acceptOrder);
+		std::vector<NodeVisitor::TreePositionEntry> trailingEntries;
+		trailingEntries.swap(visitor.treePositionEntries);
+		visitor.isDeferringTreePositions = wasDeferring;
+
+		utl::parallelFor(tasks.size(), [&tasks](const size_t i)
+		{
+			tasks[i].root->traverse(*tasks[i].visitor);
+		});
 
+		for (const std::shared_ptr<Node>& node : acceptOrder)
+		{
+			node->initialize();
+			node->accept(visitor);
+		}
+
+		for (SubtreeTask& task : tasks)
+		{
+			for (NodeVisitor::TreePositionEntry& entry : task.precedingEntries)
+			{
+				visitor.applyTreePosition(entry);
+			}
+			visitor.mergeSubtreeVisitor(*task.visitor);
+		}
+		for (NodeVisitor::TreePositionEntry& entry : trailingEntries)
+		{
+			visitor.applyTreePosition(entry);
+		}
 	}
 
 	void Node::traverseChildren(NodeVisitor& visitor)
@@ -1,7 +1,11 @@
 #pragma once
 #include "Core/VortexID.h"
+#include <atomic>
 #include <vector>
 #include <memory>
+#include <thread>
+#include <type_traits>
+#include <typeinfo>
 #include "NodeTypes.h"
 
 #define ACCEPT(derived, visitor) \
@@ -16,14 +20,95 @@ namespace vtx::graph
 {
 
 	class SceneIndexManager;
+	class Node;
+
+	// Flag which records its node in the scene change journal whenever it is raised,
+	// the device synchronization only visits the journaled nodes
+	class JournaledFlag
+	{
+	public:
+		JournaledFlag() = default;
+		JournaledFlag(const JournaledFlag& other) : value(other.value) {}
+
+		JournaledFlag& operator=(const JournaledFlag& other)
+		{
+			return *this = other.value;
+		}
+
+		JournaledFlag& operator=(bool raised);
+
+		operator bool() const
+		{
+			return value;
+		}
+
+	private:
+		friend class Node;
+		Node* owner = nullptr;
+		bool  value = false;
+	};
+
+	// Flag read without a lock by the traversal, it is written with release and read with acquire semantics so that a node
+	// seen as initialized is seen with everything its init wrote. Nodes waiting for their initialization are counted,
+	// the parallel traversal initializes them serially before forking when there are some.
+	class InitializedFlag
+	{
+	public:
+		InitializedFlag()
+		{
+			++pendingCount;
+		}
+
+		InitializedFlag(const InitializedFlag& other) : InitializedFlag()
+		{
+			*this = (bool)other;
+		}
+
+		~InitializedFlag()
+		{
+			if (!value.load(std::memory_order_acquire))
+			{
+				--pendingCount;
+			}
+		}
+
+		InitializedFlag& operator=(const InitializedFlag& other)
+		{
+			return *this = (bool)other;
+		}
+
+		InitializedFlag& operator=(const bool initialized)
+		{
+			if (value.exchange(initialized, std::memory_order_acq_rel) != initialized)
+			{
+				pendingCount += initialized ? -1 : 1;
+			}
+			return *this;
+		}
+
+		operator bool() const
+		{
+			return value.load(std::memory_order_acquire);
+		}
+
+		// Number of existing nodes which are not initialized
+		static int64_t getPendingCount()
+		{
+			return pendingCount.load();
+		}
+
+	private:
+		std::atomic<bool>              value = false;
+		inline static std::atomic<int64_t> pendingCount = 0;
+	};
 
 	struct NodeState
 	{
-		bool isInitialized = false;
+		InitializedFlag isInitialized;
 		bool isChangedByGui = false;
-		bool updateOnDevice = false;
+		JournaledFlag updateOnDevice;
 		bool isShaderCodeUpdated = false;
-		bool isShaderArgBlockUpdated = false;
+		JournaledFlag isShaderArgBlockUpdated;
 	};
 
 	struct NodeTreePosition
@@ -50,11 +135,24 @@ namespace vtx::graph
 
 		void traverse(NodeVisitor& visitor);
 
+		// Visits the top levels of the graph on the calling thread and the subtrees below them in parallel, for visitors
+		// which declare themselves thread safe. Top level nodes are accepted once the subtrees below them are visited.
+		void traverseParallel(NodeVisitor& visitor);
+
+		// Calls init once. Concurrent callers of the same node wait for the first one, other nodes initialize in parallel,
+		// and init may initialize other nodes. A node whose init initializes itself again is an error.
+		void initialize(bool isConcurrent = false);
+
+		// Initializes the uninitialized nodes of the subtree children first, as the traversal does, including the
+		// children created by the initialization of their parent
+		void initializeSubtree();
+
+		// Records the node in the scene change journal, raising NodeState::updateOnDevice does it implicitly
+		void markChanged() const;
+
+		// Checked downcast on the node type, nullptr if the node is not a Derived (see nodeCast)
 		template<class Derived>
-		std::shared_ptr<Derived> as()
-		{
-			return std::dynamic_pointer_cast<Derived>(shared_from_this());
-		}
+		std::shared_ptr<Derived> as();
 
 		virtual void init() {};
 
@@ -81,7 +179,10 @@ namespace vtx::graph
 		NodeType type;
 		vtxID UID;
 		vtxID typeID = 0;
+		uint32_t uidGeneration = 0;
+		uint32_t typeIdGeneration = 0;
 		std::shared_ptr<SceneIndexManager> sim;
+		std::atomic<std::thread::id> initializingThread; // Thread running init during a concurrent initialization
 	};
 
 	namespace shader {
@@ -124,4 +225,94 @@ namespace vtx::graph
 	struct Configuration;
 	struct FunctionNames;
 	struct DevicePrograms;
+
+	// Range of node types a node class is constructed with, specialized for every class of the graph.
+	// Classes without a specialization are cast with dynamic_pointer_cast.
+	template<class T>
+	struct NodeTypeRange
+	{
+		static constexpr bool isDefined = false;
+	};
+
+#define VTX_NODE_TYPE_RANGE(Class, First, Last) \
+	template<> struct NodeTypeRange<Class> \
+	{ \
+		static constexpr bool     isDefined = true; \
+		static constexpr NodeType first     = First; \
+		static constexpr NodeType last      = Last; \
+	};
+
+	VTX_NODE_TYPE_RANGE(Group, NT_GROUP, NT_GROUP)
+	VTX_NODE_TYPE_RANGE(Instance, NT_INSTANCE, NT_INSTANCE)
+	VTX_NODE_TYPE_RANGE(Mesh, NT_MESH, NT_MESH)
+	VTX_NODE_TYPE_RANGE(Transform, NT_TRANSFORM, NT_TRANSFORM)
+	VTX_NODE_TYPE_RANGE(MeshLight, NT_MESH_LIGHT, NT_MESH_LIGHT)
+	VTX_NODE_TYPE_RANGE(EnvironmentLight, NT_ENV_LIGHT, NT_ENV_LIGHT)
+	VTX_NODE_TYPE_RANGE(Camera, NT_CAMERA, NT_CAMERA)
+	VTX_NODE_TYPE_RANGE(Renderer, NT_RENDERER, NT_RENDERER)
+	VTX_NODE_TYPE_RANGE(Material, NT_MATERIAL, NT_MATERIAL)
+	VTX_NODE_TYPE_RANGE(Texture, NT_MDL_TEXTURE, NT_MDL_TEXTURE)
+	VTX_NODE_TYPE_RANGE(BsdfMeasurement, NT_MDL_BSDF, NT_MDL_BSDF)
+	VTX_NODE_TYPE_RANGE(LightProfile, NT_MDL_LIGHTPROFILE, NT_MDL_LIGHTPROFILE)
+	VTX_NODE_TYPE_RANGE(shader::ShaderNode, NT_SHADER_DF, NT_PRINCIPLED_MATERIAL)
+	VTX_NODE_TYPE_RANGE(shader::DiffuseReflection, NT_SHADER_DF, NT_SHADER_DF)
+	VTX_NODE_TYPE_RANGE(shader::Material, NT_SHADER_MATERIAL, NT_SHADER_MATERIAL)
+	VTX_NODE_TYPE_RANGE(shader::MaterialSurface, NT_SHADER_SURFACE, NT_SHADER_SURFACE)
+	VTX_NODE_TYPE_RANGE(shader::ImportedNode, NT_SHADER_IMPORTED, NT_SHADER_IMPORTED)
+	VTX_NODE_TYPE_RANGE(shader::TextureTransform, NT_SHADER_COORDINATE, NT_SHADER_COORDINATE)
+	VTX_NODE_TYPE_RANGE(shader::NormalTexture, NT_SHADER_NORMAL_TEXTURE, NT_SHADER_NORMAL_TEXTURE)
+	VTX_NODE_TYPE_RANGE(shader::MonoTexture, NT_SHADER_MONO_TEXTURE, NT_SHADER_MONO_TEXTURE)
+	VTX_NODE_TYPE_RANGE(shader::ColorTexture, NT_SHADER_COLOR_TEXTURE, NT_SHADER_COLOR_TEXTURE)
+	VTX_NODE_TYPE_RANGE(shader::BumpTexture, NT_SHADER_BUMP_TEXTURE, NT_SHADER_BUMP_TEXTURE)
+	VTX_NODE_TYPE_RANGE(shader::NormalMix, NT_NORMAL_MIX, NT_NORMAL_MIX)
+	VTX_NODE_TYPE_RANGE(shader::GetChannel, NT_GET_CHANNEL, NT_GET_CHANNEL)
+	VTX_NODE_TYPE_RANGE(shader::PrincipledMaterial, NT_PRINCIPLED_MATERIAL, NT_PRINCIPLED_MATERIAL)
+
+#undef VTX_NODE_TYPE_RANGE
+
+	template<class Derived>
+	bool isNodeOfType(const NodeType type)
+	{
+		static_assert(NodeTypeRange<Derived>::isDefined, "Node class without a NodeTypeRange!");
+		return type >= NodeTypeRange<Derived>::first && type <= NodeTypeRange<Derived>::last;
+	}
+
+	// Logs casts where the node type and the dynamic type of the node disagree, the NodeTypeRange of the class is wrong
+	void reportNodeCastMismatch(const Node& node, const char* className, bool isDynamicCastValid);
+
+	// Downcast checked on the node type instead of RTTI. Debug builds verify the result against dynamic_cast.
+	template<class Derived>
+	std::shared_ptr<Derived> nodeCast(const std::shared_ptr<Node>& node)
+	{
+		static_assert(std::is_base_of_v<Node, Derived>, "Template type is not a subclass of Node!");
+		if constexpr (std::is_same_v<Derived, Node>)
+		{
+			return node;
+		}
+		else if constexpr (!NodeTypeRange<Derived>::isDefined)
+		{
+			return std::dynamic_pointer_cast<Derived>(node);
+		}
+		else
+		{
+			if (!node)
+			{
+				return nullptr;
+			}
+			const bool isDerived = isNodeOfType<Derived>(node->getType());
+#ifdef _DEBUG
+			if (const bool isDynamicCastValid = dynamic_cast<Derived*>(node.get()) != nullptr; isDynamicCastValid != isDerived)
+			{
+				reportNodeCastMismatch(*node, typeid(Derived).name(), isDynamicCastValid);
+			}
+#endif
+			return isDerived ? std::static_pointer_cast<Derived>(node) : nullptr;
+		}
+	}
+
+	template<class Derived>
+	std::shared_ptr<Derived> Node::as()
+	{
+		return nodeCast<Derived>(shared_from_this());
+	}
 }
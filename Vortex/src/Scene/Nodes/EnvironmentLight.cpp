@@ -1,7 +1,18 @@
 #include "EnvironmentLight.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include "Core/Hashing.h"
+#include "Core/Options.h"
+#include "Core/ThreadPool.h"
+#include "Core/Timer.h"
+#include "Core/Utils.h"
 #include "MDL/MdlWrapper.h"
 #include "Scene/Traversal.h"
 #include "Scene/Utility/Operations.h"
+#include "Scene/Utility/PreparedDataStore.h"
 #include "Shader/Texture.h"
 #include "Scene/Graph.h"
 
@@ -137,82 +148,288 @@ namespace vtx::graph
 		VTX_INFO("Finished Computing Env Area Light for Texture {}", envTexture->databaseName);
 	}
 
-	float buildAliasMap(
-		const std::vector<float>& data,
-		const unsigned int size,
-		std::vector<AliasData>& aliasMap)
+	static constexpr char     samplingCacheMagic[8] = { 'V', 'T', 'X', 'E', 'N', 'V', 'A', 'M' };
+	static constexpr uint32_t samplingCacheVersion  = 1;
+
+	struct SamplingCacheHeader
 	{
-		// create qs (normalized)
-		float sum = 0.0f;
-		for (unsigned int i = 0; i < size; ++i)
-			sum += data[i];
+		char     magic[8];
+		uint32_t version;
+		uint32_t width;
+		uint32_t height;
+		uint32_t prefilter;
+		uint64_t key;
+		float    invIntegral;
+		uint32_t padding;
+	};
+
+	static std::string getSamplingCachePath(const uint64_t key)
+	{
+		std::stringstream ss;
+		ss << std::hex << key;
+		return getOptions()->importCacheFolder + ss.str() + ".vtxenv";
+	}
 
-		for (unsigned int i = 0; i < size; ++i)
-			aliasMap[i].q = (static_cast<float>(size) * data[i] / sum);
+	static uint64_t computeSamplingCacheKey(const float* pixels, const unsigned int width, const unsigned int height, const bool prefilter)
+	{
+		// Hashing a large hdri byte per byte takes seconds, the rows are hashed on the thread pool and then combined
+		std::vector<uint64_t> rowHashes(height);
+		utl::parallelFor(height, [&](const size_t y)
+		{
+			rowHashes[y] = utl::hashBytes(pixels + y * width * 4, width * 4 * sizeof(float));
+		}, 16);
+
+		uint64_t key = utl::hashValue(samplingCacheVersion);
+		key          = utl::hashCombine(key, utl::hashValue(width));
+		key          = utl::hashCombine(key, utl::hashValue(height));
+		key          = utl::hashCombine(key, utl::hashValue(prefilter));
+		key          = utl::hashCombine(key, utl::hashVector(rowHashes));
+		return key;
+	}
 
-		// create partition table
-		std::vector<unsigned> partitionTable(size);
-		unsigned int s = 0u, large = size;
-		for (unsigned int i = 0; i < size; ++i)
-			partitionTable[(aliasMap[i].q < 1.0f) ? (s++) : (--large)] = aliasMap[i].alias = i;
+	static bool readSamplingCache(const uint64_t key, const unsigned int width, const unsigned int height, std::vector<AliasData>& aliasMap, float& invIntegral)
+	{
+		const std::string cachePath = getSamplingCachePath(key);
+		utl::MappedFile   file;
+		if (!std::filesystem::exists(cachePath) || !file.open(cachePath))
+		{
+			return false;
+		}
 
-		// create alias map
-		for (s = 0; s < large && large < size; ++s)
+		const size_t numTexels = (size_t)width * height;
+		const auto*  header    = static_cast<const SamplingCacheHeader*>(file.getData());
+		if (file.getSize() != sizeof(SamplingCacheHeader) + numTexels * sizeof(AliasData) ||
+			std::memcmp(header->magic, samplingCacheMagic, sizeof(samplingCacheMagic)) != 0 ||
+			header->version != samplingCacheVersion ||
+			header->key != key ||
+			header->width != width ||
+			header->height != height)
 		{
-			const unsigned int j = partitionTable[s], k = partitionTable[large];
-			aliasMap[j].alias = k;
-			aliasMap[k].q += aliasMap[j].q - 1.0f;
-			large = (aliasMap[k].q < 1.0f) ? (large + 1u) : large;
+			VTX_WARN("Environment sampling cache: {} is not valid, ignoring it", cachePath);
+			return false;
 		}
-		return sum;
+
+		aliasMap.resize(numTexels);
+		std::memcpy(aliasMap.data(), header + 1, numTexels * sizeof(AliasData));
+		invIntegral = header->invIntegral;
+		return true;
 	}
 
-	void EnvironmentLight::computeCdfAliasMaps()
+	static void writeSamplingCache(const uint64_t key, const unsigned int width, const unsigned int height, const bool prefilter, const std::vector<AliasData>& aliasMap, const float invIntegral)
 	{
-		const unsigned int width = envTexture->dimension[0];
-		const unsigned int height = envTexture->dimension[1];
-		const math::vec3f ntscLuminance{ 0.30f, 0.59f, 0.11f };
+		SamplingCacheHeader header{};
+		std::memcpy(header.magic, samplingCacheMagic, sizeof(samplingCacheMagic));
+		header.version     = samplingCacheVersion;
+		header.width       = width;
+		header.height      = height;
+		header.prefilter   = prefilter ? 1u : 0u;
+		header.key         = key;
+		header.invIntegral = invIntegral;
+
+		utl::writeFileAtomically(getSamplingCachePath(key), [&header, &aliasMap](std::ofstream& outFile)
+		{
+			outFile.write(reinterpret_cast<const char*>(&header), sizeof(SamplingCacheHeader));
+			outFile.write(reinterpret_cast<const char*>(aliasMap.data()), (std::streamsize)(aliasMap.size() * sizeof(AliasData)));
+		});
+	}
 
-		const auto         pixels = static_cast<const float*>(envTexture->imageLayersPointers[0]);
-		importanceData.resize(width * height);
-		aliasMap.resize(width * height);
-		// Create importance sampling data
-		float cosTheta0 = 1.0f;
-		const float stepPhi = float(2.0 * M_PI) / float(width);
+	// Solid angle of a texel in row y of the lat-long map
+	static float getTexelSolidAngle(const size_t y, const unsigned int width, const unsigned int height)
+	{
+		const float stepPhi   = float(2.0 * M_PI) / float(width);
 		const float stepTheta = float(M_PI) / float(height);
-		for (unsigned int y = 0; y < height; ++y)
-		{
-			const float theta1 = float(y + 1) * stepTheta;
-			const float cosTheta1 = std::cos(theta1);
-			const float area = (cosTheta0 - cosTheta1) * stepPhi;
-			cosTheta0 = cosTheta1;
-
-			for (unsigned int x = 0; x < width; ++x) {
-				const unsigned int idx = y * width + x;
-				const unsigned int idx4 = idx * 4;
-				//importanceData[idx] = area * std::max(pixels[idx4], std::max(pixels[idx4 + 1], pixels[idx4 + 2]));
-				//importanceData[idx] = area * (pixels[idx4] + pixels[idx4 + 1] + pixels[idx4 + 2]) * 0.3333333333f;
-				const float       luminance = dot(math::vec3f(pixels[idx4], pixels[idx4 + 1], pixels[idx4 + 2]), ntscLuminance);
-				float value = vtx::ops::gaussianFilter(pixels, width, height, x, y, true);
-				value = luminance;
-				importanceData[idx] = area * (value);
+		return (std::cos(float(y) * stepTheta) - std::cos(float(y + 1) * stepTheta)) * stepPhi;
+	}
+
+	// The histogram of the sampled texels is taken on a coarse lat-long grid. Also checks that the pdf integrates to one over the sphere.
+	bool validateEnvironmentSampling(const std::vector<AliasData>& aliasMap, const std::vector<float>& importance, const unsigned int width, const unsigned int height, const std::string& name)
+	{
+		constexpr unsigned binsX      = 64;
+		constexpr unsigned binsY      = 32;
+		constexpr unsigned numBins    = binsX * binsY;
+		constexpr unsigned numChunks  = 64;
+		constexpr size_t   numSamples = 1 << 22;
+
+		const size_t size = aliasMap.size();
+		auto getBin = [&](const size_t idx)
+		{
+			const size_t y = idx / width;
+			const size_t x = idx % width;
+			return (unsigned)(y * binsY / height) * binsX + (unsigned)(x * binsX / width);
+		};
+
+		std::vector<std::vector<double>> expectedChunks(numChunks, std::vector<double>(numBins, 0.0));
+		std::vector<std::vector<double>> observedChunks(numChunks, std::vector<double>(numBins, 0.0));
+		std::vector<double>              pdfIntegrals(numChunks, 0.0);
+		utl::parallelFor(numChunks, [&](const size_t chunk)
+		{
+			for (size_t y = height * chunk / numChunks; y < height * (chunk + 1) / numChunks; ++y)
+			{
+				const double solidAngle = getTexelSolidAngle(y, width, height);
+				for (size_t x = 0; x < width; ++x)
+				{
+					const size_t idx = y * width + x;
+					expectedChunks[chunk][getBin(idx)] += importance[idx];
+					pdfIntegrals[chunk] += aliasMap[idx].pdf * solidAngle;
+				}
+			}
+
+			std::mt19937                          rng((unsigned)chunk);
+			std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+			for (size_t i = 0; i < numSamples / numChunks; ++i)
+			{
+				const size_t idx     = std::min<size_t>((size_t)(uniform(rng) * (float)size), size - 1);
+				const size_t sampled = uniform(rng) < aliasMap[idx].q ? idx : aliasMap[idx].alias;
+				observedChunks[chunk][getBin(sampled)] += 1.0;
+			}
+		});
+
+		std::vector<double> expected(numBins, 0.0);
+		std::vector<double> observed(numBins, 0.0);
+		double              pdfIntegral = 0.0;
+		for (unsigned chunk = 0; chunk < numChunks; ++chunk)
+		{
+			for (unsigned bin = 0; bin < numBins; ++bin)
+			{
+				expected[bin] += expectedChunks[chunk][bin];
+				observed[bin] += observedChunks[chunk][bin];
 			}
+			pdfIntegral += pdfIntegrals[chunk];
 		}
 
-		const float invEnvIntegral = 1.0f / buildAliasMap(importanceData, width * height, aliasMap);
-		for (unsigned int y = 0; y < height; ++y) {
-			for (unsigned int x = 0; x < width; ++x) {
-				const unsigned int idx = y * width + x;
-				const unsigned int idx4 = idx * 4;
-				//aliasMap[i].pdf = std::max(pixels[idx4], std::max(pixels[idx4 + 1], pixels[idx4 + 2])) * invEnvIntegral;
-				const float       luminance = dot(math::vec3f(pixels[idx4], pixels[idx4 + 1], pixels[idx4 + 2]), ntscLuminance);
+		double total = 0.0;
+		for (const double value : expected)
+		{
+			total += value;
+		}
+		if (total <= 0.0)
+		{
+			return true;
+		}
 
-				float value = vtx::ops::gaussianFilter(pixels, width, height, x, y, true);
+		// Total variation distance between the histograms, and the one expected from the sample noise alone
+		double distance = 0.0;
+		double noise    = 0.0;
+		for (unsigned bin = 0; bin < numBins; ++bin)
+		{
+			const double p = expected[bin] / total;
+			distance += 0.5 * std::abs(observed[bin] / (double)numSamples - p);
+			noise += 0.5 * std::sqrt(2.0 * p * (1.0 - p) / (M_PI * (double)numSamples));
+		}
 
-				value = luminance;
-				aliasMap[idx].pdf = value * invEnvIntegral;
+		if (distance > 4.0 * noise + 1e-3 || std::abs(pdfIntegral - 1.0) > 1e-2)
+		{
+			VTX_WARN("Environment sampling check for {} failed: histogram distance {:.5f} (noise {:.5f}), pdf integral {:.5f}", name, distance, noise, pdfIntegral);
+			return false;
+		}
+		VTX_INFO("Environment sampling check for {}: histogram distance {:.5f} (noise {:.5f}), pdf integral {:.5f}", name, distance, noise, pdfIntegral);
+		return true;
+	}
+
+	float buildEnvironmentSampling(const float* pixels, const unsigned int width, const unsigned int height, const bool prefilter, std::vector<float>& importance, std::vector<AliasData>& aliasMap)
+	{
+		// The optional prefilter spreads the importance to the neighbours, so that black texels next to bright ones can
+		// still be sampled.
+		const math::vec3f ntscLuminance{ 0.30f, 0.59f, 0.11f };
+		importance.resize((size_t)width * height);
+		utl::parallelFor(height, [&](const size_t y)
+		{
+			const float area = getTexelSolidAngle(y, width, height);
+			for (unsigned int x = 0; x < width; ++x)
+			{
+				const size_t idx   = y * width + x;
+				const float* p     = pixels + idx * 4;
+				const float  value = prefilter ?
+					vtx::ops::gaussianFilter(pixels, width, height, x, (unsigned int)y, true) :
+					dot(math::vec3f(p[0], p[1], p[2]), ntscLuminance);
+				importance[idx] = area * value;
+			}
+		}, 16);
+
+		const double sum         = ops::buildAliasMap(importance, aliasMap);
+		const float  invIntegral = sum > 0.0 ? (float)(1.0 / sum) : 0.0f;
+
+		// The alias map stores the probability of the texel, the renderer needs the pdf over solid angle
+		utl::parallelFor(height, [&](const size_t y)
+		{
+			const float invArea = 1.0f / getTexelSolidAngle(y, width, height);
+			for (size_t idx = y * width; idx < (y + 1) * width; ++idx)
+			{
+				aliasMap[idx].pdf = sum > 0.0 ? importance[idx] * invArea * invIntegral : float(0.25 * M_1_PI);
 			}
+		}, 16);
+		return invIntegral;
+	}
+
+	void EnvironmentLight::computeCdfAliasMaps()
+	{
+		Timer timer;
+
+		const unsigned int width     = envTexture->dimension[0];
+		const unsigned int height    = envTexture->dimension[1];
+		const auto         pixels    = static_cast<const float*>(envTexture->imageLayersPointers[0]);
+		const bool         prefilter = getOptions()->envMapPrefilter;
+
+		PreparedDataStore* store    = PreparedDataStore::get();
+		uint64_t           cacheKey = 0;
+		samplingKey                 = 0;
+		if (getOptions()->envMapSamplingCache || getOptions()->embedPreparedData || store->hasKind(PD_ENV_SAMPLING))
+		{
+			cacheKey    = computeSamplingCacheKey(pixels, width, height, prefilter);
+			samplingKey = PreparedDataStore::computeKey(PD_ENV_SAMPLING, cacheKey, 0);
 		}
+		if (store->hasKind(PD_ENV_SAMPLING))
+		{
+			std::vector<char> blob;
+			if (store->find(PD_ENV_SAMPLING, samplingKey, blob))
+			{
+				PreparedDataReader reader(blob);
+				unsigned int       preparedWidth, preparedHeight;
+				if (reader.readValue(preparedWidth) && reader.readValue(preparedHeight) && reader.readValue(invIntegral) &&
+					reader.read(aliasMap) && reader.isComplete() &&
+					preparedWidth == width && preparedHeight == height && aliasMap.size() == (size_t)width * height)
+				{
+					importanceData.clear();
+					VTX_INFO("Env light sampling for {} loaded from the scene file in {} ms", envTexture->databaseName, timer.elapsedMillis());
+					return;
+				}
+			}
+		}
+		if (getOptions()->envMapSamplingCache)
+		{
+			if (readSamplingCache(cacheKey, width, height, aliasMap, invIntegral))
+			{
+				importanceData.clear();
+				VTX_INFO("Env light sampling for {} loaded from cache in {} ms", envTexture->databaseName, timer.elapsedMillis());
+				return;
+			}
+		}
+
+		invIntegral = buildEnvironmentSampling(pixels, width, height, prefilter, importanceData, aliasMap);
+		if (getOptions()->validateLightSampling)
+		{
+			validateEnvironmentSampling(aliasMap, importanceData, width, height, envTexture->databaseName);
+		}
+		if (getOptions()->envMapSamplingCache)
+		{
+			writeSamplingCache(cacheKey, width, height, prefilter, aliasMap, invIntegral);
+		}
+
+		VTX_INFO("Env light sampling for {} ({}x{}) built in {} ms", envTexture->databaseName, width, height, timer.elapsedMillis());
 	}
-}
 
+	bool EnvironmentLight::getPreparedData(PreparedData& data) const
+	{
+		if (samplingKey == 0 || !envTexture || aliasMap.empty())
+		{
+			return false;
+		}
+		data.kind = PD_ENV_SAMPLING;
+		data.key  = samplingKey;
+		data.appendValue(envTexture->dimension[0]);
+		data.appendValue(envTexture->dimension[1]);
+		data.appendValue(invIntegral);
+		data.append(aliasMap);
+		return true;
+	}
+}
@@ -4,6 +4,7 @@
 
 namespace vtx::graph
 {
+	struct PreparedData;
 
 	class EnvironmentLight : public Node
 	{
@@ -16,6 +17,9 @@ namespace vtx::graph
 
 		std::vector<std::shared_ptr<Node>> getChildren() const override;
 
+		// Sampling data to embed in a saved scene, false if it has not been computed
+		bool getPreparedData(PreparedData& data) const;
+
 	protected:
 
 		void accept(NodeVisitor& visitor) override;
@@ -34,7 +38,15 @@ namespace vtx::graph
 		std::vector<float>								importanceData;
 
 		float invIntegral;
+		uint64_t							samplingKey = 0;
 		bool								isValid = false;
 
 	};
+
+	// Importance (luminance times solid angle) of every texel of a lat-long rgba float map and its alias map, the pdf of
+	// the entries is over solid angle. Returns the inverse of the importance integral, 0 for a black map.
+	float buildEnvironmentSampling(const float* pixels, unsigned int width, unsigned int height, bool prefilter, std::vector<float>& importance, std::vector<AliasData>& aliasMap);
+
+	// Samples the alias map the way the renderer does and compares the histogram with the importance, returns false on a mismatch
+	bool validateEnvironmentSampling(const std::vector<AliasData>& aliasMap, const std::vector<float>& importance, unsigned int width, unsigned int height, const std::string& name);
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "Group.h"
 #include <memory>
 #include "Scene/Traversal.h"
+#include "Scene/TransformHierarchy.h"
 #include "Scene/Utility/Operations.h"
 
 namespace vtx::graph
@@ -27,6 +28,7 @@ namespace vtx::graph
 		if(newChildType == NT_GROUP || newChildType == NT_INSTANCE || newChildType == NT_TRANSFORM)
 		{
 			children.push_back(child);
+			TransformHierarchy::get()->markTopologyChanged();
 		}
 		else
 		{
@@ -4,6 +4,7 @@
 #include "MeshLight.h"
 #include "Scene/Scene.h"
 #include "Scene/SceneIndexManager.h"
+#include "Scene/TransformHierarchy.h"
 
 namespace vtx::graph
 {
@@ -34,6 +35,7 @@ namespace vtx::graph
 			}
 		}
 		child = _child ;
+		TransformHierarchy::get()->markTopologyChanged();
 		if (child->getType() == NT_MESH)
 		{
 			childIsMesh = true;
@@ -80,7 +82,7 @@ namespace vtx::graph
 
 		if (childIsMesh)
 		{
-			materialSlot->meshLight->mesh = std::dynamic_pointer_cast<graph::Mesh>(getChild());
+			materialSlot->meshLight->mesh = nodeCast<Mesh>(getChild());
 		}
 	} 
 
@@ -113,23 +115,20 @@ namespace vtx::graph
 
 	void Instance::clearMeshLights() const
 	{
-		for (auto it : materialSlots)
+		// The mesh lights keep their ids, releasing them would drop the lights from the scene index while they are still in use
+		for (const auto& it : materialSlots)
 		{
-			Scene::getSim()->releaseUID(it.meshLight->getUID());
-			Scene::getSim()->releaseTypeId(it.meshLight->getTypeID(), NT_MESH_LIGHT);
-			it.meshLight = nullptr;
+			it.meshLight->state.isInitialized = false;
 		}
 	}
 
 	void Instance::clearMeshLight(const vtxID matID) const
 	{
-		for (auto it : materialSlots)
+		for (const auto& it : materialSlots)
 		{
 			if(it.material->getUID() == matID)
 			{
-				Scene::getSim()->releaseUID(it.meshLight->getUID());
-				Scene::getSim()->releaseTypeId(it.meshLight->getTypeID(), NT_MESH_LIGHT);
-				it.meshLight = nullptr;
+				it.meshLight->state.isInitialized = false;
 			}
 		}
 	}
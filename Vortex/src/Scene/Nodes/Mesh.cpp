@@ -1,4 +1,5 @@
 #include "Mesh.h"
+#include "Core/Log.h"
 #include "Scene/SceneIndexManager.h"
 #include "Scene/Traversal.h"
 
@@ -16,6 +17,107 @@ namespace vtx::graph
 	{
 		return {};
 	}
+
+	bool Mesh::isReady() const
+	{
+		return payloadState.load() == PS_LOADED && !isPreparing.load() && status.hasFaceAttributes && status.hasNormals && status.hasTangents;
+	}
+
+	void Mesh::setPayloadSource(std::shared_ptr<const MeshPayloadSource> source)
+	{
+		std::lock_guard<std::mutex> lock(payloadMutex);
+		payloadSource = std::move(source);
+		payloadState.store(PS_DEFERRED);
+	}
+
+	std::shared_ptr<const MeshPayloadSource> Mesh::getPayloadSource()
+	{
+		std::lock_guard<std::mutex> lock(payloadMutex);
+		return payloadState.load() == PS_DEFERRED ? payloadSource : nullptr;
+	}
+
+	bool Mesh::loadPayload()
+	{
+		if (payloadState.load() != PS_DEFERRED)
+		{
+			return payloadState.load() == PS_LOADED;
+		}
+		std::lock_guard<std::mutex> lock(payloadMutex);
+		if (payloadState.load() != PS_DEFERRED)
+		{
+			return payloadState.load() == PS_LOADED;
+		}
+		MeshPayload payload;
+		const bool  isLoaded = payloadSource->read(payload);
+		if (isLoaded)
+		{
+			vertices       = std::move(payload.vertices);
+			indices        = std::move(payload.indices);
+			faceAttributes = std::move(payload.faceAttributes);
+		}
+		// The source keeps the file mapped, it is released as soon as it is not needed anymore
+		payloadSource = nullptr;
+		payloadState.store(isLoaded ? PS_LOADED : PS_FAILED);
+		if (!isLoaded)
+		{
+			VTX_ERROR("Mesh {}: could not load its vertices from the saved scene", getUID());
+		}
+		return isLoaded;
+	}
+
+	bool Mesh::copyPayload(MeshPayload& payload, std::shared_ptr<const MeshPayloadSource>& source)
+	{
+		std::lock_guard<std::mutex> lock(payloadMutex);
+		payload.status = status;
+		source         = nullptr;
+		if (payloadState.load() == PS_LOADED)
+		{
+			payload.vertices       = vertices;
+			payload.indices        = indices;
+			payload.faceAttributes = faceAttributes;
+			return true;
+		}
+		if (payloadState.load() == PS_FAILED)
+		{
+			return false;
+		}
+		// The source is kept until the payload is published, the mesh arrays are still empty
+		source = payloadSource;
+		return true;
+	}
+
+	bool Mesh::readPayload(const std::shared_ptr<const MeshPayloadSource>& source, MeshPayload& payload)
+	{
+		// Sources are immutable, the file is read without holding the lock
+		if (source->read(payload))
+		{
+			return true;
+		}
+		std::lock_guard<std::mutex> lock(payloadMutex);
+		if (payloadState.load() == PS_DEFERRED && payloadSource == source)
+		{
+			payloadSource = nullptr;
+			payloadState.store(PS_FAILED);
+		}
+		VTX_ERROR("Mesh {}: could not load its vertices from the saved scene", getUID());
+		return false;
+	}
+
+	void Mesh::publishPayload(MeshPayload&& payload)
+	{
+		std::lock_guard<std::mutex> lock(payloadMutex);
+		vertices       = std::move(payload.vertices);
+		indices        = std::move(payload.indices);
+		faceAttributes = std::move(payload.faceAttributes);
+		status         = payload.status;
+		payloadSource  = nullptr;
+		payloadState.store(PS_LOADED);
+	}
+
+	Mesh::PayloadState Mesh::getPayloadState() const
+	{
+		return payloadState.load();
+	}
 	void Mesh::accept(NodeVisitor& visitor)
 	{
 		visitor.visit(as<Mesh>());
@@ -1,6 +1,11 @@
 #pragma once
 #include "Scene/Node.h"
 #include "Scene/DataStructs/VertexAttribute.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
 
 namespace vtx::graph
 {
@@ -12,13 +17,68 @@ namespace vtx::graph
 		bool hasFaceAttributes = false;
 	};
 
+	// Arrays of a mesh handled outside of the node, by the deferred loader and by the background preparation
+	struct MeshPayload
+	{
+		std::vector<VertexAttributes> vertices;
+		std::vector<vtxID>            indices;
+		std::vector<FaceAttributes>   faceAttributes;
+		MeshStatus                    status;
+	};
+
+	// Where the arrays of a deferred mesh are read from, e.g. the sections of a mapped scene file. Sources are immutable and
+	// shared, a save can write the arrays straight from the source without loading them into the mesh.
+	class MeshPayloadSource
+	{
+	public:
+		virtual ~MeshPayloadSource() = default;
+
+		// Fills the arrays of the payload, the status is left untouched
+		virtual bool read(MeshPayload& payload) const = 0;
+
+		virtual const std::string& getFilePath() const = 0;
+	};
+
 	class Mesh : public Node {
 	public:
+		enum PayloadState : uint8_t
+		{
+			PS_LOADED,
+			PS_DEFERRED, // The arrays are still in the saved scene, they are read on first access
+			PS_FAILED
+		};
+
 		Mesh();
 
 		~Mesh();
 
 		std::vector<std::shared_ptr<Node>> getChildren() const override;
+
+		// True once face attributes, normals and tangents are available and no background preparation is running
+		bool isReady() const;
+
+		// The arrays are read from the source on first access instead of when the mesh is restored
+		void setPayloadSource(std::shared_ptr<const MeshPayloadSource> source);
+
+		// Source of the deferred arrays, nullptr once they are loaded
+		std::shared_ptr<const MeshPayloadSource> getPayloadSource();
+
+		// Reads the deferred arrays if needed, returns false if they are not available
+		bool loadPayload();
+
+		// Copies the status and the loaded arrays into the payload. Deferred arrays are not read, their source is returned
+		// in source instead. Returns false if the arrays failed to load. The arrays are read without locks, only the main
+		// thread may call it while it is the one modifying them.
+		bool copyPayload(MeshPayload& payload, std::shared_ptr<const MeshPayloadSource>& source);
+
+		// Reads the deferred arrays from a source returned by copyPayload without touching the mesh, can be called from any
+		// thread. If they can't be read the mesh is marked as failed, unless it has been loaded in the meantime.
+		bool readPayload(const std::shared_ptr<const MeshPayloadSource>& source, MeshPayload& payload);
+
+		// Replaces the arrays and status of the mesh, only the main thread may call it since the arrays are read without locks
+		void publishPayload(MeshPayload&& payload);
+
+		PayloadState getPayloadState() const;
 	protected:
 		void accept(NodeVisitor& visitor) override;
 	public:
@@ -26,6 +86,11 @@ namespace vtx::graph
 		std::vector<vtxID>            indices; // indices for triangles (every 3 indices define a triangle)
 		std::vector<FaceAttributes>   faceAttributes;
 		MeshStatus                    status;
+		std::atomic<bool>             isPreparing{ false };
+	private:
+		std::shared_ptr<const MeshPayloadSource> payloadSource;
+		std::atomic<PayloadState>                payloadState{ PS_LOADED };
+		std::mutex                               payloadMutex;
 	};
 
 }
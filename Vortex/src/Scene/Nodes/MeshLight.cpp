@@ -2,6 +2,15 @@
 #include "Scene/Traversal.h"
 #include "Material.h"
 #include "Mesh.h"
+#include "Core/ThreadPool.h"
+#include "Device/Structs/MeshLightSampling.h"
+#include "Core/Hashing.h"
+#include "Scene/Utility/Operations.h"
+#include "Scene/Utility/PreparedDataStore.h"
+#include <cfloat>
+#include <map>
+#include <mutex>
+#include <random>
 
 namespace vtx::graph
 {
@@ -17,8 +26,8 @@ namespace vtx::graph
 
 	void MeshLight::init()
 	{
-		computeAreaCdf();
-		isValid = (cdfAreas.size() > 1);
+		emissiveTriangles = getEmissiveTriangles(mesh, materialRelativeIndex);
+		isValid = !emissiveTriangles->triangleIndices.empty() && emissiveTriangles->area > 0.0f;
 		state.isInitialized = true;
 	}
 
@@ -36,76 +45,249 @@ namespace vtx::graph
 		visitor.visit(as<MeshLight>());
 	}
 
-	inline void MeshLight::computeAreaCdf()
+	// The lights hold the tables, the cache only finds them again for other instances of the same mesh
+	static std::mutex                                                                 cacheMutex;
+	static std::map<std::pair<vtxID, unsigned int>, std::weak_ptr<EmissiveTriangles>> cache;
+	static size_t                                                                     cacheSweepSize = 64;
+
+	// Tables released with their lights leave expired entries, they are swept once the cache has doubled since the last sweep
+	static void sweepExpiredTables()
 	{
-		VTX_INFO("Computing Mesh Area Light for Mesh {} with Material {}", mesh->getUID(), material->getUID());
-		const size_t numTriangles = mesh->indices.size() / 3;
-		size_t actualNumTriangles = 0;
+		if (cache.size() < cacheSweepSize)
+		{
+			return;
+		}
+		for (auto it = cache.begin(); it != cache.end();)
+		{
+			it = it->second.expired() ? cache.erase(it) : std::next(it);
+		}
+		cacheSweepSize = std::max<size_t>(64, cache.size() * 2);
+	}
 
-		float areaSurface = 0.0f;
-		cdfAreas.push_back(areaSurface); // CDF starts with zero. One element more than number of triangles.
+	static uint64_t computePreparedKey(const std::shared_ptr<Mesh>& mesh, const unsigned int materialSlot)
+	{
+		mesh->loadPayload();
+		uint64_t meshHash = utl::hashValue(materialSlot);
+		meshHash          = utl::hashCombine(meshHash, utl::hashBytesParallel(mesh->vertices.data(), mesh->vertices.size() * sizeof(VertexAttributes)));
+		meshHash          = utl::hashCombine(meshHash, utl::hashBytesParallel(mesh->indices.data(), mesh->indices.size() * sizeof(vtxID)));
+		meshHash          = utl::hashCombine(meshHash, utl::hashBytesParallel(mesh->faceAttributes.data(), mesh->faceAttributes.size() * sizeof(FaceAttributes)));
+		return PreparedDataStore::computeKey(PD_EMISSIVE_TRIANGLES, meshHash, 0);
+	}
 
-		for (size_t i = 0; i < numTriangles; ++i)
+	static std::shared_ptr<EmissiveTriangles> readPreparedEmissiveTriangles(const std::shared_ptr<Mesh>& mesh, const unsigned int materialSlot, const uint64_t key)
+	{
+		std::vector<char> blob;
+		if (!PreparedDataStore::get()->find(PD_EMISSIVE_TRIANGLES, key, blob))
+		{
+			return nullptr;
+		}
+
+		auto               table = std::make_shared<EmissiveTriangles>();
+		PreparedDataReader reader(blob);
+		table->mesh         = mesh;
+		table->materialSlot = materialSlot;
+		table->preparedKey  = key;
+		reader.read(table->triangleIndices);
+		reader.read(table->aliasMap);
+		reader.readValue(table->area);
+		reader.readValue(table->boundsMin);
+		reader.readValue(table->boundsMax);
+		reader.readValue(table->normalAxis);
+		reader.readValue(table->normalCosTheta);
+		if (!reader.isComplete() || table->aliasMap.size() != table->triangleIndices.size())
 		{
-			FaceAttributes& face = mesh->faceAttributes[i];
-			unsigned int materialSlotId = face.materialSlotId;
+			return nullptr;
+		}
+		return table;
+	}
 
-			if (materialSlotId != materialRelativeIndex)
+	static std::shared_ptr<EmissiveTriangles> buildEmissiveTriangles(const std::shared_ptr<Mesh>& mesh, const unsigned int materialSlot)
+	{
+		VTX_INFO("Computing Emissive Triangles for Mesh {} Material Slot {}", mesh->getUID(), materialSlot);
+		mesh->loadPayload();
+		auto table          = std::make_shared<EmissiveTriangles>();
+		table->mesh         = mesh;
+		table->materialSlot = materialSlot;
+
+		const size_t numTriangles = mesh->indices.size() / 3;
+		for (size_t i = 0; i < numTriangles; ++i)
+		{
+			if (mesh->faceAttributes[i].materialSlotId == materialSlot)
 			{
-				continue;
+				table->triangleIndices.push_back((unsigned int)i);
 			}
-			actualNumTriangles++;
+		}
 
-			const size_t idx = i * 3;
+		// All in object space, the instances apply their transform at sampling time
+		std::vector<float> areas(table->triangleIndices.size());
+		table->boundsMin = math::vec3f(FLT_MAX);
+		table->boundsMax = math::vec3f(-FLT_MAX);
+		math::vec3f normalSum(0.0f);
+		for (size_t i = 0; i < table->triangleIndices.size(); ++i)
+		{
+			const size_t      idx = table->triangleIndices[i] * 3;
+			const math::vec3f v0  = mesh->vertices[mesh->indices[idx]].position;
+			const math::vec3f v1  = mesh->vertices[mesh->indices[idx + 1]].position;
+			const math::vec3f v2  = mesh->vertices[mesh->indices[idx + 2]].position;
 
-			const unsigned int i0 = mesh->indices[idx];
-			const unsigned int i1 = mesh->indices[idx + 1];
-			const unsigned int i2 = mesh->indices[idx + 2];
+			table->boundsMin = min(table->boundsMin, min(v0, min(v1, v2)));
+			table->boundsMax = max(table->boundsMax, max(v0, max(v1, v2)));
+			normalSum += cross(v1 - v0, v2 - v0);
 
-			// All in object space.
-			const math::vec3f v0 = mesh->vertices[i0].position;
-			const math::vec3f v1 = mesh->vertices[i1].position;
-			const math::vec3f v2 = mesh->vertices[i2].position;
+			// Zero area triangles (e.g. at the poles of spheres) get a zero weight and are never sampled
+			areas[i] = meshLightSampling::triangleArea(v0, v1, v2);
+		}
+		table->area = (float)ops::buildAliasMap(areas, table->aliasMap);
 
-#ifdef AREA_COORDINATE_SYSTEM_TRANSFORMED
-			// TODO Why should I change coordinate system if I ma just computing the area of a triangle?
-			// PERF Work in world space to do fewer transforms during explicit light hits.
-			math::vec3f p0(math::vec4f(v0.x, v0.y, v0.z, 1.0f) * matrix);
-			math::vec3f p1(math::vec4f(v1.x, v1.y, v1.z, 1.0f) * matrix);
-			math::vec3f p2(math::vec4f(v2.x, v2.y, v2.z, 1.0f) * matrix);
-			math::vec3f e0 = p1 - p0;
-			math::vec3f e1 = p2 - p0;
-#else
-			math::vec3f e0 = v1 - v0;
-			math::vec3f e1 = v2 - v0;
-#endif
+		// The normal cone is kept only if all the triangles face the same hemisphere
+		table->normalCosTheta = -1.0f;
+		if (!math::isZero(normalSum))
+		{
+			table->normalAxis     = math::normalize(normalSum);
+			table->normalCosTheta = 1.0f;
+			for (const unsigned int triangle : table->triangleIndices)
+			{
+				const math::vec3f& v0 = mesh->vertices[mesh->indices[triangle * 3]].position;
+				const math::vec3f& v1 = mesh->vertices[mesh->indices[triangle * 3 + 1]].position;
+				const math::vec3f& v2 = mesh->vertices[mesh->indices[triangle * 3 + 2]].position;
+				const math::vec3f  n  = cross(v1 - v0, v2 - v0);
+				if (!math::isZero(n))
+				{
+					table->normalCosTheta = std::min(table->normalCosTheta, dot(math::normalize(n), table->normalAxis));
+				}
+			}
+			if (table->normalCosTheta < 0.0f)
+			{
+				table->normalCosTheta = -1.0f;
+			}
+		}
 
+		return table;
+	}
 
-			// The triangle area is half of the parallelogram area (length of cross product).
-			const float area = math::length(cross(e0, e1)) * 0.5f;
-			//const float area = dp::math::length(e0 ^ e1) * 0.5f;
+	std::shared_ptr<EmissiveTriangles> MeshLight::getEmissiveTriangles(const std::shared_ptr<Mesh>& mesh, const unsigned int materialSlot)
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		const auto key = std::make_pair(mesh->getUID(), materialSlot);
+		if (const auto it = cache.find(key); it != cache.end())
+		{
+			if (std::shared_ptr<EmissiveTriangles> table = it->second.lock(); table != nullptr && table->mesh == mesh)
+			{
+				return table;
+			}
+		}
+		std::shared_ptr<EmissiveTriangles> table;
+		if (PreparedDataStore::get()->hasKind(PD_EMISSIVE_TRIANGLES))
+		{
+			table = readPreparedEmissiveTriangles(mesh, materialSlot, computePreparedKey(mesh, materialSlot));
+		}
+		if (table == nullptr)
+		{
+			table = buildEmissiveTriangles(mesh, materialSlot);
+		}
+		cache[key] = table;
+		sweepExpiredTables();
+		return table;
+	}
 
-			areaSurface += area;
+	void MeshLight::collectPreparedData(std::vector<PreparedData>& preparedData)
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		for (const auto& [key, weakTable] : cache)
+		{
+			const std::shared_ptr<EmissiveTriangles> table = weakTable.lock();
+			if (table == nullptr || table->mesh == nullptr || table->mesh->getPayloadState() != Mesh::PS_LOADED)
+			{
+				continue;
+			}
+			if (table->preparedKey == 0)
+			{
+				table->preparedKey = computePreparedKey(table->mesh, table->materialSlot);
+			}
+			PreparedData& data = preparedData.emplace_back();
+			data.kind          = PD_EMISSIVE_TRIANGLES;
+			data.key           = table->preparedKey;
+			data.append(table->triangleIndices);
+			data.append(table->aliasMap);
+			data.appendValue(table->area);
+			data.appendValue(table->boundsMin);
+			data.appendValue(table->boundsMax);
+			data.appendValue(table->normalAxis);
+			data.appendValue(table->normalCosTheta);
+		}
+	}
 
-			cdfAreas.push_back(areaSurface); // Store the unnormalized sums of triangle surfaces.
-			actualTriangleIndices.push_back(i);
+	float EmissiveTriangles::computeWorldArea(const math::affine3f& transform) const
+	{
+		if (const float scale = meshLightSampling::uniformAreaScale(transform); scale >= 0.0f)
+		{
+			return area * scale;
 		}
 
-		// Normalize the CDF values. 
-		// PERF This means only the area integral value is in world space and the CDF could be reused for instanced mesh lights.
-		for (auto& val : cdfAreas)
+		constexpr size_t    blockSize = 16384;
+		std::vector<double> blockAreas((triangleIndices.size() + blockSize - 1) / blockSize);
+		utl::parallelFor(blockAreas.size(), [&](const size_t block)
 		{
-			val /= areaSurface;
-			// The last cdf element will automatically be 1.0f.
-			// If this happens to be smaller due to inaccuracies in the floating point calculations, 
-			// the clamping to valid triangle indices inside the sample_light_mesh() function will 
-			// prevent out of bounds accesses, no need for corrections here.
-			// (The corrections would be to set all identical values below 1.0f at the end of this array to 1.0f.)
+			const size_t end = std::min((block + 1) * blockSize, triangleIndices.size());
+			double       sum = 0.0;
+			for (size_t i = block * blockSize; i < end; ++i)
+			{
+				const size_t idx = triangleIndices[i] * 3;
+				sum += meshLightSampling::worldTriangleArea(transform,
+															 mesh->vertices[mesh->indices[idx]].position,
+															 mesh->vertices[mesh->indices[idx + 1]].position,
+															 mesh->vertices[mesh->indices[idx + 2]].position);
+			}
+			blockAreas[block] = sum;
+		});
+
+		double worldArea = 0.0;
+		for (const double blockArea : blockAreas)
+		{
+			worldArea += blockArea;
 		}
+		return (float)worldArea;
+	}
 
-		area = areaSurface;
+	void MeshLight::validateSampling(const math::affine3f& transform, const float worldArea) const
+	{
+		// E[1 / pdf] over the sampled points is the world area of the light, whatever the transform
+		constexpr int                         numSamples = 1 << 16;
+		const EmissiveTriangles&              table      = *emissiveTriangles;
+		std::mt19937                          rng(getUID());
+		std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+		double                                sum        = 0.0;
+		double                                sumSquares = 0.0;
+		float                                 maxTableError = 0.0f;
+		for (int i = 0; i < numSamples; ++i)
+		{
+			float             probability;
+			const int         local = lightSelection::sampleAliasTable(table.aliasMap.data(), (int)table.aliasMap.size(), uniform(rng), &probability);
+			const size_t      idx   = table.triangleIndices[local] * 3;
+			const math::vec3f v0    = mesh->vertices[mesh->indices[idx]].position;
+			const math::vec3f v1    = mesh->vertices[mesh->indices[idx + 1]].position;
+			const math::vec3f v2    = mesh->vertices[mesh->indices[idx + 2]].position;
+
+			// The renderer recomputes the probability of the triangle from its vertices, it has to agree with the table
+			const float objectArea = meshLightSampling::triangleArea(v0, v1, v2);
+			maxTableError = std::max(maxTableError, fabsf(objectArea / table.area - probability) / probability);
+
+			const float  pdf     = meshLightSampling::areaPdf(objectArea, table.area, meshLightSampling::worldTriangleArea(transform, v0, v1, v2));
+			const double inverse = pdf > 0.0f ? 1.0 / (double)pdf : 0.0;
+			sum += inverse;
+			sumSquares += inverse * inverse;
+		}
 
-		VTX_INFO("Fnished Computation of Mesh Area Light for Mesh {} with Material {}", mesh->getUID(), material->getUID());
+		const double mean          = sum / numSamples;
+		const double standardError = std::sqrt(std::max(sumSquares / numSamples - mean * mean, 0.0) / numSamples);
+		if (std::abs(mean - worldArea) > 5.0 * standardError + 1e-4 * worldArea || maxTableError > 1e-3f)
+		{
+			VTX_WARN("Mesh light sampling check for light {} failed: estimated area {} (+- {}), world area {}, table error {}", getUID(), mean, standardError, worldArea, maxTableError);
+		}
+		else
+		{
+			VTX_INFO("Mesh light sampling check for light {}: estimated area {} (+- {}), world area {}", getUID(), mean, standardError, worldArea);
+		}
 	}
 
 }
@@ -1,8 +1,33 @@
 ﻿#pragma once
 #include "Scene/Node.h"
+#include "Core/Math.h"
+#include "Device/Structs/LightSelection.h"
 
 namespace vtx::graph
 {
+	struct PreparedData;
+
+	// Emissive triangles of a mesh material slot and their alias table, built from object space areas.
+	// The table only depends on the mesh, the mesh lights of all the instances of the mesh share it.
+	struct EmissiveTriangles
+	{
+		std::shared_ptr<graph::Mesh>	mesh;
+		unsigned int					materialSlot = 0;
+		std::vector<unsigned int>		triangleIndices;
+		std::vector<AliasData>			aliasMap;
+		float							area = 0.0f;
+		// Object space bounds and normal cone of the emissive triangles, used to build the light selection bvh
+		math::vec3f						boundsMin{ 0.0f };
+		math::vec3f						boundsMax{ 0.0f };
+		math::vec3f						normalAxis{ 0.0f, 0.0f, 1.0f };
+		float							normalCosTheta = -1.0f;
+		// Content key of the table when embedded in a saved scene, 0 until it is needed
+		uint64_t						preparedKey = 0;
+
+		// Total area once transformed. It's a scale of the object space area unless the transform has a non-uniform scale,
+		// in which case the triangles are summed on the thread pool.
+		float computeWorldArea(const math::affine3f& transform) const;
+	};
 
 	class MeshLight : public Node
 	{
@@ -14,11 +39,18 @@ namespace vtx::graph
 		void init() override;
 
 		std::vector<std::shared_ptr<Node>> getChildren() const override;
+
+		// Returns the table of the mesh slot, it's only built the first time one of the instances asks for it
+		static std::shared_ptr<EmissiveTriangles> getEmissiveTriangles(const std::shared_ptr<graph::Mesh>& mesh, unsigned int materialSlot);
+
+		// Tables currently in use, to embed in a saved scene
+		static void collectPreparedData(std::vector<PreparedData>& preparedData);
+
+		// Checks on the cpu that the area pdf used by the renderer integrates the world area of the light under the transform
+		void validateSampling(const math::affine3f& transform, float worldArea) const;
 	protected:
 
 		void accept(NodeVisitor& visitor) override;
-	private:
-		void computeAreaCdf();
 	public:
 		//std::shared_ptr<LightAttributes> attributes;
 
@@ -27,9 +59,7 @@ namespace vtx::graph
 		unsigned int						materialRelativeIndex;
 		vtxID								parentInstanceId;
 
-		std::vector<float>					cdfAreas;
-		std::vector<unsigned int>			actualTriangleIndices;
-		float								area;
+		std::shared_ptr<EmissiveTriangles>	emissiveTriangles;
 		bool								isValid = false;
 
 	};
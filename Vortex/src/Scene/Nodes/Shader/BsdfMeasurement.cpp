@@ -2,6 +2,9 @@
 #include "Scene/Traversal.h"
 #include "MDL/mdlWrapper.h"
 #include "Scene/SceneIndexManager.h"
+#include "Core/Hashing.h"
+#include "Core/ThreadPool.h"
+#include <algorithm>
 
 namespace vtx::graph {
 
@@ -18,6 +21,7 @@ namespace vtx::graph {
 		{
 			prepareSampling(transmissionBsdf);
 		}
+		isInitialized = true;
 	}
 
 	void BsdfMeasurement::accept(NodeVisitor& visitor)
@@ -40,7 +44,7 @@ namespace vtx::graph {
 	{
 	}
 
-	void BsdfMeasurement::prepareSampling(BsdfPartData bsdfData)
+	static BsdfSamplingTables computeSamplingTables(const BsdfMeasurement::BsdfPartData& bsdfData)
 	{
 		// CDF of the probability to select a certain theta_out for a given theta_in.
 
@@ -53,18 +57,18 @@ namespace vtx::graph {
 		// For each of theta_in x theta_out combination, a CDF of the probabilities to select a certain theta_out is stored.
 		const unsigned sampleDataSize = cdfThetaSize + cdfThetaSize * res.y;
 
-		bsdfData.sampleData.resize(sampleDataSize);
-		bsdfData.albedoData.resize(res.x);
+		BsdfSamplingTables tables;
+		tables.sampleData.resize(sampleDataSize);
+		tables.albedoData.resize(res.x);
 
-		float* sampleDataTheta = bsdfData.sampleData.data();                  // begin of the first (theta) CDF
-		float* sampleDataPhi = bsdfData.sampleData.data() + cdfThetaSize; // begin of the second (phi) CDFs
+		float* sampleDataTheta = tables.sampleData.data();                  // begin of the first (theta) CDF
+		float* sampleDataPhi = tables.sampleData.data() + cdfThetaSize; // begin of the second (phi) CDFs
 
 		const float sTheta = static_cast<float>((M_PI * 0.5)) / static_cast<float>(res.x); // step size
 		const float sPhi = (float)(M_PI) / static_cast<float>(res.y); // step size
 
-		float maxAlbedo = 0.0f;
-
-		for (unsigned int tIn = 0; tIn < res.x; ++tIn)
+		// The CDFs of each theta_in are independent, they are built in parallel
+		utl::parallelFor(res.x, [&](const size_t tIn)
 		{
 			float sumTheta = 0.0f;
 			float sintheta0Sqd = 0.0f;
@@ -83,8 +87,8 @@ namespace vtx::graph {
 				sintheta0Sqd = sintheta1_sqd;
 
 				// Offset for both the thetas into the measurement data (select row in the volume).
-				const unsigned int offsetPhi = (tIn * res.x + tOut) * res.y;
-				const unsigned int offsetPhi2 = (tOut * res.x + tIn) * res.y;
+				const unsigned int offsetPhi = ((unsigned int)tIn * res.x + tOut) * res.y;
+				const unsigned int offsetPhi2 = (tOut * res.x + (unsigned int)tIn) * res.y;
 
 				// Build CDF for phi
 				float sumPhi = 0.0f;
@@ -111,12 +115,12 @@ namespace vtx::graph {
 					sampleDataPhi[idx] = sumPhi;
 				}
 
-				// Normalize CDF for phi.
+				// Normalize CDF for phi, a row without any value is sampled uniformly.
 				for (unsigned int pOut = 0; pOut < res.y; ++pOut)
 				{
 					const unsigned int idx = offsetPhi + pOut;
 
-					sampleDataPhi[idx] = sampleDataPhi[idx] / sumPhi;
+					sampleDataPhi[idx] = (0.0f < sumPhi) ? sampleDataPhi[idx] / sumPhi : static_cast<float>(pOut + 1) / static_cast<float>(res.y);
 				}
 
 				// Build CDF for theta.
@@ -124,34 +128,34 @@ namespace vtx::graph {
 				sampleDataTheta[tIn * res.x + tOut] = sumTheta;
 			}
 
-			if (sumTheta > maxAlbedo)
-			{
-				maxAlbedo = sumTheta;
-			}
-
-			bsdfData.albedoData[tIn] = sumTheta;
+			tables.albedoData[tIn] = sumTheta;
 
 			// normalize CDF for theta
 			for (unsigned int tOut = 0; tOut < res.x; ++tOut)
 			{
-				const unsigned int idx = tIn * res.x + tOut;
+				const unsigned int idx = (unsigned int)tIn * res.x + tOut;
 
-				sampleDataTheta[idx] = sampleDataTheta[idx] / sumTheta;
+				sampleDataTheta[idx] = (0.0f < sumTheta) ? sampleDataTheta[idx] / sumTheta : static_cast<float>(tOut + 1) / static_cast<float>(res.x);
 			}
+		});
+
+		tables.maxAlbedo = 0.0f;
+		for (const float albedo : tables.albedoData)
+		{
+			tables.maxAlbedo = std::max(tables.maxAlbedo, albedo);
 		}
 
-		bsdfData.maxAlbedo = maxAlbedo;
 		const unsigned int lookupChannels = (numChannels == 3) ? 4 : 1;
 
 		// Make lookup data symmetric
-		bsdfData.albedoData.resize(res.y * res.x * res.x * lookupChannels);
+		tables.lookupData.resize(res.y * res.x * res.x * lookupChannels);
 
-		for (unsigned int tIn = 0; tIn < res.x; ++tIn)
+		utl::parallelFor(res.x, [&](const size_t tIn)
 		{
 			for (unsigned int tOut = 0; tOut < res.x; ++tOut)
 			{
-				const unsigned int offsetPhi = (tIn * res.x + tOut) * res.y;
-				const unsigned int offsetPhi2 = (tOut * res.x + tIn) * res.y;
+				const unsigned int offsetPhi = ((unsigned int)tIn * res.x + tOut) * res.y;
+				const unsigned int offsetPhi2 = (tOut * res.x + (unsigned int)tIn) * res.y;
 
 				for (unsigned int pOut = 0; pOut < res.y; ++pOut)
 				{
@@ -160,19 +164,36 @@ namespace vtx::graph {
 
 					if (numChannels == 3)
 					{
-						bsdfData.lookupData[4 * idx + 0] = (srcData[3 * idx + 0] + srcData[3 * idx2 + 0]) * 0.5f;
-						bsdfData.lookupData[4 * idx + 1] = (srcData[3 * idx + 1] + srcData[3 * idx2 + 1]) * 0.5f;
-						bsdfData.lookupData[4 * idx + 2] = (srcData[3 * idx + 2] + srcData[3 * idx2 + 2]) * 0.5f;
-						bsdfData.lookupData[4 * idx + 3] = 1.0f;
+						tables.lookupData[4 * idx + 0] = (srcData[3 * idx + 0] + srcData[3 * idx2 + 0]) * 0.5f;
+						tables.lookupData[4 * idx + 1] = (srcData[3 * idx + 1] + srcData[3 * idx2 + 1]) * 0.5f;
+						tables.lookupData[4 * idx + 2] = (srcData[3 * idx + 2] + srcData[3 * idx2 + 2]) * 0.5f;
+						tables.lookupData[4 * idx + 3] = 1.0f;
 					}
 					else
 					{
-						bsdfData.lookupData[idx] = (srcData[idx] + srcData[idx2]) * 0.5f;
+						tables.lookupData[idx] = (srcData[idx] + srcData[idx2]) * 0.5f;
 					}
 				}
 			}
-		}
+		});
+
+		return tables;
+	}
 
-		bsdfData.isValid = true;
+	void BsdfMeasurement::prepareSampling(BsdfPartData& bsdfData)
+	{
+		const math::vec2ui& res = bsdfData.angularResolution;
+		uint64_t settingsHash   = utl::hashValue(res);
+		settingsHash            = utl::hashCombine(settingsHash, utl::hashValue(bsdfData.numChannels));
+		const uint64_t key      = SamplingTableCache::computeKey(bsdfData.srcData, (size_t)res.x * res.x * res.y * bsdfData.numChannels, settingsHash);
+
+		// Same sizes as computeSamplingTables
+		BsdfSamplingTableSizes sizes;
+		sizes.sampleDataSize = (size_t)res.x * res.x + (size_t)res.x * res.x * res.y;
+		sizes.albedoDataSize = res.x;
+		sizes.lookupDataSize = (size_t)res.y * res.x * res.x * (bsdfData.numChannels == 3 ? 4 : 1);
+
+		bsdfData.samplingTables = SamplingTableCache::get()->getBsdfTables(key, sizes, [&bsdfData]() { return computeSamplingTables(bsdfData); });
+		bsdfData.isValid        = true;
 	}
 }
@@ -2,6 +2,7 @@
 #include <mi/base/types.h>
 #include "Core/Math.h"
 #include "Scene/Node.h"
+#include "Scene/Utility/SamplingTableCache.h"
 
 namespace vtx::graph
 {
@@ -19,14 +20,12 @@ namespace vtx::graph
 			math::vec2ui angularResolution;
 			unsigned int numChannels{};
 			const float* srcData = nullptr;
-			std::vector<float> sampleData;
-			std::vector<float> albedoData;
-			std::vector<float> lookupData;
-			float maxAlbedo;
+			// sampleData, albedoData, lookupData and maxAlbedo, shared with the other measurements of the same data
+			std::shared_ptr<const BsdfSamplingTables> samplingTables;
 			bool isValid = false;
 		};
 
-		void prepareSampling(BsdfPartData bsdfData);
+		void prepareSampling(BsdfPartData& bsdfData);
 
 		void init() override;
 	protected:
@@ -2,6 +2,8 @@
 #include "Scene/Traversal.h"
 #include "MDL/MdlWrapper.h"
 #include "Scene/SceneIndexManager.h"
+#include "Core/Hashing.h"
+#include "Core/ThreadPool.h"
 
 namespace vtx::graph {
 	LightProfile::LightProfile() :
@@ -29,6 +31,22 @@ namespace vtx::graph {
 	}
 
 	void LightProfile::prepareSampling()
+	{
+		const math::vec2ui& res = lightProfileData.resolution;
+
+		// First (res.x-1) for the cdf for sampling theta.
+		// Rest (rex.x-1) * (res.y-1) for the individual cdfs for sampling phi (after theta).
+		lightProfileData.cdfDataSize = (res.x - 1) + (res.x - 1) * (res.y - 1);
+
+		uint64_t settingsHash = utl::hashValue(res);
+		settingsHash          = utl::hashCombine(settingsHash, utl::hashValue(lightProfileData.start));
+		settingsHash          = utl::hashCombine(settingsHash, utl::hashValue(lightProfileData.delta));
+		const uint64_t key    = SamplingTableCache::computeKey(lightProfileData.sourceData, (size_t)res.x * res.y, settingsHash);
+
+		lightProfileData.samplingTables = SamplingTableCache::get()->getLightProfileTables(key, lightProfileData.cdfDataSize, [this]() { return computeSamplingTables(); });
+	}
+
+	LightProfileSamplingTables LightProfile::computeSamplingTables() const
 	{
 		const math::vec2ui& res		= lightProfileData.resolution;
 		const math::vec2f& start	= lightProfileData.start;
@@ -38,30 +56,22 @@ namespace vtx::graph {
 		// Compute total power.
 		// Compute inverse CDF data for sampling.
 		// Sampling will work on cells rather than grid nodes (used for evaluation).
+		LightProfileSamplingTables tables;
+		tables.cdfData.resize(lightProfileData.cdfDataSize);
+		float* cdfDataTheta = tables.cdfData.data();
 
-		// First (res.x-1) for the cdf for sampling theta.
-		// Rest (rex.x-1) * (res.y-1) for the individual cdfs for sampling phi (after theta).
-		lightProfileData.cdfDataSize = (res.x - 1) + (res.x - 1) * (res.y - 1);
-
-		lightProfileData.cdfData.resize(lightProfileData.cdfDataSize);
-
-		float debugTotalArea = 0.0f;
-		float sumTheta = 0.0f;
-		float totalPower = 0.0f;
-
-		float cosTheta0 = cosf(start.x);
-
-		for (unsigned int t = 0; t < res.x - 1; ++t)
+		// The cdf for phi of each theta row only depends on the row, rows are built in parallel.
+		// The row integral is stored in the theta cdf and accumulated afterwards.
+		utl::parallelFor(res.x - 1, [&](const size_t t)
 		{
-			const float cosTheta1 = cosf(start.x + static_cast<float>(t + 1) * delta.x);
-
 			// Area of the patch (grid cell)
 			// \mu = int_{theta0}^{theta1} sin{theta} \delta theta
+			const float cosTheta0 = cosf(start.x + static_cast<float>(t) * delta.x);
+			const float cosTheta1 = cosf(start.x + static_cast<float>(t + 1) * delta.x);
 			const float mu = cosTheta0 - cosTheta1;
-			cosTheta0 = cosTheta1;
 
 			// Build CDF for phi.
-			float* cdfDataPhi = lightProfileData.cdfData.data() + (res.x - 1) + t * (res.y - 1);
+			float* cdfDataPhi = tables.cdfData.data() + (res.x - 1) + t * (res.y - 1);
 
 			float sumPhi = 0.0f;
 			for (unsigned int p = 0; p < res.y - 1; ++p)
@@ -76,8 +86,6 @@ namespace vtx::graph {
 
 				sumPhi += value * mu;
 				cdfDataPhi[p] = sumPhi;
-
-				debugTotalArea += mu;
 			}
 
 			// Normalize CDF for phi.
@@ -87,20 +95,26 @@ namespace vtx::graph {
 			}
 
 			cdfDataPhi[res.y - 2] = 1.0f;
+			cdfDataTheta[t] = sumPhi;
+		}, 16);
 
-			// Build CDF for theta
-			sumTheta += sumPhi;
-			lightProfileData.cdfData[t] = sumTheta;
+		// Build CDF for theta
+		float sumTheta = 0.0f;
+		for (unsigned int t = 0; t < res.x - 1; ++t)
+		{
+			sumTheta += cdfDataTheta[t];
+			cdfDataTheta[t] = sumTheta;
 		}
 
-		lightProfileData.totalPower = sumTheta * 0.25f * delta.y;
+		tables.totalPower = sumTheta * 0.25f * delta.y;
 
 		// Normalize CDF for theta.
 		for (unsigned int t = 0; t < res.x - 2; ++t)
 		{
-			lightProfileData.cdfData[t] = (0.0f < sumTheta) ? (lightProfileData.cdfData[t] / sumTheta) : lightProfileData.cdfData[t];
+			cdfDataTheta[t] = (0.0f < sumTheta) ? (cdfDataTheta[t] / sumTheta) : cdfDataTheta[t];
 		}
 
-		lightProfileData.cdfData[res.x - 2] = 1.0f;
+		cdfDataTheta[res.x - 2] = 1.0f;
+		return tables;
 	}
 }
@@ -2,6 +2,7 @@
 #include <mi/base/types.h>
 #include "Core/Math.h"
 #include "Scene/Node.h"
+#include "Scene/Utility/SamplingTableCache.h"
 
 namespace vtx::graph {
 	class LightProfile : public Node
@@ -18,16 +19,18 @@ namespace vtx::graph {
 			math::vec2f start;
 			math::vec2f delta;
 			const float* sourceData;
-			std::vector<float> cdfData;
 			size_t cdfDataSize;
 			double candelaMultiplier;
-			float totalPower;
+			// cdfData and totalPower, shared with the other light profiles of the same data
+			std::shared_ptr<const LightProfileSamplingTables> samplingTables;
 		};
 
 		void init() override;
 
 		void prepareSampling();
 	protected:
+		LightProfileSamplingTables computeSamplingTables() const;
+
 		void accept(NodeVisitor& visitor) override;
 
 	public:
@@ -2,6 +2,7 @@
 #include "Scene/Traversal.h"
 #include "MDL/MdlWrapper.h"
 #include "Scene/SceneIndexManager.h"
+#include "Scene/Utility/PreparedDataStore.h"
 
 namespace vtx::graph
 {
@@ -43,6 +44,76 @@ namespace vtx::graph
 		}
 	}
 
+	bool Texture::loadPreparedData()
+	{
+		std::vector<char> blob;
+		if (preparedKey == 0 || !PreparedDataStore::get()->find(PD_TEXTURE, preparedKey, blob))
+		{
+			return false;
+		}
+
+		PreparedDataReader  reader(blob);
+		math::vec4ui        preparedDimension;
+		CUarray_format_enum preparedFormat;
+		size_t              preparedPixelBytesSize;
+		float               preparedGamma;
+		uint32_t            numLayers = 0;
+		if (!reader.readValue(preparedDimension) || !reader.readValue(preparedFormat) || !reader.readValue(preparedPixelBytesSize) ||
+			!reader.readValue(preparedGamma) || !reader.readValue(numLayers))
+		{
+			return false;
+		}
+
+		const size_t             layerSize = (size_t)preparedDimension.x * preparedDimension.y * preparedPixelBytesSize * preparedDimension.w;
+		std::vector<const void*> layers;
+		for (uint32_t z = 0; z < numLayers; ++z)
+		{
+			void* layer = malloc(layerSize);
+			layers.push_back(layer);
+			if (!reader.read(layer, layerSize))
+			{
+				break;
+			}
+		}
+		if (!reader.isComplete() || layers.size() != numLayers || numLayers == 0)
+		{
+			for (const void* layer : layers)
+			{
+				free(const_cast<void*>(layer));
+			}
+			return false;
+		}
+
+		dimension           = preparedDimension;
+		format              = preparedFormat;
+		pixelBytesSize      = preparedPixelBytesSize;
+		effectiveGamma      = preparedGamma;
+		imageLayersPointers = std::move(layers);
+		return true;
+	}
+
+	bool Texture::getPreparedData(PreparedData& data) const
+	{
+		if (preparedKey == 0 || imageLayersPointers.empty())
+		{
+			return false;
+		}
+
+		const size_t layerSize = (size_t)dimension.x * dimension.y * pixelBytesSize * dimension.w;
+		data.kind = PD_TEXTURE;
+		data.key  = preparedKey;
+		data.appendValue(dimension);
+		data.appendValue(format);
+		data.appendValue(pixelBytesSize);
+		data.appendValue(effectiveGamma);
+		data.appendValue((uint32_t)imageLayersPointers.size());
+		for (const void* layer : imageLayersPointers)
+		{
+			data.append(layer, layerSize);
+		}
+		return true;
+	}
+
 	void Texture::accept(NodeVisitor& visitor)
 	{
 		visitor.visit(as<Texture>());
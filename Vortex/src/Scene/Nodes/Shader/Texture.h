@@ -6,6 +6,8 @@
 
 namespace vtx::graph
 {
+	struct PreparedData;
+
 	using namespace mi;
 	using namespace base;
 	using namespace neuraylib;
@@ -23,6 +25,12 @@ namespace vtx::graph
 
 		void init() override;
 
+		// Replaces the conversion of the image by the layers embedded in the loaded scene under preparedKey
+		bool loadPreparedData();
+
+		// Converted layers to embed in a saved scene, false if the texture has no key or no data
+		bool getPreparedData(PreparedData& data) const;
+
 	protected:
 		void accept(NodeVisitor& visitor) override;
 	public:
@@ -39,5 +47,6 @@ namespace vtx::graph
 		bool											isInitialized = false;
 		bool											loadFromFile = false;
 		Size mdlIndex;
+		uint64_t										preparedKey = 0; // Content key of the source file, 0 for textures created in the database
 	};
 }
@@ -1,6 +1,7 @@
 #include "Transform.h"
 #include "Scene/SceneIndexManager.h"
 #include "Scene/Traversal.h"
+#include "Scene/TransformHierarchy.h"
 
 namespace vtx::graph
 {
@@ -112,7 +113,7 @@ namespace vtx::graph
 	void Transform::updateFromVectors() {
 		affineTransform = math::affine3f::translate(translation) * math::AffineFromEuler<math::LinearSpace3f>(eulerAngles) * math::affine3f::scale(scaleVector);
 		rcpAffineTransform = rcp(affineTransform);
-		state.updateOnDevice = true;
+		TransformHierarchy::get()->markLocalChanged(this);
 	}
 
 	/* Update the vector representation given the affine matrix*/
@@ -120,7 +121,7 @@ namespace vtx::graph
 	void Transform::updateFromAffine() {
 		math::VectorFromAffine<math::LinearSpace3f>(affineTransform, translation, scaleVector, eulerAngles);
 		rcpAffineTransform = rcp(affineTransform);
-		state.updateOnDevice = true;
+		TransformHierarchy::get()->markLocalChanged(this);
 	}
 	void Transform::accept(NodeVisitor& visitor)
 	{
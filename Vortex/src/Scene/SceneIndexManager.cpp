@@ -1,176 +1,383 @@
 #include "SceneIndexManager.h"
+#include <algorithm>
+#include <map>
+#include <random>
+#include "Core/Timer.h"
 
 
 namespace vtx::graph
 {
 	vtxID SceneIndexManager::getUID() {
-
-		if (freeUID.empty()) {
-			// If no free indices available, create a new one
-
-			vtxID id = nextUID++;
-			if(nodesByUID.find(id) == nodesByUID.end())
-			{
-				return id;
-			}
-
-			while (nodesByUID.find(id) != nodesByUID.end())
-			{
-				id = nextUID++;
-			}
-			return id;
-		}
-		
-		// If there are free indices, use the first one and remove it from the set
-		const auto it = freeUID.begin();
-		const vtxID idx = *it;
-		freeUID.erase(it);
-		return idx;
+		return allocateUID().id;
 	}
 
 
 	vtxID SceneIndexManager::getTypeId(NodeType type)
 	{
-		if (freeTID.find(type) == freeTID.end() || freeTID[type].empty())
-		{
-			if (nextTID.find(type) == nextTID.end())
-			{
-				nextTID[type] = 1;
-			}
-
-			vtxID id = nextTID[type]++;
-			if (TIDtoUID.find(type) == TIDtoUID.end())
-			{
-				return id;
-			}
-
-			while (TIDtoUID[type].find(id) != TIDtoUID[type].end())
-			{
-				id = nextTID[type]++;
-			}
+		return allocateTypeId(type).id;
+	}
 
-			return id;
-		}
+	utl::SlotId SceneIndexManager::allocateUID()
+	{
+		std::lock_guard<std::recursive_mutex> lock(indexMutex);
+		return uidSlots.allocate();
+	}
 
-		const auto it = freeTID[type].begin();
-		const vtxID idx = *it;
-		freeTID[type].erase(it);
-		return idx;
+	utl::SlotId SceneIndexManager::allocateTypeId(const NodeType type)
+	{
+		std::lock_guard<std::recursive_mutex> lock(indexMutex);
+		return typeSlots[type].allocate();
 	}
 
 	void SceneIndexManager::releaseUID(const vtxID id, bool doRemoveNodeReference) {
+		std::lock_guard<std::recursive_mutex> lock(indexMutex);
 
-		// Release the index
-		if (id + 1 == nextUID) {
-			// If the released index is the last one, just decrement nextUID
-			--nextUID;
-		}
-		else {
-			// Otherwise, add it to the set of free indices
-			freeUID.insert(id);
+		// Releasing the id of a recorded node removes the node, otherwise its references would point to whatever gets the id next
+		if (const NodeEntry* entry = uidSlots.find(id); entry != nullptr && doRemoveNodeReference)
+		{
+			removeNodeReference(id, entry->TID, entry->type);
+			return;
 		}
+		uidSlots.release(uidSlots.getSlotId(id));
 	}
 
 	void SceneIndexManager::releaseTypeId(const vtxID id, NodeType type)
 	{
-		if (id + 1 == nextTID[type])
+		std::lock_guard<std::recursive_mutex> lock(indexMutex);
+		if (const TypeEntry* entry = typeSlots[type].find(id); entry != nullptr)
 		{
-			--nextTID[type];
-		}
-		else
-		{
-			freeTID[type].insert(id);
+			removeNodeReference(entry->UID, id, type);
+			return;
 		}
+		typeSlots[type].release(typeSlots[type].getSlotId(id));
 	}
 
 	void SceneIndexManager::record(const std::shared_ptr<Node>& node) {
+		std::lock_guard<std::recursive_mutex> lock(indexMutex);
 
-		const NodeType& type = node->getType();
 		// check if node is already in the map
-		if (nodesByUID.find(node->getUID()) != nodesByUID.end())
+		if (const NodeEntry* entry = uidSlots.find(node->getUID()); entry != nullptr && entry->node.lock() == node)
 		{
-			const std::shared_ptr<Node>& previousNode = getNode<Node>(node->getUID());
-			if (previousNode && previousNode == node)
-			{
-				return;
-			}
+			return;
 		}
 
-		nodesByUID.insert({ node->getUID(), node });
-		if (nodesByType.find(type) == nodesByType.end())
+		recordEntry(node->getUID(), node->getTypeID(), node->getType(), node);
+		markChanged(node->getType(), uidSlots.getSlotId(node->getUID()));
+	}
+
+	void SceneIndexManager::recordEntry(const vtxID UID, const vtxID TID, NodeType type, const std::shared_ptr<Node>& node)
+	{
+		if (!uidSlots.isAllocated(UID) || !typeSlots[type].isAllocated(TID))
 		{
-			nodesByType[type] = {};
+			VTX_WARN("Node {} UID: {} TID: {} can't be recorded, its ids have already been released!", nodeNames[type], UID, TID);
+			return;
 		}
-		nodesByType[type].push_back(node->getUID());
-		UIDtoNodeType.insert({ node->getUID(), type });
-		UIDtoTID[node->getUID()] = node->getTypeID();
-		TIDtoUID[type][node->getTypeID()] = node->getUID();
+		uidSlots.insert(UID, NodeEntry{ node, TID, type });
+		typeSlots[type].insert(TID, TypeEntry{ node, UID });
 	}
 
 	void SceneIndexManager::removeNodeReference(const vtxID UID, const vtxID TID, NodeType type, bool addToDeleted)
 	{
-		UIDtoNodeType.erase(UID);
-		nodesByUID.erase(UID);
-		deletedNodes[type].push_back({ UID, TID });
-		UIDtoTID.erase(UID);
-		TIDtoUID[type].erase(TID);
+		std::lock_guard<std::recursive_mutex> lock(indexMutex);
+		removeNodeReference(uidSlots.getSlotId(UID), typeSlots[type].getSlotId(TID), type, addToDeleted);
+	}
 
-		releaseTypeId(TID, type);
-		releaseUID(UID);
+	void SceneIndexManager::removeNodeReference(const utl::SlotId UID, const utl::SlotId TID, NodeType type, bool addToDeleted)
+	{
+		std::lock_guard<std::recursive_mutex> lock(indexMutex);
+		const bool isUIDAlive = uidSlots.isAlive(UID);
+		const bool isTIDAlive = typeSlots[type].isAlive(TID);
+		if (!isUIDAlive && !isTIDAlive)
+		{
+			return;
+		}
+
+		// An id which has been handed out again belongs to another node, it is reported as invalid
+		if (addToDeleted)
+		{
+			deletedNodes[type].push_back({ isUIDAlive ? UID.id : 0u, isTIDAlive ? TID.id : 0u });
+		}
 
-		std::vector<vtxID>& nodesOfType = nodesByType[type];
-		nodesOfType.erase(std::remove(nodesOfType.begin(), nodesOfType.end(), UID), nodesOfType.end());
+		uidSlots.release(UID);
+		typeSlots[type].release(TID);
 	}
+
 	std::vector<math::vec2ui> SceneIndexManager::getDeletedNodesByType(const NodeType nodeType)
 	{
-		if (deletedNodes.find(nodeType) == deletedNodes.end())
-		{
-			return std::vector<math::vec2ui>();
-		}
+		std::lock_guard<std::recursive_mutex> lock(indexMutex);
 		return deletedNodes[nodeType];
 	}
 	void SceneIndexManager::cleanDeletedNodesByType(const NodeType nodeType)
 	{
-		if (deletedNodes.find(nodeType) == deletedNodes.end())
-		{
-			return;
-		}
+		std::lock_guard<std::recursive_mutex> lock(indexMutex);
 		deletedNodes[nodeType].clear();
 	}
 	vtxID SceneIndexManager::UIDfromTID(const NodeType nodeType, const vtxID UID)
 	{
-		if (TIDtoUID.find(nodeType) == TIDtoUID.end())
+		std::lock_guard<std::recursive_mutex> lock(indexMutex);
+		const TypeEntry* entry = typeSlots[nodeType].find(UID);
+		if (entry == nullptr)
 		{
 			return 0; //invalid
 		}
-		return TIDtoUID[nodeType][UID];
+		return entry->UID;
 	}
 	vtxID SceneIndexManager::TIDfromUID(const vtxID typeID)
 	{
-		if (UIDtoTID.find(typeID) == UIDtoTID.end())
+		std::lock_guard<std::recursive_mutex> lock(indexMutex);
+		const NodeEntry* entry = uidSlots.find(typeID);
+		if (entry == nullptr)
 		{
 			return 0; //invalid
 		}
-		return UIDtoTID[typeID];
+		return entry->TID;
 	}
 	NodeType SceneIndexManager::nodeTypeFromUID(const vtxID id)
 	{
-		if (UIDtoNodeType.find(id) == UIDtoNodeType.end())
+		std::lock_guard<std::recursive_mutex> lock(indexMutex);
+		const NodeEntry* entry = uidSlots.find(id);
+		if (entry == nullptr)
 		{
 			return NodeType::NT_NUM_NODE_TYPES;
 		}
-		return UIDtoNodeType[id];
+		return entry->type;
 	}
 	std::vector<std::shared_ptr<Node>> SceneIndexManager::getAllNodes()
 	{
+		std::lock_guard<std::recursive_mutex> lock(indexMutex);
 		std::vector<std::shared_ptr<Node>> nodes;
-		for (const auto& [nodeUID, _] : nodesByUID)
+		nodes.reserve(uidSlots.size());
+		for (const NodeEntry& entry : uidSlots.getValues())
 		{
-			if (const std::shared_ptr<Node>& node = (*this)[nodeUID])
+			if (std::shared_ptr<Node> node = entry.node.lock())
 			{
-				nodes.push_back(node);
+				nodes.push_back(std::move(node));
 			}
 		}
 		return nodes;
 	}
+
+	void SceneIndexManager::markChanged(const NodeType type, const utl::SlotId UID)
+	{
+		if (UID.id == 0)
+		{
+			return;
+		}
+		std::lock_guard<std::mutex> lock(journalMutex);
+		if (UID.id >= journaledGeneration.size())
+		{
+			journaledGeneration.resize(std::max<size_t>(UID.id + 1, journaledGeneration.size() * 2), 0u);
+			lastChangeEpoch.resize(journaledGeneration.size(), 0u);
+		}
+		lastChangeEpoch[UID.id] = ++changeEpoch;
+		if (journaledGeneration[UID.id] == UID.generation)
+		{
+			return;
+		}
+		journaledGeneration[UID.id] = UID.generation;
+		changedNodes[type].push_back(UID);
+		++journalCounters.markedNodes;
+	}
+
+	std::vector<vtxID> SceneIndexManager::takeChangedNodes(const NodeType type)
+	{
+		std::vector<utl::SlotId> listed;
+		{
+			std::lock_guard<std::mutex> lock(journalMutex);
+			if (changedNodes[type].empty())
+			{
+				return {};
+			}
+			listed.swap(changedNodes[type]);
+			for (const utl::SlotId& UID : listed)
+			{
+				if (journaledGeneration[UID.id] == UID.generation)
+				{
+					journaledGeneration[UID.id] = 0u;
+				}
+			}
+		}
+
+		// Nodes deleted since they were listed are dropped, their ids might belong to another node by now
+		std::vector<vtxID> ids;
+		ids.reserve(listed.size());
+		{
+			std::lock_guard<std::recursive_mutex> lock(indexMutex);
+			for (const utl::SlotId& UID : listed)
+			{
+				if (uidSlots.isAlive(UID))
+				{
+					ids.push_back(UID.id);
+				}
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(journalMutex);
+		journalCounters.takenNodes += ids.size();
+		return ids;
+	}
+
+	uint64_t SceneIndexManager::getChangeEpoch()
+	{
+		std::lock_guard<std::mutex> lock(journalMutex);
+		return changeEpoch;
+	}
+
+	uint64_t SceneIndexManager::getLastChangeEpoch(const vtxID UID)
+	{
+		std::lock_guard<std::mutex> lock(journalMutex);
+		return UID < lastChangeEpoch.size() ? lastChangeEpoch[UID] : 0u;
+	}
+
+	SceneIndexManager::ChangeJournalCounters SceneIndexManager::getChangeJournalCounters()
+	{
+		std::lock_guard<std::mutex> lock(journalMutex);
+		ChangeJournalCounters counters = journalCounters;
+		counters.pendingNodes = 0;
+		for (const std::vector<utl::SlotId>& listed : changedNodes)
+		{
+			counters.pendingNodes += listed.size();
+		}
+		return counters;
+	}
+
+	void SceneIndexManager::beginBulkRelease()
+	{
+		++bulkReleaseDepth;
+	}
+
+	void SceneIndexManager::endBulkRelease()
+	{
+		--bulkReleaseDepth;
+	}
+
+	bool SceneIndexManager::isBulkReleasing() const
+	{
+		return bulkReleaseDepth.load() > 0;
+	}
+
+	void SceneIndexManager::benchmark(const size_t numNodes)
+	{
+		constexpr NodeType type = NT_TRANSFORM;
+		// The layout replaced by the slot maps removed a node from a vector, erasing all of the nodes would be quadratic
+		const size_t numOldErase = std::min<size_t>(numNodes, 10000);
+
+		// Nodes are stood in for by aliasing pointers with their own control block, so locking the weak pointers costs
+		// what it costs for real nodes, without registering graph nodes in the scene
+		std::vector<std::shared_ptr<Node>> nodes(numNodes);
+		for (std::shared_ptr<Node>& node : nodes)
+		{
+			node = std::shared_ptr<Node>(std::make_shared<int>(0), static_cast<Node*>(nullptr));
+		}
+		std::vector<size_t> order(numNodes);
+		for (size_t i = 0; i < numNodes; ++i)
+		{
+			order[i] = i;
+		}
+		std::shuffle(order.begin(), order.end(), std::mt19937(42));
+
+		const auto nsPerNode = [](const float milliseconds, const size_t count)
+		{
+			return count > 0 ? (double)milliseconds * 1.0e6 / (double)count : 0.0;
+		};
+
+		{
+			SceneIndexManager        sim;
+			std::vector<utl::SlotId> uids(numNodes);
+			std::vector<utl::SlotId> tids(numNodes);
+
+			Timer timer;
+			for (size_t i = 0; i < numNodes; ++i)
+			{
+				uids[i] = sim.allocateUID();
+				tids[i] = sim.allocateTypeId(type);
+				sim.recordEntry(uids[i].id, tids[i].id, type, nodes[i]);
+			}
+			const float createTime = timer.elapsedMillis();
+
+			timer.reset();
+			size_t found = 0;
+			for (const size_t i : order)
+			{
+				const vtxID uid = sim.UIDfromTID(type, sim.TIDfromUID(uids[i].id));
+				found += sim[uid].use_count() != 0 ? 1 : 0;
+			}
+			const float lookupTime = timer.elapsedMillis();
+
+			timer.reset();
+			const size_t iterated = sim.getAllNodeOfType<Node>(type).size();
+			const float iterateTime = timer.elapsedMillis();
+
+			timer.reset();
+			for (const size_t i : order)
+			{
+				sim.removeNodeReference(uids[i], tids[i], type, false);
+			}
+			const float eraseTime = timer.elapsedMillis();
+
+			VTX_INFO("Scene index benchmark, slot maps, {} nodes: create {:.1f} ns, lookup {:.1f} ns, iterate {:.1f} ns, erase {:.1f} ns per node ({} found, {} iterated)",
+					 numNodes, nsPerNode(createTime, numNodes), nsPerNode(lookupTime, numNodes), nsPerNode(iterateTime, numNodes), nsPerNode(eraseTime, numNodes), found, iterated);
+		}
+
+		{
+			std::map<vtxID, std::weak_ptr<Node>>       nodesByUID;
+			std::map<NodeType, std::vector<vtxID>>     nodesByType;
+			std::map<vtxID, NodeType>                  UIDtoNodeType;
+			std::map<vtxID, vtxID>                     UIDtoTID;
+			std::map<NodeType, std::map<vtxID, vtxID>> TIDtoUID;
+
+			Timer timer;
+			for (size_t i = 0; i < numNodes; ++i)
+			{
+				const auto id = static_cast<vtxID>(i + 1);
+				nodesByUID.insert({ id, nodes[i] });
+				nodesByType[type].push_back(id);
+				UIDtoNodeType.insert({ id, type });
+				UIDtoTID[id] = id;
+				TIDtoUID[type][id] = id;
+			}
+			const float createTime = timer.elapsedMillis();
+
+			timer.reset();
+			size_t found = 0;
+			for (const size_t i : order)
+			{
+				const vtxID uid = TIDtoUID[type][UIDtoTID[static_cast<vtxID>(i + 1)]];
+				const auto  it  = nodesByUID.find(uid);
+				found += (it != nodesByUID.end() && !it->second.expired()) ? 1 : 0;
+			}
+			const float lookupTime = timer.elapsedMillis();
+
+			// The dynamic_pointer_cast done for every node is not included
+			timer.reset();
+			std::vector<std::shared_ptr<Node>> iterated;
+			for (const vtxID id : nodesByType[type])
+			{
+				if (const auto it = nodesByUID.find(id); it != nodesByUID.end())
+				{
+					if (std::shared_ptr<Node> node = it->second.lock())
+					{
+						iterated.push_back(std::move(node));
+					}
+				}
+			}
+			const float iterateTime = timer.elapsedMillis();
+
+			timer.reset();
+			for (size_t e = 0; e < numOldErase; ++e)
+			{
+				const auto id = static_cast<vtxID>(order[e] + 1);
+				UIDtoNodeType.erase(id);
+				nodesByUID.erase(id);
+				UIDtoTID.erase(id);
+				TIDtoUID[type].erase(id);
+				std::vector<vtxID>& nodesOfType = nodesByType[type];
+				nodesOfType.erase(std::remove(nodesOfType.begin(), nodesOfType.end(), id), nodesOfType.end());
+			}
+			const float eraseTime = timer.elapsedMillis();
+
+			VTX_INFO("Scene index benchmark, ordered maps, {} nodes: create {:.1f} ns, lookup {:.1f} ns, iterate {:.1f} ns, erase {:.1f} ns per node ({} found, {} iterated, {} erased)",
+					 numNodes, nsPerNode(createTime, numNodes), nsPerNode(lookupTime, numNodes), nsPerNode(iterateTime, numNodes), nsPerNode(eraseTime, numOldErase), found, iterated.size(), numOldErase);
+		}
+	}
 }
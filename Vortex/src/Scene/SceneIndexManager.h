@@ -1,13 +1,19 @@
 #pragma once
+#include <array>
+#include <atomic>
 #include <map>
+#include <mutex>
 #include <set>
 
 #include "Node.h"
 #include "Core/Log.h"
 #include "Core/Math.h"
+#include "Core/SlotMap.h"
 
 namespace vtx::graph
 {
+	// Nodes are created and dropped on pool threads as well, every access to the slot maps is guarded by indexMutex.
+	// The mutex is recursive since dropping the last reference to a node while holding it re-enters through the destructor.
 	class SceneIndexManager {
 	public:
 
@@ -20,6 +26,11 @@ namespace vtx::graph
 
 		vtxID getTypeId(NodeType type);
 
+		// Same as getUID and getTypeId, the generation allows to recognize the ids once they have been released
+		utl::SlotId allocateUID();
+
+		utl::SlotId allocateTypeId(NodeType type);
+
 		void releaseUID(vtxID id, bool doRemoveNodeReference = true);
 
 		void releaseTypeId(const vtxID id, NodeType type);
@@ -27,27 +38,27 @@ namespace vtx::graph
 		void record(const std::shared_ptr<Node>& node);
 
 		std::shared_ptr<Node> operator[](const vtxID id) {
-			const auto it = nodesByUID.find(id);
-			if (it == nodesByUID.end()) {
+			std::lock_guard<std::recursive_mutex> lock(indexMutex);
+			const NodeEntry* entry = uidSlots.find(id);
+			if (entry == nullptr) {
 				//VTX_WARN("The requested Node Id either doesn't exist or has not been registered!");
 				return nullptr;
 			}
 
-			std::shared_ptr<Node> node = it->second.lock();
-			if (!node) {
-				//VTX_WARN("The requested Node Id has been deleted, removing references!");
-				removeNodeReference(node->getUID(), node->getTypeID(), node->getType(), true);
-			}
-			return node;
+			// An expired node is in its destructor, it removes its own references
+			return entry->node.lock();
 		}
 
 		void removeNodeReference(const vtxID UID, const vtxID TID, NodeType type, bool addToDeleted = true);
 
+		// Ids which have been released in the meantime (e.g. by removeNodeReference) are ignored
+		void removeNodeReference(const utl::SlotId UID, const utl::SlotId TID, NodeType type, bool addToDeleted = true);
+
 		// Template function to return the statically-casted shared_ptr based on NodeType
 		template<typename T>
 		std::shared_ptr<T> getNode(const vtxID id) {
 			static_assert(std::is_base_of_v<Node, T>, "Template type is not a subclass of Node!");
-			const std::shared_ptr<T>& nodePtr = std::dynamic_pointer_cast<T>((*this)[id]);
+			const std::shared_ptr<T>& nodePtr = nodeCast<T>((*this)[id]);
 			if(!nodePtr)
 			{
 				VTX_WARN("The requested Node Id doesn't match it's type!");
@@ -66,15 +77,18 @@ namespace vtx::graph
 		template<typename T>
 		std::vector<std::shared_ptr<T>> getAllNodeOfType(const NodeType nodeType)
 		{
-			std::vector<std::shared_ptr<T>> nodes;
-
-			const std::vector<vtxID>& ids = nodesByType[nodeType];
+			static_assert(std::is_base_of_v<Node, T>, "Template type is not a subclass of Node!");
+			std::lock_guard<std::recursive_mutex> lock(indexMutex);
+			const std::vector<TypeEntry>& entries = typeSlots[nodeType].getValues();
 
-			for (const vtxID id : ids)
+			std::vector<std::shared_ptr<T>> nodes;
+			nodes.reserve(entries.size());
+			for (const TypeEntry& entry : entries)
 			{
-				if (const std::shared_ptr<T>& nodePtr = getNode<T>(id))
+				// Every node recorded under nodeType is a T, no need to check the cast
+				if (std::shared_ptr<Node> node = entry.node.lock())
 				{
-					nodes.push_back(nodePtr);
+					nodes.push_back(std::static_pointer_cast<T>(std::move(node)));
 				}
 			}
 			return nodes;
@@ -84,7 +98,16 @@ namespace vtx::graph
 		template<typename T>
 		std::vector<vtxID> getAllNodeIdByType(const NodeType nodeType)
 		{
-			return nodesByType[nodeType];
+			std::lock_guard<std::recursive_mutex> lock(indexMutex);
+			const std::vector<TypeEntry>& entries = typeSlots[nodeType].getValues();
+
+			std::vector<vtxID> ids;
+			ids.reserve(entries.size());
+			for (const TypeEntry& entry : entries)
+			{
+				ids.push_back(entry.UID);
+			}
+			return ids;
 		}
 
 		std::vector<math::vec2ui> getDeletedNodesByType(const NodeType nodeType);
@@ -98,20 +121,70 @@ namespace vtx::graph
 		NodeType nodeTypeFromUID(const vtxID id);
 		std::vector<std::shared_ptr<Node>>      getAllNodes();
 
+		struct ChangeJournalCounters
+		{
+			size_t markedNodes  = 0; // Nodes added to the journal
+			size_t takenNodes   = 0; // Nodes handed out by takeChangedNodes
+			size_t pendingNodes = 0; // Nodes currently in the journal
+		};
+
+		// Change journal, a node is listed once per type until takeChangedNodes hands it out. Recording a node lists it.
+		// Can be called from any thread.
+		void markChanged(NodeType type, utl::SlotId UID);
+
+		// Empties the journal of the type, returns the listed nodes which still exist
+		std::vector<vtxID> takeChangedNodes(NodeType type);
+
+		ChangeJournalCounters getChangeJournalCounters();
+
+		// Every markChanged call advances the change epoch, a node changed after epoch E if its last change epoch is greater.
+		// Unlike the journal this can be queried by any number of consumers.
+		uint64_t getChangeEpoch();
+
+		uint64_t getLastChangeEpoch(vtxID UID);
+
+		// Node destructors don't log while a bulk release (e.g. of a whole scene) is running, calls can be nested
+		void beginBulkRelease();
+
+		void endBulkRelease();
+
+		bool isBulkReleasing() const;
+
+		// Logs create, lookup, iterate and erase timings of the index for the given number of nodes,
+		// next to the ordered map layout it replaced
+		static void benchmark(size_t numNodes = 1000000);
+
 	private:
-		vtxID														nextUID = 1; // Index Zero is reserved for Invalid Index, maybe I can use invalid unsigned
-		std::set<vtxID>												freeUID;
+		void recordEntry(const vtxID UID, const vtxID TID, NodeType type, const std::shared_ptr<Node>& node);
+
+		struct NodeEntry
+		{
+			std::weak_ptr<Node> node;
+			vtxID               TID;
+			NodeType            type;
+		};
 
+		struct TypeEntry
+		{
+			std::weak_ptr<Node> node;
+			vtxID               UID;
+		};
+
+		// Index Zero is reserved for Invalid Index in both the UID and the per type TID slot maps
 		// Currently the use of weak_ptr allows for the automatic removal of nodes which are not reference by any other node
 		// However we can revert to shared_ptr if we want to keep the nodes alive even if they are not referenced by any other node have them be removed manually
-		std::map<vtxID, std::weak_ptr<Node>>						nodesByUID; 
-		std::map<NodeType, std::vector<vtxID>>						nodesByType;
-		std::map<vtxID, NodeType>									UIDtoNodeType;
-		std::map<NodeType, std::set<vtxID>>							freeTID;
-		std::map<NodeType, vtxID>									nextTID;
-		std::map<NodeType, std::vector<math::vec2ui>>				deletedNodes;
-		std::map<vtxID,vtxID>										UIDtoTID;
-		std::map<NodeType, std::map<vtxID, vtxID>>					TIDtoUID;
+		std::recursive_mutex															indexMutex;
+		utl::SlotMap<NodeEntry>															uidSlots;
+		std::array<utl::SlotMap<TypeEntry>, NT_NUM_NODE_TYPES>							typeSlots;
+		std::array<std::vector<math::vec2ui>, NT_NUM_NODE_TYPES>						deletedNodes;
+
+		std::mutex																		journalMutex;
+		std::array<std::vector<utl::SlotId>, NT_NUM_NODE_TYPES>							changedNodes;
+		std::vector<uint32_t>															journaledGeneration; // By UID, zero if not journaled
+		ChangeJournalCounters															journalCounters;
+		uint64_t																		changeEpoch = 0;
+		std::vector<uint64_t>															lastChangeEpoch; // By UID
+
+		std::atomic<int>																bulkReleaseDepth = 0;
 	};
-
 }
@@ -0,0 +1,489 @@
+#include "TransformHierarchy.h"
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+#include "Core/Log.h"
+#include "Core/ThreadPool.h"
+#include "Core/Timer.h"
+#include "Graph.h"
+
+namespace vtx::graph
+{
+	static constexpr size_t propagationGrain = 256;
+
+	TransformHierarchy* TransformHierarchy::get()
+	{
+		static TransformHierarchy hierarchy;
+		return &hierarchy;
+	}
+
+	void TransformHierarchy::markTopologyChanged()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		isTopologyChanged = true;
+	}
+
+	void TransformHierarchy::markLocalChanged(const Transform* transform)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		const vtxID uid = transform->getUID();
+		if (uid >= indexOfUID.size() || indexOfUID[uid] == invalidIndex)
+		{
+			// Not attached to the scene yet, the rebuild which attaches it reads its local matrix
+			return;
+		}
+		const uint32_t index = indexOfUID[uid];
+		if (nodes[index].lock().get() != transform)
+		{
+			// The UID has been handed out again since the last rebuild
+			isTopologyChanged = true;
+			return;
+		}
+		if (!isDirty[index])
+		{
+			isDirty[index] = 1;
+			dirtyIndices.push_back(index);
+		}
+	}
+
+	void TransformHierarchy::update(const std::shared_ptr<Renderer>& renderer)
+	{
+		update(renderer->getChildren());
+	}
+
+	void TransformHierarchy::update(const std::vector<std::shared_ptr<Node>>& rootNodes)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		// Camera, scene root and environment light are replaced by assignment, without going through markTopologyChanged
+		bool areRootsChanged = rootNodes.size() != roots.size();
+		for (size_t i = 0; !areRootsChanged && i < roots.size(); ++i)
+		{
+			areRootsChanged = roots[i].lock() != rootNodes[i];
+		}
+
+		if (isTopologyChanged || areRootsChanged)
+		{
+			rebuild(rootNodes);
+		}
+		else
+		{
+			for (const uint32_t index : dirtyIndices)
+			{
+				if (const std::shared_ptr<Transform> transform = nodes[index].lock())
+				{
+					local[index] = transform->affineTransform;
+				}
+			}
+		}
+
+		propagate();
+		writeBack();
+	}
+
+	size_t TransformHierarchy::getNumberOfTransforms() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return nodes.size();
+	}
+
+	size_t TransformHierarchy::getNumberOfUpdatedTransforms() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return updatedIndices.size();
+	}
+
+	void TransformHierarchy::rebuild(const std::vector<std::shared_ptr<Node>>& rootNodes)
+	{
+		isTopologyChanged = false;
+
+		// Depth first walk collecting the transforms with the transform enclosing them, following the same rule as the
+		// traversal: the first transform child of a node applies to the node and everything below it.
+		// A transform node holds a single world matrix, so nodes reachable under different enclosing transforms are not
+		// supported: the first path is kept and the others are rejected with a warning. Paths sharing the same enclosing
+		// transform compute the same matrices and are merged.
+		struct Frame
+		{
+			std::shared_ptr<Node> node;
+			uint32_t              parent;
+		};
+		std::vector<std::shared_ptr<Transform>> transforms;
+		std::vector<uint32_t>                   parents;
+		std::unordered_map<vtxID, uint32_t>     transformOfUID;
+		std::unordered_map<vtxID, uint32_t>     enclosingOfVisited;
+		std::vector<Frame>                      stack;
+		size_t                                  numRejectedPaths = 0;
+		std::string                             firstRejectedName;
+		const auto rejectPath = [&](const std::shared_ptr<Node>& node)
+		{
+			if (numRejectedPaths++ == 0)
+			{
+				firstRejectedName = node->name;
+			}
+		};
+
+		roots.assign(rootNodes.begin(), rootNodes.end());
+		for (auto it = rootNodes.rbegin(); it != rootNodes.rend(); ++it)
+		{
+			stack.push_back({ *it, invalidIndex });
+		}
+
+		while (!stack.empty())
+		{
+			const Frame frame = std::move(stack.back());
+			stack.pop_back();
+			if (!frame.node)
+			{
+				continue;
+			}
+			if (const auto [it, isInserted] = enclosingOfVisited.insert({ frame.node->getUID(), frame.parent }); !isInserted)
+			{
+				if (it->second != frame.parent)
+				{
+					rejectPath(frame.node);
+				}
+				continue;
+			}
+
+			const std::vector<std::shared_ptr<Node>> children = frame.node->getChildren();
+			uint32_t enclosing = frame.parent;
+			for (const std::shared_ptr<Node>& child : children)
+			{
+				if (!child || child->getType() != NT_TRANSFORM)
+				{
+					continue;
+				}
+				if (const auto it = transformOfUID.find(child->getUID()); it != transformOfUID.end())
+				{
+					enclosing = it->second;
+					if (parents[it->second] != frame.parent)
+					{
+						rejectPath(child);
+					}
+				}
+				else
+				{
+					enclosing = static_cast<uint32_t>(transforms.size());
+					transformOfUID[child->getUID()] = enclosing;
+					transforms.push_back(std::static_pointer_cast<Transform>(child));
+					parents.push_back(frame.parent);
+				}
+				break;
+			}
+
+			for (auto it = children.rbegin(); it != children.rend(); ++it)
+			{
+				if (!*it)
+				{
+					continue;
+				}
+				const NodeType type = (*it)->getType();
+				if (type == NT_GROUP || type == NT_INSTANCE || type == NT_CAMERA || type == NT_ENV_LIGHT)
+				{
+					stack.push_back({ *it, enclosing });
+				}
+			}
+		}
+
+		if (numRejectedPaths != 0)
+		{
+			VTX_WARN("Transform hierarchy: {} paths reach a node already placed under another transform (first: {}), "
+					 "shared nodes keep the world transform of their first path", numRejectedPaths, firstRejectedName);
+		}
+
+		const std::vector<uint32_t> order = layout(parents);
+
+		vtxID maxUID = 0;
+		for (const std::shared_ptr<Transform>& transform : transforms)
+		{
+			maxUID = std::max(maxUID, transform->getUID());
+		}
+		indexOfUID.assign(transforms.empty() ? 0 : maxUID + 1, invalidIndex);
+		nodes.resize(order.size());
+		for (size_t index = 0; index < order.size(); ++index)
+		{
+			const std::shared_ptr<Transform>& transform = transforms[order[index]];
+			nodes[index]                    = transform;
+			local[index]                    = transform->affineTransform;
+			indexOfUID[transform->getUID()] = static_cast<uint32_t>(index);
+		}
+		VTX_INFO("Transform hierarchy rebuilt: {} transforms on {} levels", nodes.size(), levelOffsets.size() - 1);
+	}
+
+	std::vector<uint32_t> TransformHierarchy::layout(const std::vector<uint32_t>& parents)
+	{
+		const size_t count = parents.size();
+
+		// Children of each transform in the given order
+		std::vector<uint32_t> childOffsets(count + 1, 0);
+		for (const uint32_t p : parents)
+		{
+			if (p != invalidIndex)
+			{
+				++childOffsets[p + 1];
+			}
+		}
+		for (size_t i = 0; i < count; ++i)
+		{
+			childOffsets[i + 1] += childOffsets[i];
+		}
+		std::vector<uint32_t> children(count);
+		std::vector<uint32_t> cursor(childOffsets.begin(), childOffsets.end() - 1);
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (parents[i] != invalidIndex)
+			{
+				children[cursor[parents[i]]++] = static_cast<uint32_t>(i);
+			}
+		}
+
+		// Breadth first order: levels are contiguous, and so are the children of a transform
+		std::vector<uint32_t> order;
+		order.reserve(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (parents[i] == invalidIndex)
+			{
+				order.push_back(static_cast<uint32_t>(i));
+			}
+		}
+
+		parent.resize(count);
+		firstChild.resize(count);
+		childCount.resize(count);
+		level.resize(count);
+		levelOffsets.assign(1, 0);
+
+		std::vector<uint32_t> newIndex(count);
+		size_t   levelEnd     = order.size();
+		uint32_t currentLevel = 0;
+		for (size_t index = 0; index < order.size(); ++index)
+		{
+			if (index == levelEnd)
+			{
+				levelOffsets.push_back(static_cast<uint32_t>(index));
+				levelEnd = order.size();
+				++currentLevel;
+			}
+			const uint32_t source = order[index];
+			newIndex[source]  = static_cast<uint32_t>(index);
+			level[index]      = currentLevel;
+			firstChild[index] = static_cast<uint32_t>(order.size());
+			childCount[index] = childOffsets[source + 1] - childOffsets[source];
+			order.insert(order.end(), children.begin() + childOffsets[source], children.begin() + childOffsets[source + 1]);
+		}
+		levelOffsets.push_back(static_cast<uint32_t>(order.size()));
+
+		if (order.size() != count)
+		{
+			VTX_WARN("Transform hierarchy: {} transforms are not reachable from a root and are ignored", count - order.size());
+		}
+
+		for (size_t index = 0; index < order.size(); ++index)
+		{
+			const uint32_t p = parents[order[index]];
+			parent[index]    = p == invalidIndex ? invalidIndex : newIndex[p];
+		}
+
+		const size_t laidOut = order.size();
+		parent.resize(laidOut);
+		firstChild.resize(laidOut);
+		childCount.resize(laidOut);
+		level.resize(laidOut);
+		local.assign(laidOut, math::affine3f(math::Identity));
+		world.assign(laidOut, math::affine3f(math::Identity));
+		inverseWorld.assign(laidOut, math::affine3f(math::Identity));
+		isDirty.assign(laidOut, 0);
+		visitEpoch.assign(laidOut, 0);
+		epoch = 0;
+		updatedIndices.clear();
+
+		// Every root is dirty so the next propagation computes the whole hierarchy
+		dirtyIndices.clear();
+		for (uint32_t index = levelOffsets[0]; index < levelOffsets[1]; ++index)
+		{
+			isDirty[index] = 1;
+			dirtyIndices.push_back(index);
+		}
+		return order;
+	}
+
+	void TransformHierarchy::propagate()
+	{
+		updatedIndices.clear();
+		if (dirtyIndices.empty())
+		{
+			return;
+		}
+
+		const size_t numLevels = levelOffsets.size() - 1;
+		std::vector<std::vector<uint32_t>> dirtyOfLevel(numLevels);
+		size_t deepestDirtyLevel = 0;
+		for (const uint32_t index : dirtyIndices)
+		{
+			isDirty[index] = 0;
+			dirtyOfLevel[level[index]].push_back(index);
+			deepestDirtyLevel = std::max<size_t>(deepestDirtyLevel, level[index]);
+		}
+		dirtyIndices.clear();
+
+		if (++epoch == 0)
+		{
+			std::fill(visitEpoch.begin(), visitEpoch.end(), 0u);
+			epoch = 1;
+		}
+
+		// The transforms of a level only depend on the level above, each level is computed in parallel.
+		// A level is made of the children of the transforms updated on the level above plus its own dirty transforms.
+		size_t previousBegin = 0;
+		size_t previousEnd   = 0;
+		for (size_t l = 0; l < numLevels; ++l)
+		{
+			const size_t begin = updatedIndices.size();
+			for (size_t u = previousBegin; u < previousEnd; ++u)
+			{
+				const uint32_t p = updatedIndices[u];
+				for (uint32_t c = firstChild[p]; c < firstChild[p] + childCount[p]; ++c)
+				{
+					visitEpoch[c] = epoch;
+					updatedIndices.push_back(c);
+				}
+			}
+			for (const uint32_t index : dirtyOfLevel[l])
+			{
+				if (visitEpoch[index] != epoch)
+				{
+					visitEpoch[index] = epoch;
+					updatedIndices.push_back(index);
+				}
+			}
+			const size_t end = updatedIndices.size();
+			if (begin == end && l >= deepestDirtyLevel)
+			{
+				break;
+			}
+
+			utl::parallelFor(end - begin, [this, begin](const size_t i)
+			{
+				const uint32_t index = updatedIndices[begin + i];
+				const uint32_t p     = parent[index];
+				world[index]         = p == invalidIndex ? local[index] : world[p] * local[index];
+				inverseWorld[index]  = gdt::rcp(world[index]);
+			}, propagationGrain);
+
+			previousBegin = begin;
+			previousEnd   = end;
+		}
+	}
+
+	void TransformHierarchy::writeBack()
+	{
+		std::vector<uint8_t> isMoved(updatedIndices.size(), 0);
+		std::atomic<bool>    isExpired = false;
+		utl::parallelFor(updatedIndices.size(), [&](const size_t i)
+		{
+			const uint32_t index = updatedIndices[i];
+			const std::shared_ptr<Transform> transform = nodes[index].lock();
+			if (!transform)
+			{
+				isExpired = true;
+				return;
+			}
+			const uint32_t p = parent[index];
+			transform->parentGlobalTransform           = p == invalidIndex ? math::affine3f(math::Identity) : world[p];
+			transform->reciprocalParentGlobalTransform = p == invalidIndex ? math::affine3f(math::Identity) : inverseWorld[p];
+			if (transform->globalTransform != world[index])
+			{
+				transform->globalTransform = world[index];
+				isMoved[i] = 1;
+			}
+		}, propagationGrain);
+
+		// Raising the flag lists the transform in the change journal, from which the owning instance is synced
+		for (size_t i = 0; i < updatedIndices.size(); ++i)
+		{
+			if (!isMoved[i])
+			{
+				continue;
+			}
+			if (const std::shared_ptr<Transform> transform = nodes[updatedIndices[i]].lock())
+			{
+				transform->state.updateOnDevice = true;
+			}
+		}
+
+		if (isExpired)
+		{
+			isTopologyChanged = true;
+		}
+	}
+
+	void TransformHierarchy::benchmark(const size_t numTransforms, const float animatedFraction)
+	{
+		if (numTransforms == 0)
+		{
+			return;
+		}
+
+		// Synthetic hierarchy with a branching factor of 8, deep enough to exercise the level by level propagation
+		constexpr uint32_t branching = 8;
+		std::vector<uint32_t> parents(numTransforms);
+		parents[0] = invalidIndex;
+		for (size_t i = 1; i < numTransforms; ++i)
+		{
+			parents[i] = static_cast<uint32_t>((i - 1) / branching);
+		}
+
+		std::mt19937                          generator(42);
+		std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+		const auto randomLocal = [&]()
+		{
+			const math::vec3f axis = math::normalize(math::vec3f(distribution(generator), distribution(generator), 1.0f));
+			return math::affine3f::translate(math::vec3f(distribution(generator), distribution(generator), distribution(generator)))
+				* math::affine3f::rotate(axis, distribution(generator));
+		};
+
+		TransformHierarchy hierarchy;
+		hierarchy.layout(parents);
+		for (math::affine3f& local : hierarchy.local)
+		{
+			local = randomLocal();
+		}
+
+		Timer timer;
+		hierarchy.propagate();
+		const float fullTime = timer.elapsedMillis();
+		const size_t fullCount = hierarchy.updatedIndices.size();
+
+		const size_t numAnimated = std::max<size_t>(1, static_cast<size_t>(static_cast<double>(numTransforms) * animatedFraction));
+		std::uniform_int_distribution<uint32_t> pick(0, static_cast<uint32_t>(numTransforms - 1));
+		constexpr int numFrames = 10;
+		float  animatedTime  = 0.0f;
+		size_t animatedCount = 0;
+		for (int frame = 0; frame < numFrames; ++frame)
+		{
+			for (size_t a = 0; a < numAnimated; ++a)
+			{
+				const uint32_t index = pick(generator);
+				hierarchy.local[index] = randomLocal();
+				if (!hierarchy.isDirty[index])
+				{
+					hierarchy.isDirty[index] = 1;
+					hierarchy.dirtyIndices.push_back(index);
+				}
+			}
+			timer.reset();
+			hierarchy.propagate();
+			animatedTime += timer.elapsedMillis();
+			animatedCount += hierarchy.updatedIndices.size();
+		}
+
+		VTX_INFO("Transform hierarchy benchmark, {} transforms on {} levels: full propagation {:.2f} ms ({} transforms), "
+				 "{} animated per frame {:.2f} ms ({} transforms recomputed on average)",
+				 numTransforms, hierarchy.levelOffsets.size() - 1, fullTime, fullCount,
+				 numAnimated, animatedTime / numFrames, animatedCount / numFrames);
+	}
+}
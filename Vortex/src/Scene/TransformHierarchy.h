@@ -0,0 +1,81 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Core/Math.h"
+#include "Core/VortexID.h"
+
+namespace vtx::graph
+{
+	class Node;
+	class Transform;
+	class Renderer;
+
+	// Flattened copy of the transform hierarchy of the scene graph. Transforms are stored level by level, the children of a
+	// transform are contiguous, so the world matrices are propagated one level at a time in parallel.
+	// Only the transforms whose local matrix changed and their subtrees are recomputed, the results are written back to
+	// the transform nodes (globalTransform and the parent matrices) which raise updateOnDevice when their world matrix moved.
+	// A node has a single world matrix, nodes shared under different enclosing transforms keep their first path with a warning.
+	class TransformHierarchy
+	{
+	public:
+		static TransformHierarchy* get();
+
+		// Children have been added to or removed from groups or instances, the hierarchy is rebuilt by the next update
+		void markTopologyChanged();
+
+		// The local matrix of the transform changed, can be called from any thread
+		void markLocalChanged(const Transform* transform);
+
+		void update(const std::shared_ptr<Renderer>& renderer);
+
+		// Same as the update of a renderer, for the hierarchy below the given roots
+		void update(const std::vector<std::shared_ptr<Node>>& rootNodes);
+
+		size_t getNumberOfTransforms() const;
+
+		// Transforms recomputed by the last update
+		size_t getNumberOfUpdatedTransforms() const;
+
+		// Logs the cost of propagating random local changes of a fraction of the transforms of a synthetic hierarchy,
+		// next to the cost of recomputing every transform
+		static void benchmark(size_t numTransforms = 1000000, float animatedFraction = 0.01f);
+
+	private:
+		TransformHierarchy() = default;
+
+		void rebuild(const std::vector<std::shared_ptr<Node>>& rootNodes);
+
+		// Lays out the hierarchy given by the parent of each transform level by level,
+		// returns the position in the given order of every transform in the new one
+		std::vector<uint32_t> layout(const std::vector<uint32_t>& parents);
+
+		void propagate();
+
+		void writeBack();
+
+		static constexpr uint32_t invalidIndex = UINT32_MAX;
+
+		std::vector<math::affine3f>           local;
+		std::vector<math::affine3f>           world;
+		std::vector<math::affine3f>           inverseWorld;
+		std::vector<uint32_t>                 parent;
+		std::vector<uint32_t>                 firstChild;
+		std::vector<uint32_t>                 childCount;
+		std::vector<uint32_t>                 level;
+		std::vector<uint32_t>                 levelOffsets;
+		std::vector<uint8_t>                  isDirty;
+		std::vector<uint32_t>                 visitEpoch;
+		uint32_t                              epoch = 0;
+		std::vector<std::weak_ptr<Transform>> nodes;
+		std::vector<uint32_t>                 indexOfUID;
+
+		std::vector<uint32_t>                 dirtyIndices;   // Local changes since the last update
+		std::vector<uint32_t>                 updatedIndices; // Recomputed by the last update, level by level
+
+		std::vector<std::weak_ptr<Node>>      roots;
+		bool                                  isTopologyChanged = true;
+		mutable std::mutex                    mutex;
+	};
+}
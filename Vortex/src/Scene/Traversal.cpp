@@ -1,5 +1,8 @@
 #include "Traversal.h"
 #include "Graph.h"
+#include "Core/Timer.h"
+#include "Scene/Scene.h"
+#include "Scene/Utility/Operations.h"
 
 namespace vtx
 {
@@ -12,7 +15,6 @@ namespace vtx
 			if(depthStack.empty())
 			{
 				depthStack.push(0);
-				depthWidth.resize(1);
 				isRoot = true;
 			}
 			else
@@ -25,21 +27,15 @@ namespace vtx
 			int depth = depthStack.top();
 			int width = widthStack.empty()? 0 : widthStack.top();
 
-			if (depth == depthWidth.size())
+			TreePositionEntry entry{ node.get(), depth, width, isRoot, parentPath };
+			if (isDeferringTreePositions)
 			{
-				depthWidth.resize(depth + 1);
-				depthWidth[depth] = 0;
+				treePositionEntries.push_back(std::move(entry));
 			}
-			else if (!isRoot)
+			else
 			{
-				depthWidth[depth] += 1;
+				applyTreePosition(entry);
 			}
-			//VTX_INFO("Node ID: {} Name: {} \t\t Depth: {} Width: {} Overall Width: {}", node->getUID(), node->name, depth, width, overallWidth);
-			nodesDepthsAndWidths[node->getUID()] = { depth, width, depthWidth[depth] };// , currentWidth + parent
-
-			node->treePosition.depth = depth;
-			node->treePosition.width = width;
-			node->treePosition.overallWidth = depthWidth[depth];
 
 			if (!widthStack.empty())
 			{
@@ -49,7 +45,6 @@ namespace vtx
 
 			widthStack.push(0);
 
-			nodesParents[node->getUID()] = parentPath;
 			parentPath.push_back(node->getUID());
 		}
 
@@ -101,105 +96,259 @@ namespace vtx
 		}
 	}
 
+	void NodeVisitor::applyTreePosition(TreePositionEntry& entry)
+	{
+		const int depth = entry.depth;
+		if (entry.isRoot)
+		{
+			depthWidth.resize(1);
+		}
+		if (depth == depthWidth.size())
+		{
+			depthWidth.resize(depth + 1);
+			depthWidth[depth] = 0;
+		}
+		else if (!entry.isRoot)
+		{
+			depthWidth[depth] += 1;
+		}
+		//VTX_INFO("Node ID: {} Name: {} \t\t Depth: {} Width: {} Overall Width: {}", node->getUID(), node->name, depth, width, overallWidth);
+		const vtxID uid = entry.node->getUID();
+		nodesDepthsAndWidths[uid] = { depth, entry.width, depthWidth[depth] };// , currentWidth + parent
+
+		entry.node->treePosition.depth = depth;
+		entry.node->treePosition.width = entry.width;
+		entry.node->treePosition.overallWidth = depthWidth[depth];
+
+		nodesParents[uid] = std::move(entry.parentPath);
+	}
+
+	std::unique_ptr<NodeVisitor> NodeVisitor::forkSubtree()
+	{
+		std::unique_ptr<NodeVisitor> subtreeVisitor = createSubtreeVisitor();
+		if (!subtreeVisitor)
+		{
+			return nullptr;
+		}
+		subtreeVisitor->isSubtreeVisitor       = true;
+		subtreeVisitor->collectWidthsAndDepths = collectWidthsAndDepths;
+		subtreeVisitor->collectTransforms      = collectTransforms;
+
+		if (collectWidthsAndDepths)
+		{
+			// The subtree root takes the next width among the children of the current node
+			subtreeVisitor->isDeferringTreePositions = true;
+			subtreeVisitor->depthStack.push(depthStack.top());
+			subtreeVisitor->widthStack.push(widthStack.top());
+			subtreeVisitor->parentPath = parentPath;
+			widthStack.top() += 1;
+		}
+		if (collectTransforms)
+		{
+			subtreeVisitor->currentTransform = currentTransform;
+		}
+		return subtreeVisitor;
+	}
+
+	void NodeVisitor::mergeSubtreeVisitor(NodeVisitor& subtreeVisitor)
+	{
+		for (TreePositionEntry& entry : subtreeVisitor.treePositionEntries)
+		{
+			applyTreePosition(entry);
+		}
+		subtreeVisitor.treePositionEntries.clear();
+	}
+
 	void NodeVisitor::visit(const std::shared_ptr<graph::Transform>& transform)
 	{
-		visit(std::dynamic_pointer_cast<graph::Node>(transform));
+		visit(std::static_pointer_cast<graph::Node>(transform));
 	}
 	void NodeVisitor::visit(const std::shared_ptr<graph::Instance>& instance)
 	{
-		visit(std::dynamic_pointer_cast<graph::Node>(instance));
+		visit(std::static_pointer_cast<graph::Node>(instance));
 	}
 	void NodeVisitor::visit(const std::shared_ptr<graph::Group>& group)
 	{
-		visit(std::dynamic_pointer_cast<graph::Node>(group));
+		visit(std::static_pointer_cast<graph::Node>(group));
 	}
 	void NodeVisitor::visit(const std::shared_ptr<graph::Mesh>& mesh)
 	{
-		visit(std::dynamic_pointer_cast<graph::Node>(mesh));
+		visit(std::static_pointer_cast<graph::Node>(mesh));
 	}
 	void NodeVisitor::visit(const std::shared_ptr<graph::Material>& material)
 	{
-		visit(std::dynamic_pointer_cast<graph::Node>(material));
+		visit(std::static_pointer_cast<graph::Node>(material));
 	}
 	void NodeVisitor::visit(const std::shared_ptr<graph::Camera>& camera)
 	{
-		visit(std::dynamic_pointer_cast<graph::Node>(camera));
+		visit(std::static_pointer_cast<graph::Node>(camera));
 	}
 	void NodeVisitor::visit(const std::shared_ptr<graph::Renderer>& renderer)
 	{
-		visit(std::dynamic_pointer_cast<graph::Node>(renderer));
+		visit(std::static_pointer_cast<graph::Node>(renderer));
 	}
 	void NodeVisitor::visit(const std::shared_ptr<graph::Texture>& texture)
 	{
-		visit(std::dynamic_pointer_cast<graph::Node>(texture));
+		visit(std::static_pointer_cast<graph::Node>(texture));
 	}
 	void NodeVisitor::visit(const std::shared_ptr<graph::BsdfMeasurement>& bsdfMeasurement)
 	{
-		visit(std::dynamic_pointer_cast<graph::Node>(bsdfMeasurement));
+		visit(std::static_pointer_cast<graph::Node>(bsdfMeasurement));
 	}
 	void NodeVisitor::visit(const std::shared_ptr<graph::LightProfile>& lightProfile)
 	{
-		visit(std::dynamic_pointer_cast<graph::Node>(lightProfile));
+		visit(std::static_pointer_cast<graph::Node>(lightProfile));
 	}
 	void NodeVisitor::visit(const std::shared_ptr<graph::EnvironmentLight>& node)
 	{
-		visit(std::dynamic_pointer_cast<graph::Node>(node));
+		visit(std::static_pointer_cast<graph::Node>(node));
 	}
 	void NodeVisitor::visit(const std::shared_ptr<graph::MeshLight>& node)
 	{
-		visit(std::dynamic_pointer_cast<graph::Node>(node));
+		visit(std::static_pointer_cast<graph::Node>(node));
 	}
 
 	void NodeVisitor::visit(const std::shared_ptr<graph::shader::ShaderNode>& shaderNode)
 	{
-		visit(std::dynamic_pointer_cast<graph::Node>(shaderNode));
+		visit(std::static_pointer_cast<graph::Node>(shaderNode));
 	}
 	void NodeVisitor::visit(const std::shared_ptr<graph::shader::DiffuseReflection>& shaderNode)
 	{
-		visit(std::dynamic_pointer_cast<graph::shader::ShaderNode>(shaderNode));
+		visit(std::static_pointer_cast<graph::shader::ShaderNode>(shaderNode));
 	}
 	void NodeVisitor::visit(const std::shared_ptr<graph::shader::MaterialSurface>& shaderNode)
 	{
-		visit(std::dynamic_pointer_cast<graph::shader::ShaderNode>(shaderNode));
+		visit(std::static_pointer_cast<graph::shader::ShaderNode>(shaderNode));
 	}
 	void NodeVisitor::visit(const std::shared_ptr<graph::shader::Material>& shaderNode)
 	{
-		visit(std::dynamic_pointer_cast<graph::shader::ShaderNode>(shaderNode));
+		visit(std::static_pointer_cast<graph::shader::ShaderNode>(shaderNode));
 	}
 	void NodeVisitor::visit(const std::shared_ptr<graph::shader::ImportedNode>& shaderNode)
 	{
-		visit(std::dynamic_pointer_cast<graph::shader::ShaderNode>(shaderNode));
+		visit(std::static_pointer_cast<graph::shader::ShaderNode>(shaderNode));
 	}
 	void NodeVisitor::visit(const std::shared_ptr<graph::shader::PrincipledMaterial>& shaderNode)
 	{
-		visit(std::dynamic_pointer_cast<graph::shader::ShaderNode>(shaderNode));
+		visit(std::static_pointer_cast<graph::shader::ShaderNode>(shaderNode));
 	}
 	void NodeVisitor::visit(const std::shared_ptr<graph::shader::ColorTexture>& shaderNode)
 	{
-		visit(std::dynamic_pointer_cast<graph::shader::ShaderNode>(shaderNode));
+		visit(std::static_pointer_cast<graph::shader::ShaderNode>(shaderNode));
 	}
 	void NodeVisitor::visit(const std::shared_ptr<graph::shader::MonoTexture>& shaderNode)
 	{
-		visit(std::dynamic_pointer_cast<graph::shader::ShaderNode>(shaderNode));
+		visit(std::static_pointer_cast<graph::shader::ShaderNode>(shaderNode));
 	}
 	void NodeVisitor::visit(const std::shared_ptr<graph::shader::NormalTexture>& shaderNode)
 	{
-		visit(std::dynamic_pointer_cast<graph::shader::ShaderNode>(shaderNode));
+		visit(std::static_pointer_cast<graph::shader::ShaderNode>(shaderNode));
 	}
 	void NodeVisitor::visit(const std::shared_ptr<graph::shader::BumpTexture>& shaderNode)
 	{
-		visit(std::dynamic_pointer_cast<graph::shader::ShaderNode>(shaderNode));
+		visit(std::static_pointer_cast<graph::shader::ShaderNode>(shaderNode));
 	}
 	void NodeVisitor::visit(const std::shared_ptr<graph::shader::TextureTransform>& shaderNode)
 	{
-		visit(std::dynamic_pointer_cast<graph::shader::ShaderNode>(shaderNode));
+		visit(std::static_pointer_cast<graph::shader::ShaderNode>(shaderNode));
 	}
 	void NodeVisitor::visit(const std::shared_ptr<graph::shader::NormalMix>& shaderNode)
 	{
-		visit(std::dynamic_pointer_cast<graph::shader::ShaderNode>(shaderNode));
+		visit(std::static_pointer_cast<graph::shader::ShaderNode>(shaderNode));
 	}
 	void NodeVisitor::visit(const std::shared_ptr<graph::shader::GetChannel>& shaderNode)
 	{
-		visit(std::dynamic_pointer_cast<graph::shader::ShaderNode>(shaderNode));
+		visit(std::static_pointer_cast<graph::shader::ShaderNode>(shaderNode));
+	}
+
+	namespace
+	{
+		class CountingVisitor : public NodeVisitor
+		{
+		public:
+			void visit(const std::shared_ptr<graph::Node>& node) override
+			{
+				++visitedNodes;
+			}
+
+			size_t visitedNodes = 0;
+		};
+	}
+
+	void benchmarkNodeCasts(const size_t numNodes)
+	{
+		// Every group brings its transform, groups are attached eight per parent
+		constexpr size_t branching = 8;
+		const size_t numGroups = std::max<size_t>(1, numNodes / 2);
+		std::vector<std::shared_ptr<graph::Group>> groups(numGroups);
+		std::vector<std::shared_ptr<graph::Node>>  nodes;
+		nodes.reserve(numGroups * 2);
+		for (size_t i = 0; i < numGroups; ++i)
+		{
+			groups[i] = ops::createNode<graph::Group>();
+			if (i > 0)
+			{
+				groups[(i - 1) / branching]->addChild(groups[i]);
+			}
+			nodes.push_back(groups[i]);
+			nodes.push_back(groups[i]->transform);
+		}
+
+		const auto nsPerNode = [&nodes](const float milliseconds)
+		{
+			return (double)milliseconds * 1.0e6 / (double)nodes.size();
+		};
+
+		// The traversal casts every node to its own class to accept the visitor,
+		// and probes the children of every node for a transform
+		Timer  timer;
+		size_t found = 0;
+		for (const std::shared_ptr<graph::Node>& node : nodes)
+		{
+			found += std::dynamic_pointer_cast<graph::Group>(node) != nullptr ? 1 : 0;
+			found += std::dynamic_pointer_cast<graph::Transform>(node) != nullptr ? 1 : 0;
+		}
+		const float dynamicCastTime = timer.elapsedMillis();
+
+		timer.reset();
+		for (const std::shared_ptr<graph::Node>& node : nodes)
+		{
+			found += graph::nodeCast<graph::Group>(node) != nullptr ? 1 : 0;
+			found += graph::nodeCast<graph::Transform>(node) != nullptr ? 1 : 0;
+		}
+		const float nodeCastTime = timer.elapsedMillis();
+
+		CountingVisitor visitor;
+		visitor.collectTransforms = true;
+		timer.reset();
+		groups[0]->traverse(visitor);
+		const float traversalTime = timer.elapsedMillis();
+
+		// The synchronization looks the journaled nodes up by id
+		const std::shared_ptr<graph::SceneIndexManager> sim = graph::Scene::getSim();
+		timer.reset();
+		for (const std::shared_ptr<graph::Node>& node : nodes)
+		{
+			found += std::dynamic_pointer_cast<graph::Transform>((*sim)[node->getUID()]) != nullptr ? 1 : 0;
+		}
+		const float dynamicLookupTime = timer.elapsedMillis();
+
+		timer.reset();
+		for (const std::shared_ptr<graph::Node>& node : nodes)
+		{
+			found += graph::nodeCast<graph::Transform>((*sim)[node->getUID()]) != nullptr ? 1 : 0;
+		}
+		const float nodeLookupTime = timer.elapsedMillis();
+
+		VTX_INFO("Node cast benchmark, {} nodes: traversal {:.2f} ms ({} visited), traversal casts {:.1f} ns per node with "
+				 "dynamic_pointer_cast / {:.1f} ns with nodeCast, sync lookups {:.1f} ns / {:.1f} ns per node ({} found)",
+				 nodes.size(), traversalTime, visitor.visitedNodes, nsPerNode(dynamicCastTime), nsPerNode(nodeCastTime),
+				 nsPerNode(dynamicLookupTime), nsPerNode(nodeLookupTime), found);
+
+		// The synthetic nodes are not part of the scene, they should not show up as deleted nodes on the device
+		for (const std::shared_ptr<graph::Node>& node : nodes)
+		{
+			sim->removeNodeReference(node->getUID(), node->getTypeID(), node->getType(), false);
+		}
 	}
 }
@@ -67,6 +67,42 @@ namespace vtx {
 
 		void visitEnd(const std::shared_ptr<graph::Node>& node);
 
+		//////////////////////////////////////////////////////////////////////////////////
+		//////////////////////// Parallel Traversal //////////////////////////////////////
+		//////////////////////////////////////////////////////////////////////////////////
+
+		// Visitors which can visit disjoint subtrees from several threads at once declare it here and implement
+		// createSubtreeVisitor. Node::traverseParallel hands every subtree below the top levels of the graph to its own
+		// copy of the visitor, and merges the copies back in traversal order.
+		// Nodes shared by several subtrees can be visited by several threads at the same time.
+		virtual bool isThreadSafe() const { return false; }
+
+		// Empty visitor of the same kind, the traversal state is copied by forkSubtree
+		virtual std::unique_ptr<NodeVisitor> createSubtreeVisitor() const { return nullptr; }
+
+		// Merges the results of a subtree visitor, called on the calling thread of the traversal in traversal order
+		virtual void mergeSubtreeVisitor(NodeVisitor& subtreeVisitor);
+
+		// Visitor continuing the traversal below the current node
+		std::unique_ptr<NodeVisitor> forkSubtree();
+
+		struct TreePositionEntry
+		{
+			graph::Node*       node;
+			int                depth;
+			int                width;
+			bool               isRoot;
+			std::vector<vtxID> parentPath;
+		};
+
+		// The overall width depends on every node visited before, subtree visitors and the top levels of a parallel
+		// traversal defer the tree positions until the merge
+		void applyTreePosition(TreePositionEntry& entry);
+
+		bool                           isSubtreeVisitor         = false;
+		bool                           isDeferringTreePositions = false;
+		std::vector<TreePositionEntry> treePositionEntries;
+
 		bool collectWidthsAndDepths = false;
 		std::map<vtxID, std::tuple<int, int, int>> nodesDepthsAndWidths = {};
 		std::map<vtxID, std::vector<vtxID>> nodesParents = {};
@@ -81,4 +117,8 @@ namespace vtx {
 		std::stack<math::affine3f> tmpTransforms;
 	};
 
+	// Logs the cost of traversing a synthetic graph of the given number of nodes and of the node casts done by the
+	// traversal and by the device synchronization lookups, with the node type casts next to dynamic_pointer_cast
+	void benchmarkNodeCasts(size_t numNodes = 500000);
+
 }
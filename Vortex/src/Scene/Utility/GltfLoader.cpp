@@ -0,0 +1,969 @@
+#include "GltfLoader.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <set>
+#include <sstream>
+#include <cereal/external/rapidjson/document.h>
+#include "Core/Hashing.h"
+#include "Core/Options.h"
+#include "Core/ThreadPool.h"
+#include "Core/Timer.h"
+#include "Scene/Graph.h"
+#include "Operations.h"
+
+namespace vtx::importer
+{
+	using JsonValue    = CEREAL_RAPIDJSON_NAMESPACE::Value;
+	using JsonDocument = CEREAL_RAPIDJSON_NAMESPACE::Document;
+
+	enum GltfConstants
+	{
+		GLB_MAGIC            = 0x46546C67,
+		GLB_CHUNK_JSON       = 0x4E4F534A,
+		GLB_CHUNK_BIN        = 0x004E4942,
+
+		GLTF_BYTE            = 5120,
+		GLTF_UNSIGNED_BYTE   = 5121,
+		GLTF_SHORT           = 5122,
+		GLTF_UNSIGNED_SHORT  = 5123,
+		GLTF_UNSIGNED_INT    = 5125,
+		GLTF_FLOAT           = 5126,
+
+		GLTF_TRIANGLES       = 4,
+		GLTF_TRIANGLE_STRIP  = 5,
+		GLTF_TRIANGLE_FAN    = 6
+	};
+
+	// Extensions which may be listed as required without preventing the native import
+	static const std::set<std::string> supportedExtensions = {
+		"KHR_materials_emissive_strength",
+		"KHR_materials_transmission",
+		"KHR_materials_clearcoat",
+		"KHR_materials_sheen",
+		"KHR_materials_specular"
+	};
+
+	struct GltfBuffer
+	{
+		const unsigned char* data;
+		size_t               size;
+	};
+
+	static uint32_t readU32(const unsigned char* data)
+	{
+		uint32_t value;
+		std::memcpy(&value, data, sizeof(uint32_t));
+		return value;
+	}
+
+	static const JsonValue* findMember(const JsonValue& object, const char* name)
+	{
+		if (!object.IsObject())
+		{
+			return nullptr;
+		}
+		const auto it = object.FindMember(name);
+		return it != object.MemberEnd() ? &it->value : nullptr;
+	}
+
+	static const JsonValue* findArray(const JsonValue& object, const char* name)
+	{
+		const JsonValue* value = findMember(object, name);
+		return (value != nullptr && value->IsArray()) ? value : nullptr;
+	}
+
+	static int64_t getInt(const JsonValue& object, const char* name, const int64_t defaultValue)
+	{
+		const JsonValue* value = findMember(object, name);
+		return (value != nullptr && value->IsInt64()) ? value->GetInt64() : defaultValue;
+	}
+
+	static float getFloat(const JsonValue& object, const char* name, const float defaultValue)
+	{
+		const JsonValue* value = findMember(object, name);
+		return (value != nullptr && value->IsNumber()) ? (float)value->GetDouble() : defaultValue;
+	}
+
+	static bool getBool(const JsonValue& object, const char* name, const bool defaultValue)
+	{
+		const JsonValue* value = findMember(object, name);
+		return (value != nullptr && value->IsBool()) ? value->GetBool() : defaultValue;
+	}
+
+	static std::string getString(const JsonValue& object, const char* name, const std::string& defaultValue = "")
+	{
+		const JsonValue* value = findMember(object, name);
+		return (value != nullptr && value->IsString()) ? std::string(value->GetString(), value->GetStringLength()) : defaultValue;
+	}
+
+	static std::vector<float> getFloats(const JsonValue& object, const char* name, const std::vector<float>& defaultValue)
+	{
+		const JsonValue* value = findArray(object, name);
+		if (value == nullptr || value->Size() != defaultValue.size())
+		{
+			return defaultValue;
+		}
+		std::vector<float> result(defaultValue.size());
+		for (unsigned i = 0; i < value->Size(); ++i)
+		{
+			result[i] = (*value)[i].IsNumber() ? (float)(*value)[i].GetDouble() : defaultValue[i];
+		}
+		return result;
+	}
+
+	static bool decodeBase64(const char* input, const size_t size, std::vector<unsigned char>& output)
+	{
+		static const std::string alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+		output.clear();
+		output.reserve(size / 4 * 3);
+		uint32_t buffer = 0;
+		int      bits   = 0;
+		for (size_t i = 0; i < size; ++i)
+		{
+			const char c = input[i];
+			if (c == '=')
+			{
+				break;
+			}
+			const size_t value = alphabet.find(c);
+			if (value == std::string::npos)
+			{
+				return false;
+			}
+			buffer = (buffer << 6) | (uint32_t)value;
+			bits += 6;
+			if (bits >= 8)
+			{
+				bits -= 8;
+				output.push_back((unsigned char)((buffer >> bits) & 0xFF));
+			}
+		}
+		return true;
+	}
+
+	// Offsets and sizes come from the file, the check is written so that it can't wrap around
+	static bool isRangeInside(const int64_t offset, const int64_t size, const size_t available)
+	{
+		return offset >= 0 && size >= 0 && (uint64_t)offset <= available && (uint64_t)size <= available - (uint64_t)offset;
+	}
+
+	static size_t componentSize(const int componentType)
+	{
+		switch (componentType)
+		{
+		case GLTF_BYTE:
+		case GLTF_UNSIGNED_BYTE: return 1;
+		case GLTF_SHORT:
+		case GLTF_UNSIGNED_SHORT: return 2;
+		case GLTF_UNSIGNED_INT:
+		case GLTF_FLOAT: return 4;
+		default: return 0;
+		}
+	}
+
+	static int numberOfComponents(const std::string& type)
+	{
+		if (type == "SCALAR") return 1;
+		if (type == "VEC2") return 2;
+		if (type == "VEC3") return 3;
+		if (type == "VEC4") return 4;
+		return 0;
+	}
+
+	static float readComponent(const GltfLoader::Accessor& accessor, const size_t element, const int component)
+	{
+		const unsigned char* data = accessor.data + element * accessor.stride;
+		switch (accessor.componentType)
+		{
+		case GLTF_FLOAT:
+		{
+			float value;
+			std::memcpy(&value, data + component * sizeof(float), sizeof(float));
+			return value;
+		}
+		case GLTF_UNSIGNED_BYTE:
+		{
+			const float value = (float)data[component];
+			return accessor.normalized ? value / 255.0f : value;
+		}
+		case GLTF_UNSIGNED_SHORT:
+		{
+			uint16_t value;
+			std::memcpy(&value, data + component * sizeof(uint16_t), sizeof(uint16_t));
+			return accessor.normalized ? (float)value / 65535.0f : (float)value;
+		}
+		case GLTF_BYTE:
+		{
+			const float value = (float)(int8_t)data[component];
+			return accessor.normalized ? std::max(value / 127.0f, -1.0f) : value;
+		}
+		case GLTF_SHORT:
+		{
+			int16_t value;
+			std::memcpy(&value, data + component * sizeof(int16_t), sizeof(int16_t));
+			return accessor.normalized ? std::max((float)value / 32767.0f, -1.0f) : (float)value;
+		}
+		default:
+			return 0.0f;
+		}
+	}
+
+	static vtxID readIndex(const GltfLoader::Accessor& accessor, const size_t element)
+	{
+		const unsigned char* data = accessor.data + element * accessor.stride;
+		switch (accessor.componentType)
+		{
+		case GLTF_UNSIGNED_BYTE:
+			return data[0];
+		case GLTF_UNSIGNED_SHORT:
+		{
+			uint16_t value;
+			std::memcpy(&value, data, sizeof(uint16_t));
+			return value;
+		}
+		default:
+		{
+			uint32_t value;
+			std::memcpy(&value, data, sizeof(uint32_t));
+			return value;
+		}
+		}
+	}
+
+	static math::vec3f readVec3(const GltfLoader::Accessor& accessor, const size_t element)
+	{
+		return { readComponent(accessor, element, 0), readComponent(accessor, element, 1), readComponent(accessor, element, 2) };
+	}
+
+	static math::vec3f swapVector(const math::vec3f& vec, const SwapType swap)
+	{
+		return (swap == SwapType::yToZ) ? math::vec3f(vec.x, vec.z, vec.y) : vec;
+	}
+
+	static aiMatrix4x4 getNodeMatrix(const JsonValue& node)
+	{
+		const JsonValue* matrix = findArray(node, "matrix");
+		if (matrix != nullptr && matrix->Size() == 16)
+		{
+			// glTF matrices are column major
+			const std::vector<float> m = getFloats(node, "matrix", std::vector<float>(16, 0.0f));
+			return aiMatrix4x4(m[0], m[4], m[8], m[12],
+							   m[1], m[5], m[9], m[13],
+							   m[2], m[6], m[10], m[14],
+							   m[3], m[7], m[11], m[15]);
+		}
+		const std::vector<float> t = getFloats(node, "translation", { 0.0f, 0.0f, 0.0f });
+		const std::vector<float> r = getFloats(node, "rotation", { 0.0f, 0.0f, 0.0f, 1.0f });
+		const std::vector<float> s = getFloats(node, "scale", { 1.0f, 1.0f, 1.0f });
+		return aiMatrix4x4(aiVector3D(s[0], s[1], s[2]), aiQuaternion(r[3], r[0], r[1], r[2]), aiVector3D(t[0], t[1], t[2]));
+	}
+
+	// Embedded images are written next to the import cache so that textures can be loaded by path like any other image
+	static std::string writeEmbeddedImage(const unsigned char* data, const size_t size, const std::string& mimeType)
+	{
+		const std::string extension = (mimeType == "image/jpeg") ? "jpg" : (mimeType == "image/png") ? "png" : "bin";
+		std::stringstream ss;
+		ss << getOptions()->importCacheFolder << "textures/" << std::hex << utl::hashBytes(data, size) << "." << extension;
+		const std::string imagePath = ss.str();
+		if (!std::filesystem::exists(imagePath))
+		{
+			utl::createDirectory(imagePath);
+			std::ofstream outFile(imagePath, std::ios::binary);
+			outFile.write(reinterpret_cast<const char*>(data), (std::streamsize)size);
+		}
+		return imagePath;
+	}
+
+	bool GltfLoader::open(const std::string& filePath, const SwapType swapType)
+	{
+		Timer timer;
+		swap = swapType;
+		const std::string folder = utl::getFolder(filePath);
+
+		auto file = std::make_unique<utl::MappedFile>(filePath);
+		if (!file->isValid())
+		{
+			VTX_WARN("glTF loader: failed to map {}", filePath);
+			return false;
+		}
+		const auto*  fileData = static_cast<const unsigned char*>(file->getData());
+		const size_t fileSize = file->getSize();
+		mappedFiles.push_back(std::move(file));
+
+		const char*          json     = reinterpret_cast<const char*>(fileData);
+		size_t               jsonSize = fileSize;
+		const unsigned char* binChunk = nullptr;
+		size_t               binSize  = 0;
+		if (fileSize >= 12 && readU32(fileData) == GLB_MAGIC)
+		{
+			if (readU32(fileData + 4) != 2)
+			{
+				VTX_WARN("glTF loader: {} is not a glTF 2.0 binary", filePath);
+				return false;
+			}
+			json = nullptr;
+			size_t offset = 12;
+			while (offset + 8 <= fileSize)
+			{
+				const uint32_t chunkLength = readU32(fileData + offset);
+				const uint32_t chunkType   = readU32(fileData + offset + 4);
+				offset += 8;
+				if (offset + chunkLength > fileSize)
+				{
+					VTX_WARN("glTF loader: {} is truncated", filePath);
+					return false;
+				}
+				if (chunkType == GLB_CHUNK_JSON && json == nullptr)
+				{
+					json     = reinterpret_cast<const char*>(fileData + offset);
+					jsonSize = chunkLength;
+				}
+				else if (chunkType == GLB_CHUNK_BIN && binChunk == nullptr)
+				{
+					binChunk = fileData + offset;
+					binSize  = chunkLength;
+				}
+				offset += chunkLength;
+			}
+			if (json == nullptr)
+			{
+				VTX_WARN("glTF loader: {} has no json chunk", filePath);
+				return false;
+			}
+		}
+
+		JsonDocument document;
+		document.Parse(json, jsonSize);
+		if (document.HasParseError() || !document.IsObject())
+		{
+			VTX_WARN("glTF loader: failed to parse the json of {}", filePath);
+			return false;
+		}
+
+		if (const JsonValue* required = findArray(document, "extensionsRequired"))
+		{
+			for (const JsonValue& extension : required->GetArray())
+			{
+				if (!extension.IsString() || supportedExtensions.find(extension.GetString()) == supportedExtensions.end())
+				{
+					VTX_INFO("glTF loader: required extension {} is not supported natively", extension.IsString() ? extension.GetString() : "?");
+					return false;
+				}
+			}
+		}
+
+		static const JsonValue emptyArray(CEREAL_RAPIDJSON_NAMESPACE::kArrayType);
+		auto getArray = [&document](const char* name) -> const JsonValue&
+		{
+			const JsonValue* value = findArray(document, name);
+			return value != nullptr ? *value : emptyArray;
+		};
+		const JsonValue& jsonBuffers     = getArray("buffers");
+		const JsonValue& jsonBufferViews = getArray("bufferViews");
+		const JsonValue& jsonAccessors   = getArray("accessors");
+		const JsonValue& jsonImages      = getArray("images");
+		const JsonValue& jsonTextures    = getArray("textures");
+		const JsonValue& jsonMaterials   = getArray("materials");
+		const JsonValue& jsonMeshes      = getArray("meshes");
+		const JsonValue& jsonNodes       = getArray("nodes");
+		const JsonValue& jsonCameras     = getArray("cameras");
+		const JsonValue& jsonScenes      = getArray("scenes");
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		/////////////////// Buffers //////////////////////////////////////////////////////////
+		//////////////////////////////////////////////////////////////////////////////////////
+		std::vector<GltfBuffer> buffers;
+		for (const JsonValue& jsonBuffer : jsonBuffers.GetArray())
+		{
+			const size_t      byteLength = (size_t)getInt(jsonBuffer, "byteLength", 0);
+			const std::string uri        = getString(jsonBuffer, "uri");
+			GltfBuffer        buffer{ nullptr, 0 };
+			if (uri.empty())
+			{
+				buffer = { binChunk, binSize };
+			}
+			else if (uri.rfind("data:", 0) == 0)
+			{
+				const size_t dataStart = uri.find(";base64,");
+				decodedBuffers.emplace_back();
+				if (dataStart == std::string::npos || !decodeBase64(uri.c_str() + dataStart + 8, uri.size() - dataStart - 8, decodedBuffers.back()))
+				{
+					VTX_WARN("glTF loader: unsupported data uri in {}", filePath);
+					return false;
+				}
+				buffer = { decodedBuffers.back().data(), decodedBuffers.back().size() };
+			}
+			else
+			{
+				const std::string bufferPath   = utl::replacePercent20WithSpace(utl::absolutePath(uri, folder));
+				auto              bufferFile = std::make_unique<utl::MappedFile>(bufferPath);
+				if (!bufferFile->isValid())
+				{
+					VTX_WARN("glTF loader: failed to map buffer {}", bufferPath);
+					return false;
+				}
+				buffer = { static_cast<const unsigned char*>(bufferFile->getData()), bufferFile->getSize() };
+				mappedFiles.push_back(std::move(bufferFile));
+			}
+			if (buffer.data == nullptr || buffer.size < byteLength)
+			{
+				VTX_WARN("glTF loader: buffer {} of {} is missing or too small", buffers.size(), filePath);
+				return false;
+			}
+			buffers.push_back(buffer);
+		}
+
+		// Returns the bytes of a buffer view, or nullptr if the view is not valid
+		auto getBufferView = [&](const int64_t viewId, size_t& viewSize, size_t& viewStride) -> const unsigned char*
+		{
+			if (viewId < 0 || viewId >= (int64_t)jsonBufferViews.Size())
+			{
+				return nullptr;
+			}
+			const JsonValue& view     = jsonBufferViews[(unsigned)viewId];
+			const int64_t    bufferId = getInt(view, "buffer", -1);
+			const int64_t    offset   = getInt(view, "byteOffset", 0);
+			const int64_t    length   = getInt(view, "byteLength", 0);
+			const int64_t    stride   = getInt(view, "byteStride", 0);
+			if (bufferId < 0 || bufferId >= (int64_t)buffers.size() || stride < 0 || !isRangeInside(offset, length, buffers[bufferId].size))
+			{
+				return nullptr;
+			}
+			viewSize   = (size_t)length;
+			viewStride = (size_t)stride;
+			return buffers[bufferId].data + offset;
+		};
+
+		auto parseAccessor = [&](const int64_t accessorId, Accessor& accessor) -> bool
+		{
+			if (accessorId < 0 || accessorId >= (int64_t)jsonAccessors.Size())
+			{
+				return false;
+			}
+			const JsonValue& jsonAccessor = jsonAccessors[(unsigned)accessorId];
+			if (findMember(jsonAccessor, "sparse") != nullptr)
+			{
+				VTX_INFO("glTF loader: sparse accessors are not supported natively");
+				return false;
+			}
+			size_t                     viewSize   = 0;
+			size_t                     viewStride = 0;
+			const unsigned char* const viewData   = getBufferView(getInt(jsonAccessor, "bufferView", -1), viewSize, viewStride);
+			accessor.componentType = (int)getInt(jsonAccessor, "componentType", 0);
+			accessor.numComponents = numberOfComponents(getString(jsonAccessor, "type"));
+			accessor.normalized    = getBool(jsonAccessor, "normalized", false);
+			const int64_t count       = getInt(jsonAccessor, "count", 0);
+			const int64_t offset      = getInt(jsonAccessor, "byteOffset", 0);
+			const size_t  elementSize = componentSize(accessor.componentType) * accessor.numComponents;
+			accessor.count            = (size_t)std::max<int64_t>(count, 0);
+			accessor.stride           = viewStride != 0 ? viewStride : elementSize;
+			if (viewData == nullptr || elementSize == 0 || count < 0 || offset < 0)
+			{
+				return false;
+			}
+			// The last element starts count - 1 strides after the first one and has to end inside the view
+			if (accessor.count > 0 && (!isRangeInside(offset, (int64_t)elementSize, viewSize) ||
+									   accessor.count - 1 > (viewSize - (size_t)offset - elementSize) / accessor.stride))
+			{
+				return false;
+			}
+			accessor.data = viewData + offset;
+			return true;
+		};
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		/////////////////// Materials ////////////////////////////////////////////////////////
+		//////////////////////////////////////////////////////////////////////////////////////
+		std::vector<std::string> imagePaths;
+		for (const JsonValue& jsonImage : jsonImages.GetArray())
+		{
+			const std::string uri      = getString(jsonImage, "uri");
+			const std::string mimeType = getString(jsonImage, "mimeType");
+			if (!uri.empty() && uri.rfind("data:", 0) != 0)
+			{
+				imagePaths.push_back(utl::replacePercent20WithSpace(utl::absolutePath(uri, folder)));
+			}
+			else if (!uri.empty())
+			{
+				const size_t               dataStart = uri.find(";base64,");
+				std::vector<unsigned char> imageData;
+				const bool decoded = dataStart != std::string::npos && decodeBase64(uri.c_str() + dataStart + 8, uri.size() - dataStart - 8, imageData);
+				const std::string uriMimeType = uri.substr(5, uri.find(';') - 5);
+				imagePaths.push_back(decoded ? writeEmbeddedImage(imageData.data(), imageData.size(), uriMimeType) : "");
+			}
+			else
+			{
+				size_t                     viewSize   = 0;
+				size_t                     viewStride = 0;
+				const unsigned char* const viewData   = getBufferView(getInt(jsonImage, "bufferView", -1), viewSize, viewStride);
+				imagePaths.push_back(viewData != nullptr ? writeEmbeddedImage(viewData, viewSize, mimeType) : "");
+			}
+		}
+
+		auto getTexturePath = [&](const JsonValue* textureInfo) -> std::string
+		{
+			if (textureInfo == nullptr)
+			{
+				return "";
+			}
+			const int64_t textureId = getInt(*textureInfo, "index", -1);
+			if (textureId < 0 || textureId >= (int64_t)jsonTextures.Size())
+			{
+				return "";
+			}
+			const int64_t imageId = getInt(jsonTextures[(unsigned)textureId], "source", -1);
+			return (imageId >= 0 && imageId < (int64_t)imagePaths.size()) ? imagePaths[imageId] : "";
+		};
+
+		// Same mapping assimp does for glTF, so that createPrincipledMaterial gives the same result
+		auto describeMaterial = [&](const JsonValue& jsonMaterial)
+		{
+			AssimpMaterialProperties properties;
+			properties.name = getString(jsonMaterial, "name");
+
+			static const JsonValue emptyObject(CEREAL_RAPIDJSON_NAMESPACE::kObjectType);
+			const JsonValue* pbrMember = findMember(jsonMaterial, "pbrMetallicRoughness");
+			const JsonValue& pbr       = pbrMember != nullptr ? *pbrMember : emptyObject;
+
+			const std::vector<float> baseColor = getFloats(pbr, "baseColorFactor", { 1.0f, 1.0f, 1.0f, 1.0f });
+			properties.diffuse.value   = math::vec3f(baseColor[0], baseColor[1], baseColor[2]);
+			properties.diffuse.path    = getTexturePath(findMember(pbr, "baseColorTexture"));
+			properties.metallic.value  = getFloat(pbr, "metallicFactor", 1.0f);
+			properties.roughness.value = getFloat(pbr, "roughnessFactor", 1.0f);
+			properties.ORM.path        = getTexturePath(findMember(pbr, "metallicRoughnessTexture"));
+
+			const JsonValue* normalTexture = findMember(jsonMaterial, "normalTexture");
+			properties.normal.path  = getTexturePath(normalTexture);
+			properties.normal.value = normalTexture != nullptr ? getFloat(*normalTexture, "scale", 1.0f) : -1.0f;
+
+			const std::vector<float> emissive = getFloats(jsonMaterial, "emissiveFactor", { 0.0f, 0.0f, 0.0f });
+			properties.emissionColor.value    = math::vec3f(emissive[0], emissive[1], emissive[2]);
+			properties.emissionIntensity.path = getTexturePath(findMember(jsonMaterial, "emissiveTexture"));
+
+			if (const JsonValue* extensions = findMember(jsonMaterial, "extensions"))
+			{
+				if (const JsonValue* strength = findMember(*extensions, "KHR_materials_emissive_strength"))
+				{
+					properties.emissionIntensity.value = getFloat(*strength, "emissiveStrength", 1.0f);
+				}
+				if (const JsonValue* transmission = findMember(*extensions, "KHR_materials_transmission"))
+				{
+					properties.transmission.value = getFloat(*transmission, "transmissionFactor", 0.0f);
+					properties.transmission.path  = getTexturePath(findMember(*transmission, "transmissionTexture"));
+				}
+				if (const JsonValue* clearcoat = findMember(*extensions, "KHR_materials_clearcoat"))
+				{
+					properties.clearcoatAmount.value    = getFloat(*clearcoat, "clearcoatFactor", 0.0f);
+					properties.clearcoatAmount.path     = getTexturePath(findMember(*clearcoat, "clearcoatTexture"));
+					properties.clearcoatRoughness.value = getFloat(*clearcoat, "clearcoatRoughnessFactor", 0.0f);
+					properties.clearcoatRoughness.path  = getTexturePath(findMember(*clearcoat, "clearcoatRoughnessTexture"));
+					properties.clearcoatNormal.path     = getTexturePath(findMember(*clearcoat, "clearcoatNormalTexture"));
+				}
+				if (const JsonValue* sheen = findMember(*extensions, "KHR_materials_sheen"))
+				{
+					const std::vector<float> sheenColor = getFloats(*sheen, "sheenColorFactor", { 0.0f, 0.0f, 0.0f });
+					properties.sheenColor.value     = math::vec3f(sheenColor[0], sheenColor[1], sheenColor[2]);
+					properties.sheenColor.path      = getTexturePath(findMember(*sheen, "sheenColorTexture"));
+					properties.sheenRoughness.value = getFloat(*sheen, "sheenRoughnessFactor", 0.0f);
+					properties.sheenRoughness.path  = getTexturePath(findMember(*sheen, "sheenRoughnessTexture"));
+				}
+				if (const JsonValue* specular = findMember(*extensions, "KHR_materials_specular"))
+				{
+					properties.specular.value = getFloat(*specular, "specularFactor", 1.0f);
+					properties.specular.path  = getTexturePath(findMember(*specular, "specularTexture"));
+				}
+			}
+
+			if (getString(jsonMaterial, "alphaMode", "OPAQUE") == "BLEND")
+			{
+				properties.opacity.value = baseColor[3];
+				properties.opacity.path  = properties.diffuse.path;
+			}
+			return properties;
+		};
+
+		for (const JsonValue& jsonMaterial : jsonMaterials.GetArray())
+		{
+			scene.materials.push_back(describeMaterial(jsonMaterial));
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		/////////////////// Meshes ///////////////////////////////////////////////////////////
+		//////////////////////////////////////////////////////////////////////////////////////
+		constexpr unsigned       noMaterial = ~0u;
+		std::vector<std::vector<unsigned>> meshPrimitives;
+		for (const JsonValue& jsonMesh : jsonMeshes.GetArray())
+		{
+			meshPrimitives.emplace_back();
+			const JsonValue* jsonPrimitives = findArray(jsonMesh, "primitives");
+			if (jsonPrimitives == nullptr)
+			{
+				continue;
+			}
+			for (const JsonValue& jsonPrimitive : jsonPrimitives->GetArray())
+			{
+				Primitive primitive;
+				primitive.mode = (int)getInt(jsonPrimitive, "mode", GLTF_TRIANGLES);
+				if (findMember(jsonPrimitive, "extensions") != nullptr && findMember(*findMember(jsonPrimitive, "extensions"), "KHR_draco_mesh_compression") != nullptr)
+				{
+					VTX_INFO("glTF loader: draco compressed primitives are not supported natively");
+					return false;
+				}
+
+				const JsonValue* attributes = findMember(jsonPrimitive, "attributes");
+				if (attributes == nullptr || !parseAccessor(getInt(*attributes, "POSITION", -1), primitive.positions) ||
+					primitive.positions.componentType != GLTF_FLOAT || primitive.positions.numComponents != 3)
+				{
+					VTX_WARN("glTF loader: primitive without valid float positions in {}", filePath);
+					return false;
+				}
+				auto parseOptional = [&](const char* name, Accessor& accessor, const int numComponents) -> bool
+				{
+					const int64_t accessorId = getInt(*attributes, name, -1);
+					if (accessorId < 0)
+					{
+						return true;
+					}
+					if (!parseAccessor(accessorId, accessor) || accessor.numComponents != numComponents || accessor.count != primitive.positions.count)
+					{
+						return false;
+					}
+					return accessor.componentType == GLTF_FLOAT || (accessor.normalized && numComponents == 2);
+				};
+				if (!parseOptional("NORMAL", primitive.normals, 3) || !parseOptional("TANGENT", primitive.tangents, 4) || !parseOptional("TEXCOORD_0", primitive.texCoords, 2))
+				{
+					VTX_INFO("glTF loader: primitive attribute format not supported natively in {}", filePath);
+					return false;
+				}
+				const int64_t indicesId = getInt(jsonPrimitive, "indices", -1);
+				if (indicesId >= 0 && (!parseAccessor(indicesId, primitive.indices) || primitive.indices.numComponents != 1 ||
+					!(primitive.indices.componentType == GLTF_UNSIGNED_BYTE || primitive.indices.componentType == GLTF_UNSIGNED_SHORT || primitive.indices.componentType == GLTF_UNSIGNED_INT)))
+				{
+					VTX_WARN("glTF loader: primitive with invalid indices in {}", filePath);
+					return false;
+				}
+
+				const int64_t materialId = getInt(jsonPrimitive, "material", -1);
+				meshPrimitives.back().push_back((unsigned)primitives.size());
+				scene.meshMaterials.push_back({ (materialId >= 0 && materialId < (int64_t)scene.materials.size()) ? (unsigned)materialId : noMaterial });
+				primitives.push_back(primitive);
+			}
+		}
+
+		// As assimp, primitives without material use a default one appended after the file materials
+		if (std::find(scene.meshMaterials.begin(), scene.meshMaterials.end(), std::vector<unsigned>{ noMaterial }) != scene.meshMaterials.end())
+		{
+			AssimpMaterialProperties defaultMaterial;
+			defaultMaterial.name            = "DefaultMaterial";
+			defaultMaterial.diffuse.value   = math::vec3f(1.0f);
+			defaultMaterial.metallic.value  = 1.0f;
+			defaultMaterial.roughness.value = 1.0f;
+			defaultMaterial.emissionColor.value = math::vec3f(0.0f);
+			std::replace(scene.meshMaterials.begin(), scene.meshMaterials.end(), std::vector<unsigned>{ noMaterial }, std::vector<unsigned>{ (unsigned)scene.materials.size() });
+			scene.materials.push_back(defaultMaterial);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		/////////////////// Hierarchy ////////////////////////////////////////////////////////
+		//////////////////////////////////////////////////////////////////////////////////////
+		std::vector<bool> visitedNodes(jsonNodes.Size(), false);
+		bool              validHierarchy = true;
+		std::function<unsigned(int64_t)> describeNode = [&](const int64_t gltfNodeId) -> unsigned
+		{
+			const unsigned nodeId = (unsigned)scene.nodes.size();
+			scene.nodes.emplace_back();
+			if (gltfNodeId < 0 || gltfNodeId >= (int64_t)jsonNodes.Size() || visitedNodes[gltfNodeId])
+			{
+				validHierarchy = false;
+				return nodeId;
+			}
+			visitedNodes[gltfNodeId] = true;
+
+			const JsonValue&  jsonNode  = jsonNodes[(unsigned)gltfNodeId];
+			const aiMatrix4x4 matrix    = getNodeMatrix(jsonNode);
+			scene.nodes[nodeId].transform = convertAssimpMatrix(matrix, swap);
+
+			const int64_t meshId = getInt(jsonNode, "mesh", -1);
+			if (meshId >= 0 && meshId < (int64_t)meshPrimitives.size())
+			{
+				scene.nodes[nodeId].meshes = meshPrimitives[meshId];
+			}
+
+			const int64_t cameraId = getInt(jsonNode, "camera", -1);
+			if (cameraId >= 0 && cameraId < (int64_t)jsonCameras.Size())
+			{
+				const JsonValue& jsonCamera = jsonCameras[(unsigned)cameraId];
+				if (const JsonValue* perspective = findMember(jsonCamera, "perspective"))
+				{
+					const float yFov        = getFloat(*perspective, "yfov", 0.8f);
+					const float aspectRatio = getFloat(*perspective, "aspectRatio", 0.0f);
+					const float xFov        = aspectRatio > 0.0f ? 2.0f * std::atan(aspectRatio * std::tan(yFov * 0.5f)) : yFov;
+					ImportedCamera camera;
+					camera.transform = scene.nodes[nodeId].transform;
+					camera.fovY      = xFov * 180.0f / M_PI;
+					scene.cameras.push_back(camera);
+				}
+			}
+
+			if (const JsonValue* children = findArray(jsonNode, "children"))
+			{
+				for (const JsonValue& child : children->GetArray())
+				{
+					const unsigned childId = describeNode(child.IsInt64() ? child.GetInt64() : -1);
+					scene.nodes[nodeId].children.push_back(childId);
+				}
+			}
+			return nodeId;
+		};
+
+		const int64_t sceneId = getInt(document, "scene", 0);
+		const JsonValue* rootNodes = (sceneId >= 0 && sceneId < (int64_t)jsonScenes.Size()) ? findArray(jsonScenes[(unsigned)sceneId], "nodes") : nullptr;
+		if (rootNodes != nullptr && rootNodes->Size() == 1)
+		{
+			describeNode((*rootNodes)[0].IsInt64() ? (*rootNodes)[0].GetInt64() : -1);
+		}
+		else
+		{
+			scene.nodes.emplace_back();
+			scene.nodes[0].transform = math::affine3f(math::Identity);
+			if (rootNodes != nullptr)
+			{
+				for (const JsonValue& rootNode : rootNodes->GetArray())
+				{
+					const unsigned childId = describeNode(rootNode.IsInt64() ? rootNode.GetInt64() : -1);
+					scene.nodes[0].children.push_back(childId);
+				}
+			}
+		}
+		if (!validHierarchy)
+		{
+			VTX_WARN("glTF loader: invalid node hierarchy in {}", filePath);
+			return false;
+		}
+
+		VTX_INFO("glTF loader: {} parsed in {} ms ({} primitives, {} materials, {} nodes)",
+				 filePath, timer.elapsedMillis(), primitives.size(), scene.materials.size(), scene.nodes.size());
+		return true;
+	}
+
+	const ImportedScene& GltfLoader::getScene() const
+	{
+		return scene;
+	}
+
+	// Accessors decoded by one task of fillMeshes. The vertex tasks write disjoint members of the vertices, the vertex array
+	// is sized beforehand.
+	enum AccessorTask
+	{
+		AT_POSITIONS,
+		AT_NORMALS, // Normals and tangents, the bitangent needs both
+		AT_TEXCOORDS,
+		AT_INDICES
+	};
+
+	static void decodePositions(const GltfLoader::Primitive& primitive, graph::Mesh& mesh, const SwapType swap)
+	{
+		for (size_t i = 0; i < mesh.vertices.size(); ++i)
+		{
+			mesh.vertices[i].position = swapVector(readVec3(primitive.positions, i), swap);
+		}
+	}
+
+	static void decodeNormals(const GltfLoader::Primitive& primitive, graph::Mesh& mesh, const SwapType swap)
+	{
+		for (size_t i = 0; i < mesh.vertices.size(); ++i)
+		{
+			graph::VertexAttributes& vertex = mesh.vertices[i];
+			const math::vec3f        normal = readVec3(primitive.normals, i);
+			vertex.normal = swapVector(normal, swap);
+			if (primitive.tangents.data != nullptr)
+			{
+				// The bitangent is computed in the file frame, before the swap which is a reflection
+				const math::vec3f tangent    = readVec3(primitive.tangents, i);
+				const float       handedness = readComponent(primitive.tangents, i, 3);
+				vertex.tangent   = swapVector(tangent, swap);
+				vertex.bitangent = swapVector(cross(normal, tangent) * handedness, swap);
+			}
+		}
+	}
+
+	static void decodeTexCoords(const GltfLoader::Primitive& primitive, graph::Mesh& mesh)
+	{
+		for (size_t i = 0; i < mesh.vertices.size(); ++i)
+		{
+			// glTF uvs have the origin on the top left corner, flipped as assimp does
+			mesh.vertices[i].texCoord = math::vec3f(readComponent(primitive.texCoords, i, 0), 1.0f - readComponent(primitive.texCoords, i, 1), 0.0f);
+		}
+	}
+
+	static void decodeIndices(const GltfLoader::Primitive& primitive, graph::Mesh& mesh, const SwapType swap)
+	{
+		const size_t numVertices = primitive.positions.count;
+		const size_t numElements = primitive.indices.data != nullptr ? primitive.indices.count : numVertices;
+		auto getIndex = [&primitive](const size_t element) -> vtxID
+		{
+			return primitive.indices.data != nullptr ? readIndex(primitive.indices, element) : (vtxID)element;
+		};
+
+		size_t numTriangles = 0;
+		switch (primitive.mode)
+		{
+		case GLTF_TRIANGLES: numTriangles = numElements / 3; break;
+		case GLTF_TRIANGLE_STRIP:
+		case GLTF_TRIANGLE_FAN: numTriangles = numElements >= 3 ? numElements - 2 : 0; break;
+		default:
+			VTX_WARN("Mesh {}: primitive mode {} is not made of triangles and will be skipped.", mesh.getUID(), primitive.mode);
+			break;
+		}
+
+		const unsigned int second = (swap == SwapType::yToZ) ? 2 : 1;
+		const unsigned int third  = (swap == SwapType::yToZ) ? 1 : 2;
+		mesh.indices.resize(numTriangles * 3);
+		mesh.faceAttributes.resize(numTriangles);
+		size_t numValidTriangles = 0;
+		for (size_t t = 0; t < numTriangles; ++t)
+		{
+			vtxID triangle[3];
+			if (primitive.mode == GLTF_TRIANGLES)
+			{
+				triangle[0] = getIndex(t * 3);
+				triangle[1] = getIndex(t * 3 + 1);
+				triangle[2] = getIndex(t * 3 + 2);
+			}
+			else if (primitive.mode == GLTF_TRIANGLE_STRIP)
+			{
+				const bool odd = (t % 2) == 1;
+				triangle[0] = getIndex(t);
+				triangle[1] = getIndex(odd ? t + 2 : t + 1);
+				triangle[2] = getIndex(odd ? t + 1 : t + 2);
+			}
+			else
+			{
+				triangle[0] = getIndex(0);
+				triangle[1] = getIndex(t + 1);
+				triangle[2] = getIndex(t + 2);
+			}
+			if (triangle[0] >= numVertices || triangle[1] >= numVertices || triangle[2] >= numVertices)
+			{
+				continue;
+			}
+			vtxID* triangleIndices = mesh.indices.data() + numValidTriangles * 3;
+			triangleIndices[0] = triangle[0];
+			triangleIndices[1] = triangle[second];
+			triangleIndices[2] = triangle[third];
+			mesh.faceAttributes[numValidTriangles].materialSlotId = 0;
+			++numValidTriangles;
+		}
+		if (numValidTriangles != numTriangles)
+		{
+			VTX_WARN("Mesh {}: {} triangles reference vertices out of range and have been skipped.", mesh.getUID(), numTriangles - numValidTriangles);
+			mesh.indices.resize(numValidTriangles * 3);
+			mesh.faceAttributes.resize(numValidTriangles);
+		}
+	}
+
+	void GltfLoader::fillMeshes(const std::vector<std::shared_ptr<graph::Mesh>>& meshNodes) const
+	{
+		Timer timer;
+
+		// Every accessor of every primitive is a task, a single large primitive is not decoded by one thread
+		std::vector<std::pair<size_t, AccessorTask>> tasks;
+		for (size_t i = 0; i < meshNodes.size(); ++i)
+		{
+			if (meshNodes[i] == nullptr)
+			{
+				continue;
+			}
+			const Primitive& primitive = primitives[i];
+			graph::Mesh&     mesh      = *meshNodes[i];
+			mesh.vertices.resize(primitive.positions.count);
+			mesh.status.hasNormals        = primitive.normals.data != nullptr;
+			mesh.status.hasTangents       = mesh.status.hasNormals && primitive.tangents.data != nullptr;
+
+			tasks.emplace_back(i, AT_POSITIONS);
+			if (primitive.normals.data != nullptr)
+			{
+				tasks.emplace_back(i, AT_NORMALS);
+			}
+			if (primitive.texCoords.data != nullptr)
+			{
+				tasks.emplace_back(i, AT_TEXCOORDS);
+			}
+			tasks.emplace_back(i, AT_INDICES);
+		}
+		utl::parallelFor(tasks.size(), [&](const size_t t)
+		{
+			const auto& [i, task] = tasks[t];
+			switch (task)
+			{
+			case AT_POSITIONS: decodePositions(primitives[i], *meshNodes[i], swap); break;
+			case AT_NORMALS: decodeNormals(primitives[i], *meshNodes[i], swap); break;
+			case AT_TEXCOORDS: decodeTexCoords(primitives[i], *meshNodes[i]); break;
+			case AT_INDICES: decodeIndices(primitives[i], *meshNodes[i], swap); break;
+			}
+		});
+
+		utl::parallelFor(meshNodes.size(), [&](const size_t i)
+		{
+			if (meshNodes[i] == nullptr)
+			{
+				return;
+			}
+			// decodeIndices writes the material slot of every triangle it keeps
+			meshNodes[i]->status.hasFaceAttributes = meshNodes[i]->faceAttributes.size() * 3 == meshNodes[i]->indices.size();
+			if (meshNodes[i]->status.hasNormals && !meshNodes[i]->status.hasTangents)
+			{
+				// Assimp would generate them with aiProcess_CalcTangentSpace, the file normals are kept
+				ops::computeVertexTangentSpace(meshNodes[i], true);
+			}
+		});
+		VTX_INFO("glTF loader: {} meshes decoded in {} ms", meshNodes.size(), timer.elapsedMillis());
+	}
+
+	static void logImportStatistics(const char* loaderName, const float milliseconds, const std::vector<std::shared_ptr<graph::Mesh>>& meshNodes)
+	{
+		size_t numVertices  = 0;
+		size_t numTriangles = 0;
+		for (const std::shared_ptr<graph::Mesh>& mesh : meshNodes)
+		{
+			if (mesh != nullptr)
+			{
+				numVertices += mesh->vertices.size();
+				numTriangles += mesh->indices.size() / 3;
+			}
+		}
+		VTX_INFO("glTF benchmark: {} took {} ms, {} meshes, {} vertices, {} triangles", loaderName, milliseconds, meshNodes.size(), numVertices, numTriangles);
+	}
+
+	void benchmarkGltfImport(const std::string& filePath)
+	{
+		const std::string absoluteFilePath = utl::absolutePath(filePath);
+		VTX_INFO("glTF benchmark: {}", absoluteFilePath);
+		{
+			Timer                                     timer;
+			std::vector<std::shared_ptr<graph::Mesh>> meshNodes;
+			GltfLoader                                loader;
+			if (loader.open(absoluteFilePath, SwapType::yToZ))
+			{
+				auto sceneGraph = buildSceneGraph(loader.getScene(), meshNodes);
+				loader.fillMeshes(meshNodes);
+				logImportStatistics("native loader", timer.elapsedMillis(), meshNodes);
+			}
+			else
+			{
+				VTX_WARN("glTF benchmark: the native loader can't import {}", absoluteFilePath);
+			}
+		}
+		{
+			Timer                                     timer;
+			std::vector<std::shared_ptr<graph::Mesh>> meshNodes;
+			ImportedScene                             description;
+			auto sceneGraph = importWithAssimp(absoluteFilePath, SwapType::yToZ, description, meshNodes);
+			logImportStatistics("assimp", timer.elapsedMillis(), meshNodes);
+		}
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "ModelLoader.h"
+
+namespace vtx::importer
+{
+	// Native reader for glTF 2.0 files (.gltf and .glb).
+	// Buffers are memory mapped and accessors are decoded straight into the mesh nodes, the scene is described with the same
+	// ImportedScene used for the assimp path, so the resulting graph is built by the same code.
+	class GltfLoader
+	{
+	public:
+		// Parses the json, maps the buffers and describes the scene. Returns false if the file can't be read or uses features
+		// which are not supported natively (e.g. compressed or sparse geometry), in which case the caller falls back to assimp.
+		bool open(const std::string& filePath, SwapType swap);
+
+		const ImportedScene& getScene() const;
+
+		// Decodes the primitives into the mesh nodes created from the scene description, in parallel
+		void fillMeshes(const std::vector<std::shared_ptr<graph::Mesh>>& meshNodes) const;
+
+		struct Accessor
+		{
+			const unsigned char* data          = nullptr;
+			size_t               count         = 0;
+			size_t               stride        = 0;
+			int                  componentType = 0;
+			int                  numComponents = 0;
+			bool                 normalized    = false;
+		};
+
+		// Each glTF primitive becomes a mesh, as assimp does
+		struct Primitive
+		{
+			int      mode = 4;
+			Accessor positions;
+			Accessor normals;
+			Accessor tangents;
+			Accessor texCoords;
+			Accessor indices;
+		};
+
+	private:
+		std::vector<std::unique_ptr<utl::MappedFile>> mappedFiles;
+		std::vector<std::vector<unsigned char>>       decodedBuffers;
+		std::vector<Primitive>                        primitives;
+		ImportedScene                                 scene;
+		SwapType                                      swap = SwapType::None;
+	};
+
+	// Imports the file with both the native loader and assimp and logs the timings and the resulting geometry sizes
+	void benchmarkGltfImport(const std::string& filePath);
+}
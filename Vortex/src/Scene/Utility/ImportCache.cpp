@@ -0,0 +1,348 @@
+#include "ImportCache.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <cereal/archives/binary.hpp>
+#include "Core/Hashing.h"
+#include "Core/Options.h"
+#include "Core/ThreadPool.h"
+#include "Core/Timer.h"
+#include "Scene/Nodes/Mesh.h"
+#include "Serialization/ArchiveFunctions.h"
+
+namespace cereal
+{
+	template<class Archive, typename T>
+	void serialize(Archive& archive, vtx::importer::TextureAndValue<T>& data)
+	{
+		archive(nvp(data, path), nvp(data, value));
+	}
+
+	template<class Archive>
+	void serialize(Archive& archive, vtx::importer::AssimpMaterialProperties& data)
+	{
+		archive(nvp(data, diffuse), nvp(data, ambientOcclusion), nvp(data, roughness), nvp(data, specular), nvp(data, metallic),
+				nvp(data, normal), nvp(data, bump), nvp(data, emissionColor), nvp(data, emissionIntensity), nvp(data, clearcoatAmount),
+				nvp(data, clearcoatRoughness), nvp(data, clearcoatNormal), nvp(data, transmission), nvp(data, sheenColor),
+				nvp(data, sheenRoughness), nvp(data, anisotropy), nvp(data, name), nvp(data, ORM), nvp(data, opacity));
+	}
+
+	template<class Archive>
+	void serialize(Archive& archive, vtx::importer::ImportedNode& data)
+	{
+		archive(nvp(data, transform), nvp(data, children), nvp(data, meshes));
+	}
+
+	template<class Archive>
+	void serialize(Archive& archive, vtx::importer::ImportedCamera& data)
+	{
+		archive(nvp(data, transform), nvp(data, fovY));
+	}
+
+	template<class Archive>
+	void serialize(Archive& archive, vtx::importer::ImportedScene& data)
+	{
+		archive(nvp(data, materials), nvp(data, meshMaterials), nvp(data, nodes), nvp(data, cameras));
+	}
+}
+
+namespace vtx::importer
+{
+	static constexpr char     cacheMagic[8] = { 'V', 'T', 'X', 'I', 'C', 'A', 'C', 'H' };
+	static constexpr uint64_t cacheAlignment = 64;
+
+	static uint64_t alignOffset(const uint64_t offset)
+	{
+		return (offset + cacheAlignment - 1) & ~(cacheAlignment - 1);
+	}
+
+	// Every index of the description is used as is by buildSceneGraph. Each node has at most one parent and the root
+	// none, so the hierarchy reached from the root can't loop.
+	static bool isSceneValid(const ImportedScene& scene)
+	{
+		for (const std::vector<unsigned>& slots : scene.meshMaterials)
+		{
+			for (const unsigned materialId : slots)
+			{
+				if (materialId >= scene.materials.size())
+				{
+					return false;
+				}
+			}
+		}
+		std::vector<char> hasParent(scene.nodes.size(), 0);
+		for (const ImportedNode& node : scene.nodes)
+		{
+			for (const unsigned childId : node.children)
+			{
+				if (childId == 0 || childId >= scene.nodes.size() || hasParent[childId])
+				{
+					return false;
+				}
+				hasParent[childId] = 1;
+			}
+			for (const unsigned meshId : node.meshes)
+			{
+				if (meshId >= scene.meshMaterials.size())
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	// Triangle indices within the vertices and face material slots within the slots of the mesh. A mesh without slots
+	// only uses slot 0.
+	static bool isMeshDataValid(const char* data, const ImportCache::MeshEntry& entry, const size_t numSlots)
+	{
+		if (entry.numIndices % 3 != 0 || (entry.numFaces != 0 && entry.numFaces != entry.numIndices / 3))
+		{
+			return false;
+		}
+		const auto* indices = reinterpret_cast<const vtxID*>(data + entry.indicesOffset);
+		for (uint64_t i = 0; i < entry.numIndices; ++i)
+		{
+			if (indices[i] >= entry.numVertices)
+			{
+				return false;
+			}
+		}
+		const auto* faces = reinterpret_cast<const graph::FaceAttributes*>(data + entry.facesOffset);
+		for (uint64_t i = 0; i < entry.numFaces; ++i)
+		{
+			if (faces[i].materialSlotId >= std::max<size_t>(numSlots, 1))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	uint64_t ImportCache::computeKey(const std::string& filePath, const uint64_t settingsHash)
+	{
+		Timer          timer;
+		const uint64_t fileHash = utl::hashFile(filePath);
+		if (fileHash == 0)
+		{
+			return 0;
+		}
+
+		uint64_t key = utl::hashValue(version);
+		key          = utl::hashCombine(key, fileHash);
+		key          = utl::hashCombine(key, utl::hashString(utl::getFolder(filePath)));
+		key          = utl::hashCombine(key, settingsHash);
+		key          = utl::hashCombine(key, utl::hashValue(sizeof(graph::VertexAttributes)));
+		VTX_INFO("Import cache key {:016x} computed in {} ms", key, timer.elapsedMillis());
+		return key;
+	}
+
+	std::string ImportCache::getCachePath(const uint64_t key)
+	{
+		std::stringstream ss;
+		ss << std::hex << key;
+		return getOptions()->importCacheFolder + ss.str() + ".vtxcache";
+	}
+
+	bool ImportCache::write(const uint64_t key, const ImportedScene& scene, const std::vector<std::shared_ptr<graph::Mesh>>& meshNodes)
+	{
+		Timer timer;
+
+		std::stringstream sceneStream;
+		{
+			cereal::BinaryOutputArchive archive(sceneStream);
+			archive(scene);
+		}
+		const std::string sceneBlob = sceneStream.str();
+
+		Header header{};
+		std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+		header.version     = version;
+		header.vertexSize  = sizeof(graph::VertexAttributes);
+		header.key         = key;
+		header.numMeshes   = meshNodes.size();
+		header.sceneOffset = sizeof(Header) + meshNodes.size() * sizeof(MeshEntry);
+		header.sceneSize   = sceneBlob.size();
+
+		// Layout all the arrays first, the file is then written sequentially
+		std::vector<MeshEntry> entries(meshNodes.size());
+		uint64_t               offset = header.sceneOffset + header.sceneSize;
+		for (size_t i = 0; i < meshNodes.size(); ++i)
+		{
+			MeshEntry& entry = entries[i];
+			entry            = {};
+			const std::shared_ptr<graph::Mesh>& mesh = meshNodes[i];
+			if (mesh == nullptr)
+			{
+				continue;
+			}
+			entry.numVertices       = mesh->vertices.size();
+			entry.numIndices        = mesh->indices.size();
+			entry.numFaces          = mesh->faceAttributes.size();
+			entry.hasTangents       = mesh->status.hasTangents;
+			entry.hasNormals        = mesh->status.hasNormals;
+			entry.hasFaceAttributes = mesh->status.hasFaceAttributes;
+
+			entry.verticesOffset = alignOffset(offset);
+			offset               = entry.verticesOffset + entry.numVertices * sizeof(graph::VertexAttributes);
+			entry.indicesOffset  = alignOffset(offset);
+			offset               = entry.indicesOffset + entry.numIndices * sizeof(vtxID);
+			entry.facesOffset    = alignOffset(offset);
+			offset               = entry.facesOffset + entry.numFaces * sizeof(graph::FaceAttributes);
+		}
+
+		const std::string cachePath = getCachePath(key);
+		const bool        isWritten = utl::writeFileAtomically(cachePath, [&](std::ofstream& outFile)
+		{
+			uint64_t written = 0;
+			auto writeAt = [&outFile, &written](const uint64_t position, const void* data, const uint64_t size)
+			{
+				static constexpr char zeros[cacheAlignment] = {};
+				outFile.write(zeros, (std::streamsize)(position - written));
+				outFile.write(static_cast<const char*>(data), (std::streamsize)size);
+				written = position + size;
+			};
+
+			writeAt(0, &header, sizeof(Header));
+			writeAt(written, entries.data(), entries.size() * sizeof(MeshEntry));
+			writeAt(written, sceneBlob.data(), sceneBlob.size());
+			for (size_t i = 0; i < meshNodes.size(); ++i)
+			{
+				if (meshNodes[i] == nullptr)
+				{
+					continue;
+				}
+				const MeshEntry& entry = entries[i];
+				writeAt(entry.verticesOffset, meshNodes[i]->vertices.data(), entry.numVertices * sizeof(graph::VertexAttributes));
+				writeAt(entry.indicesOffset, meshNodes[i]->indices.data(), entry.numIndices * sizeof(vtxID));
+				writeAt(entry.facesOffset, meshNodes[i]->faceAttributes.data(), entry.numFaces * sizeof(graph::FaceAttributes));
+			}
+		});
+		if (!isWritten)
+		{
+			return false;
+		}
+
+		VTX_INFO("Import cache written to {} ({} MB) in {} ms", cachePath, offset / (1024 * 1024), timer.elapsedMillis());
+		return true;
+	}
+
+	bool ImportCache::open(const uint64_t key)
+	{
+		const std::string cachePath = getCachePath(key);
+		if (!std::filesystem::exists(cachePath) || !file.open(cachePath))
+		{
+			return false;
+		}
+
+		const auto*  data = static_cast<const char*>(file.getData());
+		const size_t size = file.getSize();
+
+		const auto* header = reinterpret_cast<const Header*>(data);
+		if (size < sizeof(Header) ||
+			std::memcmp(header->magic, cacheMagic, sizeof(cacheMagic)) != 0 ||
+			header->version != version ||
+			header->vertexSize != sizeof(graph::VertexAttributes) ||
+			header->key != key ||
+			!file.containsRange(sizeof(Header), header->numMeshes, sizeof(MeshEntry)) ||
+			header->sceneOffset != sizeof(Header) + header->numMeshes * sizeof(MeshEntry) ||
+			!file.containsRange(header->sceneOffset, header->sceneSize, 1))
+		{
+			VTX_WARN("Import cache: {} is not valid, ignoring it", cachePath);
+			file.close();
+			return false;
+		}
+
+		meshEntries = reinterpret_cast<const MeshEntry*>(data + sizeof(Header));
+		for (uint64_t i = 0; i < header->numMeshes; ++i)
+		{
+			const MeshEntry& entry = meshEntries[i];
+			if (!file.containsRange(entry.verticesOffset, entry.numVertices, sizeof(graph::VertexAttributes)) ||
+				!file.containsRange(entry.indicesOffset, entry.numIndices, sizeof(vtxID)) ||
+				!file.containsRange(entry.facesOffset, entry.numFaces, sizeof(graph::FaceAttributes)))
+			{
+				VTX_WARN("Import cache: {} is truncated, ignoring it", cachePath);
+				file.close();
+				meshEntries = nullptr;
+				return false;
+			}
+		}
+
+		try
+		{
+			std::istringstream          sceneStream(std::string(data + header->sceneOffset, header->sceneSize));
+			cereal::BinaryInputArchive archive(sceneStream);
+			archive(scene);
+		}
+		catch (const std::exception& e)
+		{
+			VTX_WARN("Import cache: failed to read scene description from {}: {}", cachePath, e.what());
+			file.close();
+			meshEntries = nullptr;
+			return false;
+		}
+
+		if (scene.nodes.empty() || scene.meshMaterials.size() != header->numMeshes || !isSceneValid(scene))
+		{
+			VTX_WARN("Import cache: {} has an inconsistent scene description, ignoring it", cachePath);
+			file.close();
+			meshEntries = nullptr;
+			return false;
+		}
+
+		std::atomic<bool> isValid{ true };
+		utl::parallelFor(header->numMeshes, [&](const size_t i)
+		{
+			if (isValid.load(std::memory_order_relaxed) && !isMeshDataValid(data, meshEntries[i], scene.meshMaterials[i].size()))
+			{
+				isValid.store(false, std::memory_order_relaxed);
+			}
+		});
+		if (!isValid.load())
+		{
+			VTX_WARN("Import cache: {} has mesh indices out of range, ignoring it", cachePath);
+			file.close();
+			meshEntries = nullptr;
+			scene       = {};
+			return false;
+		}
+
+		return true;
+	}
+
+	const ImportedScene& ImportCache::getScene() const
+	{
+		return scene;
+	}
+
+	void ImportCache::fillMeshes(const std::vector<std::shared_ptr<graph::Mesh>>& meshNodes) const
+	{
+		VTX_ASSERT_RETURN(meshEntries != nullptr, "Import cache: fillMeshes() called on a cache which is not open");
+		Timer timer;
+
+		const auto* data = static_cast<const char*>(file.getData());
+		utl::parallelFor(meshNodes.size(), [&](const size_t i)
+		{
+			const std::shared_ptr<graph::Mesh>& mesh = meshNodes[i];
+			if (mesh == nullptr)
+			{
+				return;
+			}
+			const MeshEntry& entry = meshEntries[i];
+
+			mesh->vertices.resize(entry.numVertices);
+			mesh->indices.resize(entry.numIndices);
+			mesh->faceAttributes.resize(entry.numFaces);
+			std::memcpy(mesh->vertices.data(), data + entry.verticesOffset, entry.numVertices * sizeof(graph::VertexAttributes));
+			std::memcpy(mesh->indices.data(), data + entry.indicesOffset, entry.numIndices * sizeof(vtxID));
+			std::memcpy(mesh->faceAttributes.data(), data + entry.facesOffset, entry.numFaces * sizeof(graph::FaceAttributes));
+
+			mesh->status.hasTangents       = entry.hasTangents != 0;
+			mesh->status.hasNormals        = entry.hasNormals != 0;
+			mesh->status.hasFaceAttributes = entry.hasFaceAttributes != 0;
+		});
+		VTX_INFO("Import cache: {} meshes filled in {} ms", meshNodes.size(), timer.elapsedMillis());
+	}
+}
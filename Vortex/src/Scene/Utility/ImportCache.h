@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ModelLoader.h"
+
+namespace vtx::importer
+{
+	// Content addressed on-disk cache of imported scenes.
+	// A cache file holds the scene description (materials, hierarchy, cameras) and the converted mesh arrays,
+	// the arrays are stored 64 bytes aligned so that the file can be memory mapped and copied straight into the mesh nodes.
+	class ImportCache
+	{
+	public:
+		static constexpr uint32_t version = 2;
+
+		// Key of the cached import, it depends on the content of the source file, on its folder (texture paths are
+		// resolved against it) and on the hash of every setting that changes the import result. Returns 0 if the file can't be read.
+		static uint64_t computeKey(const std::string& filePath, uint64_t settingsHash);
+
+		static std::string getCachePath(uint64_t key);
+
+		static bool write(uint64_t key, const ImportedScene& scene, const std::vector<std::shared_ptr<graph::Mesh>>& meshNodes);
+
+		// Maps the cache file for the key, returns false if the file is missing or not valid. Every index of the scene
+		// description and of the mesh arrays is checked against the size of what it indexes, the caller imports the source
+		// file instead of an invalid cache.
+		bool open(uint64_t key);
+
+		const ImportedScene& getScene() const;
+
+		// Fills the mesh nodes created from the cached scene description, meshes are copied in parallel
+		void fillMeshes(const std::vector<std::shared_ptr<graph::Mesh>>& meshNodes) const;
+
+		struct Header
+		{
+			char     magic[8];
+			uint32_t version;
+			uint32_t vertexSize;
+			uint64_t key;
+			uint64_t numMeshes;
+			uint64_t sceneOffset;
+			uint64_t sceneSize;
+		};
+
+		struct MeshEntry
+		{
+			uint64_t verticesOffset;
+			uint64_t numVertices;
+			uint64_t indicesOffset;
+			uint64_t numIndices;
+			uint64_t facesOffset;
+			uint64_t numFaces;
+			uint32_t hasTangents;
+			uint32_t hasNormals;
+			uint32_t hasFaceAttributes;
+			uint32_t padding;
+		};
+
+	private:
+		utl::MappedFile  file;
+		ImportedScene    scene;
+		const MeshEntry* meshEntries = nullptr;
+	};
+}
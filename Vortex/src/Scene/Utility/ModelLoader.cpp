@@ -1,7 +1,19 @@
 ﻿#include "ModelLoader.h"
 
+#include <algorithm>
+#include <cctype>
+#include <unordered_map>
+
 #include "Scene/Nodes/Shader/mdl/ShaderNodes.h"
 #include "Scene/Graph.h"
+#include "Core/ThreadPool.h"
+#include "Core/Timer.h"
+#include "Core/Options.h"
+#include "ImportCache.h"
+#include "GltfLoader.h"
+#include "ObjLoader.h"
+#include "TexturePrefetcher.h"
+#include "Core/Hashing.h"
 #include "assimp/GltfMaterial.h"
 
 namespace vtx::importer
@@ -386,30 +398,110 @@ namespace vtx::importer
             opacity.path = opacity.path.empty() ? diffuse.path : opacity.path;
         }
 
+        // Decoding starts right away and overlaps with mesh conversion and MDL compilation
+        TexturePrefetcher::get()->prefetch(*this);
+    }
+
+    // Calls func on each pair of matching properties, the name is skipped since it doesn't change the compiled material
+    template<typename F>
+    void forEachMaterialProperty(const AssimpMaterialProperties& a, const AssimpMaterialProperties& b, F&& func)
+    {
+        func(a.diffuse, b.diffuse);
+        func(a.ambientOcclusion, b.ambientOcclusion);
+        func(a.roughness, b.roughness);
+        func(a.specular, b.specular);
+        func(a.metallic, b.metallic);
+        func(a.normal, b.normal);
+        func(a.bump, b.bump);
+        func(a.emissionColor, b.emissionColor);
+        func(a.emissionIntensity, b.emissionIntensity);
+        func(a.clearcoatAmount, b.clearcoatAmount);
+        func(a.clearcoatRoughness, b.clearcoatRoughness);
+        func(a.clearcoatNormal, b.clearcoatNormal);
+        func(a.transmission, b.transmission);
+        func(a.sheenColor, b.sheenColor);
+        func(a.sheenRoughness, b.sheenRoughness);
+        func(a.anisotropy, b.anisotropy);
+        func(a.ORM, b.ORM);
+        func(a.opacity, b.opacity);
+    }
+
+    uint64_t hashMaterialProperties(const AssimpMaterialProperties& properties)
+    {
+        uint64_t hash = 0;
+        forEachMaterialProperty(properties, properties, [&hash](const auto& property, const auto&)
+        {
+            hash = utl::hashCombine(hash, utl::hashString(property.path));
+            hash = utl::hashCombine(hash, utl::hashValue(property.value));
+        });
+        return hash;
+    }
+
+    bool isSameMaterial(const AssimpMaterialProperties& a, const AssimpMaterialProperties& b)
+    {
+        bool same = true;
+        forEachMaterialProperty(a, b, [&same](const auto& propertyA, const auto& propertyB)
+        {
+            same = same && propertyA.path == propertyB.path && propertyA.value == propertyB.value;
+        });
+        return same;
+    }
+
+    std::vector<size_t> findIdenticalMaterials(const std::vector<AssimpMaterialProperties>& materialProperties)
+    {
+        std::vector<size_t>                               firstIdentical(materialProperties.size());
+        std::unordered_map<uint64_t, std::vector<size_t>> uniqueMaterials;
+        for (size_t i = 0; i < materialProperties.size(); ++i)
+        {
+            std::vector<size_t>& candidates = uniqueMaterials[hashMaterialProperties(materialProperties[i])];
+            const auto           identical  = std::find_if(candidates.begin(), candidates.end(), [&](const size_t j) { return isSameMaterial(materialProperties[i], materialProperties[j]); });
+            if (identical != candidates.end())
+            {
+                firstIdentical[i] = *identical;
+                continue;
+            }
+            candidates.push_back(i);
+            firstIdentical[i] = i;
+        }
+        return firstIdentical;
     }
-    // Process materials in the aiScene
-    std::vector<std::shared_ptr<graph::Material>> processMaterials(const aiScene* scene, std::string scenePath)
+
+    std::vector<std::shared_ptr<graph::Material>> createMaterials(const std::vector<AssimpMaterialProperties>& materialProperties)
     {
         std::vector<std::shared_ptr<graph::Material>> materials;
+        materials.reserve(materialProperties.size());
 
-        for (unsigned int i = 0; i < scene->mNumMaterials; ++i)
+        for (const AssimpMaterialProperties& properties : materialProperties)
         {
-			const aiMaterial* aiMat = scene->mMaterials[i];
+            // Already requested for assimp imports, this covers the native loaders and the import cache
+            TexturePrefetcher::get()->prefetch(properties);
+        }
 
-            // Create a new material in your renderer and set its properties based on aiMat
-            auto material = ops::createNode<graph::Material>();
-            // Set material properties, e.g., diffuse color, specular color, textures, etc.
-            // ...
+        // Materials with identical parameters share a single node, so they are compiled and get shader binding table entries once
+        const bool                mergeMaterials     = getOptions()->mergeIdenticalMaterials;
+        const std::vector<size_t> firstIdentical     = mergeMaterials ? findIdenticalMaterials(materialProperties) : std::vector<size_t>();
+        size_t                    numUniqueMaterials = 0;
+        for (size_t i = 0; i < materialProperties.size(); ++i)
+        {
+            const AssimpMaterialProperties& properties = materialProperties[i];
+            if (mergeMaterials && firstIdentical[i] != i)
+            {
+                materials.push_back(materials[firstIdentical[i]]);
+                continue;
+            }
 
-            AssimpMaterialProperties properties;
-            properties.determineProperties(aiMat, scenePath);
+            auto material = ops::createNode<graph::Material>();
 			std::shared_ptr<graph::shader::PrincipledMaterial> principled = createPrincipledMaterial(properties);
-            // You can now use the extracted variables within the function
             material->materialGraph = principled;
             
             materials.push_back(material);
+            ++numUniqueMaterials;
         }
 
+        if (numUniqueMaterials != materialProperties.size())
+        {
+            VTX_INFO("{} imported materials merged into {} unique materials", materialProperties.size(), numUniqueMaterials);
+        }
         return materials;
     }
 
@@ -425,10 +517,9 @@ namespace vtx::importer
         }
 	}
 
-	std::shared_ptr<graph::Mesh> convertAssimpMeshToMeshNode(const aiMesh* aiMesh, SwapType swap)
-    {
+	void fillMeshNode(const aiMesh* aiMesh, const std::shared_ptr<graph::Mesh>& meshNode, const SwapType swap)
+	{
         // Process vertices
-        const auto meshNode = ops::createNode<graph::Mesh>();
         meshNode->vertices.resize(aiMesh->mNumVertices);
         meshNode->status.hasNormals = aiMesh->HasNormals();
         meshNode->status.hasTangents = aiMesh->HasTangentsAndBitangents();
@@ -439,6 +530,7 @@ namespace vtx::importer
             meshNode->status.hasNormals,
             meshNode->status.hasTangents
         );
+        const bool hasTexCoords = aiMesh->HasTextureCoords(0);
         for (unsigned int i = 0; i < aiMesh->mNumVertices; ++i)
         {
             auto& vertex = meshNode->vertices[i];
@@ -459,55 +551,72 @@ namespace vtx::importer
             }
 
             // Texture coordinates
-            if (aiMesh->HasTextureCoords(0))
+            if (hasTexCoords)
             {
                 vertex.texCoord = math::vec3f(aiMesh->mTextureCoords[0][i].x, aiMesh->mTextureCoords[0][i].y, 0.0f);
             }
         }
 
-        // Handle the winding order if yToZ is true
-        if (swap == SwapType::yToZ)
+        // Count triangles first so that index and face buffers are allocated once
+        size_t numTriangles = 0;
+        for (unsigned int i = 0; i < aiMesh->mNumFaces; ++i)
         {
-            for (unsigned int i = 0; i < aiMesh->mNumFaces; ++i)
+            if (aiMesh->mFaces[i].mNumIndices == 3)
             {
-                const aiFace& face = aiMesh->mFaces[i];
-                if (face.mNumIndices == 3)
-                {
-                    std::swap(face.mIndices[1], face.mIndices[2]);
-                }
+                ++numTriangles;
             }
         }
+        if (numTriangles != aiMesh->mNumFaces)
+        {
+            VTX_WARN("Mesh {}: {} faces are not triangles and will be skipped. Only triangles are supported.", meshNode->name, aiMesh->mNumFaces - numTriangles);
+        }
 
         // Process faces and indices
-        meshNode->faceAttributes.resize(aiMesh->mNumFaces);
+        // The winding order is flipped when yToZ is requested, the assimp faces are left untouched
+        const unsigned int second = (swap == SwapType::yToZ) ? 2 : 1;
+        const unsigned int third  = (swap == SwapType::yToZ) ? 1 : 2;
+        meshNode->indices.resize(numTriangles * 3);
+        meshNode->faceAttributes.resize(numTriangles);
+        size_t triangleId = 0;
         for (unsigned int i = 0; i < aiMesh->mNumFaces; ++i)
         {
             const aiFace& face = aiMesh->mFaces[i];
-
-            // Store indices for the face
-            if(face.mNumIndices != 3)
+            if (face.mNumIndices != 3)
             {
-	            std::cout << "Warning: face with " << face.mNumIndices << " indices found. Only triangles are supported." << std::endl;
-			}
-            else
-            {
-                for (unsigned int j = 0; j < face.mNumIndices; ++j)
-                {
-                    meshNode->indices.push_back(face.mIndices[j]);
-                }
-
-                // Set face attributes (you can update it later based on the material, if needed)
-                graph::FaceAttributes faceAttr;
-                faceAttr.materialSlotId = 0;
-                meshNode->faceAttributes[i] = faceAttr;
-	            
+                continue;
             }
-            
+            vtxID* triangleIndices = meshNode->indices.data() + triangleId * 3;
+            triangleIndices[0] = face.mIndices[0];
+            triangleIndices[1] = face.mIndices[second];
+            triangleIndices[2] = face.mIndices[third];
+
+            // Set face attributes (you can update it later based on the material, if needed)
+            meshNode->faceAttributes[triangleId].materialSlotId = 0;
+            ++triangleId;
         }
+	}
 
+	std::shared_ptr<graph::Mesh> convertAssimpMeshToMeshNode(const aiMesh* aiMesh, SwapType swap)
+    {
+        const auto meshNode = ops::createNode<graph::Mesh>();
+        fillMeshNode(aiMesh, meshNode, swap);
         return meshNode;
     }
 
+    void convertMeshes(const std::vector<MeshConversionJob>& conversionJobs)
+    {
+        VTX_INFO("Converting {} meshes on {} threads", conversionJobs.size(), ThreadPool::get()->getNumberOfWorkers());
+        Timer timer;
+        // Nodes have already been created and registered by the graph pass, here we only fill their buffers,
+        // every job writes to a different mesh so no synchronization is needed.
+        utl::parallelFor(conversionJobs.size(), [&conversionJobs](const size_t i)
+        {
+            const MeshConversionJob& job = conversionJobs[i];
+            fillMeshNode(job.aiMesh, job.meshNode, job.swap);
+        });
+        VTX_INFO("Mesh conversion took {} ms", timer.elapsedMillis());
+    }
+
     math::vec3f swapZY(const math::vec3f& vec)
     {
 	    return math::vec3f(vec.x, vec.z, vec.y);
@@ -545,51 +654,99 @@ namespace vtx::importer
         return matrix;
     }
 
-    std::shared_ptr<graph::Instance> processAssimpNode(aiMesh* node, const unsigned assimpMeshId, std::map<unsigned, vtxID>& meshMap, const std::vector<std::shared_ptr<graph::Material>>& importedMaterials, SwapType swap)
+    unsigned describeAssimpNode(const aiNode* node, ImportedScene& description, const SwapType swap)
     {
-        std::shared_ptr<graph::Mesh> meshNode = nullptr;
-        if (meshMap.find(assimpMeshId) != meshMap.end())
+        // Indices are used instead of references since the recursion grows the node vector
+        const unsigned nodeId = (unsigned)description.nodes.size();
+        description.nodes.emplace_back();
+        description.nodes[nodeId].transform = convertAssimpMatrix(node->mTransformation, swap);
+        description.nodes[nodeId].meshes.assign(node->mMeshes, node->mMeshes + node->mNumMeshes);
+
+        for (unsigned int i = 0; i < node->mNumChildren; ++i) {
+            const unsigned childId = describeAssimpNode(node->mChildren[i], description, swap);
+            description.nodes[nodeId].children.push_back(childId);
+        }
+        return nodeId;
+    }
+
+    ImportedScene describeAssimpScene(const aiScene* scene, const std::string& scenePath, const SwapType swap)
+    {
+        ImportedScene description;
+
+        description.materials.resize(scene->mNumMaterials);
+        for (unsigned int i = 0; i < scene->mNumMaterials; ++i)
         {
-            meshNode = graph::Scene::getSim()->getNode<graph::Mesh>(meshMap[assimpMeshId]);
+            description.materials[i].determineProperties(scene->mMaterials[i], scenePath);
         }
-        else
+
+        description.meshMaterials.resize(scene->mNumMeshes);
+        for (unsigned int i = 0; i < scene->mNumMeshes; ++i)
+        {
+            description.meshMaterials[i] = { scene->mMeshes[i]->mMaterialIndex };
+        }
+
+        describeAssimpNode(scene->mRootNode, description, swap);
+
+        for (unsigned int i = 0; i < scene->mNumCameras; ++i)
         {
-            meshNode = convertAssimpMeshToMeshNode(node, swap);
-            meshMap.insert({ assimpMeshId, meshNode->getUID() });
+            const aiCamera* cam = scene->mCameras[i];
+
+            // Position and direction are expressed in the local space of the node the camera is attached to.
+            const aiNode* node = scene->mRootNode->FindNode(cam->mName);
+            if (node == nullptr)
+            {
+                VTX_WARN("Camera {} is not attached to any node, skipping it", cam->mName.C_Str());
+                continue;
+            }
+
+            ImportedCamera camera;
+            camera.transform = convertAssimpMatrix(node->mTransformation, swap);
+            camera.fovY      = cam->mHorizontalFOV * 180.0f / M_PI;
+            description.cameras.push_back(camera);
         }
 
-        std::shared_ptr<graph::Instance> instanceNode = ops::createNode<graph::Instance>();
-        // Set the meshNode as a child of the instanceNode
-        instanceNode->setChild(meshNode);
-        instanceNode->addMaterial(importedMaterials[node->mMaterialIndex]);
-        return instanceNode;
+        return description;
     }
 
-    std::shared_ptr<graph::Node> processAssimpNode(const aiNode* node, const aiScene* scene, std::map<unsigned, vtxID>& meshMap, const std::vector<std::shared_ptr<graph::Material>>& importedMaterials, SwapType swap) {
+    std::shared_ptr<graph::Node> buildSceneNode(const ImportedScene& description, const unsigned nodeId, const std::vector<std::shared_ptr<graph::Material>>& materials, std::vector<std::shared_ptr<graph::Mesh>>& meshNodes)
+    {
+        const ImportedNode& importedNode = description.nodes[nodeId];
         std::vector<std::shared_ptr<graph::Node>> children;
 
         // Process node children
-        for (unsigned int i = 0; i < node->mNumChildren; ++i) {
-            children.push_back(processAssimpNode(node->mChildren[i], scene, meshMap, importedMaterials, swap));
+        for (const unsigned childId : importedNode.children) {
+            children.push_back(buildSceneNode(description, childId, materials, meshNodes));
         }
 
         // Process node meshes
-        for (unsigned int i = 0; i < node->mNumMeshes; ++i) {
-            aiMesh* aiMesh = scene->mMeshes[node->mMeshes[i]];
-            const std::shared_ptr<graph::Instance> instance = processAssimpNode(aiMesh, node->mMeshes[i], meshMap, importedMaterials, swap);
-            children.push_back(instance);
+        for (const unsigned meshId : importedNode.meshes) {
+            std::shared_ptr<graph::Mesh>& meshNode = meshNodes[meshId];
+            if (meshNode == nullptr)
+            {
+                // Only the node is created here, the data is filled afterwards by a parallel pass
+                meshNode = ops::createNode<graph::Mesh>();
+            }
+
+            std::shared_ptr<graph::Instance> instanceNode = ops::createNode<graph::Instance>();
+            // Set the meshNode as a child of the instanceNode
+            instanceNode->setChild(meshNode);
+            for (const unsigned materialId : description.meshMaterials[meshId])
+            {
+                instanceNode->addMaterial(materials[materialId]);
+            }
+            children.push_back(instanceNode);
         }
 
         // If there's only one child and it's a mesh, return the mesh's instance directly.
-        if (children.size() == 1 && dynamic_cast<graph::Instance*>(children[0].get())) {
+        if (children.size() == 1 && children[0]->getType() == graph::NT_INSTANCE) {
             std::shared_ptr<graph::Instance> instance = children[0]->as<graph::Instance>();
-            instance->transform->setAffine(convertAssimpMatrix(node->mTransformation, swap));
+            instance->transform->setAffine(importedNode.transform);
             return instance;
         }
         else {
             auto groupNode = ops::createNode<graph::Group>();
             // Process node transformation
-            groupNode->transform->setAffine(convertAssimpMatrix(node->mTransformation, swap));
+            groupNode->transform->setAffine(importedNode.transform);
             for (auto& child : children) {
                 groupNode->addChild(child);
             }
@@ -597,6 +754,42 @@ namespace vtx::importer
         }
     }
 
+    std::tuple<std::shared_ptr<graph::Group>, std::vector<std::shared_ptr<graph::Camera>>> buildSceneGraph(const ImportedScene& description, std::vector<std::shared_ptr<graph::Mesh>>& meshNodes)
+    {
+        VTX_INFO("Creating Scene Graph");
+        meshNodes.assign(description.meshMaterials.size(), nullptr);
+
+        const std::vector<std::shared_ptr<graph::Material>> materials  = createMaterials(description.materials);
+        std::shared_ptr<graph::Group>                       sceneGraph = nullptr;
+        const std::shared_ptr<graph::Node>                  root       = buildSceneNode(description, 0, materials, meshNodes);
+        if (root->as<graph::Instance>())
+        {
+	        // scene contains only one mesh, so we need to create a group to contain it
+            sceneGraph = ops::createNode<graph::Group>();
+            sceneGraph->addChild(root);
+        }
+        else
+        {
+	        sceneGraph = root->as<graph::Group>();
+        }
+
+        sceneGraph->name = "Scene Root Group";
+
+        std::vector<std::shared_ptr<graph::Camera>> cameras;
+        for (const ImportedCamera& importedCamera : description.cameras)
+        {
+            std::shared_ptr<graph::Camera> camera = ops::createNode<graph::Camera>();
+            camera->transform->setAffine(importedCamera.transform);
+            camera->transform->rotateAroundPoint(camera->transform->affineTransform.p, math::yAxis, M_PI_2);
+            camera->fovY = importedCamera.fovY;
+            camera->updateDirections();
+
+            cameras.push_back(camera);
+        }
+
+        return { sceneGraph, cameras };
+    }
+
     void processMetadata(const aiScene* scene, const std::string& fileFormat) {
         if (scene->mMetaData!=nullptr)
         { 
@@ -717,116 +910,146 @@ namespace vtx::importer
         }
     }
 
-    std::vector<std::shared_ptr<graph::Camera>> processCameras(const aiScene* scene, SwapType swap)
+    void instanceDuplicateMeshes(const std::shared_ptr<graph::Group>& sceneRoot)
     {
-        std::vector<std::shared_ptr<graph::Camera>> cameras;
-        for (unsigned int i = 0; i < scene->mNumCameras; ++i)
+        if (getOptions()->instanceDuplicateMeshes)
         {
-            const aiCamera* cam = scene->mCameras[i];
+            ops::instanceDuplicateMeshes(ops::collectInstances(sceneRoot), getOptions()->rigidMeshInstancing);
+        }
+    }
 
-            // Extract camera properties
-            float fov = cam->mHorizontalFOV;
-            float aspect = cam->mAspect;
-            float clipNear = cam->mClipPlaneNear;
-            float clipFar = cam->mClipPlaneFar;
-
-            // Position and direction are expressed in the local space of the node
-            // the camera is attached to. These will need to be transformed by the
-            // node's transform to get them into world space.
-            // Get the node that this camera is attached to
-            aiNode* node = scene->mRootNode->FindNode(cam->mName);
-
-            // Get the transformation of the node
-            //math::affine3f transform = convertAssimpMatrix(node->mTransformation, SwapType::None);
-            //math::affine3f rootM = convertAssimpMatrix(scene->mRootNode->mTransformation);
-            //math::affine3f finalTransform = rootM * transform;
-            // Transform the camera's local vectors into world space
-            //aiVector3D posAssimp = cam->mPosition;
-            //aiVector3D upAssimp = cam->mUp;
-            //aiVector3D lookAssimp = cam->mLookAt;
-            //
-            //math::vec3f pos (posAssimp.x, posAssimp.y, posAssimp.z);
-            //math::vec3f up = math::normalize({ upAssimp.x, upAssimp.y, upAssimp.z });
-            //math::vec3f lookAt = math::normalize({lookAssimp.x, lookAssimp.y, lookAssimp.z});
-            //math::vec3f horizzontal = math::normalize(cross(lookAt, up));
-            //
-            //math::vec3f wUp = math::transformVector3F(finalTransform, up);
-            //math::vec3f wLookAt = math::transformVector3F(finalTransform, lookAt);
-            //math::vec3f wHorizzontal = math::transformVector3F(finalTransform, horizzontal);
-        	//math::vec3f wPos = math::transformPoint3F(rootM, pos);
-
-
-			std::shared_ptr<graph::Camera> camera = ops::createNode<graph::Camera>();
-
-			//math::affine3f cameraTransform(wHorizzontal, wUp, -wLookAt, wPos);
-            const auto cameraTransform = convertAssimpMatrix(node->mTransformation, swap);
-            camera->transform->setAffine(convertAssimpMatrix(node->mTransformation, swap));
-            //camera->transform->rotateAroundPoint(camera->transform->affineTransform.p, math::zAxis, M_PI);
-            camera->transform->rotateAroundPoint(camera->transform->affineTransform.p, math::yAxis, M_PI_2);
-            camera->fovY = fov*180.0f/M_PI;
-            //camera->aspect = aspect;
-            camera->updateDirections();
+    static constexpr float    smoothingAngle = 30.0f;
+    static constexpr unsigned importFlags    = aiProcess_Triangulate |
+                                               //aiProcess_MakeLeftHanded |
+                                               //aiProcess_JoinIdenticalVertices |
+                                               aiProcess_SortByPType |
+                                               //aiProcess_GenNormals |
+                                               aiProcess_GenSmoothNormals |
+                                               aiProcess_CalcTangentSpace |
+                                               //aiProcess_CalcTangentSpace |
+                                               //aiProcess_RemoveComponent (remove colors) |
+                                               //aiProcess_LimitBoneWeights |
+                                               aiProcess_ImproveCacheLocality |
+                                               aiProcess_RemoveRedundantMaterials |
+                                               //aiProcess_GenUVCoords |
+                                               aiProcess_FindDegenerates |
+                                               aiProcess_FindInvalidData |
+                                               aiProcess_FindInstances |
+                                               aiTextureFlags_UseAlpha |
+                                               //aiProcess_ValidateDataStructure |
+                                               //aiProcess_OptimizeMeshes |
+                                               //aiProcess_OptimizeGraph |
+                                               //aiProcess_Debone |
+                                               0;
+
+    std::tuple<std::shared_ptr<graph::Group>, std::vector<std::shared_ptr<graph::Camera>>> importWithAssimp(const std::string& filePath, const SwapType swap, ImportedScene& description, std::vector<std::shared_ptr<graph::Mesh>>& meshNodes)
+    {
+        Assimp::Importer importer;
+        importer.SetPropertyFloat("PP_GSN_MAX_SMOOTHING_ANGLE", smoothingAngle);
+        const aiScene* scene = importer.ReadFile(filePath, importFlags);
+        const bool successCondition = (scene && !(scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) && scene->mRootNode);
+        VTX_ASSERT_CONTINUE(successCondition, "Assimp Importer Errror: {}", importer.GetErrorString());
 
-            cameras.push_back(camera);
+        processMetadata(scene, utl::getFileExtension(filePath));
+        description = describeAssimpScene(scene, utl::getFolder(filePath), swap);
+        auto result = buildSceneGraph(description, meshNodes);
+
+        std::vector<MeshConversionJob> conversionJobs;
+        conversionJobs.reserve(meshNodes.size());
+        for (unsigned int i = 0; i < meshNodes.size(); ++i)
+        {
+            if (meshNodes[i] != nullptr)
+            {
+                conversionJobs.push_back({ scene->mMeshes[i], meshNodes[i], swap });
+            }
         }
-        return cameras;
+        convertMeshes(conversionJobs);
+        return result;
     }
 
 #pragma optimize("", off)
     std::tuple<std::shared_ptr<graph::Group>, std::vector<std::shared_ptr<graph::Camera>>> importSceneFile(std::string filePath)
     {
-        filePath                     = utl::absolutePath(filePath);
-		const std::string fileFormat = utl::getFileExtension(filePath);
+        filePath                = utl::absolutePath(filePath);
+		std::string fileFormat  = utl::getFileExtension(filePath);
+        std::transform(fileFormat.begin(), fileFormat.end(), fileFormat.begin(), [](const unsigned char c) { return (char)std::tolower(c); });
+        constexpr SwapType swap = SwapType::yToZ;
         VTX_INFO("Loading scene file: {}", filePath);
-        Assimp::Importer importer;
-        importer.SetPropertyFloat("PP_GSN_MAX_SMOOTHING_ANGLE", 30);
-        const aiScene* scene = importer.ReadFile(filePath,
-                                                 aiProcess_Triangulate |
-                                                 //aiProcess_MakeLeftHanded |
-                                                 //aiProcess_JoinIdenticalVertices |
-                                                 aiProcess_SortByPType |
-												 //aiProcess_GenNormals |
-                                                 aiProcess_GenSmoothNormals |
-												 aiProcess_CalcTangentSpace |
-                                                 //aiProcess_CalcTangentSpace |
-                                                 //aiProcess_RemoveComponent (remove colors) |
-                                                 //aiProcess_LimitBoneWeights |
-                                                 aiProcess_ImproveCacheLocality |
-                                                 aiProcess_RemoveRedundantMaterials |
-                                                 //aiProcess_GenUVCoords |
-                                                 aiProcess_FindDegenerates |
-                                                 aiProcess_FindInvalidData |
-                                                 aiProcess_FindInstances |
-												 aiTextureFlags_UseAlpha |
-                                                 //aiProcess_ValidateDataStructure |
-                                                 //aiProcess_OptimizeMeshes |
-                                                 //aiProcess_OptimizeGraph |
-                                                 //aiProcess_Debone |
-                                                 0);
-        const bool successCondition = (scene && !(scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) && scene->mRootNode);
-        VTX_ASSERT_CONTINUE(successCondition, "Assimp Importer Errror: {}", importer.GetErrorString());
 
-        processMetadata(scene, fileFormat);
-        std::map<unsigned, vtxID> meshMap;
-        VTX_INFO("Creating Scene Graph");
-		const std::vector<std::shared_ptr<graph::Material>> importedMaterials = processMaterials(scene, utl::getFolder(filePath));
-        std::shared_ptr<graph::Group>                       sceneGraph        = nullptr;
-		const std::shared_ptr<graph::Node>                  root              = processAssimpNode(scene->mRootNode, scene, meshMap,importedMaterials, SwapType::yToZ);
-        if (root->as<graph::Instance>())
+        Timer timer;
+        std::vector<std::shared_ptr<graph::Mesh>> meshNodes;
+        const ops::WeldTolerances weldTolerances{ getOptions()->weldTolerance, getOptions()->weldNormalTolerance, getOptions()->weldTexCoordTolerance };
+        const bool  isWelding     = getOptions()->weldMeshesOnImport;
+        const bool  useNativeGltf = getOptions()->nativeGltfLoader && (fileFormat == "gltf" || fileFormat == "glb");
+        const bool  useNativeObj  = getOptions()->nativeObjLoader && fileFormat == "obj";
+
+        uint64_t cacheKey = 0;
+        if (getOptions()->enableImportCache)
         {
-	        // scene contains only one mesh, so we need to create a group to contain it
-            sceneGraph = ops::createNode<graph::Group>();
-            sceneGraph->addChild(root);
+            uint64_t settingsHash = utl::hashValue(importFlags);
+            settingsHash          = utl::hashCombine(settingsHash, utl::hashValue(smoothingAngle));
+            settingsHash          = utl::hashCombine(settingsHash, utl::hashValue(swap));
+            settingsHash          = utl::hashCombine(settingsHash, utl::hashValue(isWelding));
+            settingsHash          = utl::hashCombine(settingsHash, utl::hashValue(weldTolerances));
+            settingsHash          = utl::hashCombine(settingsHash, utl::hashValue(useNativeGltf));
+            settingsHash          = utl::hashCombine(settingsHash, utl::hashValue(useNativeObj));
+
+            cacheKey = ImportCache::computeKey(filePath, settingsHash);
+            ImportCache cache;
+            if (cacheKey != 0 && cache.open(cacheKey))
+            {
+                VTX_INFO("Import cache hit for {}", filePath);
+                auto result = buildSceneGraph(cache.getScene(), meshNodes);
+                cache.fillMeshes(meshNodes);
+                ops::reportVertexMemory(meshNodes);
+                instanceDuplicateMeshes(std::get<0>(result));
+                VTX_INFO("Scene loaded from import cache in {} ms", timer.elapsedMillis());
+                return result;
+            }
+        }
+
+        ImportedScene description;
+        std::tuple<std::shared_ptr<graph::Group>, std::vector<std::shared_ptr<graph::Camera>>> result;
+        GltfLoader gltfLoader;
+        ObjLoader  objLoader;
+        if (useNativeGltf && gltfLoader.open(filePath, swap))
+        {
+            description = gltfLoader.getScene();
+            result      = buildSceneGraph(description, meshNodes);
+            gltfLoader.fillMeshes(meshNodes);
+        }
+        else if (useNativeObj && objLoader.open(filePath, swap))
+        {
+            description = objLoader.getScene();
+            result      = buildSceneGraph(description, meshNodes);
+            objLoader.fillMeshes(meshNodes);
+            objLoader.logThroughput(filePath, timer.elapsedMillis());
         }
         else
         {
-	        sceneGraph = root->as<graph::Group>();
+            if (useNativeGltf || useNativeObj)
+            {
+                VTX_INFO("Falling back to assimp for {}", filePath);
+                meshNodes.clear();
+            }
+            result = importWithAssimp(filePath, swap, description, meshNodes);
         }
 
-        sceneGraph->name = "Scene Root Group";
+        if (isWelding)
+        {
+            ops::weldMeshes(meshNodes, weldTolerances);
+        }
 
-		std::vector<std::shared_ptr<graph::Camera>> cameras = processCameras(scene, SwapType::yToZ);
-        return { sceneGraph, cameras };
+        // The cache stores the meshes as imported, instancing only relinks the graph so it's redone on cache hits
+        if (cacheKey != 0)
+        {
+            ImportCache::write(cacheKey, description, meshNodes);
+        }
+        ops::reportVertexMemory(meshNodes);
+        instanceDuplicateMeshes(std::get<0>(result));
+        VTX_INFO("Scene imported in {} ms", timer.elapsedMillis());
+
+        return result;
     }
 #pragma optimize("", on)
 
@@ -61,16 +61,64 @@ namespace vtx::importer
 		void determineProperties(const aiMaterial* material, std::string scenePath);
     };
 
-    // Process materials in the aiScene
-	std::vector<std::shared_ptr<graph::Material>> processMaterials(const aiScene* scene, std::string scenePath);
+    // Format agnostic description of an imported scene, the scene graph is built from it whether the data comes
+    // from assimp or from the import cache
+    struct ImportedNode
+    {
+	    math::affine3f        transform;
+		std::vector<unsigned> children;
+		std::vector<unsigned> meshes;
+    };
+
+    struct ImportedCamera
+    {
+	    math::affine3f transform;
+		float          fovY;
+    };
+
+    struct ImportedScene
+    {
+	    std::vector<AssimpMaterialProperties> materials;
+		std::vector<std::vector<unsigned>>    meshMaterials; // material index of each material slot of each mesh
+		std::vector<ImportedNode>             nodes;         // nodes[0] is the root
+		std::vector<ImportedCamera>           cameras;
+    };
+
+    // Mesh node created by the graph building pass whose data still has to be converted from assimp
+    struct MeshConversionJob
+    {
+	    const aiMesh*                aiMesh;
+		std::shared_ptr<graph::Mesh> meshNode;
+		SwapType                     swap;
+    };
+
+	// Hash and comparison of every material parameter, the name is left out since it doesn't change the compiled material
+	uint64_t hashMaterialProperties(const AssimpMaterialProperties& properties);
+	bool     isSameMaterial(const AssimpMaterialProperties& a, const AssimpMaterialProperties& b);
+
+	// Index of the first material with the same parameters as each material, its own index if there is none before it
+	std::vector<size_t> findIdenticalMaterials(const std::vector<AssimpMaterialProperties>& materialProperties);
+
+	std::vector<std::shared_ptr<graph::Material>> createMaterials(const std::vector<AssimpMaterialProperties>& materialProperties);
+
+	// Fills an already created mesh node, doesn't touch the scene index manager so it can run on worker threads
+	void fillMeshNode(const aiMesh* aiMesh, const std::shared_ptr<graph::Mesh>& meshNode, SwapType swap);
+
+	std::shared_ptr<graph::Mesh> convertAssimpMeshToMeshNode(const aiMesh* aiMesh, SwapType swap);
+
+	// Runs all the pending conversions concurrently on the shared thread pool
+	void convertMeshes(const std::vector<MeshConversionJob>& conversionJobs);
 
-	std::shared_ptr<graph::Mesh> convertAssimpMeshToMeshNode(const aiMesh* aiMesh, SwapType swap, float scaleFactor);
+    math::affine3f convertAssimpMatrix(const aiMatrix4x4& aiMatrix, SwapType swap);
 
-    math::affine3f convertAssimpMatrix(const aiMatrix4x4& aiMatrix, SwapType swap, float scaleFactor);
+	ImportedScene describeAssimpScene(const aiScene* scene, const std::string& scenePath, SwapType swap);
 
-    std::shared_ptr<graph::Instance> processAssimpNode(aiMesh* node, const unsigned assimpMeshId, std::map<unsigned, vtxID>& meshMap, const std::vector<std::shared_ptr<graph::Material>>& importedMaterials, SwapType swap, float scaleFactor);
+	// Creates materials, instances, groups and cameras. Mesh nodes are created empty, one per referenced mesh,
+	// and returned in meshNodes (indexed like the description meshes, nullptr if unreferenced) to be filled afterwards.
+	std::tuple<std::shared_ptr<graph::Group>, std::vector<std::shared_ptr<graph::Camera>>> buildSceneGraph(const ImportedScene& description, std::vector<std::shared_ptr<graph::Mesh>>& meshNodes);
 
-	std::shared_ptr<graph::Node> processAssimpNode(const aiNode* node, const aiScene* scene, std::map<unsigned, vtxID>& meshMap, const std::vector<std::shared_ptr<graph::Material>>& importedMaterials, SwapType swap, float scaleFactor);
+	// Reads the file with assimp and converts it, description and meshNodes are returned to allow caching the result
+	std::tuple<std::shared_ptr<graph::Group>, std::vector<std::shared_ptr<graph::Camera>>> importWithAssimp(const std::string& filePath, SwapType swap, ImportedScene& description, std::vector<std::shared_ptr<graph::Mesh>>& meshNodes);
 
 	std::tuple<std::shared_ptr<graph::Group>, std::vector<std::shared_ptr<graph::Camera>>> importSceneFile(std::string filePath);
 }
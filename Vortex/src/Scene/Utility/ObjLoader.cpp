@@ -0,0 +1,1004 @@
+#include "ObjLoader.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include "Core/Hashing.h"
+#include "Core/ThreadPool.h"
+#include "Core/Timer.h"
+#include "Scene/Graph.h"
+#include "Operations.h"
+
+namespace vtx::importer
+{
+	static constexpr int64_t noIndex      = -1;
+	static constexpr int64_t invalidIndex = std::numeric_limits<int64_t>::min();
+	static constexpr size_t  minChunkSize = 1024ull * 1024ull;
+	static constexpr size_t  maxChunkSize = 64ull * 1024ull * 1024ull;
+
+	static bool isSpace(const char c)
+	{
+		return c == ' ' || c == '\t';
+	}
+
+	static const char* skipSpaces(const char* it, const char* end)
+	{
+		while (it < end && isSpace(*it))
+		{
+			++it;
+		}
+		return it;
+	}
+
+	static const char* skipToken(const char* it, const char* end)
+	{
+		while (it < end && !isSpace(*it))
+		{
+			++it;
+		}
+		return it;
+	}
+
+	// True if the line starts with the keyword followed by a separator
+	static bool isKeyword(const char* it, const char* end, const char* keyword)
+	{
+		const size_t length = std::strlen(keyword);
+		return (size_t)(end - it) >= length && std::memcmp(it, keyword, length) == 0 && (it + length == end || isSpace(it[length]));
+	}
+
+	static std::string restOfLine(const char* it, const char* end)
+	{
+		it = skipSpaces(it, end);
+		return std::string(it, end);
+	}
+
+	static const char* parseFloat(const char* it, const char* end, float& value)
+	{
+		it = skipSpaces(it, end);
+		if (it < end && *it == '+')
+		{
+			++it;
+		}
+		const auto [ptr, error] = std::from_chars(it, end, value);
+		return error == std::errc() ? ptr : nullptr;
+	}
+
+	static math::vec3f parseVec3(const char* it, const char* end, const float defaultValue)
+	{
+		math::vec3f value(defaultValue);
+		for (size_t i = 0; i < 3 && it != nullptr; ++i)
+		{
+			float component;
+			it = parseFloat(it, end, component);
+			if (it != nullptr)
+			{
+				value[i] = component;
+			}
+		}
+		return value;
+	}
+
+	static math::vec3f swapVector(const math::vec3f& vec, const SwapType swap)
+	{
+		return (swap == SwapType::yToZ) ? math::vec3f(vec.x, vec.z, vec.y) : vec;
+	}
+
+	static void parseFace(const char* it, const char* end, ObjLoader::Chunk& chunk, const int32_t currentMaterial, const int32_t currentGroup)
+	{
+		ObjLoader::Face face{ (uint32_t)chunk.corners.size(), 0, currentMaterial, currentGroup };
+		const int64_t localCounts[3] = { (int64_t)chunk.positions.size(), (int64_t)chunk.texCoords.size(), (int64_t)chunk.normals.size() };
+
+		it = skipSpaces(it, end);
+		while (it < end)
+		{
+			int64_t indices[3]  = { invalidIndex, noIndex, noIndex };
+			uint8_t relativeMask = 0;
+			for (size_t k = 0; k < 3; ++k)
+			{
+				if (k > 0)
+				{
+					if (it >= end || *it != '/')
+					{
+						break;
+					}
+					++it;
+				}
+				int64_t value;
+				const auto [ptr, error] = std::from_chars(it, end, value);
+				if (error != std::errc())
+				{
+					// Empty slot as in p//n, only the position is mandatory
+					if (k == 0)
+					{
+						break;
+					}
+					continue;
+				}
+				it = ptr;
+				if (value > 0)
+				{
+					indices[k] = value - 1;
+				}
+				else if (value < 0)
+				{
+					// Relative to the data read so far, the chunk offset is added when merging
+					indices[k] = localCounts[k] + value;
+					relativeMask |= (uint8_t)(1u << k);
+				}
+				else
+				{
+					indices[k] = invalidIndex;
+				}
+			}
+			it = skipSpaces(skipToken(it, end), end);
+
+			chunk.corners.push_back({ indices[0], indices[1], indices[2] });
+			chunk.relativeCorners.push_back(relativeMask);
+			++face.numCorners;
+		}
+
+		if (face.numCorners < 3)
+		{
+			chunk.corners.resize(face.firstCorner);
+			chunk.relativeCorners.resize(face.firstCorner);
+			return;
+		}
+		chunk.faces.push_back(face);
+	}
+
+	static void parseChunk(const char* begin, const char* end, ObjLoader::Chunk& chunk)
+	{
+		int32_t     currentMaterial = -1;
+		int32_t     currentGroup    = -1;
+		const char* line            = begin;
+		while (line < end)
+		{
+			const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', end - line));
+			lineEnd             = lineEnd != nullptr ? lineEnd : end;
+			const char* next    = lineEnd < end ? lineEnd + 1 : end;
+			while (lineEnd > line && (lineEnd[-1] == '\r' || isSpace(lineEnd[-1])))
+			{
+				--lineEnd;
+			}
+
+			const char* it = skipSpaces(line, lineEnd);
+			line           = next;
+			if (it + 1 >= lineEnd)
+			{
+				continue;
+			}
+
+			if (it[0] == 'v')
+			{
+				if (isSpace(it[1]))
+				{
+					chunk.positions.push_back(parseVec3(it + 1, lineEnd, 0.0f));
+				}
+				else if (isKeyword(it, lineEnd, "vt"))
+				{
+					const math::vec3f uv = parseVec3(it + 2, lineEnd, 0.0f);
+					chunk.texCoords.emplace_back(uv.x, uv.y, 0.0f);
+				}
+				else if (isKeyword(it, lineEnd, "vn"))
+				{
+					chunk.normals.push_back(parseVec3(it + 2, lineEnd, 0.0f));
+				}
+			}
+			else if (it[0] == 'f' && isSpace(it[1]))
+			{
+				parseFace(it + 1, lineEnd, chunk, currentMaterial, currentGroup);
+			}
+			else if (isKeyword(it, lineEnd, "usemtl"))
+			{
+				currentMaterial = (int32_t)chunk.materialNames.size();
+				chunk.materialNames.push_back(restOfLine(it + 6, lineEnd));
+				chunk.materialFaceCounts.push_back(0);
+			}
+			else if (isKeyword(it, lineEnd, "mtllib"))
+			{
+				// A single statement can reference several libraries
+				for (const char* name = skipSpaces(it + 6, lineEnd); name < lineEnd;)
+				{
+					const char* nameEnd = skipToken(name, lineEnd);
+					chunk.materialLibraries.emplace_back(name, nameEnd);
+					name = skipSpaces(nameEnd, lineEnd);
+				}
+			}
+			else if (isKeyword(it, lineEnd, "o") || isKeyword(it, lineEnd, "g"))
+			{
+				currentGroup = (int32_t)chunk.groupNames.size();
+				chunk.groupNames.push_back(restOfLine(it + 1, lineEnd));
+			}
+		}
+	}
+
+	static AssimpMaterialProperties createObjMaterial(const std::string& name)
+	{
+		// Same defaults assimp uses for obj materials
+		AssimpMaterialProperties material;
+		material.name                = name;
+		material.diffuse.value       = math::vec3f(0.6f);
+		material.emissionColor.value = math::vec3f(0.0f);
+		material.opacity.value       = 1.0f;
+		return material;
+	}
+
+	// Path of a texture statement, options such as -bm 1 or -s 1 1 1 are skipped
+	static std::string parseTexturePath(const char* it, const char* end, const std::string& folder)
+	{
+		static const std::map<std::string, int> optionArguments = {
+			{ "-bm", 1 }, { "-blendu", 1 }, { "-blendv", 1 }, { "-boost", 1 }, { "-cc", 1 }, { "-clamp", 1 },
+			{ "-imfchan", 1 }, { "-mm", 2 }, { "-o", 3 }, { "-s", 3 }, { "-t", 3 }, { "-texres", 1 }, { "-type", 1 }
+		};
+
+		it = skipSpaces(it, end);
+		while (it < end && *it == '-')
+		{
+			const char* tokenEnd = skipToken(it, end);
+			const auto  option   = optionArguments.find(std::string(it, tokenEnd));
+			if (option == optionArguments.end())
+			{
+				break;
+			}
+			it = skipSpaces(tokenEnd, end);
+			for (int i = 0; i < option->second && it < end; ++i)
+			{
+				// -o, -s and -t take up to three numbers
+				float       value;
+				const char* numberEnd = parseFloat(it, end, value);
+				const bool  isNumber  = numberEnd != nullptr && (numberEnd == end || isSpace(*numberEnd));
+				if (!isNumber && option->second == 3)
+				{
+					break;
+				}
+				it = skipSpaces(skipToken(it, end), end);
+			}
+		}
+
+		if (it >= end)
+		{
+			return "";
+		}
+		return utl::replacePercent20WithSpace(utl::absolutePath(std::string(it, end), folder));
+	}
+
+	static void parseMaterialLibrary(const std::string& libraryPath, std::map<std::string, AssimpMaterialProperties>& materials)
+	{
+		std::ifstream file(libraryPath, std::ios::binary);
+		if (!file)
+		{
+			VTX_WARN("Obj loader: can't open material library {}", libraryPath);
+			return;
+		}
+		const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		const std::string folder = utl::getFolder(libraryPath);
+
+		std::map<std::string, math::vec3f> specularColors;
+		AssimpMaterialProperties*          material = nullptr;
+		const char*                        line     = content.data();
+		const char*                        end      = content.data() + content.size();
+		while (line < end)
+		{
+			const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', end - line));
+			lineEnd             = lineEnd != nullptr ? lineEnd : end;
+			const char* next    = lineEnd < end ? lineEnd + 1 : end;
+			while (lineEnd > line && (lineEnd[-1] == '\r' || isSpace(lineEnd[-1])))
+			{
+				--lineEnd;
+			}
+			const char* it = skipSpaces(line, lineEnd);
+			line           = next;
+
+			if (isKeyword(it, lineEnd, "newmtl"))
+			{
+				const std::string name = restOfLine(it + 6, lineEnd);
+				materials[name]        = createObjMaterial(name);
+				material               = &materials[name];
+				continue;
+			}
+			if (material == nullptr || it >= lineEnd)
+			{
+				continue;
+			}
+
+			const char* keywordEnd = skipToken(it, lineEnd);
+			const std::string keyword(it, keywordEnd);
+			float             value;
+			if (keyword == "Kd")
+			{
+				material->diffuse.value = parseVec3(keywordEnd, lineEnd, 0.0f);
+			}
+			else if (keyword == "Ks")
+			{
+				specularColors[material->name] = parseVec3(keywordEnd, lineEnd, 0.0f);
+			}
+			else if (keyword == "Ke")
+			{
+				material->emissionColor.value = parseVec3(keywordEnd, lineEnd, 0.0f);
+			}
+			else if (keyword == "Pr" && parseFloat(keywordEnd, lineEnd, value))
+			{
+				material->roughness.value = value;
+			}
+			else if (keyword == "Pm" && parseFloat(keywordEnd, lineEnd, value))
+			{
+				material->metallic.value = value;
+			}
+			else if (keyword == "d" && parseFloat(keywordEnd, lineEnd, value))
+			{
+				material->opacity.value = value;
+			}
+			else if (keyword == "Tr" && parseFloat(keywordEnd, lineEnd, value))
+			{
+				material->opacity.value = 1.0f - value;
+			}
+			else if (keyword == "map_Kd")
+			{
+				material->diffuse.path = parseTexturePath(keywordEnd, lineEnd, folder);
+			}
+			else if (keyword == "map_Pr" || (keyword == "map_Ns" && material->roughness.path.empty()))
+			{
+				material->roughness.path = parseTexturePath(keywordEnd, lineEnd, folder);
+			}
+			else if (keyword == "map_Pm")
+			{
+				material->metallic.path = parseTexturePath(keywordEnd, lineEnd, folder);
+			}
+			else if (keyword == "map_Ks")
+			{
+				material->specular.path = parseTexturePath(keywordEnd, lineEnd, folder);
+			}
+			else if (keyword == "norm" || keyword == "map_Kn")
+			{
+				material->normal.path = parseTexturePath(keywordEnd, lineEnd, folder);
+			}
+			else if (keyword == "map_bump" || keyword == "map_Bump" || keyword == "bump")
+			{
+				material->bump.path = parseTexturePath(keywordEnd, lineEnd, folder);
+			}
+			else if (keyword == "map_Ke")
+			{
+				material->emissionIntensity.path = parseTexturePath(keywordEnd, lineEnd, folder);
+			}
+			else if (keyword == "map_d")
+			{
+				material->opacity.path = parseTexturePath(keywordEnd, lineEnd, folder);
+			}
+		}
+
+		// Same fallbacks as AssimpMaterialProperties::determineProperties
+		for (auto& [name, properties] : materials)
+		{
+			const auto specularColor = specularColors.find(name);
+			const math::vec3f ks = specularColor != specularColors.end() ? specularColor->second : math::vec3f(0.0f);
+			if (properties.specular.value == -1.0f && ks != properties.diffuse.value && ks.x == ks.y && ks.x == ks.z)
+			{
+				properties.specular.value = ks.x;
+			}
+			if (properties.opacity.value < 1.0f)
+			{
+				properties.opacity.path = properties.opacity.path.empty() ? properties.diffuse.path : properties.opacity.path;
+			}
+		}
+	}
+
+	bool ObjLoader::open(const std::string& filePath, const SwapType swapType)
+	{
+		Timer timer;
+		swap = swapType;
+
+		const utl::MappedFile file(filePath);
+		if (!file.isValid())
+		{
+			VTX_WARN("Obj loader: failed to map {}", filePath);
+			return false;
+		}
+		fileSize = file.getSize();
+		const char* data = static_cast<const char*>(file.getData());
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		/////////////////// Parallel Parsing /////////////////////////////////////////////////
+		//////////////////////////////////////////////////////////////////////////////////////
+		const size_t numberOfWorkers = vtx::ThreadPool::get()->getNumberOfWorkers();
+		const size_t chunkSize       = std::clamp(fileSize / std::max<size_t>(numberOfWorkers * 4, 1), minChunkSize, maxChunkSize);
+		std::vector<const char*> chunkBegins;
+		for (const char* it = data; it < data + fileSize;)
+		{
+			chunkBegins.push_back(it);
+			const char* splitPoint = it + std::min(chunkSize, (size_t)(data + fileSize - it));
+			const char* lineEnd    = splitPoint < data + fileSize ? static_cast<const char*>(std::memchr(splitPoint, '\n', data + fileSize - splitPoint)) : nullptr;
+			it                     = lineEnd != nullptr ? lineEnd + 1 : data + fileSize;
+		}
+		chunkBegins.push_back(data + fileSize);
+
+		chunks.clear();
+		chunks.resize(chunkBegins.size() - 1);
+		utl::parallelFor(chunks.size(), [&](const size_t i)
+		{
+			parseChunk(chunkBegins[i], chunkBegins[i + 1], chunks[i]);
+		});
+		const float parseTime = timer.elapsedMillis();
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		/////////////////// Merge ////////////////////////////////////////////////////////////
+		//////////////////////////////////////////////////////////////////////////////////////
+		std::vector<size_t> positionOffsets(chunks.size() + 1, 0);
+		std::vector<size_t> texCoordOffsets(chunks.size() + 1, 0);
+		std::vector<size_t> normalOffsets(chunks.size() + 1, 0);
+		numCorners = 0;
+		for (size_t i = 0; i < chunks.size(); ++i)
+		{
+			positionOffsets[i + 1] = positionOffsets[i] + chunks[i].positions.size();
+			texCoordOffsets[i + 1] = texCoordOffsets[i] + chunks[i].texCoords.size();
+			normalOffsets[i + 1]   = normalOffsets[i] + chunks[i].normals.size();
+			chunks[i].firstCorner  = numCorners;
+			numCorners += chunks[i].corners.size();
+		}
+		if (numCorners == 0)
+		{
+			VTX_WARN("Obj loader: no faces found in {}", filePath);
+			return false;
+		}
+		if (numCorners >= std::numeric_limits<vtxID>::max())
+		{
+			VTX_WARN("Obj loader: {} has too many face corners to be indexed natively", filePath);
+			return false;
+		}
+
+		positions.resize(positionOffsets.back());
+		texCoords.resize(texCoordOffsets.back());
+		normals.resize(normalOffsets.back());
+		const int64_t numPositions = (int64_t)positions.size();
+		const int64_t numTexCoords = (int64_t)texCoords.size();
+		const int64_t numNormals   = (int64_t)normals.size();
+
+		std::vector<uint8_t> chunkHasNormals(chunks.size(), 1);
+		utl::parallelFor(chunks.size(), [&](const size_t i)
+		{
+			Chunk& chunk = chunks[i];
+			std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + positionOffsets[i]);
+			std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), texCoords.begin() + texCoordOffsets[i]);
+			std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + normalOffsets[i]);
+			std::vector<math::vec3f>().swap(chunk.positions);
+			std::vector<math::vec3f>().swap(chunk.texCoords);
+			std::vector<math::vec3f>().swap(chunk.normals);
+
+			const int64_t offsets[3] = { (int64_t)positionOffsets[i], (int64_t)texCoordOffsets[i], (int64_t)normalOffsets[i] };
+			for (Face& face : chunk.faces)
+			{
+				bool valid = true;
+				for (uint32_t c = face.firstCorner; c < face.firstCorner + face.numCorners; ++c)
+				{
+					Corner&       corner   = chunk.corners[c];
+					const uint8_t relative = chunk.relativeCorners[c];
+					int64_t*      indices[3] = { &corner.position, &corner.texCoord, &corner.normal };
+					for (size_t k = 0; k < 3; ++k)
+					{
+						if ((relative & (1u << k)) != 0)
+						{
+							*indices[k] += offsets[k];
+						}
+					}
+					valid = valid &&
+						corner.position >= 0 && corner.position < numPositions &&
+						(corner.texCoord == noIndex || (corner.texCoord >= 0 && corner.texCoord < numTexCoords)) &&
+						(corner.normal == noIndex || (corner.normal >= 0 && corner.normal < numNormals));
+				}
+
+				if (!valid)
+				{
+					// The corners are marked so that they don't produce vertices
+					for (uint32_t c = face.firstCorner; c < face.firstCorner + face.numCorners; ++c)
+					{
+						chunk.corners[c].position = noIndex;
+					}
+					face.numCorners = 0;
+					continue;
+				}
+				for (uint32_t c = face.firstCorner; c < face.firstCorner + face.numCorners; ++c)
+				{
+					if (chunk.corners[c].normal == noIndex)
+					{
+						chunkHasNormals[i] = 0;
+					}
+				}
+				chunk.numTriangles += face.numCorners - 2;
+
+				// Counted once the face is known to be valid, a material used only by skipped faces gets no slot
+				if (face.material >= 0)
+				{
+					++chunk.materialFaceCounts[face.material];
+				}
+				else
+				{
+					++chunk.inheritedFaceCount;
+				}
+			}
+			std::vector<uint8_t>().swap(chunk.relativeCorners);
+		});
+
+		size_t numInvalidFaces = 0;
+		numTriangles           = 0;
+		hasNormals             = true;
+		for (size_t i = 0; i < chunks.size(); ++i)
+		{
+			chunks[i].firstTriangle = numTriangles;
+			numTriangles += chunks[i].numTriangles;
+			hasNormals = hasNormals && chunkHasNormals[i] != 0;
+			numInvalidFaces += std::count_if(chunks[i].faces.begin(), chunks[i].faces.end(), [](const Face& face) { return face.numCorners == 0; });
+		}
+		if (numInvalidFaces != 0)
+		{
+			VTX_WARN("Obj loader: {} faces of {} reference missing vertex data and have been skipped", numInvalidFaces, filePath);
+		}
+		if (numTriangles == 0)
+		{
+			VTX_WARN("Obj loader: no valid faces found in {}", filePath);
+			return false;
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		/////////////////// Materials ////////////////////////////////////////////////////////
+		//////////////////////////////////////////////////////////////////////////////////////
+		// Slots are assigned in order of first use, faces before any usemtl use assimp's default material
+		const std::string defaultMaterialName = "DefaultMaterial";
+		std::vector<std::string>                  slotNames;
+		std::unordered_map<std::string, unsigned> slotIds;
+		auto getSlot = [&slotNames, &slotIds](const std::string& name) -> unsigned
+		{
+			const auto [it, inserted] = slotIds.try_emplace(name, (unsigned)slotNames.size());
+			if (inserted)
+			{
+				slotNames.push_back(name);
+			}
+			return it->second;
+		};
+
+		std::string currentMaterial = defaultMaterialName;
+		std::vector<std::string> libraries;
+		for (Chunk& chunk : chunks)
+		{
+			if (chunk.inheritedFaceCount != 0)
+			{
+				chunk.inheritedSlot = getSlot(currentMaterial);
+			}
+			chunk.materialSlots.resize(chunk.materialNames.size(), 0);
+			for (size_t m = 0; m < chunk.materialNames.size(); ++m)
+			{
+				if (chunk.materialFaceCounts[m] != 0)
+				{
+					chunk.materialSlots[m] = getSlot(chunk.materialNames[m]);
+				}
+			}
+			if (!chunk.materialNames.empty())
+			{
+				currentMaterial = chunk.materialNames.back();
+			}
+			libraries.insert(libraries.end(), chunk.materialLibraries.begin(), chunk.materialLibraries.end());
+		}
+
+		std::map<std::string, AssimpMaterialProperties> libraryMaterials;
+		std::set<std::string>                           parsedLibraries;
+		for (const std::string& library : libraries)
+		{
+			const std::string libraryPath = utl::replacePercent20WithSpace(utl::absolutePath(library, utl::getFolder(filePath)));
+			if (parsedLibraries.insert(libraryPath).second)
+			{
+				parseMaterialLibrary(libraryPath, libraryMaterials);
+			}
+		}
+
+		scene = {};
+		scene.materials.reserve(slotNames.size());
+		for (const std::string& name : slotNames)
+		{
+			const auto material = libraryMaterials.find(name);
+			if (material != libraryMaterials.end())
+			{
+				scene.materials.push_back(material->second);
+				continue;
+			}
+			if (name != defaultMaterialName)
+			{
+				VTX_WARN("Obj loader: material {} not found, using the default material", name);
+			}
+			scene.materials.push_back(createObjMaterial(defaultMaterialName));
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		/////////////////// Meshes ///////////////////////////////////////////////////////////
+		//////////////////////////////////////////////////////////////////////////////////////
+		// Groups are numbered in order of first statement, faces before any o or g statement form an unnamed mesh.
+		// Groups left without valid faces are dropped afterwards.
+		std::vector<std::string>                  groupNames;
+		std::unordered_map<std::string, unsigned> groupIds;
+		auto getGroup = [&groupNames, &groupIds](const std::string& name) -> unsigned
+		{
+			const auto [it, inserted] = groupIds.try_emplace(name, (unsigned)groupNames.size());
+			if (inserted)
+			{
+				groupNames.push_back(name);
+			}
+			return it->second;
+		};
+
+		std::string currentGroup;
+		for (Chunk& chunk : chunks)
+		{
+			chunk.inheritedGroup = getGroup(currentGroup);
+			chunk.groupIds.resize(chunk.groupNames.size());
+			for (size_t g = 0; g < chunk.groupNames.size(); ++g)
+			{
+				chunk.groupIds[g] = getGroup(chunk.groupNames[g]);
+			}
+			if (!chunk.groupNames.empty())
+			{
+				currentGroup = chunk.groupNames.back();
+			}
+		}
+
+		std::vector<std::set<std::pair<unsigned, unsigned>>> chunkGroupSlots(chunks.size());
+		utl::parallelFor(chunks.size(), [&](const size_t i)
+		{
+			const Chunk& chunk = chunks[i];
+			for (const Face& face : chunk.faces)
+			{
+				if (face.numCorners != 0)
+				{
+					const unsigned group = face.group >= 0 ? chunk.groupIds[face.group] : chunk.inheritedGroup;
+					const unsigned slot  = face.material >= 0 ? chunk.materialSlots[face.material] : chunk.inheritedSlot;
+					chunkGroupSlots[i].insert({ group, slot });
+				}
+			}
+		});
+
+		std::vector<std::set<unsigned>> usedSlots(groupNames.size());
+		for (const std::set<std::pair<unsigned, unsigned>>& pairs : chunkGroupSlots)
+		{
+			for (const auto& [group, slot] : pairs)
+			{
+				usedSlots[group].insert(slot);
+			}
+		}
+		std::vector<unsigned> meshIds(groupNames.size(), 0);
+		groupSlots.clear();
+		for (size_t g = 0; g < groupNames.size(); ++g)
+		{
+			if (!usedSlots[g].empty())
+			{
+				meshIds[g] = (unsigned)groupSlots.size();
+				groupSlots.emplace_back(usedSlots[g].begin(), usedSlots[g].end());
+			}
+		}
+		for (Chunk& chunk : chunks)
+		{
+			chunk.inheritedGroup = meshIds[chunk.inheritedGroup];
+			for (unsigned& group : chunk.groupIds)
+			{
+				group = meshIds[group];
+			}
+		}
+
+		scene.nodes.emplace_back();
+		scene.nodes[0].transform = math::affine3f(math::Identity);
+		for (unsigned i = 0; i < groupSlots.size(); ++i)
+		{
+			// Slots are created in material order, the slot index is the material index
+			scene.meshMaterials.push_back(groupSlots[i]);
+			scene.nodes[0].meshes.push_back(i);
+		}
+
+		VTX_INFO("Obj loader: {} parsed in {} ms ({} ms parsing {} chunks), {} positions, {} triangles, {} materials, {} meshes",
+				 filePath, timer.elapsedMillis(), parseTime, chunks.size(), positions.size(), numTriangles, scene.materials.size(), groupSlots.size());
+		return true;
+	}
+
+	const ImportedScene& ObjLoader::getScene() const
+	{
+		return scene;
+	}
+
+	struct CornerHash
+	{
+		size_t operator()(const ObjLoader::Corner& corner) const
+		{
+			return (size_t)utl::hashCombine(utl::hashCombine((uint64_t)corner.position, (uint64_t)corner.texCoord), (uint64_t)corner.normal);
+		}
+	};
+
+	struct CornerEqual
+	{
+		bool operator()(const ObjLoader::Corner& a, const ObjLoader::Corner& b) const
+		{
+			return a.position == b.position && a.texCoord == b.texCoord && a.normal == b.normal;
+		}
+	};
+
+	void ObjLoader::fillMeshes(const std::vector<std::shared_ptr<graph::Mesh>>& meshNodes) const
+	{
+		VTX_ASSERT_RETURN(meshNodes.size() == groupSlots.size(), "Obj loader: fillMeshes() expects the meshes of the scene description");
+		Timer timer;
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		/////////////////// Corner Welding ///////////////////////////////////////////////////
+		//////////////////////////////////////////////////////////////////////////////////////
+		// Corners are bucketed by position index, each bucket is deduplicated independently
+		// and the buckets are then laid out one after the other.
+		const size_t numPartitions = std::max<size_t>(vtx::ThreadPool::get()->getNumberOfWorkers() * 4, 1);
+
+		std::vector<size_t> histograms(chunks.size() * numPartitions, 0);
+		utl::parallelFor(chunks.size(), [&](const size_t i)
+		{
+			size_t* histogram = histograms.data() + i * numPartitions;
+			for (const Corner& corner : chunks[i].corners)
+			{
+				if (corner.position != noIndex)
+				{
+					++histogram[corner.position % numPartitions];
+				}
+			}
+		});
+
+		std::vector<size_t> bucketOffsets(chunks.size() * numPartitions);
+		std::vector<size_t> partitionOffsets(numPartitions + 1, 0);
+		size_t              numValidCorners = 0;
+		for (size_t p = 0; p < numPartitions; ++p)
+		{
+			partitionOffsets[p] = numValidCorners;
+			for (size_t i = 0; i < chunks.size(); ++i)
+			{
+				bucketOffsets[i * numPartitions + p] = numValidCorners;
+				numValidCorners += histograms[i * numPartitions + p];
+			}
+		}
+		partitionOffsets[numPartitions] = numValidCorners;
+
+		std::vector<uint32_t> buckets(numValidCorners);
+		utl::parallelFor(chunks.size(), [&](const size_t i)
+		{
+			size_t*                    offsets = bucketOffsets.data() + i * numPartitions;
+			const std::vector<Corner>& corners = chunks[i].corners;
+			for (size_t c = 0; c < corners.size(); ++c)
+			{
+				if (corners[c].position != noIndex)
+				{
+					buckets[offsets[corners[c].position % numPartitions]++] = (uint32_t)(chunks[i].firstCorner + c);
+				}
+			}
+		});
+
+		auto getCorner = [this](const uint32_t globalCorner) -> const Corner&
+		{
+			const auto chunk = std::upper_bound(chunks.begin(), chunks.end(), globalCorner, [](const uint32_t corner, const Chunk& c) { return corner < c.firstCorner; }) - 1;
+			return chunk->corners[globalCorner - chunk->firstCorner];
+		};
+
+		std::vector<vtxID>               cornerVertices(numCorners, 0);
+		std::vector<std::vector<Corner>> partitionVertices(numPartitions);
+		utl::parallelFor(numPartitions, [&](const size_t p)
+		{
+			std::unordered_map<Corner, vtxID, CornerHash, CornerEqual> vertexIds;
+			vertexIds.reserve(partitionOffsets[p + 1] - partitionOffsets[p]);
+			std::vector<Corner>& uniqueCorners = partitionVertices[p];
+			for (size_t b = partitionOffsets[p]; b < partitionOffsets[p + 1]; ++b)
+			{
+				const uint32_t globalCorner = buckets[b];
+				const Corner&  corner       = getCorner(globalCorner);
+				const auto [it, inserted]   = vertexIds.try_emplace(corner, (vtxID)uniqueCorners.size());
+				if (inserted)
+				{
+					uniqueCorners.push_back(corner);
+				}
+				cornerVertices[globalCorner] = it->second;
+			}
+		}, 1);
+
+		std::vector<size_t> vertexOffsets(numPartitions + 1, 0);
+		for (size_t p = 0; p < numPartitions; ++p)
+		{
+			vertexOffsets[p + 1] = vertexOffsets[p] + partitionVertices[p].size();
+		}
+
+		std::vector<graph::VertexAttributes> vertices(vertexOffsets.back());
+		utl::parallelFor(numPartitions, [&](const size_t p)
+		{
+			for (size_t v = 0; v < partitionVertices[p].size(); ++v)
+			{
+				const Corner&            corner = partitionVertices[p][v];
+				graph::VertexAttributes& vertex = vertices[vertexOffsets[p] + v];
+				vertex          = {};
+				vertex.position = swapVector(positions[corner.position], swap);
+				if (corner.texCoord != noIndex)
+				{
+					vertex.texCoord = texCoords[corner.texCoord];
+				}
+				if (corner.normal != noIndex)
+				{
+					vertex.normal = swapVector(normals[corner.normal], swap);
+				}
+			}
+			for (size_t b = partitionOffsets[p]; b < partitionOffsets[p + 1]; ++b)
+			{
+				cornerVertices[buckets[b]] += (vtxID)vertexOffsets[p];
+			}
+		}, 1);
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		/////////////////// Triangulation ////////////////////////////////////////////////////
+		//////////////////////////////////////////////////////////////////////////////////////
+		const unsigned int second = (swap == SwapType::yToZ) ? 2 : 1;
+		const unsigned int third  = (swap == SwapType::yToZ) ? 1 : 2;
+		std::vector<vtxID>                 indices(numTriangles * 3);
+		std::vector<graph::FaceAttributes> faceAttributes(numTriangles);
+		std::vector<unsigned>              triangleMeshes(numTriangles);
+		utl::parallelFor(chunks.size(), [&](const size_t i)
+		{
+			const Chunk& chunk    = chunks[i];
+			size_t       triangle = chunk.firstTriangle;
+			for (const Face& face : chunk.faces)
+			{
+				if (face.numCorners == 0)
+				{
+					continue;
+				}
+				const unsigned slot   = face.material >= 0 ? chunk.materialSlots[face.material] : chunk.inheritedSlot;
+				const unsigned group  = face.group >= 0 ? chunk.groupIds[face.group] : chunk.inheritedGroup;
+				const size_t   corner = chunk.firstCorner + face.firstCorner;
+				// Polygons are triangulated as fans, as assimp does for convex faces
+				for (uint32_t c = 1; c + 1 < face.numCorners; ++c)
+				{
+					const vtxID triangleIndices[3] = { cornerVertices[corner], cornerVertices[corner + c], cornerVertices[corner + c + 1] };
+					indices[triangle * 3]     = triangleIndices[0];
+					indices[triangle * 3 + 1] = triangleIndices[second];
+					indices[triangle * 3 + 2] = triangleIndices[third];
+					faceAttributes[triangle].materialSlotId = (unsigned)(std::lower_bound(groupSlots[group].begin(), groupSlots[group].end(), slot) - groupSlots[group].begin());
+					triangleMeshes[triangle] = group;
+					++triangle;
+				}
+			}
+		});
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		/////////////////// Mesh Split ///////////////////////////////////////////////////////
+		//////////////////////////////////////////////////////////////////////////////////////
+		const size_t numMeshes = meshNodes.size();
+		if (numMeshes == 1)
+		{
+			meshNodes[0]->vertices       = std::move(vertices);
+			meshNodes[0]->indices        = std::move(indices);
+			meshNodes[0]->faceAttributes = std::move(faceAttributes);
+		}
+		else
+		{
+			// Triangles are bucketed by mesh, each mesh then gathers the vertices it references
+			std::vector<size_t> meshHistograms(chunks.size() * numMeshes, 0);
+			utl::parallelFor(chunks.size(), [&](const size_t i)
+			{
+				size_t* histogram = meshHistograms.data() + i * numMeshes;
+				for (size_t t = chunks[i].firstTriangle; t < chunks[i].firstTriangle + chunks[i].numTriangles; ++t)
+				{
+					++histogram[triangleMeshes[t]];
+				}
+			});
+
+			std::vector<size_t> meshOffsets(numMeshes + 1, 0);
+			size_t              offset = 0;
+			for (size_t m = 0; m < numMeshes; ++m)
+			{
+				meshOffsets[m] = offset;
+				for (size_t i = 0; i < chunks.size(); ++i)
+				{
+					const size_t count = meshHistograms[i * numMeshes + m];
+					meshHistograms[i * numMeshes + m] = offset;
+					offset += count;
+				}
+			}
+			meshOffsets[numMeshes] = offset;
+
+			std::vector<uint32_t> meshTriangles(numTriangles);
+			utl::parallelFor(chunks.size(), [&](const size_t i)
+			{
+				size_t* offsets = meshHistograms.data() + i * numMeshes;
+				for (size_t t = chunks[i].firstTriangle; t < chunks[i].firstTriangle + chunks[i].numTriangles; ++t)
+				{
+					meshTriangles[offsets[triangleMeshes[t]]++] = (uint32_t)t;
+				}
+			});
+
+			utl::parallelFor(numMeshes, [&](const size_t m)
+			{
+				graph::Mesh&                     mesh             = *meshNodes[m];
+				const size_t                     meshNumTriangles = meshOffsets[m + 1] - meshOffsets[m];
+				std::unordered_map<vtxID, vtxID> localIds;
+				localIds.reserve(meshNumTriangles);
+				mesh.indices.resize(meshNumTriangles * 3);
+				mesh.faceAttributes.resize(meshNumTriangles);
+				for (size_t t = 0; t < meshNumTriangles; ++t)
+				{
+					const uint32_t triangle = meshTriangles[meshOffsets[m] + t];
+					for (size_t k = 0; k < 3; ++k)
+					{
+						const vtxID vertex        = indices[triangle * 3 + k];
+						const auto [it, inserted] = localIds.try_emplace(vertex, (vtxID)mesh.vertices.size());
+						if (inserted)
+						{
+							mesh.vertices.push_back(vertices[vertex]);
+						}
+						mesh.indices[t * 3 + k] = it->second;
+					}
+					mesh.faceAttributes[t] = faceAttributes[triangle];
+				}
+			}, 1);
+		}
+
+		utl::parallelFor(numMeshes, [&](const size_t m)
+		{
+			graph::Mesh& mesh = *meshNodes[m];
+			mesh.status.hasFaceAttributes = true;
+			mesh.status.hasNormals        = hasNormals;
+			mesh.status.hasTangents       = false;
+			if (hasNormals)
+			{
+				// Assimp would generate them with aiProcess_CalcTangentSpace, the file normals are kept
+				ops::computeVertexTangentSpace(meshNodes[m], true);
+			}
+		}, 1);
+
+		const float milliseconds = timer.elapsedMillis();
+		VTX_INFO("Obj loader: {} meshes filled in {} ms, {} vertices, {} triangles", numMeshes, milliseconds, vertexOffsets.back(), numTriangles);
+	}
+
+	void ObjLoader::logThroughput(const std::string& filePath, const float milliseconds) const
+	{
+		const double megabytes = (double)fileSize / (1024.0 * 1024.0);
+		VTX_INFO("Obj loader: {} ({:.1f} MB) imported in {} ms, {:.1f} MB/s", filePath, megabytes, milliseconds, megabytes / std::max(milliseconds / 1000.0, 1e-6));
+	}
+
+	static void logImportStatistics(const char* loaderName, const float milliseconds, const std::vector<std::shared_ptr<graph::Mesh>>& meshNodes)
+	{
+		size_t numVertices  = 0;
+		size_t numTriangles = 0;
+		for (const std::shared_ptr<graph::Mesh>& mesh : meshNodes)
+		{
+			if (mesh != nullptr)
+			{
+				numVertices += mesh->vertices.size();
+				numTriangles += mesh->indices.size() / 3;
+			}
+		}
+		VTX_INFO("Obj benchmark: {} took {} ms, {} meshes, {} vertices, {} triangles", loaderName, milliseconds, meshNodes.size(), numVertices, numTriangles);
+	}
+
+	void benchmarkObjImport(const std::string& filePath)
+	{
+		const std::string absoluteFilePath = utl::absolutePath(filePath);
+		VTX_INFO("Obj benchmark: {}", absoluteFilePath);
+		{
+			Timer                                     timer;
+			std::vector<std::shared_ptr<graph::Mesh>> meshNodes;
+			ObjLoader                                 loader;
+			if (loader.open(absoluteFilePath, SwapType::yToZ))
+			{
+				auto sceneGraph = buildSceneGraph(loader.getScene(), meshNodes);
+				loader.fillMeshes(meshNodes);
+				logImportStatistics("native loader", timer.elapsedMillis(), meshNodes);
+				loader.logThroughput(absoluteFilePath, timer.elapsedMillis());
+			}
+			else
+			{
+				VTX_WARN("Obj benchmark: the native loader can't import {}", absoluteFilePath);
+			}
+		}
+		{
+			Timer                                     timer;
+			std::vector<std::shared_ptr<graph::Mesh>> meshNodes;
+			ImportedScene                             description;
+			auto sceneGraph = importWithAssimp(absoluteFilePath, SwapType::yToZ, description, meshNodes);
+			logImportStatistics("assimp", timer.elapsedMillis(), meshNodes);
+		}
+	}
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ModelLoader.h"
+
+namespace vtx::importer
+{
+	// Native reader for Wavefront obj files, meant for large scanned assets.
+	// The file is memory mapped and split in line aligned chunks which are parsed in parallel, the chunks are then merged
+	// with global index offsets. Every o and g statement starts a mesh, statements with the same name add to the same mesh,
+	// and usemtl statements select the material slot of the faces.
+	class ObjLoader
+	{
+	public:
+		// Parses the geometry and the referenced mtl libraries. Returns false if the file can't be read or contains
+		// no faces, in which case the caller falls back to assimp.
+		bool open(const std::string& filePath, SwapType swap);
+
+		const ImportedScene& getScene() const;
+
+		// Welds the face corners into vertices and fills the mesh nodes created from the scene description, in parallel
+		void fillMeshes(const std::vector<std::shared_ptr<graph::Mesh>>& meshNodes) const;
+
+		// Logs the size of the parsed file and the import throughput in MB/s
+		void logThroughput(const std::string& filePath, float milliseconds) const;
+
+		struct Corner
+		{
+			int64_t position;
+			int64_t texCoord;
+			int64_t normal;
+		};
+
+		struct Face
+		{
+			uint32_t firstCorner;
+			uint32_t numCorners; // 0 if the face references missing data
+			int32_t  material;   // index in the chunk usemtl list, -1 if inherited from the previous chunk
+			int32_t  group;      // index in the chunk o/g list, -1 if inherited from the previous chunk
+		};
+
+		struct Chunk
+		{
+			std::vector<math::vec3f> positions;
+			std::vector<math::vec3f> texCoords;
+			std::vector<math::vec3f> normals;
+			std::vector<Corner>      corners;
+			std::vector<uint8_t>     relativeCorners; // bit mask of the corner indices which were negative in the file
+			std::vector<Face>        faces;
+			std::vector<std::string> materialNames;
+			std::vector<size_t>      materialFaceCounts;
+			size_t                   inheritedFaceCount = 0;
+			std::vector<std::string> materialLibraries;
+			std::vector<std::string> groupNames;
+
+			// Filled by the merge
+			std::vector<unsigned> materialSlots;
+			unsigned              inheritedSlot = 0;
+			std::vector<unsigned> groupIds;
+			unsigned              inheritedGroup = 0;
+			size_t                firstCorner   = 0;
+			size_t                firstTriangle = 0;
+			size_t                numTriangles  = 0;
+		};
+
+	private:
+		std::vector<Chunk>       chunks;
+		std::vector<math::vec3f> positions;
+		std::vector<math::vec3f> texCoords;
+		std::vector<math::vec3f> normals;
+		std::vector<std::vector<unsigned>> groupSlots; // sorted material slots used by the faces of each mesh
+		size_t                   numCorners   = 0;
+		size_t                   numTriangles = 0;
+		size_t                   fileSize     = 0;
+		bool                     hasNormals   = false;
+		ImportedScene            scene;
+		SwapType                 swap = SwapType::None;
+	};
+
+	// Imports the file with both the native loader and assimp and logs the timings and the resulting geometry sizes
+	void benchmarkObjImport(const std::string& filePath);
+}
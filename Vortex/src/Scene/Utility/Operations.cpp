@@ -7,6 +7,19 @@
 #include "Scene/Graph.h"
 #include "Scene/Scene.h"
 #include "Scene/Nodes/Shader/mdl/ShaderNodes.h"
+#include "Core/ThreadPool.h"
+#include "Core/Timer.h"
+#include "Core/Hashing.h"
+#include "Device/Structs/LightSelection.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <set>
+#include <stack>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace vtx::ops
 {
@@ -503,181 +516,1369 @@ namespace vtx::ops
 		//}
 	}
 
+	static constexpr size_t kernelBlockSize = 16384;
+
+	static size_t getNumberOfBlocks(const size_t count)
+	{
+		return (count + kernelBlockSize - 1) / kernelBlockSize;
+	}
+
+	// Faces adjacent to each vertex, in compressed rows. The corners are bucketed once by vertex range, each worker then
+	// fills the rows of its range from its bucket only, without atomics. Buckets keep the corner order so the faces of a
+	// vertex stay sorted (deterministic sums).
+	struct VertexFaceAdjacency
+	{
+		std::vector<uint32_t> offsets;
+		std::vector<uint32_t> faces;
+	};
+
+	static void buildVertexFaceAdjacency(const std::vector<vtxID>& indices, const size_t numVertices, VertexFaceAdjacency& adjacency)
+	{
+		const size_t numCorners = indices.size() - indices.size() % 3;
+		const size_t numRanges  = std::max<size_t>(std::min<size_t>(ThreadPool::get()->getNumberOfWorkers(), getNumberOfBlocks(numVertices)), 1);
+		const size_t rangeSize  = std::max<size_t>((numVertices + numRanges - 1) / numRanges, 1);
+		const size_t numBlocks  = getNumberOfBlocks(numCorners);
+
+		std::vector<size_t> bucketOffsets(numBlocks * numRanges, 0);
+		utl::parallelFor(numBlocks, [&](const size_t block)
+		{
+			size_t*      counts = bucketOffsets.data() + block * numRanges;
+			const size_t end    = std::min((block + 1) * kernelBlockSize, numCorners);
+			for (size_t c = block * kernelBlockSize; c < end; ++c)
+			{
+				if (indices[c] < numVertices)
+				{
+					++counts[indices[c] / rangeSize];
+				}
+			}
+		});
+
+		// Ranges first, so that the corners of a range are contiguous and in index order
+		std::vector<size_t> rangeOffsets(numRanges + 1, 0);
+		size_t              numValidCorners = 0;
+		for (size_t range = 0; range < numRanges; ++range)
+		{
+			rangeOffsets[range] = numValidCorners;
+			for (size_t block = 0; block < numBlocks; ++block)
+			{
+				const size_t count = bucketOffsets[block * numRanges + range];
+				bucketOffsets[block * numRanges + range] = numValidCorners;
+				numValidCorners += count;
+			}
+		}
+		rangeOffsets[numRanges] = numValidCorners;
+
+		std::vector<uint32_t> rangeCorners(numValidCorners);
+		utl::parallelFor(numBlocks, [&](const size_t block)
+		{
+			size_t*      offsets = bucketOffsets.data() + block * numRanges;
+			const size_t end     = std::min((block + 1) * kernelBlockSize, numCorners);
+			for (size_t c = block * kernelBlockSize; c < end; ++c)
+			{
+				if (indices[c] < numVertices)
+				{
+					rangeCorners[offsets[indices[c] / rangeSize]++] = (uint32_t)c;
+				}
+			}
+		});
+
+		adjacency.offsets.assign(numVertices + 1, 0);
+		adjacency.faces.resize(numValidCorners);
+		utl::parallelFor(numRanges, [&](const size_t range)
+		{
+			const size_t begin = std::min(range * rangeSize, numVertices);
+			const size_t end   = std::min(begin + rangeSize, numVertices);
+			for (size_t k = rangeOffsets[range]; k < rangeOffsets[range + 1]; ++k)
+			{
+				++adjacency.offsets[indices[rangeCorners[k]] + 1];
+			}
+
+			// Each range only writes offsets[begin + 1, end], the start of its first row is the range offset
+			std::vector<uint32_t> cursors(end - begin);
+			size_t                running = rangeOffsets[range];
+			for (size_t v = begin; v < end; ++v)
+			{
+				cursors[v - begin] = (uint32_t)running;
+				running += adjacency.offsets[v + 1];
+				adjacency.offsets[v + 1] = (uint32_t)running;
+			}
+			for (size_t k = rangeOffsets[range]; k < rangeOffsets[range + 1]; ++k)
+			{
+				const uint32_t corner = rangeCorners[k];
+				adjacency.faces[cursors[indices[corner] - begin]++] = corner / 3;
+			}
+		}, 1);
+	}
+
+	void TangentSpaceDiagnostics::add(const TangentSpaceDiagnostics& other)
+	{
+		zeroNormals += other.zeroNormals;
+		zeroTangents += other.zeroTangents;
+		zeroBitangents += other.zeroBitangents;
+		nanNormals += other.nanNormals;
+		nanTangents += other.nanTangents;
+		nanBitangents += other.nanBitangents;
+	}
+
+	size_t TangentSpaceDiagnostics::total() const
+	{
+		return zeroNormals + zeroTangents + zeroBitangents + nanNormals + nanTangents + nanBitangents;
+	}
+
+	// Runs faceKernel(face) on every triangle, then vertexKernel(vertex, faces, numFaces, diagnostics) on every vertex with
+	// the list of its adjacent triangles. Both passes run in blocks on the thread pool, diagnostics are summed per mesh.
+	template<typename FaceKernel, typename VertexKernel>
+	static TangentSpaceDiagnostics runTangentSpaceKernels(const std::vector<vtxID>& indices, const size_t numVertices, FaceKernel&& faceKernel, VertexKernel&& vertexKernel)
+	{
+		const size_t numFaces = indices.size() / 3;
+
+		utl::parallelFor(getNumberOfBlocks(numFaces), [&](const size_t block)
+		{
+			const size_t end = std::min((block + 1) * kernelBlockSize, numFaces);
+			for (size_t face = block * kernelBlockSize; face < end; ++face)
+			{
+				faceKernel(face);
+			}
+		});
+
+		VertexFaceAdjacency adjacency;
+		buildVertexFaceAdjacency(indices, numVertices, adjacency);
+
+		std::vector<TangentSpaceDiagnostics> blockDiagnostics(getNumberOfBlocks(numVertices));
+		utl::parallelFor(blockDiagnostics.size(), [&](const size_t block)
+		{
+			const size_t end = std::min((block + 1) * kernelBlockSize, numVertices);
+			for (size_t vertex = block * kernelBlockSize; vertex < end; ++vertex)
+			{
+				const uint32_t first = adjacency.offsets[vertex];
+				vertexKernel(vertex, adjacency.faces.data() + first, adjacency.offsets[vertex + 1] - first, blockDiagnostics[block]);
+			}
+		});
+
+		TangentSpaceDiagnostics diagnostics;
+		for (const TangentSpaceDiagnostics& block : blockDiagnostics)
+		{
+			diagnostics.add(block);
+		}
+		return diagnostics;
+	}
+
+	static void reportDiagnostics(const vtxID meshId, const size_t numVertices, const TangentSpaceDiagnostics& diagnostics)
+	{
+		if (diagnostics.total() == 0)
+		{
+			return;
+		}
+		VTX_WARN("Mesh {}: degenerate vertices replaced by a default frame, zero normals {}, zero tangents {}, zero bitangents {}, "
+				 "nan normals {}, nan tangents {}, nan bitangents {} (of {} vertices)",
+				 meshId, diagnostics.zeroNormals, diagnostics.zeroTangents, diagnostics.zeroBitangents,
+				 diagnostics.nanNormals, diagnostics.nanTangents, diagnostics.nanBitangents, numVertices);
+	}
+
+	static math::vec3f computeFaceNormal(const Mesh& mesh, const size_t face)
+	{
+		const math::vec3f& p0 = mesh.vertices[mesh.indices[face * 3]].position;
+		const math::vec3f& p1 = mesh.vertices[mesh.indices[face * 3 + 1]].position;
+		const math::vec3f& p2 = mesh.vertices[mesh.indices[face * 3 + 2]].position;
+		return math::normalize(cross(p1 - p0, p2 - p0));
+	}
+
 	void computeVertexNormals(std::shared_ptr<Mesh> mesh)
 	{
-		//VTX_INFO("Computing vertex normals Mesh {}", mesh->getUID());
-		//std::vector<VertexAttributes>& vertices = mesh->vertices;
-		//std::vector<vtxID>& indices = mesh->indices;
-		//// Initialize normals, tangents, and bitangents to zero
-		//for (auto& vertex : mesh->vertices)
-		//{
-		//    vertex.normal = math::vec3f(0.0f, 0.0f, 0.0f);
-		//}
+		Timer timer;
+		std::vector<math::vec3f> faceNormals(mesh->indices.size() / 3);
 
-		//for (size_t i = 0; i < indices.size(); i += 3)
-		//{
-		//    const int                   faceIndex = i / 3;
-		//    const FaceAttributes& faceAttr = mesh->faceAttributes[faceIndex];
+		const TangentSpaceDiagnostics diagnostics = runTangentSpaceKernels(mesh->indices, mesh->vertices.size(),
+			[&](const size_t face)
+			{
+				faceNormals[face] = computeFaceNormal(*mesh, face);
+			},
+			[&](const size_t vertex, const uint32_t* faces, const size_t numFaces, TangentSpaceDiagnostics& vertexDiagnostics)
+			{
+				math::vec3f n(0.0f);
+				for (size_t i = 0; i < numFaces; ++i)
+				{
+					n += faceNormals[faces[i]];
+				}
+				if (math::isZero(n))
+				{
+					n = math::vec3f(0.0f, 0.0f, 1.0f);
+					++vertexDiagnostics.zeroNormals;
+				}
+				n = math::normalize(n);
+				if (math::isNan(n))
+				{
+					n = math::vec3f(0.0f, 0.0f, 1.0f);
+					++vertexDiagnostics.nanNormals;
+				}
+				mesh->vertices[vertex].normal = n;
+			});
 
-		//    // Get triangle mesh->vertices
-		//    VertexAttributes& v0 = vertices[indices[i]];
-		//    VertexAttributes& v1 = vertices[indices[i + 1]];
-		//    VertexAttributes& v2 = vertices[indices[i + 2]];
-		//    // Compute edges
-		//    math::vec3f e1 = v1.position - v0.position;
-		//    math::vec3f e2 = v2.position - v0.position;
+		reportDiagnostics(mesh->getUID(), mesh->vertices.size(), diagnostics);
+		mesh->status.hasNormals = true;
+		VTX_INFO("Computed vertex normals for Mesh {} ({} vertices) in {} ms", mesh->getUID(), mesh->vertices.size(), timer.elapsedMillis());
+	}
 
-		//    // Compute face normal
-		//    math::vec3f normal = cross(e1, e2);
-		//    normal = math::normalize(normal);
+	// Tangent space of the vertex arrays, shared by the in place computation and the background preparation
+	static TangentSpaceDiagnostics computeTangentFrames(std::vector<VertexAttributes>& vertices, const std::vector<vtxID>& indices, const bool keepNormals)
+	{
+		const size_t             numFaces = indices.size() / 3;
+		std::vector<math::vec3f> faceNormals(numFaces);
+		std::vector<math::vec3f> faceTangents(numFaces);
+		std::vector<math::vec3f> faceBitangents(numFaces);
 
-		//    // Accumulate normals, tangents, and bitangents at each vertex
-		//    v0.normal += normal;
-		//    v1.normal += normal;
-		//    v2.normal += normal;
-		//}
+		return runTangentSpaceKernels(indices, vertices.size(),
+			[&](const size_t face)
+			{
+				const VertexAttributes& v0 = vertices[indices[face * 3]];
+				const VertexAttributes& v1 = vertices[indices[face * 3 + 1]];
+				const VertexAttributes& v2 = vertices[indices[face * 3 + 2]];
+
+				// Compute edges and face normal
+				const math::vec3f e1     = v1.position - v0.position;
+				const math::vec3f e2     = v2.position - v0.position;
+				const math::vec3f normal = math::normalize(cross(e1, e2));
+
+				// Compute UV deltas
+				math::vec3f deltaUv1 = v1.texCoord - v0.texCoord;
+				math::vec3f deltaUv2 = v2.texCoord - v0.texCoord;
+				if (
+					deltaUv1 == deltaUv2 ||
+					math::isZero(deltaUv1) || math::isZero(deltaUv2) ||
+					math::isZero(cross(deltaUv1, deltaUv2)))
+				{
+					deltaUv1 = math::vec3f(1.0f, 0.0f, 0.0f);
+					deltaUv2 = math::vec3f(0.0f, 1.0f, 0.0f);
+				}
 
-		//// Normalize and orthogonalize vertex normals and tangents
-		//for (auto& vertex : vertices)
-		//{
-		//    vertex.normal = math::normalize(vertex.normal);
-		//}
-		//mesh->status.hasNormals = true;
+				// Compute tangent and bitangent
+				const float determinant = deltaUv1.x * deltaUv2.y - deltaUv1.y * deltaUv2.x;
+				const float f           = 1.0f / determinant;
+				math::vec3f tangent     = (e1 * deltaUv2.y - e2 * deltaUv1.y) * f;
+				math::vec3f bitangent   = cross(normal, tangent);
+				if (determinant < 0.0f)
+				{
+					tangent *= -1.0f;
+				}
+				const float handedness = (dot(cross(normal, tangent), bitangent) < 0.0f) ? -1.0f : 1.0f;
+				bitangent *= handedness;
+
+				faceNormals[face]    = normal;
+				faceTangents[face]   = tangent;
+				faceBitangents[face] = bitangent;
+			},
+			[&](const size_t vertex, const uint32_t* faces, const size_t numAdjacentFaces, TangentSpaceDiagnostics& vertexDiagnostics)
+			{
+				// Accumulate normals, tangents, and bitangents of the adjacent faces
+				math::vec3f n(0.0f);
+				math::vec3f t(0.0f);
+				math::vec3f b(0.0f);
+				for (size_t i = 0; i < numAdjacentFaces; ++i)
+				{
+					n += faceNormals[faces[i]];
+					t += faceTangents[faces[i]];
+					b += faceBitangents[faces[i]];
+				}
+
+				if (keepNormals && !math::isZero(vertices[vertex].normal))
+				{
+					n = vertices[vertex].normal;
+				}
+				if (math::isZero(n))
+				{
+					n = math::vec3f(0.0f, 0.0f, 1.0f);
+					++vertexDiagnostics.zeroNormals;
+				}
+				if (math::isZero(t))
+				{
+					t = math::vec3f(1.0f, 0.0f, 0.0f);
+					++vertexDiagnostics.zeroTangents;
+				}
+				if (math::isZero(b))
+				{
+					b = math::vec3f(0.0f, 1.0f, 0.0f);
+					++vertexDiagnostics.zeroBitangents;
+				}
+
+				// Normalize and orthogonalize
+				n = math::normalize(n);
+				if (math::isNan(n))
+				{
+					n = math::vec3f(0.0f, 0.0f, 1.0f);
+					++vertexDiagnostics.nanNormals;
+				}
+				t -= n * dot(n, t);
+				t = math::normalize(t);
+				b -= n * dot(n, b);
+				b = math::normalize(b);
+				if (math::isNan(t))
+				{
+					t = math::vec3f(1.0f, 0.0f, 0.0f);
+					++vertexDiagnostics.nanTangents;
+				}
+				if (math::isNan(b))
+				{
+					b = math::vec3f(0.0f, 1.0f, 0.0f);
+					++vertexDiagnostics.nanBitangents;
+				}
+
+				VertexAttributes& attributes = vertices[vertex];
+				attributes.normal            = n;
+				attributes.tangent           = t;
+				attributes.bitangent         = b;
+			});
 	}
 
-	void computeVertexTangentSpace(const std::shared_ptr<Mesh>& mesh)
+	void computeVertexTangentSpace(const std::shared_ptr<Mesh>& mesh, const bool keepNormals)
 	{
-		VTX_INFO("Computing vertex tangents Space for Mesh {}", mesh->getUID());
-		std::vector<VertexAttributes>& vertices = mesh->vertices;
-		std::vector<vtxID>& indices = mesh->indices;
-		// Initialize normals, tangents, and bitangents to zero
-		for (auto& vertex : vertices)
+		Timer timer;
+		const TangentSpaceDiagnostics diagnostics = computeTangentFrames(mesh->vertices, mesh->indices, keepNormals);
+		reportDiagnostics(mesh->getUID(), mesh->vertices.size(), diagnostics);
+		mesh->status.hasTangents = true;
+		mesh->status.hasNormals  = true;
+		VTX_INFO("Computed vertex tangent space for Mesh {} ({} vertices) in {} ms", mesh->getUID(), mesh->vertices.size(), timer.elapsedMillis());
+	}
+
+	static std::atomic<size_t> queuedMeshes{ 0 };
+	static std::atomic<size_t> preparedMeshes{ 0 };
+	static std::atomic<size_t> queuedVertices{ 0 };
+	static std::atomic<size_t> preparedVertices{ 0 };
+
+	// Meshes prepared on the thread pool wait here until the main thread publishes their arrays
+	static std::mutex                                               preparedMeshesMutex;
+	static std::vector<std::pair<std::shared_ptr<Mesh>, MeshPayload>> pendingMeshes;
+
+	void prepareMesh(const std::shared_ptr<Mesh>& mesh)
+	{
+		// Meshes restored from a saved scene read their arrays on first access
+		if (!mesh->loadPayload())
+		{
+			return;
+		}
+		if (!mesh->status.hasFaceAttributes)
+		{
+			computeFaceAttributes(mesh);
+			mesh->status.hasFaceAttributes = true;
+		}
+		if (!mesh->status.hasNormals)
+		{
+			// The tangent space pass computes the normals as well
+			computeVertexTangentSpace(mesh);
+		}
+		else if (!mesh->status.hasTangents)
+		{
+			// Normals coming from the file are kept
+			computeVertexTangentSpace(mesh, true);
+		}
+	}
+
+	void prepareMeshAsync(const std::shared_ptr<Mesh>& mesh)
+	{
+		bool expected = false;
+		if (!mesh->isPreparing.compare_exchange_strong(expected, true))
+		{
+			return;
+		}
+
+		// The arrays are copied here, on the main thread or in a traversal it waits for, since it edits them without locks.
+		// Deferred arrays are read on the thread pool from their source, which doesn't change.
+		auto                                     snapshot = std::make_shared<MeshPayload>();
+		std::shared_ptr<const MeshPayloadSource> source;
+		if (!mesh->copyPayload(*snapshot, source))
+		{
+			mesh->isPreparing.store(false);
+			return;
+		}
+		++queuedMeshes;
+		queuedVertices += mesh->vertices.size();
+
+		ThreadPool::get()->submit([mesh, snapshot, source]()
+		{
+			// The mesh itself is left untouched, the gui and the saves keep reading it while the copy is prepared
+			MeshPayload payload = std::move(*snapshot);
+			if (source && !mesh->readPayload(source, payload))
+			{
+				mesh->isPreparing.store(false);
+				return;
+			}
+			payload.status.hasFaceAttributes = true;
+			if (!payload.status.hasNormals || !payload.status.hasTangents)
+			{
+				Timer timer;
+				const TangentSpaceDiagnostics diagnostics = computeTangentFrames(payload.vertices, payload.indices, payload.status.hasNormals);
+				reportDiagnostics(mesh->getUID(), payload.vertices.size(), diagnostics);
+				payload.status.hasNormals  = true;
+				payload.status.hasTangents = true;
+				VTX_INFO("Computed vertex tangent space for Mesh {} ({} vertices) in {} ms", mesh->getUID(), payload.vertices.size(), timer.elapsedMillis());
+			}
+
+			const size_t numVertices = payload.vertices.size();
+			{
+				std::lock_guard<std::mutex> lock(preparedMeshesMutex);
+				pendingMeshes.emplace_back(mesh, std::move(payload));
+			}
+
+			const size_t prepared = ++preparedMeshes;
+			preparedVertices += numVertices;
+			const MeshPreparationProgress progress = getMeshPreparationProgress();
+			VTX_INFO("Mesh preparation: {} / {} meshes, {} / {} vertices", prepared, progress.queuedMeshes, progress.preparedVertices, progress.queuedVertices);
+		});
+	}
+
+	void publishPreparedMeshes()
+	{
+		std::vector<std::pair<std::shared_ptr<Mesh>, MeshPayload>> prepared;
+		{
+			std::lock_guard<std::mutex> lock(preparedMeshesMutex);
+			prepared.swap(pendingMeshes);
+		}
+		for (auto& [mesh, payload] : prepared)
+		{
+			mesh->publishPayload(std::move(payload));
+			mesh->state.updateOnDevice = true;
+			mesh->isPreparing.store(false);
+		}
+	}
+
+	MeshPreparationProgress getMeshPreparationProgress()
+	{
+		MeshPreparationProgress progress;
+		progress.queuedMeshes     = queuedMeshes.load();
+		progress.preparedMeshes   = preparedMeshes.load();
+		progress.queuedVertices   = queuedVertices.load();
+		progress.preparedVertices = preparedVertices.load();
+		return progress;
+	}
+
+	bool isNodePoolEnabled()
+	{
+		return getOptions()->pooledNodeAllocation;
+	}
+
+	void releaseNodes(std::vector<std::shared_ptr<Node>> roots)
+	{
+		// Parents come before their children, a released parent only drops references to nodes still held here
+		std::vector<std::shared_ptr<Node>> nodes;
+		std::unordered_set<vtxID>          visited;
+		std::vector<std::shared_ptr<Node>> stack(roots.rbegin(), roots.rend());
+		roots.clear();
+		while (!stack.empty())
+		{
+			std::shared_ptr<Node> node = std::move(stack.back());
+			stack.pop_back();
+			if (!node || !visited.insert(node->getUID()).second)
+			{
+				continue;
+			}
+			const std::vector<std::shared_ptr<Node>> children = node->getChildren();
+			stack.insert(stack.end(), children.rbegin(), children.rend());
+			nodes.push_back(std::move(node));
+		}
+
+		const std::shared_ptr<SceneIndexManager> sim = Scene::getSim();
+		sim->beginBulkRelease();
+		Timer  timer;
+		size_t destroyed = 0;
+		for (std::shared_ptr<Node>& node : nodes)
+		{
+			destroyed += node.use_count() == 1 ? 1 : 0;
+			node.reset();
+		}
+		sim->endBulkRelease();
+		utl::BlockPool::trimAll();
+		VTX_INFO("Released {} nodes, {} destroyed in {:.1f} ms", nodes.size(), destroyed, timer.elapsedMillis());
+	}
+
+	void benchmarkNodeAllocation(const size_t numNodes)
+	{
+		// Every group brings its transform, groups are attached eight per parent
+		constexpr size_t branching = 8;
+		const size_t numGroups = std::max<size_t>(1, numNodes / 2);
+
+		bool&      isPooled  = getOptions()->pooledNodeAllocation;
+		const bool wasPooled = isPooled;
+		for (const bool pooled : { false, true })
+		{
+			isPooled = pooled;
+
+			Timer timer;
+			std::vector<std::shared_ptr<Group>> groups(numGroups);
+			for (size_t i = 0; i < numGroups; ++i)
+			{
+				groups[i] = createNode<Group>();
+				if (i > 0)
+				{
+					groups[(i - 1) / branching]->addChild(groups[i]);
+				}
+			}
+			const float createTime = timer.elapsedMillis();
+
+			std::shared_ptr<Node> root = groups[0];
+			groups.clear();
+			timer.reset();
+			releaseNodes({ std::move(root) });
+			const float releaseTime = timer.elapsedMillis();
+
+			VTX_INFO("Node allocation benchmark, {} nodes with {}: create {:.1f} ms, release {:.1f} ms",
+					 numGroups * 2, pooled ? "node pools" : "individual allocations", createTime, releaseTime);
+		}
+		isPooled = wasPooled;
+	}
+
+	graph::CompactVertexBounds computeCompactVertexBounds(const std::shared_ptr<Mesh>& mesh)
+	{
+		graph::CompactVertexBounds bounds;
+		if (mesh->vertices.empty())
+		{
+			return bounds;
+		}
+
+		std::vector<math::vec3f> blockMin(getNumberOfBlocks(mesh->vertices.size()), math::vec3f(FLT_MAX));
+		std::vector<math::vec3f> blockMax(blockMin.size(), math::vec3f(-FLT_MAX));
+		utl::parallelFor(blockMin.size(), [&](const size_t block)
+		{
+			const size_t end = std::min((block + 1) * kernelBlockSize, mesh->vertices.size());
+			for (size_t v = block * kernelBlockSize; v < end; ++v)
+			{
+				blockMin[block] = min(blockMin[block], mesh->vertices[v].position);
+				blockMax[block] = max(blockMax[block], mesh->vertices[v].position);
+			}
+		});
+
+		math::vec3f boundsMax(-FLT_MAX);
+		bounds.min = math::vec3f(FLT_MAX);
+		for (size_t block = 0; block < blockMin.size(); ++block)
+		{
+			bounds.min = min(bounds.min, blockMin[block]);
+			boundsMax  = max(boundsMax, blockMax[block]);
+		}
+		bounds.extent = boundsMax - bounds.min;
+		return bounds;
+	}
+
+	void encodeCompactVertices(const std::shared_ptr<Mesh>& mesh, const graph::CompactVertexBounds& bounds, std::vector<graph::CompactVertexAttributes>& compactVertices)
+	{
+		compactVertices.resize(mesh->vertices.size());
+		utl::parallelFor(getNumberOfBlocks(mesh->vertices.size()), [&](const size_t block)
+		{
+			const size_t end = std::min((block + 1) * kernelBlockSize, mesh->vertices.size());
+			for (size_t v = block * kernelBlockSize; v < end; ++v)
+			{
+				compactVertices[v] = graph::encodeVertex(mesh->vertices[v], bounds);
+			}
+		});
+	}
+
+	VertexMemoryReport reportVertexMemory(const std::vector<std::shared_ptr<Mesh>>& meshes)
+	{
+		VertexMemoryReport report;
+		std::set<Mesh*>    visited;
+		for (const std::shared_ptr<Mesh>& mesh : meshes)
+		{
+			if (mesh == nullptr || !visited.insert(mesh.get()).second)
+			{
+				continue;
+			}
+			const bool shortIndices = hasShortIndices(mesh->vertices.size());
+			++report.meshes;
+			report.shortIndexMeshes += shortIndices ? 1 : 0;
+			report.vertices += mesh->vertices.size();
+			report.indices += mesh->indices.size();
+			report.fullBytes += mesh->vertices.size() * sizeof(graph::VertexAttributes) + mesh->indices.size() * sizeof(vtxID);
+			report.compactBytes += mesh->vertices.size() * sizeof(graph::CompactVertexAttributes) + mesh->indices.size() * (shortIndices ? sizeof(uint16_t) : sizeof(vtxID));
+		}
+
+		constexpr double megaByte = 1024.0 * 1024.0;
+		VTX_INFO("Vertex memory: {} meshes, {} vertices, {} indices. Full layout {:.1f} MB, compact layout {:.1f} MB ({:.1f}%), {} meshes with 16 bit indices",
+				 report.meshes, report.vertices, report.indices, (double)report.fullBytes / megaByte, (double)report.compactBytes / megaByte,
+				 report.fullBytes > 0 ? 100.0 * (double)report.compactBytes / (double)report.fullBytes : 0.0, report.shortIndexMeshes);
+		return report;
+	}
+
+	// Prefix sums over the deficits (1 - q) of the light entries or the surpluses (q - 1) of the heavy ones.
+	// Only one value per block is stored, the rest is accumulated from the block start. The workers walk the lists with
+	// the same accumulation order, so the split points found by the binary search match the sweep bit for bit.
+	struct AliasPrefixSums
+	{
+		static constexpr size_t blockSize = 1024;
+
+		// The q of the heavy entries in the table are overwritten during the sweep, the terms use a copy
+		std::vector<float>  values;
+		double              sign;
+		std::vector<double> blockSums;
+
+		AliasPrefixSums(const std::vector<AliasData>& table, const std::vector<uint32_t>& entries, const double sign) :
+			values(entries.size()), sign(sign)
+		{
+			std::vector<double> partialSums((entries.size() + blockSize - 1) / blockSize);
+			utl::parallelFor(partialSums.size(), [&](const size_t block)
+			{
+				const size_t end = std::min((block + 1) * blockSize, entries.size());
+				double       sum = 0.0;
+				for (size_t i = block * blockSize; i < end; ++i)
+				{
+					values[i] = table[entries[i]].q;
+					sum += term(i);
+				}
+				partialSums[block] = sum;
+			}, 16);
+
+			blockSums.resize(partialSums.size() + 1);
+			blockSums[0] = 0.0;
+			for (size_t block = 0; block < partialSums.size(); ++block)
+			{
+				blockSums[block + 1] = blockSums[block] + partialSums[block];
+			}
+		}
+
+		double term(const size_t i) const
+		{
+			return sign * ((double)values[i] - 1.0);
+		}
+
+		// Sum of the first i terms
+		double at(const size_t i) const
+		{
+			const size_t block   = i / blockSize;
+			double       partial = 0.0;
+			for (size_t k = block * blockSize; k < i; ++k)
+			{
+				partial += term(k);
+			}
+			return blockSums[block] + partial;
+		}
+	};
+
+	// Incremental version of AliasPrefixSums::at
+	struct AliasPrefixCursor
+	{
+		const AliasPrefixSums& sums;
+		size_t                 position;
+		double                 partial = 0.0;
+
+		AliasPrefixCursor(const AliasPrefixSums& sums, const size_t position) : sums(sums), position(position)
+		{
+			for (size_t k = position / AliasPrefixSums::blockSize * AliasPrefixSums::blockSize; k < position; ++k)
+			{
+				partial += sums.term(k);
+			}
+		}
+
+		double value() const
+		{
+			return sums.blockSums[position / AliasPrefixSums::blockSize] + partial;
+		}
+
+		void advance()
+		{
+			partial += sums.term(position);
+			++position;
+			if (position % AliasPrefixSums::blockSize == 0)
+			{
+				partial = 0.0;
+			}
+		}
+	};
+
+	double buildAliasMap(const std::vector<float>& weights, std::vector<AliasData>& aliasMap)
+	{
+		const size_t size = weights.size();
+		aliasMap.resize(size);
+		if (size == 0)
+		{
+			return 0.0;
+		}
+
+		const size_t        numBlocks = getNumberOfBlocks(size);
+		std::vector<double> blockSums(numBlocks);
+		utl::parallelFor(numBlocks, [&](const size_t block)
 		{
-			vertex.normal = math::vec3f(0.0f, 0.0f, 0.0f);
-			vertex.tangent = math::vec3f(0.0f, 0.0f, 0.0f);
-			vertex.bitangent = math::vec3f(0.0f, 0.0f, 0.0f);
+			const size_t end = std::min((block + 1) * kernelBlockSize, size);
+			double       sum = 0.0;
+			for (size_t i = block * kernelBlockSize; i < end; ++i)
+			{
+				sum += weights[i];
+			}
+			blockSums[block] = sum;
+		});
+		double sum = 0.0;
+		for (const double blockSum : blockSums)
+		{
+			sum += blockSum;
 		}
 
-		for (size_t i = 0; i < indices.size(); i += 3)
+		// Normalized weights (the mean of q is one) and partition in light (q < 1) and heavy entries, both kept in index order
+		std::vector<size_t> blockLights(numBlocks + 1, 0);
+		utl::parallelFor(numBlocks, [&](const size_t block)
+		{
+			const size_t end    = std::min((block + 1) * kernelBlockSize, size);
+			size_t       lights = 0;
+			for (size_t i = block * kernelBlockSize; i < end; ++i)
+			{
+				AliasData& entry = aliasMap[i];
+				entry.pdf        = sum > 0.0 ? (float)((double)weights[i] / sum) : 1.0f / (float)size;
+				entry.q          = sum > 0.0 ? (float)((double)size * (double)weights[i] / sum) : 1.0f;
+				entry.alias      = (unsigned)i;
+				lights += entry.q < 1.0f ? 1 : 0;
+			}
+			blockLights[block + 1] = lights;
+		});
+		for (size_t block = 0; block < numBlocks; ++block)
+		{
+			blockLights[block + 1] += blockLights[block];
+		}
+
+		const size_t numLights = blockLights[numBlocks];
+		const size_t numHeavy  = size - numLights;
+		if (numHeavy == 0)
+		{
+			// Only reachable through rounding, every entry is within float precision of one
+			for (AliasData& entry : aliasMap)
+			{
+				entry.q = 1.0f;
+			}
+			return sum;
+		}
+
+		std::vector<uint32_t> lights(numLights);
+		std::vector<uint32_t> heavy(numHeavy);
+		utl::parallelFor(numBlocks, [&](const size_t block)
+		{
+			const size_t begin      = block * kernelBlockSize;
+			const size_t end        = std::min(begin + kernelBlockSize, size);
+			size_t       lightIndex = blockLights[block];
+			size_t       heavyIndex = begin - lightIndex;
+			for (size_t i = begin; i < end; ++i)
+			{
+				if (aliasMap[i].q < 1.0f)
+				{
+					lights[lightIndex++] = (uint32_t)i;
+				}
+				else
+				{
+					heavy[heavyIndex++] = (uint32_t)i;
+				}
+			}
+		});
+
+		// The sweep takes the next light entry while the current heavy one still has more than one unit of weight,
+		// i.e. light i is paired before heavy j is closed when deficit(i) < surplus(j + 1). This is the merge of the two
+		// prefix sum sequences, the last heavy entry closes after every light one.
+		const AliasPrefixSums deficits(aliasMap, lights, -1.0);
+		const AliasPrefixSums surpluses(aliasMap, heavy, 1.0);
+		auto heavyKey = [&](const size_t j)
+		{
+			return j + 1 >= numHeavy ? std::numeric_limits<double>::infinity() : surpluses.at(j + 1);
+		};
+
+		// Number of light entries among the first step entries of the sweep
+		auto findSplit = [&](const size_t step)
+		{
+			size_t low  = step > numHeavy ? step - numHeavy : 0;
+			size_t high = std::min(step, numLights);
+			while (low < high)
+			{
+				const size_t i = (low + high + 1) / 2;
+				if (deficits.at(i - 1) < heavyKey(step - i))
+				{
+					low = i;
+				}
+				else
+				{
+					high = i - 1;
+				}
+			}
+			return low;
+		};
+
+		const size_t numRanges = std::max<size_t>(std::min<size_t>(4 * ThreadPool::get()->getNumberOfWorkers(), numBlocks), 1);
+		utl::parallelFor(numRanges, [&](const size_t range)
+		{
+			const size_t stepBegin = size * range / numRanges;
+			const size_t stepEnd   = size * (range + 1) / numRanges;
+			const size_t i         = findSplit(stepBegin);
+			const size_t j         = stepBegin - i;
+
+			AliasPrefixCursor deficit(deficits, i);
+			AliasPrefixCursor surplus(surpluses, std::min(j + 1, numHeavy));
+			size_t            heavyIndex = j;
+			for (size_t step = stepBegin; step < stepEnd; ++step)
+			{
+				const double key = heavyIndex + 1 >= numHeavy ? std::numeric_limits<double>::infinity() : surplus.value();
+				if (deficit.position < numLights && deficit.value() < key)
+				{
+					aliasMap[lights[deficit.position]].alias = heavy[heavyIndex];
+					deficit.advance();
+				}
+				else
+				{
+					AliasData& entry = aliasMap[heavy[heavyIndex]];
+					if (heavyIndex + 1 >= numHeavy)
+					{
+						entry.q     = 1.0f;
+						entry.alias = heavy[heavyIndex];
+					}
+					else
+					{
+						// What is left of the heavy entry after the lights it covered, the next heavy entry fills the rest
+						entry.q     = (float)std::clamp(1.0 + key - deficit.value(), 0.0, 1.0);
+						entry.alias = heavy[heavyIndex + 1];
+						surplus.advance();
+					}
+					++heavyIndex;
+				}
+			}
+		});
+
+		return sum;
+	}
+
+	// Cell of the position grid used to find weld candidates. The cells are as large as the position tolerance, so two
+	// vertices within tolerance are in the same cell or in adjacent ones.
+	struct WeldCell
+	{
+		int64_t x, y, z;
+
+		bool operator==(const WeldCell& other) const
 		{
-			// Get triangle mesh->vertices
-			VertexAttributes& v0 = vertices[indices[i]];
-			VertexAttributes& v1 = vertices[indices[i + 1]];
-			VertexAttributes& v2 = vertices[indices[i + 2]];
+			return x == other.x && y == other.y && z == other.z;
+		}
+	};
 
+	struct WeldCellHasher
+	{
+		size_t operator()(const WeldCell& cell) const
+		{
+			return (size_t)utl::hashBytes(&cell, sizeof(WeldCell));
+		}
+	};
 
-			// Compute edges
-			math::vec3f e1 = v1.position - v0.position;
-			math::vec3f e2 = v2.position - v0.position;
+	static WeldCell computeWeldCell(const math::vec3f& position, const float invTolerance)
+	{
+		return { (int64_t)std::floor(position.x * invTolerance), (int64_t)std::floor(position.y * invTolerance), (int64_t)std::floor(position.z * invTolerance) };
+	}
 
-			// Compute face normal
-			math::vec3f normal = cross(e1, e2);
-			normal = math::normalize(normal);
+	static bool isWithin(const float a, const float b, const float tolerance)
+	{
+		return std::abs(a - b) <= tolerance;
+	}
 
-			// Update face attributes
-			//FaceAttributes faceAttr;
+	static bool isWeldable(const VertexAttributes& a, const VertexAttributes& b, const WeldTolerances& tolerances, const bool useTangentSpace)
+	{
+		for (int i = 0; i < 3; ++i)
+		{
+			if (!isWithin(a.position[i], b.position[i], tolerances.position) || !isWithin(a.normal[i], b.normal[i], tolerances.normal))
+			{
+				return false;
+			}
+		}
+		if (!isWithin(a.texCoord.x, b.texCoord.x, tolerances.texCoord) || !isWithin(a.texCoord.y, b.texCoord.y, tolerances.texCoord))
+		{
+			return false;
+		}
+		// Mirrored uv islands share position, normal and uv along the seam but not the tangent frame orientation
+		return !useTangentSpace ||
+			(dot(cross(a.normal, a.tangent), a.bitangent) < 0.0f) == (dot(cross(b.normal, b.tangent), b.bitangent) < 0.0f);
+	}
 
-			// Compute UV deltas
-			math::vec3f deltaUv1 = v1.texCoord - v0.texCoord;
-			math::vec3f deltaUv2 = v2.texCoord - v0.texCoord;
+	// Tipsify, Sander et al. "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"
+	static std::vector<vtxID> tipsifyTriangleOrder(const std::vector<vtxID>& indices, const size_t numVertices, const int cacheSize = 16)
+	{
+		const size_t numTriangles = indices.size() / 3;
 
-			if (
-				deltaUv1 == deltaUv2 ||
-				math::isZero(deltaUv1) || math::isZero(deltaUv2) ||
-				math::isZero(cross(deltaUv1, deltaUv2)))
+		// Vertex to triangle adjacency in compressed rows
+		std::vector<uint32_t> adjacencyOffsets(numVertices + 1, 0);
+		for (const vtxID index : indices)
+		{
+			++adjacencyOffsets[index + 1];
+		}
+		for (size_t v = 0; v < numVertices; ++v)
+		{
+			adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+		}
+		std::vector<uint32_t> liveTriangles(numVertices);
+		for (size_t v = 0; v < numVertices; ++v)
+		{
+			liveTriangles[v] = adjacencyOffsets[v + 1] - adjacencyOffsets[v];
+		}
+		std::vector<uint32_t> adjacency(indices.size());
+		{
+			std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t i = 0; i < indices.size(); ++i)
 			{
-				deltaUv1 = math::vec3f(1.0f, 0.0f, 0.0f);
-				deltaUv2 = math::vec3f(0.0f, 1.0f, 0.0f);
+				adjacency[fill[indices[i]]++] = (uint32_t)(i / 3);
 			}
+		}
 
-			// Compute tangent and bitangent
-			float determinant = deltaUv1.x * deltaUv2.y - deltaUv1.y * deltaUv2.x;
-			float f           = 1.0f / determinant;
-			math::vec3f tangent = (e1 * deltaUv2.y - e2 * deltaUv1.y) * f;
+		std::vector<int64_t> cacheTimeStamps(numVertices, 0);
+		std::vector<bool>    emitted(numTriangles, false);
+		std::vector<vtxID>   deadEnd;
+		std::vector<vtxID>   candidates;
+		std::vector<vtxID>   triangleOrder;
+		triangleOrder.reserve(numTriangles);
 
-			math::vec3f bitangent;
-			bitangent = cross(normal, tangent);
+		int64_t time   = cacheSize + 1;
+		size_t  cursor = 0;
 
-			if (determinant < 0.0f)
+		auto skipDeadEnd = [&]() -> int64_t
+		{
+			while (!deadEnd.empty())
 			{
-				tangent *= -1.0f;
+				const vtxID vertex = deadEnd.back();
+				deadEnd.pop_back();
+				if (liveTriangles[vertex] > 0)
+				{
+					return vertex;
+				}
+			}
+			while (cursor < numVertices)
+			{
+				if (liveTriangles[cursor] > 0)
+				{
+					return (int64_t)cursor;
+				}
+				++cursor;
 			}
+			return -1;
+		};
 
-			float handedness = (dot(cross(normal, tangent), bitangent) < 0.0f) ? -1.0f : 1.0f;
-			bitangent *= handedness;
+		int64_t fanningVertex = skipDeadEnd();
+		while (fanningVertex >= 0)
+		{
+			candidates.clear();
+			for (uint32_t a = adjacencyOffsets[fanningVertex]; a < adjacencyOffsets[fanningVertex + 1]; ++a)
+			{
+				const uint32_t triangle = adjacency[a];
+				if (emitted[triangle])
+				{
+					continue;
+				}
+				for (int k = 0; k < 3; ++k)
+				{
+					const vtxID vertex = indices[triangle * 3 + k];
+					deadEnd.push_back(vertex);
+					candidates.push_back(vertex);
+					--liveTriangles[vertex];
+					if (time - cacheTimeStamps[vertex] > cacheSize)
+					{
+						cacheTimeStamps[vertex] = time++;
+					}
+				}
+				emitted[triangle] = true;
+				triangleOrder.push_back(triangle);
+			}
 
-			// Accumulate normals, tangents, and bitangents at each vertex
-			v0.normal += normal;
-			v1.normal += normal;
-			v2.normal += normal;
+			// Prefer the candidate which will still be in cache once all its remaining triangles are emitted
+			int64_t nextVertex   = -1;
+			int64_t bestPriority = -1;
+			for (const vtxID vertex : candidates)
+			{
+				if (liveTriangles[vertex] == 0)
+				{
+					continue;
+				}
+				int64_t priority = 0;
+				if (time - cacheTimeStamps[vertex] + 2 * (int64_t)liveTriangles[vertex] <= cacheSize)
+				{
+					priority = time - cacheTimeStamps[vertex];
+				}
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					nextVertex   = vertex;
+				}
+			}
+			fanningVertex = (nextVertex >= 0) ? nextVertex : skipDeadEnd();
+		}
+		return triangleOrder;
+	}
 
-			v0.tangent += tangent;
-			v1.tangent += tangent;
-			v2.tangent += tangent;
+	WeldingStats weldMeshVertices(const std::shared_ptr<Mesh>& mesh, const WeldTolerances& tolerances)
+	{
+		WeldingStats stats;
+		std::vector<VertexAttributes>& vertices = mesh->vertices;
+		std::vector<vtxID>&            indices  = mesh->indices;
+		stats.verticesBefore = vertices.size();
+		stats.bytesBefore    = vertices.size() * sizeof(VertexAttributes) + indices.size() * sizeof(vtxID);
 
-			v0.bitangent += bitangent;
-			v1.bitangent += bitangent;
-			v2.bitangent += bitangent;
+		if (vertices.empty() || indices.size() < 3)
+		{
+			stats.verticesAfter = stats.verticesBefore;
+			stats.bytesAfter    = stats.bytesBefore;
+			return stats;
 		}
 
-		// Normalize and orthogonalize vertex normals and tangents
-		int i = 0;
-		for (auto& vertex : vertices)
+		// Welding, each vertex is merged into the first kept vertex within tolerance found in its cell or the adjacent ones
+		const float invTolerance    = 1.0f / std::max(tolerances.position, 1e-12f);
+		const bool  useTangentSpace = mesh->status.hasTangents;
+		std::vector<WeldCell> cells(vertices.size());
+		utl::parallelFor(vertices.size(), [&](const size_t i)
 		{
-			math::vec3f& n = vertex.normal;
-			math::vec3f& t = vertex.tangent;
-			math::vec3f& b = vertex.bitangent;
+			cells[i] = computeWeldCell(vertices[i].position, invTolerance);
+		}, 4096);
 
-			if(math::isZero(n))
+		std::vector<vtxID> weldRemap(vertices.size());
+		std::vector<VertexAttributes> weldedVertices;
+		weldedVertices.reserve(vertices.size());
+		{
+			std::unordered_map<WeldCell, std::vector<vtxID>, WeldCellHasher> cellVertices;
+			cellVertices.reserve(vertices.size());
+			auto findInCell = [&](const WeldCell& cell, const VertexAttributes& vertex)
 			{
-				n = math::vec3f(0.0f, 0.0f, 1.0f);
-				VTX_WARN("Normal Vector was Zero in mesh Id: {}, vertex index {}", mesh->getUID(), i);
+				if (const auto it = cellVertices.find(cell); it != cellVertices.end())
+				{
+					for (const vtxID candidate : it->second)
+					{
+						if (isWeldable(weldedVertices[candidate], vertex, tolerances, useTangentSpace))
+						{
+							return candidate;
+						}
+					}
+				}
+				return std::numeric_limits<vtxID>::max();
+			};
+
+			for (size_t i = 0; i < vertices.size(); ++i)
+			{
+				const WeldCell& cell  = cells[i];
+				vtxID           match = findInCell(cell, vertices[i]);
+				for (int64_t n = 0; n < 27 && match == std::numeric_limits<vtxID>::max(); ++n)
+				{
+					if (n != 13)
+					{
+						match = findInCell({ cell.x + n % 3 - 1, cell.y + (n / 3) % 3 - 1, cell.z + n / 9 - 1 }, vertices[i]);
+					}
+				}
+				if (match == std::numeric_limits<vtxID>::max())
+				{
+					match = (vtxID)weldedVertices.size();
+					weldedVertices.push_back(vertices[i]);
+					cellVertices[cell].push_back(match);
+				}
+				weldRemap[i] = match;
 			}
-			if(math::isZero(t))
+		}
+		for (vtxID& index : indices)
+		{
+			index = weldRemap[index];
+		}
+
+		// Triangle reordering, face attributes follow their triangle
+		const size_t             numTriangles  = indices.size() / 3;
+		const std::vector<vtxID> triangleOrder = tipsifyTriangleOrder(indices, weldedVertices.size());
+		{
+			std::vector<vtxID> reorderedIndices(numTriangles * 3);
+			for (size_t t = 0; t < numTriangles; ++t)
 			{
-				t = math::vec3f(1.0f, 0.0f, 0.0f);
-				VTX_WARN("Tangent Vector was Zero in mesh Id: {}, vertex index {}", mesh->getUID(), i);
+				for (int k = 0; k < 3; ++k)
+				{
+					reorderedIndices[t * 3 + k] = indices[triangleOrder[t] * 3 + k];
+				}
 			}
-			if (math::isZero(b))
+			indices.swap(reorderedIndices);
+
+			if (mesh->faceAttributes.size() == numTriangles)
 			{
-				b = math::vec3f(0.0f, 1.0f, 0.0f);
-				VTX_WARN("Bitangent Vector was Zero in mesh Id: {}, vertex index {}", mesh->getUID(), i);
+				std::vector<FaceAttributes> reorderedFaces(numTriangles);
+				for (size_t t = 0; t < numTriangles; ++t)
+				{
+					reorderedFaces[t] = mesh->faceAttributes[triangleOrder[t]];
+				}
+				mesh->faceAttributes.swap(reorderedFaces);
 			}
+		}
 
-			n = math::normalize(n);
-			if (math::isNan(n))
+		// Vertex reordering by first use, unreferenced vertices are dropped
+		constexpr vtxID unassigned = std::numeric_limits<vtxID>::max();
+		std::vector<vtxID> fetchRemap(weldedVertices.size(), unassigned);
+		vtxID              nextVertex = 0;
+		for (vtxID& index : indices)
+		{
+			if (fetchRemap[index] == unassigned)
 			{
-				n = math::vec3f(0.0f, 0.0f, 1.0f);
-				VTX_WARN("Normal Vector was Nan in mesh Id: {}, vertex index {}", mesh->getUID(), i);
+				fetchRemap[index] = nextVertex++;
 			}
+			index = fetchRemap[index];
+		}
+		vertices.resize(nextVertex);
+		for (size_t v = 0; v < weldedVertices.size(); ++v)
+		{
+			if (fetchRemap[v] != unassigned)
+			{
+				vertices[fetchRemap[v]] = weldedVertices[v];
+			}
+		}
+		vertices.shrink_to_fit();
 
-			t -= n * dot(n, t);
-			t = math::normalize(t);
+		mesh->state.updateOnDevice = true;
 
-			b -= n * dot(n, b);
-			b = math::normalize(b);
+		stats.verticesAfter = vertices.size();
+		stats.bytesAfter    = vertices.size() * sizeof(VertexAttributes) + indices.size() * sizeof(vtxID);
+		return stats;
+	}
 
-			if (math::isNan(t))
+	WeldingStats weldMeshes(const std::vector<std::shared_ptr<graph::Mesh>>& meshes, const WeldTolerances& tolerances)
+	{
+		Timer timer;
+		std::vector<WeldingStats> meshStats(meshes.size());
+		utl::parallelFor(meshes.size(), [&](const size_t i)
+		{
+			if (meshes[i] != nullptr)
 			{
-				t = math::vec3f(1.0f, 0.0f, 0.0f);
-				VTX_WARN("Tangent Vector was Nan in mesh Id: {}, vertex index {}", mesh->getUID(), i);
+				meshStats[i] = weldMeshVertices(meshes[i], tolerances);
 			}
-			if (math::isNan(b))
+		});
+
+		WeldingStats total;
+		for (size_t i = 0; i < meshes.size(); ++i)
+		{
+			const WeldingStats& stats = meshStats[i];
+			if (meshes[i] == nullptr || stats.verticesBefore == 0)
 			{
-				b = math::vec3f(0.0f, 1.0f, 0.0f);
-				VTX_WARN("Bitangent Vector was Nan in mesh Id: {}, vertex index {}", mesh->getUID(), i);
+				continue;
 			}
+			VTX_INFO("Mesh {} welding: vertices {} -> {}, {} KB saved",
+					 meshes[i]->getUID(), stats.verticesBefore, stats.verticesAfter, (stats.bytesBefore - stats.bytesAfter) / 1024);
+			total.verticesBefore += stats.verticesBefore;
+			total.verticesAfter += stats.verticesAfter;
+			total.bytesBefore += stats.bytesBefore;
+			total.bytesAfter += stats.bytesAfter;
+		}
+		VTX_INFO("Welded {} meshes in {} ms: vertices {} -> {}, {} MB -> {} MB",
+				 meshes.size(), timer.elapsedMillis(), total.verticesBefore, total.verticesAfter,
+				 total.bytesBefore / (1024 * 1024), total.bytesAfter / (1024 * 1024));
+		return total;
+	}
 
-			VTX_ASSERT_CLOSE(!math::isNan(n));
-			VTX_ASSERT_CLOSE(!math::isNan(t));
-			VTX_ASSERT_CLOSE(!math::isNan(b));
 
-			i++;
+	std::vector<std::shared_ptr<Instance>> collectInstances(const std::shared_ptr<Node>& root)
+	{
+		std::vector<std::shared_ptr<Instance>> instances;
+		std::stack<std::shared_ptr<Node>>      toVisit;
+		toVisit.push(root);
+		while (!toVisit.empty())
+		{
+			const std::shared_ptr<Node> node = toVisit.top();
+			toVisit.pop();
+			if (node == nullptr)
+			{
+				continue;
+			}
+			if (node->getType() == NT_INSTANCE)
+			{
+				instances.push_back(node->as<Instance>());
+			}
+			for (const std::shared_ptr<Node>& child : node->getChildren())
+			{
+				toVisit.push(child);
+			}
 		}
-		mesh->status.hasTangents = true;
-		mesh->status.hasNormals  = true;
+		return instances;
 	}
 
+	struct MeshSignature
+	{
+		uint64_t       hash       = 0; // Topology, meshes can only match if it is the same
+		uint64_t       vertexHash = 0; // Raw vertex bytes, to recognize exact copies
+		int64_t        areaCell   = 0; // Surface area on a logarithmic grid, rigid transforms don't change it
+		math::affine3f frame      = math::affine3f(math::Identity); // canonical frame to mesh space
+	};
+
+	// Ratio between two consecutive area cells. It is far above the area change allowed by the vertex tolerance for any
+	// reasonable mesh, so two matching meshes always fall in the same or in neighbouring cells.
+	static constexpr double areaCellRatio = 1.01;
+	static constexpr int64_t zeroAreaCell = std::numeric_limits<int64_t>::min() / 2;
+
+	static int64_t computeAreaCell(const Mesh& mesh)
+	{
+		double area = 0.0;
+		for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+		{
+			const math::vec3f& p0 = mesh.vertices[mesh.indices[i]].position;
+			const math::vec3f  n  = cross(mesh.vertices[mesh.indices[i + 1]].position - p0, mesh.vertices[mesh.indices[i + 2]].position - p0);
+			area += 0.5 * (double)math::length(n);
+		}
+		if (area <= 0.0)
+		{
+			return zeroAreaCell;
+		}
+		return (int64_t)std::floor(std::log(area) / std::log(areaCellRatio));
+	}
+
+	// The canonical frame is built on the first non degenerate triangle, two meshes which only differ by a rigid transform
+	// have the same coordinates in their canonical frames.
+	static math::affine3f computeCanonicalFrame(const Mesh& mesh)
+	{
+		for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+		{
+			const math::vec3f& p0 = mesh.vertices[mesh.indices[i]].position;
+			const math::vec3f  e1 = mesh.vertices[mesh.indices[i + 1]].position - p0;
+			const math::vec3f  e2 = mesh.vertices[mesh.indices[i + 2]].position - p0;
+			const math::vec3f  n  = cross(e1, e2);
+			if (math::length(n) < 1e-8f || math::length(e1) < 1e-8f)
+			{
+				continue;
+			}
+			const math::vec3f x = math::normalize(e1);
+			const math::vec3f z = math::normalize(n);
+			const math::vec3f y = cross(z, x);
+			return math::affine3f(x, y, z, p0);
+		}
+		return math::affine3f(math::Identity);
+	}
+
+	// Only the topology is hashed since it has to match exactly. Hashing quantized vertex attributes would separate vertices
+	// within tolerance of each other which fall on both sides of a grid boundary, the attributes are compared by isSameGeometry.
+	// The coarse area cell splits the meshes sharing a topology (a tiled floor, bolts of every size) into small buckets.
+	static MeshSignature computeMeshSignature(const Mesh& mesh, const bool rigid)
+	{
+		MeshSignature signature;
+		signature.frame = rigid ? computeCanonicalFrame(mesh) : math::affine3f(math::Identity);
+
+		uint64_t hash = utl::hashValue(mesh.vertices.size());
+		hash = utl::hashVector(mesh.indices, hash);
+		hash = utl::hashVector(mesh.faceAttributes, hash);
+		signature.hash       = hash;
+		signature.areaCell   = computeAreaCell(mesh);
+		signature.vertexHash = utl::hashBytesParallel(mesh.vertices.data(), mesh.vertices.size() * sizeof(VertexAttributes));
+		return signature;
+	}
+
+	static bool isExactCopy(const Mesh& a, const MeshSignature& signatureA, const Mesh& b, const MeshSignature& signatureB)
+	{
+		return signatureA.vertexHash == signatureB.vertexHash && a.vertices.size() == b.vertices.size() && a.indices == b.indices &&
+			std::memcmp(a.vertices.data(), b.vertices.data(), a.vertices.size() * sizeof(VertexAttributes)) == 0 &&
+			a.faceAttributes.size() == b.faceAttributes.size() &&
+			std::memcmp(a.faceAttributes.data(), b.faceAttributes.data(), a.faceAttributes.size() * sizeof(FaceAttributes)) == 0;
+	}
+
+	// Guards against hash collisions and compares the vertex attributes within tolerance
+	static bool isSameGeometry(const Mesh& a, const math::affine3f& frameA, const Mesh& b, const math::affine3f& frameB, const float tolerance)
+	{
+		if (a.vertices.size() != b.vertices.size() || a.indices != b.indices || a.faceAttributes.size() != b.faceAttributes.size())
+		{
+			return false;
+		}
+		for (size_t i = 0; i < a.faceAttributes.size(); ++i)
+		{
+			if (a.faceAttributes[i].materialSlotId != b.faceAttributes[i].materialSlotId)
+			{
+				return false;
+			}
+		}
+		const math::affine3f aToCanonical = gdt::rcp(frameA);
+		const math::affine3f bToCanonical = gdt::rcp(frameB);
+		for (size_t i = 0; i < a.vertices.size(); ++i)
+		{
+			const VertexAttributes& va = a.vertices[i];
+			const VertexAttributes& vb = b.vertices[i];
+			if (math::length(math::transformPoint3F(aToCanonical, va.position) - math::transformPoint3F(bToCanonical, vb.position)) > tolerance ||
+				math::length(math::transformVector3F(aToCanonical, va.normal) - math::transformVector3F(bToCanonical, vb.normal)) > tolerance ||
+				math::length(va.texCoord - vb.texCoord) > tolerance)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	size_t instanceDuplicateMeshes(const std::vector<std::shared_ptr<Instance>>& instances, const bool rigid, const float tolerance)
+	{
+		Timer timer;
+
+		std::vector<std::shared_ptr<Mesh>> meshes;
+		std::unordered_map<vtxID, size_t>  meshIndices;
+		for (const std::shared_ptr<Instance>& instance : instances)
+		{
+			const std::shared_ptr<Node> child = instance->getChild();
+			if (child != nullptr && child->getType() == NT_MESH && meshIndices.find(child->getUID()) == meshIndices.end())
+			{
+				meshIndices.insert({ child->getUID(), meshes.size() });
+				meshes.push_back(child->as<Mesh>());
+			}
+		}
+
+		std::vector<MeshSignature> signatures(meshes.size());
+		utl::parallelFor(meshes.size(), [&](const size_t i)
+		{
+			signatures[i] = computeMeshSignature(*meshes[i], rigid);
+		});
+
+		// For each mesh, the index of the mesh replacing it and the transform from the replacement to the original mesh space
+		std::vector<size_t>                                 replacements(meshes.size());
+		std::vector<math::affine3f>                         replacementTransforms(meshes.size(), math::affine3f(math::Identity));
+		std::vector<bool>                                   isIdentity(meshes.size(), false);
+		std::unordered_map<uint64_t, std::vector<size_t>>   uniqueMeshes;
+		size_t                                              numReplaced   = 0;
+		size_t                                              bytesReleased = 0;
+		for (size_t i = 0; i < meshes.size(); ++i)
+		{
+			replacements[i] = i;
+
+			// Meshes within tolerance can straddle a cell boundary, the neighbouring cells are searched as well
+			std::vector<size_t> candidates;
+			for (int64_t cell = signatures[i].areaCell - 1; cell <= signatures[i].areaCell + 1; ++cell)
+			{
+				const auto bucket = uniqueMeshes.find(utl::hashCombine(signatures[i].hash, (uint64_t)cell));
+				if (bucket != uniqueMeshes.end())
+				{
+					candidates.insert(candidates.end(), bucket->second.begin(), bucket->second.end());
+				}
+			}
+
+			// Exact copies keep the identity, going through the canonical frames would only add float noise to their transform
+			for (const size_t candidate : candidates)
+			{
+				if (isExactCopy(*meshes[candidate], signatures[candidate], *meshes[i], signatures[i]))
+				{
+					replacements[i] = candidate;
+					isIdentity[i]   = true;
+					break;
+				}
+			}
+			for (size_t c = 0; c < candidates.size() && replacements[i] == i; ++c)
+			{
+				const size_t candidate = candidates[c];
+				if (isSameGeometry(*meshes[candidate], signatures[candidate].frame, *meshes[i], signatures[i].frame, tolerance))
+				{
+					replacements[i]          = candidate;
+					replacementTransforms[i] = signatures[i].frame * gdt::rcp(signatures[candidate].frame);
+				}
+			}
+			if (replacements[i] == i)
+			{
+				uniqueMeshes[utl::hashCombine(signatures[i].hash, (uint64_t)signatures[i].areaCell)].push_back(i);
+			}
+			else
+			{
+				++numReplaced;
+				bytesReleased += meshes[i]->vertices.size() * sizeof(VertexAttributes) + meshes[i]->indices.size() * sizeof(vtxID) + meshes[i]->faceAttributes.size() * sizeof(FaceAttributes);
+			}
+		}
+
+		for (const std::shared_ptr<Instance>& instance : instances)
+		{
+			const std::shared_ptr<Node> child = instance->getChild();
+			if (child == nullptr || child->getType() != NT_MESH)
+			{
+				continue;
+			}
+			const size_t meshIndex = meshIndices[child->getUID()];
+			if (replacements[meshIndex] == meshIndex)
+			{
+				continue;
+			}
+			instance->setChild(meshes[replacements[meshIndex]]);
+			if (rigid && !isIdentity[meshIndex])
+			{
+				instance->transform->setAffine(instance->transform->affineTransform * replacementTransforms[meshIndex]);
+			}
+		}
+
+		VTX_INFO("Mesh instancing: {} unique meshes out of {}, {} MB released in {} ms",
+				 meshes.size() - numReplaced, meshes.size(), bytesReleased / (1024 * 1024), timer.elapsedMillis());
+		return numReplaced;
+	}
 
 	std::shared_ptr<graph::Group> simpleScene01()
 	{
@@ -2,6 +2,8 @@
 #include <memory>
 #include "Scene/SceneIndexManager.h"
 #include "Core/Math.h"
+#include "Core/PoolAllocator.h"
+#include "Scene/DataStructs/CompactVertexAttribute.h"
 #include "Scene/Scene.h"
 
 namespace vtx::graph
@@ -17,17 +19,36 @@ namespace vtx::graph
 	class Group;
 	class Node;
 	class Mesh;
+	class Instance;
 	struct TransformAttribute;
 
     class Scene;
 }
 
+namespace vtx
+{
+    struct AliasData;
+}
+
 namespace vtx::ops {
 
+    bool isNodePoolEnabled();
+
+    // The node and its control block come from the pool of the node type, the memory stays in the pool as long as weak
+    // pointers to the node exist
+    template<typename T, typename... Ts>
+    std::shared_ptr<T> allocateNode(Ts... optionalArgs) {
+        if (isNodePoolEnabled())
+        {
+            return std::allocate_shared<T>(utl::PoolAllocator<T>(), optionalArgs...);
+        }
+        return std::make_shared<T>(optionalArgs...);
+    }
+
     template<typename T,typename... Ts>
     std::shared_ptr<T> createNode(Ts... optionalArgs) {
         static_assert(std::is_base_of_v<graph::Node, T>, "Pushed type is not subclass of Node!");
-        std::shared_ptr<T> node = std::make_shared<T>(optionalArgs...);
+        std::shared_ptr<T> node = allocateNode<T>(optionalArgs...);
         graph::Scene::getSim()->record(node);
         return node;
     }
@@ -35,7 +56,7 @@ namespace vtx::ops {
     template<typename T, typename... Ts>
     std::shared_ptr<T> createNodeAndRemoveSIMReferences(Ts... optionalArgs) {
         static_assert(std::is_base_of_v<graph::Node, T>, "Pushed type is not subclass of Node!");
-        std::shared_ptr<T> node = std::make_shared<T>(optionalArgs...);
+        std::shared_ptr<T> node = allocateNode<T>(optionalArgs...);
         graph::Scene::getSim()->record(node);
         graph::Scene::getSim()->removeNodeReference(node->getUID(), node->getTypeID(), node->getType(), false);
         return node;
@@ -59,13 +80,125 @@ namespace vtx::ops {
                          const unsigned int y,
                          const bool isSpherical);
 
+    // Builds the alias table of the weights on the thread pool. The table is split along the sweep of the sequential
+    // construction (lights paired with the current heavy entry in index order), so the result doesn't depend on the number of workers.
+    // Returns the sum of the weights, the pdf of each entry is weight / sum.
+    double buildAliasMap(const std::vector<float>& weights, std::vector<AliasData>& aliasMap);
+
     std::shared_ptr <graph::shader::ImportedNode> createPbsdfGraph();
 
     void computeFaceAttributes(const std::shared_ptr<graph::Mesh>& mesh);
 
+    // Degenerate vertices found by the tangent space kernels, reported once per mesh
+    struct TangentSpaceDiagnostics
+    {
+        size_t zeroNormals    = 0;
+        size_t zeroTangents   = 0;
+        size_t zeroBitangents = 0;
+        size_t nanNormals     = 0;
+        size_t nanTangents    = 0;
+        size_t nanBitangents  = 0;
+
+        void add(const TangentSpaceDiagnostics& other);
+
+        size_t total() const;
+    };
+
+    // The normal and tangent kernels run in two parallel passes: per face vectors first, then every vertex gathers the
+    // faces adjacent to it, so there are no atomics and no per vertex allocations.
     void computeVertexNormals(std::shared_ptr<graph::Mesh> mesh);
 
-    void computeVertexTangentSpace(const std::shared_ptr<graph::Mesh>& mesh);
+    // Computes normals, tangents and bitangents from the positions and uvs. With keepNormals the vertex normals coming from
+    // the file are kept and only the tangent frame is built around them.
+    void computeVertexTangentSpace(const std::shared_ptr<graph::Mesh>& mesh, bool keepNormals = false);
+
+    // Computes whatever the mesh is missing among face attributes, normals and tangents
+    void prepareMesh(const std::shared_ptr<graph::Mesh>& mesh);
+
+    // Runs the preparation on a copy of the arrays on the thread pool, the mesh is not modified until the copy is
+    // published by publishPreparedMeshes(). The copy is taken by the caller, which must be the main thread or a traversal
+    // it waits for. Does nothing if the mesh is already being prepared.
+    void prepareMeshAsync(const std::shared_ptr<graph::Mesh>& mesh);
+
+    // Moves the arrays prepared in the background into their meshes and flags them for device upload. Main thread only,
+    // the other readers of the mesh arrays don't lock.
+    void publishPreparedMeshes();
+
+    struct MeshPreparationProgress
+    {
+        size_t queuedMeshes     = 0;
+        size_t preparedMeshes   = 0;
+        size_t queuedVertices   = 0;
+        size_t preparedVertices = 0;
+    };
+
+    MeshPreparationProgress getMeshPreparationProgress();
+
+    // Drops the given graphs, e.g. the previous scene when a new one is loaded. Nodes are released parents first so the
+    // destruction of a graph doesn't cascade down its whole depth, and per node logging is replaced by a summary.
+    // Nodes still referenced from elsewhere survive. Node pools left without live nodes give their memory back.
+    void releaseNodes(std::vector<std::shared_ptr<graph::Node>> roots);
+
+    // Logs the cost of creating and releasing a synthetic graph of the given number of nodes,
+    // with pooled nodes next to individually allocated ones
+    void benchmarkNodeAllocation(size_t numNodes = 2000000);
+
+    // Bounds used to quantise the positions of the compact vertex layout
+    graph::CompactVertexBounds computeCompactVertexBounds(const std::shared_ptr<graph::Mesh>& mesh);
+
+    // Encodes the mesh vertices in the compact layout on the thread pool
+    void encodeCompactVertices(const std::shared_ptr<graph::Mesh>& mesh, const graph::CompactVertexBounds& bounds, std::vector<graph::CompactVertexAttributes>& compactVertices);
+
+    // Meshes with less vertices than this are uploaded with 16 bit indices in the compact layout
+    static constexpr size_t shortIndexVertexLimit = 65536;
+
+    inline bool hasShortIndices(const size_t numVertices)
+    {
+        return numVertices < shortIndexVertexLimit;
+    }
+
+    struct VertexMemoryReport
+    {
+        size_t meshes           = 0;
+        size_t shortIndexMeshes = 0;
+        size_t vertices         = 0;
+        size_t indices          = 0;
+        size_t fullBytes        = 0;
+        size_t compactBytes     = 0;
+    };
+
+    // Compares the size of vertex and index buffers in the full and compact layouts and logs it
+    VertexMemoryReport reportVertexMemory(const std::vector<std::shared_ptr<graph::Mesh>>& meshes);
+
+    struct WeldingStats
+    {
+        size_t verticesBefore = 0;
+        size_t verticesAfter  = 0;
+        size_t bytesBefore    = 0;
+        size_t bytesAfter     = 0;
+    };
+
+    // Largest difference per component for two vertices to be merged
+    struct WeldTolerances
+    {
+        float position = 1e-5f; // Scene units
+        float normal   = 1e-3f; // Unit normal components
+        float texCoord = 1e-5f; // Uv units
+    };
+
+    // Merges vertices whose position, normal and uv match within tolerance, remaps the indices, reorders the triangles
+    // for vertex cache locality (tipsify) and finally sorts the vertices by first use.
+    WeldingStats weldMeshVertices(const std::shared_ptr<graph::Mesh>& mesh, const WeldTolerances& tolerances = {});
+
+    // Welds all the meshes in parallel on the shared thread pool, one task per mesh, and reports the savings
+    WeldingStats weldMeshes(const std::vector<std::shared_ptr<graph::Mesh>>& meshes, const WeldTolerances& tolerances = {});
+
+    std::vector<std::shared_ptr<graph::Instance>> collectInstances(const std::shared_ptr<graph::Node>& root);
+
+    // Collapses meshes with the same vertices, indices and face attributes into a single mesh shared by all the instances.
+    // With rigid = true meshes which only differ by a rigid transform are matched as well, the difference is folded into
+    // the instance transform. Returns the number of meshes which have been replaced.
+    size_t instanceDuplicateMeshes(const std::vector<std::shared_ptr<graph::Instance>>& instances, bool rigid = true, float tolerance = 1e-4f);
 
     /////////////////////////////////////////////////////////////////////////////////////////////////////
     ///////////////////////// Some Comodity Functions for hard coded scenes /////////////////////////////
@@ -0,0 +1,195 @@
+#include "PreparedDataStore.h"
+#include <cstring>
+#include <filesystem>
+#include <set>
+#include "SamplingTableCache.h"
+#include "Core/Hashing.h"
+#include "Core/Log.h"
+#include "Core/ThreadPool.h"
+#include "Core/Timer.h"
+#include "Scene/Scene.h"
+#include "Scene/Nodes/EnvironmentLight.h"
+#include "Scene/Nodes/MeshLight.h"
+#include "Scene/Nodes/Shader/Texture.h"
+
+namespace vtx::graph
+{
+	void PreparedData::append(const void* data, const uint64_t size)
+	{
+		const size_t offset = blob.size();
+		blob.resize(offset + sizeof(uint64_t) + size);
+		std::memcpy(blob.data() + offset, &size, sizeof(uint64_t));
+		if (size != 0)
+		{
+			std::memcpy(blob.data() + offset + sizeof(uint64_t), data, size);
+		}
+	}
+
+	PreparedDataReader::PreparedDataReader(const std::vector<char>& blob) :
+		blob(blob)
+	{
+	}
+
+	bool PreparedDataReader::nextSize(uint64_t& size) const
+	{
+		// The size comes from the blob, it is compared to the remaining bytes so that a corrupt value can't wrap around
+		if (!isValid || offset > blob.size() || blob.size() - offset < sizeof(uint64_t))
+		{
+			return false;
+		}
+		std::memcpy(&size, blob.data() + offset, sizeof(uint64_t));
+		return size <= blob.size() - offset - sizeof(uint64_t);
+	}
+
+	bool PreparedDataReader::read(void* data, const uint64_t size)
+	{
+		uint64_t arraySize;
+		if (!nextSize(arraySize) || arraySize != size)
+		{
+			isValid = false;
+			return false;
+		}
+		if (size != 0)
+		{
+			std::memcpy(data, blob.data() + offset + sizeof(uint64_t), size);
+		}
+		offset += sizeof(uint64_t) + size;
+		return true;
+	}
+
+	bool PreparedDataReader::isComplete() const
+	{
+		return isValid && offset == blob.size();
+	}
+
+	PreparedDataStore* PreparedDataStore::get()
+	{
+		static PreparedDataStore store;
+		return &store;
+	}
+
+	uint64_t PreparedDataStore::computeKey(const PreparedDataKind kind, const uint64_t sourceHash, const uint64_t settingsHash, const uint32_t layoutVersion)
+	{
+		uint64_t key = utl::hashValue(layoutVersion);
+		key          = utl::hashCombine(key, utl::hashValue(kind));
+		key          = utl::hashCombine(key, settingsHash);
+		key          = utl::hashCombine(key, sourceHash);
+		return key;
+	}
+
+	void PreparedDataStore::add(const PreparedDataKind kind, const uint64_t key, const void* data, const uint64_t size, const uint64_t checksum, std::shared_ptr<const void> owner, const std::string& ownerPath)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		const auto [it, isInserted] = entries.insert_or_assign({ kind, key }, Entry{ data, size, checksum, std::move(owner), ownerPath });
+		if (isInserted)
+		{
+			++kindCounts[kind];
+		}
+	}
+
+	bool PreparedDataStore::find(const PreparedDataKind kind, const uint64_t key, std::vector<char>& blob)
+	{
+		Entry entry;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			const auto it = entries.find({ kind, key });
+			if (it == entries.end())
+			{
+				return false;
+			}
+			entry = it->second;
+		}
+
+		blob.resize(entry.size);
+		std::memcpy(blob.data(), entry.data, entry.size);
+		if (utl::hashBytesParallel(blob.data(), blob.size()) != entry.checksum)
+		{
+			VTX_WARN("Prepared data: checksum mismatch for kind {} key {:016x}, the data is prepared again", (uint32_t)kind, key);
+			blob.clear();
+			return false;
+		}
+		return true;
+	}
+
+	bool PreparedDataStore::hasKind(const PreparedDataKind kind)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return kindCounts[kind] != 0;
+	}
+
+	void PreparedDataStore::clear()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		entries.clear();
+		std::fill(std::begin(kindCounts), std::end(kindCounts), 0u);
+	}
+
+	void PreparedDataStore::releaseFile(const std::string& filePath)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		std::error_code             error;
+		for (auto it = entries.begin(); it != entries.end();)
+		{
+			if (std::filesystem::equivalent(it->second.ownerPath, filePath, error))
+			{
+				--kindCounts[it->first.first];
+				it = entries.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
+	std::vector<PreparedData> PreparedDataStore::collect()
+	{
+		Timer                                    timer;
+		const std::shared_ptr<SceneIndexManager> sim = Scene::getSim();
+		std::vector<PreparedData>                prepared;
+
+		for (const std::shared_ptr<EnvironmentLight>& light : sim->getAllNodeOfType<EnvironmentLight>(NT_ENV_LIGHT))
+		{
+			PreparedData data;
+			if (light->getPreparedData(data))
+			{
+				prepared.push_back(std::move(data));
+			}
+		}
+		SamplingTableCache::get()->collectPreparedData(prepared);
+		MeshLight::collectPreparedData(prepared);
+
+		// Texture blobs are copies of the pixels, the large ones are copied concurrently
+		const std::vector<std::shared_ptr<Texture>> textures = sim->getAllNodeOfType<Texture>(NT_MDL_TEXTURE);
+		std::vector<PreparedData>                   textureData(textures.size());
+		utl::parallelFor(textures.size(), [&](const size_t i)
+		{
+			if (!textures[i]->getPreparedData(textureData[i]))
+			{
+				textureData[i].kind = PD_COUNT;
+			}
+		});
+		for (PreparedData& data : textureData)
+		{
+			if (data.kind != PD_COUNT)
+			{
+				prepared.push_back(std::move(data));
+			}
+		}
+
+		// Nodes sharing the same source produce the same data
+		std::set<std::pair<uint32_t, uint64_t>> keys;
+		std::vector<PreparedData>                unique;
+		uint64_t                                 totalSize = 0;
+		for (PreparedData& data : prepared)
+		{
+			if (keys.insert({ data.kind, data.key }).second)
+			{
+				totalSize += data.blob.size();
+				unique.push_back(std::move(data));
+			}
+		}
+		VTX_INFO("Prepared data: {} entries ({} MB) collected in {} ms", unique.size(), totalSize / (1024 * 1024), timer.elapsedMillis());
+		return unique;
+	}
+}
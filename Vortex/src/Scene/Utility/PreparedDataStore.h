@@ -0,0 +1,130 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace vtx::graph
+{
+	enum PreparedDataKind : uint32_t
+	{
+		PD_ENV_SAMPLING,
+		PD_LIGHT_PROFILE_TABLES,
+		PD_BSDF_TABLES,
+		PD_EMISSIVE_TRIANGLES,
+		PD_TEXTURE,
+
+		PD_COUNT
+	};
+
+	// Result of a preprocessing step, serialized as a list of arrays each preceded by its size in bytes
+	struct PreparedData
+	{
+		PreparedDataKind  kind = PD_COUNT;
+		uint64_t          key  = 0;
+		std::vector<char> blob;
+
+		void append(const void* data, uint64_t size);
+
+		template<typename T>
+		void append(const std::vector<T>& array)
+		{
+			append(array.data(), array.size() * sizeof(T));
+		}
+
+		template<typename T>
+		void appendValue(const T& value)
+		{
+			append(&value, sizeof(T));
+		}
+	};
+
+	// Reads the arrays of a blob in the order they were appended. Once a read fails, the following ones fail too.
+	class PreparedDataReader
+	{
+	public:
+		explicit PreparedDataReader(const std::vector<char>& blob);
+
+		// Fails unless the next array has exactly size bytes
+		bool read(void* data, uint64_t size);
+
+		template<typename T>
+		bool read(std::vector<T>& array)
+		{
+			uint64_t size;
+			if (!nextSize(size) || size % sizeof(T) != 0)
+			{
+				isValid = false;
+				return false;
+			}
+			array.resize(size / sizeof(T));
+			return read(array.data(), size);
+		}
+
+		template<typename T>
+		bool readValue(T& value)
+		{
+			return read(&value, sizeof(T));
+		}
+
+		// True if every read succeeded and the whole blob was consumed
+		bool isComplete() const;
+
+	private:
+		bool nextSize(uint64_t& size) const;
+
+		const std::vector<char>& blob;
+		uint64_t                 offset  = 0;
+		bool                     isValid = true;
+	};
+
+	// Preprocessed light sampling and texture data embedded in a saved scene, by kind and by a key of the source content.
+	// Loading a scene publishes the embedded data here and the nodes look it up before preparing their data themselves,
+	// saving a scene collects the data the current nodes prepared.
+	class PreparedDataStore
+	{
+	public:
+		static constexpr uint32_t version = 1;
+
+		static PreparedDataStore* get();
+
+		// Key of data prepared from source content with the given hash, settingsHash covers whatever else the result depends on.
+		// The version is part of the key, data of an older layout is never found.
+		static uint64_t computeKey(PreparedDataKind kind, uint64_t sourceHash, uint64_t settingsHash, uint32_t layoutVersion = version);
+
+		// The data is referenced, owner (e.g. the mapped scene file at ownerPath) is kept alive until clear() or releaseFile()
+		void add(PreparedDataKind kind, uint64_t key, const void* data, uint64_t size, uint64_t checksum, std::shared_ptr<const void> owner, const std::string& ownerPath);
+
+		// Copies the data of the key, returns false if no loaded scene embeds it or if its checksum doesn't match
+		bool find(PreparedDataKind kind, uint64_t key, std::vector<char>& blob);
+
+		bool hasKind(PreparedDataKind kind);
+
+		// Forgets the data of the previously loaded scene
+		void clear();
+
+		// Forgets the data embedded in the file, its mapping is released before a save replaces it
+		void releaseFile(const std::string& filePath);
+
+		// Data prepared by the nodes of the scene, one entry per kind and key
+		static std::vector<PreparedData> collect();
+
+	private:
+		PreparedDataStore() = default;
+
+		struct Entry
+		{
+			const void*                 data;
+			uint64_t                    size;
+			uint64_t                    checksum;
+			std::shared_ptr<const void> owner;
+			std::string                 ownerPath;
+		};
+
+		std::mutex                                       mutex;
+		std::map<std::pair<uint32_t, uint64_t>, Entry> entries;
+		uint32_t                                         kindCounts[PD_COUNT] = {};
+	};
+}
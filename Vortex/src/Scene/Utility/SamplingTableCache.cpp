@@ -0,0 +1,243 @@
+#include "SamplingTableCache.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include "Core/Hashing.h"
+#include "Core/Log.h"
+#include "Core/Options.h"
+#include "Core/Timer.h"
+#include "Core/Utils.h"
+
+namespace vtx::graph
+{
+	static constexpr char cacheMagic[8] = { 'V', 'T', 'X', 'S', 'A', 'M', 'P', 'L' };
+
+	SamplingTableCache* SamplingTableCache::get()
+	{
+		static SamplingTableCache cache;
+		return &cache;
+	}
+
+	uint64_t SamplingTableCache::computeKey(const float* data, const size_t count, const uint64_t settingsHash)
+	{
+		uint64_t key = utl::hashValue(version);
+		key          = utl::hashCombine(key, settingsHash);
+		key          = utl::hashCombine(key, utl::hashBytesParallel(data, count * sizeof(float)));
+		return key;
+	}
+
+	std::string SamplingTableCache::getCachePath(const uint64_t key)
+	{
+		std::stringstream ss;
+		ss << std::hex << key;
+		return getOptions()->importCacheFolder + ss.str() + ".vtxsampling";
+	}
+
+	bool SamplingTableCache::read(const uint64_t key, const std::vector<size_t>& arraySizes, std::vector<std::vector<float>>& arrays)
+	{
+		const std::string cachePath = getCachePath(key);
+		utl::MappedFile   file;
+		if (!getOptions()->samplingTableCache || !std::filesystem::exists(cachePath) || !file.open(cachePath))
+		{
+			return false;
+		}
+
+		const auto*  data   = static_cast<const char*>(file.getData());
+		const size_t size   = file.getSize();
+		const auto*  header = reinterpret_cast<const Header*>(data);
+		if (size < sizeof(Header) ||
+			std::memcmp(header->magic, cacheMagic, sizeof(cacheMagic)) != 0 ||
+			header->version != version ||
+			header->key != key ||
+			header->numArrays != arraySizes.size())
+		{
+			VTX_WARN("Sampling table cache: {} is not valid, ignoring it", cachePath);
+			return false;
+		}
+
+		arrays.resize(arraySizes.size());
+		uint64_t offset = sizeof(Header);
+		for (size_t i = 0; i < arrays.size(); ++i)
+		{
+			uint64_t count;
+			if (!file.containsRange(offset, 1, sizeof(uint64_t)))
+			{
+				VTX_WARN("Sampling table cache: {} is truncated, ignoring it", cachePath);
+				return false;
+			}
+			std::memcpy(&count, data + offset, sizeof(uint64_t));
+			offset += sizeof(uint64_t);
+			if (count != arraySizes[i] || !file.containsRange(offset, count, sizeof(float)))
+			{
+				VTX_WARN("Sampling table cache: {} is truncated or its tables don't have the expected size, ignoring it", cachePath);
+				return false;
+			}
+			arrays[i].resize(count);
+			std::memcpy(arrays[i].data(), data + offset, count * sizeof(float));
+			offset += count * sizeof(float);
+		}
+		return true;
+	}
+
+	bool SamplingTableCache::readPrepared(const PreparedDataKind kind, const uint64_t key, const std::vector<size_t>& arraySizes, std::vector<std::vector<float>>& arrays)
+	{
+		PreparedDataStore* store = PreparedDataStore::get();
+		std::vector<char>  blob;
+		if (!store->hasKind(kind) || !store->find(kind, PreparedDataStore::computeKey(kind, key, 0), blob))
+		{
+			return false;
+		}
+
+		PreparedDataReader reader(blob);
+		arrays.resize(arraySizes.size());
+		bool isMatching = true;
+		for (size_t i = 0; i < arrays.size(); ++i)
+		{
+			reader.read(arrays[i]);
+			isMatching = isMatching && arrays[i].size() == arraySizes[i];
+		}
+		if (reader.isComplete() && !isMatching)
+		{
+			VTX_WARN("Prepared sampling tables {:016x} don't have the expected size, they are built again", key);
+		}
+		return reader.isComplete() && isMatching;
+	}
+
+	void SamplingTableCache::write(const uint64_t key, const std::vector<const std::vector<float>*>& arrays)
+	{
+		if (!getOptions()->samplingTableCache)
+		{
+			return;
+		}
+
+		Header header{};
+		std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+		header.version   = version;
+		header.numArrays = (uint32_t)arrays.size();
+		header.key       = key;
+
+		utl::writeFileAtomically(getCachePath(key), [&header, &arrays](std::ofstream& outFile)
+		{
+			outFile.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+			for (const std::vector<float>* array : arrays)
+			{
+				const uint64_t count = array->size();
+				outFile.write(reinterpret_cast<const char*>(&count), sizeof(uint64_t));
+				outFile.write(reinterpret_cast<const char*>(array->data()), (std::streamsize)(count * sizeof(float)));
+			}
+		});
+	}
+
+	std::shared_ptr<const LightProfileSamplingTables> SamplingTableCache::getLightProfileTables(const uint64_t key, const size_t cdfDataSize, const std::function<LightProfileSamplingTables()>& build)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (const auto it = lightProfileTables.find(key); it != lightProfileTables.end())
+			{
+				if (std::shared_ptr<const LightProfileSamplingTables> tables = it->second.lock())
+				{
+					return tables;
+				}
+			}
+		}
+
+		Timer                           timer;
+		auto                            tables = std::make_shared<LightProfileSamplingTables>();
+		std::vector<std::vector<float>> arrays;
+		const std::vector<size_t>       arraySizes = { cdfDataSize, 1 };
+		if (readPrepared(PD_LIGHT_PROFILE_TABLES, key, arraySizes, arrays) || read(key, arraySizes, arrays))
+		{
+			tables->cdfData    = std::move(arrays[0]);
+			tables->totalPower = arrays[1][0];
+			VTX_INFO("Light profile sampling tables {:016x} loaded from cache in {} ms", key, timer.elapsedMillis());
+		}
+		else
+		{
+			*tables = build();
+			const std::vector<float> totalPower{ tables->totalPower };
+			write(key, { &tables->cdfData, &totalPower });
+			VTX_INFO("Light profile sampling tables {:016x} built in {} ms", key, timer.elapsedMillis());
+		}
+
+		// Another thread may have prepared the same tables meanwhile, the first one stays shared
+		std::lock_guard<std::mutex> lock(mutex);
+		if (std::shared_ptr<const LightProfileSamplingTables> existing = lightProfileTables[key].lock())
+		{
+			return existing;
+		}
+		lightProfileTables[key] = tables;
+		return tables;
+	}
+
+	std::shared_ptr<const BsdfSamplingTables> SamplingTableCache::getBsdfTables(const uint64_t key, const BsdfSamplingTableSizes& sizes, const std::function<BsdfSamplingTables()>& build)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (const auto it = bsdfTables.find(key); it != bsdfTables.end())
+			{
+				if (std::shared_ptr<const BsdfSamplingTables> tables = it->second.lock())
+				{
+					return tables;
+				}
+			}
+		}
+
+		Timer                           timer;
+		auto                            tables = std::make_shared<BsdfSamplingTables>();
+		std::vector<std::vector<float>> arrays;
+		const std::vector<size_t>       arraySizes = { sizes.sampleDataSize, sizes.albedoDataSize, sizes.lookupDataSize, 1 };
+		if (readPrepared(PD_BSDF_TABLES, key, arraySizes, arrays) || read(key, arraySizes, arrays))
+		{
+			tables->sampleData = std::move(arrays[0]);
+			tables->albedoData = std::move(arrays[1]);
+			tables->lookupData = std::move(arrays[2]);
+			tables->maxAlbedo  = arrays[3][0];
+			VTX_INFO("Measured bsdf sampling tables {:016x} loaded from cache in {} ms", key, timer.elapsedMillis());
+		}
+		else
+		{
+			*tables = build();
+			const std::vector<float> maxAlbedo{ tables->maxAlbedo };
+			write(key, { &tables->sampleData, &tables->albedoData, &tables->lookupData, &maxAlbedo });
+			VTX_INFO("Measured bsdf sampling tables {:016x} built in {} ms", key, timer.elapsedMillis());
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (std::shared_ptr<const BsdfSamplingTables> existing = bsdfTables[key].lock())
+		{
+			return existing;
+		}
+		bsdfTables[key] = tables;
+		return tables;
+	}
+
+	void SamplingTableCache::collectPreparedData(std::vector<PreparedData>& preparedData)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (const auto& [key, weakTables] : lightProfileTables)
+		{
+			if (const std::shared_ptr<const LightProfileSamplingTables> tables = weakTables.lock())
+			{
+				PreparedData& data = preparedData.emplace_back();
+				data.kind          = PD_LIGHT_PROFILE_TABLES;
+				data.key           = PreparedDataStore::computeKey(PD_LIGHT_PROFILE_TABLES, key, 0);
+				data.append(tables->cdfData);
+				data.append(std::vector<float>{ tables->totalPower });
+			}
+		}
+		for (const auto& [key, weakTables] : bsdfTables)
+		{
+			if (const std::shared_ptr<const BsdfSamplingTables> tables = weakTables.lock())
+			{
+				PreparedData& data = preparedData.emplace_back();
+				data.kind          = PD_BSDF_TABLES;
+				data.key           = PreparedDataStore::computeKey(PD_BSDF_TABLES, key, 0);
+				data.append(tables->sampleData);
+				data.append(tables->albedoData);
+				data.append(tables->lookupData);
+				data.append(std::vector<float>{ tables->maxAlbedo });
+			}
+		}
+	}
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "PreparedDataStore.h"
+
+namespace vtx::graph
+{
+	// Sampling tables of a light profile, see LightProfile::prepareSampling
+	struct LightProfileSamplingTables
+	{
+		std::vector<float> cdfData;
+		float              totalPower = 0.0f;
+	};
+
+	// Sampling and evaluation tables of one part (reflection or transmission) of a measured bsdf, see BsdfMeasurement::prepareSampling
+	struct BsdfSamplingTables
+	{
+		std::vector<float> sampleData;
+		std::vector<float> albedoData;
+		std::vector<float> lookupData;
+		float              maxAlbedo = 0.0f;
+	};
+
+	// Number of floats in each table of BsdfSamplingTables, follows from the angular resolution and the number of channels
+	struct BsdfSamplingTableSizes
+	{
+		size_t sampleDataSize = 0;
+		size_t albedoDataSize = 0;
+		size_t lookupDataSize = 0;
+	};
+
+	// Prepared sampling tables of the MDL light profiles and measured bsdfs, keyed by the content hash of their source data.
+	// Materials referencing the same resource share the tables in memory, on disk they are kept next to the import cache
+	// so that the next load doesn't build them again.
+	class SamplingTableCache
+	{
+	public:
+		static constexpr uint32_t version = 1;
+
+		static SamplingTableCache* get();
+
+		// Key of the tables built from count floats of source data, settingsHash covers the layout of the data (resolution, channels...)
+		static uint64_t computeKey(const float* data, size_t count, uint64_t settingsHash);
+
+		// Returns the tables of the key, building them with build() if they are neither in memory nor on disk. Tables read from
+		// disk or from the loaded scene are only used if they have the expected sizes.
+		std::shared_ptr<const LightProfileSamplingTables> getLightProfileTables(uint64_t key, size_t cdfDataSize, const std::function<LightProfileSamplingTables()>& build);
+
+		std::shared_ptr<const BsdfSamplingTables> getBsdfTables(uint64_t key, const BsdfSamplingTableSizes& sizes, const std::function<BsdfSamplingTables()>& build);
+
+		// Tables currently in use, in the array layout of the cache files
+		void collectPreparedData(std::vector<PreparedData>& preparedData);
+
+		struct Header
+		{
+			char     magic[8];
+			uint32_t version;
+			uint32_t numArrays;
+			uint64_t key;
+		};
+
+	private:
+		SamplingTableCache() = default;
+
+		static std::string getCachePath(uint64_t key);
+
+		// The tables are stored as a list of float arrays, each preceded by its size. Scalars are arrays of one element.
+		// Fails unless there are as many arrays as sizes and each has its size.
+		static bool read(uint64_t key, const std::vector<size_t>& arraySizes, std::vector<std::vector<float>>& arrays);
+
+		// Same arrays, embedded in the loaded scene
+		static bool readPrepared(PreparedDataKind kind, uint64_t key, const std::vector<size_t>& arraySizes, std::vector<std::vector<float>>& arrays);
+
+		static void write(uint64_t key, const std::vector<const std::vector<float>*>& arrays);
+
+		std::mutex                                                          mutex;
+		std::map<uint64_t, std::weak_ptr<const LightProfileSamplingTables>> lightProfileTables;
+		std::map<uint64_t, std::weak_ptr<const BsdfSamplingTables>>         bsdfTables;
+	};
+}
@@ -0,0 +1,129 @@
+#include "TexturePrefetcher.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <filesystem>
+#include "stb_image.h"
+#include "ModelLoader.h"
+#include "Core/Log.h"
+#include "Core/Options.h"
+#include "Core/ThreadPool.h"
+
+namespace vtx::importer
+{
+	PrefetchedImage::~PrefetchedImage()
+	{
+		if (pixels != nullptr)
+		{
+			stbi_image_free(pixels);
+		}
+	}
+
+	void* PrefetchedImage::releasePixels()
+	{
+		void* released = pixels;
+		pixels         = nullptr;
+		return released;
+	}
+
+	// The same file can be referenced through different spellings (separators, dot segments, case on windows)
+	static std::string getImageKey(const std::string& filePath)
+	{
+		std::string key = std::filesystem::path(filePath).lexically_normal().make_preferred().string();
+		std::transform(key.begin(), key.end(), key.begin(), [](const unsigned char c) { return (char)std::tolower(c); });
+		return key;
+	}
+
+	static std::shared_ptr<PrefetchedImage> decodeImage(const std::string& filePath)
+	{
+		int width;
+		int height;
+		int channels;
+		if (stbi_info(filePath.c_str(), &width, &height, &channels) == 0)
+		{
+			return nullptr;
+		}
+
+		// Grayscale and 16 bit images are converted to float with gamma correction by MDL, they are left to it
+		const bool isHdr = stbi_is_hdr(filePath.c_str()) != 0;
+		if (!isHdr && (channels < 3 || stbi_is_16_bit(filePath.c_str()) != 0))
+		{
+			return nullptr;
+		}
+
+		// MDL canvases start from the bottom row
+		stbi_set_flip_vertically_on_load_thread(1);
+		auto image     = std::make_shared<PrefetchedImage>();
+		image->isFloat = isHdr;
+		image->pixels  = isHdr ?
+			static_cast<void*>(stbi_loadf(filePath.c_str(), &image->width, &image->height, &channels, 4)) :
+			static_cast<void*>(stbi_load(filePath.c_str(), &image->width, &image->height, &channels, 4));
+		if (image->pixels == nullptr)
+		{
+			VTX_WARN("Texture prefetch: failed to decode {}: {}", filePath, stbi_failure_reason());
+			return nullptr;
+		}
+		return image;
+	}
+
+	TexturePrefetcher* TexturePrefetcher::get()
+	{
+		static TexturePrefetcher prefetcher;
+		return &prefetcher;
+	}
+
+	void TexturePrefetcher::prefetch(const std::string& filePath)
+	{
+		if (!getOptions()->prefetchTexturesOnImport || filePath.empty())
+		{
+			return;
+		}
+
+		const std::string           key = getImageKey(filePath);
+		std::lock_guard<std::mutex> lock(mutex);
+		if (images.find(key) == images.end())
+		{
+			images[key] = ThreadPool::get()->submit([filePath]() { return decodeImage(filePath); }).share();
+		}
+	}
+
+	void TexturePrefetcher::prefetch(const AssimpMaterialProperties& properties)
+	{
+		for (const std::string* path : {
+				 &properties.diffuse.path, &properties.ambientOcclusion.path, &properties.roughness.path, &properties.specular.path,
+				 &properties.metallic.path, &properties.normal.path, &properties.bump.path, &properties.emissionColor.path,
+				 &properties.emissionIntensity.path, &properties.clearcoatAmount.path, &properties.clearcoatRoughness.path,
+				 &properties.clearcoatNormal.path, &properties.transmission.path, &properties.sheenColor.path,
+				 &properties.sheenRoughness.path, &properties.anisotropy.path, &properties.ORM.path, &properties.opacity.path })
+		{
+			prefetch(*path);
+		}
+	}
+
+	std::shared_ptr<PrefetchedImage> TexturePrefetcher::take(const std::string& filePath)
+	{
+		std::shared_future<std::shared_ptr<PrefetchedImage>> image;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			const auto it = images.find(getImageKey(filePath));
+			if (it == images.end())
+			{
+				return nullptr;
+			}
+			image = it->second;
+			images.erase(it);
+		}
+		return image.get();
+	}
+
+	void TexturePrefetcher::clear()
+	{
+		std::unordered_map<std::string, std::shared_future<std::shared_ptr<PrefetchedImage>>> pending;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			pending.swap(images);
+		}
+		// Decodes which are still running release their pixels when their future goes out of scope
+		pending.clear();
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace vtx::importer
+{
+	struct AssimpMaterialProperties;
+
+	// Pixels decoded ahead of time, laid out as the texture upload expects them:
+	// 4 channels, bottom row first, either 8 bit or 32 bit float per channel.
+	struct PrefetchedImage
+	{
+		PrefetchedImage() = default;
+		~PrefetchedImage();
+
+		PrefetchedImage(const PrefetchedImage&) = delete;
+		PrefetchedImage& operator=(const PrefetchedImage&) = delete;
+
+		// Hands over the pixel buffer, it has to be released with free()
+		void* releasePixels();
+
+		int   width   = 0;
+		int   height  = 0;
+		bool  isFloat = false;
+		void* pixels  = nullptr;
+	};
+
+	// Decodes the textures referenced by the imported materials on the thread pool, so that decoding overlaps with mesh
+	// conversion and MDL compilation. The texture nodes pick the pixels up on their first sync instead of decoding them serially.
+	class TexturePrefetcher
+	{
+	public:
+		static TexturePrefetcher* get();
+
+		// Starts decoding the file unless it is already pending, only 8 bit rgb(a) and radiance hdr images are prefetched
+		void prefetch(const std::string& filePath);
+
+		void prefetch(const AssimpMaterialProperties& properties);
+
+		// Removes the image from the prefetcher, waiting for its decode if needed.
+		// Returns nullptr if the file was not prefetched or can't be decoded natively.
+		std::shared_ptr<PrefetchedImage> take(const std::string& filePath);
+
+		// Drops the images which have not been taken yet
+		void clear();
+
+	private:
+		TexturePrefetcher() = default;
+
+		std::mutex                                                                            mutex;
+		std::unordered_map<std::string, std::shared_future<std::shared_ptr<PrefetchedImage>>> images;
+	};
+}
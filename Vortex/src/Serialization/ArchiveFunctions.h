@@ -4,6 +4,7 @@
 #include <cereal/types/map.hpp>
 #include <cereal/types/string.hpp>
 #include <cereal/types/polymorphic.hpp>
+#include <cereal/archives/binary.hpp>
 
 //#include <cereal/types/memory.hpp>
 
@@ -195,11 +196,78 @@ namespace cereal
 	    archive(nvp(data,hasTangents), nvp(data,hasNormals), nvp(data,hasFaceAttributes));
     }
 
-    // Serialization for MeshNodeSaveData
-    template<class Archive>
-    void serialize(Archive& archive, vtx::serializer::MeshNodeSaveData& data)
-    {
-        archive(nvp(data,base), nvp(data,vertices), nvp(data,indices), nvp(data,faceAttributes), nvp(data,status));
+    // Binary archives write the attribute arrays as one block, the attribute structs are tightly packed floats and
+    // unsigned ints in the order of their serialize function, so the bytes are the same as the element wise encoding
+    static_assert(sizeof(vtx::graph::VertexAttributes) == 15 * sizeof(float), "VertexAttributes must match its element wise binary encoding");
+    static_assert(sizeof(vtx::graph::FaceAttributes) == sizeof(unsigned int), "FaceAttributes must match its element wise binary encoding");
+
+    template<class T>
+    void saveRawVector(BinaryOutputArchive& archive, const std::vector<T>& vector)
+    {
+        archive(make_size_tag(static_cast<size_type>(vector.size())));
+        archive(binary_data(vector.data(), vector.size() * sizeof(T)));
+    }
+
+    template<class T>
+    void loadRawVector(BinaryInputArchive& archive, std::vector<T>& vector)
+    {
+        size_type size;
+        archive(make_size_tag(size));
+        vector.resize(static_cast<size_t>(size));
+        archive(binary_data(vector.data(), static_cast<size_t>(size) * sizeof(T)));
+    }
+
+    // Serialization for MeshNodeSaveData, the arrays are written from the mesh node when the save data was built from one
+    template<class Archive>
+    void save(Archive& archive, vtx::serializer::MeshNodeSaveData const& data)
+    {
+        if (data.deferredSource)
+        {
+            // The mesh was not loaded, its arrays are read from the file it comes from
+            vtx::serializer::MeshNodeSaveData loaded;
+            vtx::graph::MeshPayload           payload;
+            if (!data.deferredSource->read(payload))
+            {
+                throw Exception("Could not read the data of mesh " + std::to_string(data.base.UID) + " from " + data.deferredSource->getFilePath());
+            }
+            loaded.base           = data.base;
+            loaded.status         = data.status;
+            loaded.vertices       = std::move(payload.vertices);
+            loaded.indices        = std::move(payload.indices);
+            loaded.faceAttributes = std::move(payload.faceAttributes);
+            save(archive, loaded);
+            return;
+        }
+        if constexpr (std::is_same_v<Archive, BinaryOutputArchive>)
+        {
+            archive(nvp(data,base));
+            saveRawVector(archive, data.getVertices());
+            saveRawVector(archive, data.getIndices());
+            saveRawVector(archive, data.getFaceAttributes());
+            archive(nvp(data,status));
+        }
+        else
+        {
+            archive(nvp(data,base), make_nvp("vertices", data.getVertices()), make_nvp("indices", data.getIndices()),
+                    make_nvp("faceAttributes", data.getFaceAttributes()), nvp(data,status));
+        }
+    }
+
+    template<class Archive>
+    void load(Archive& archive, vtx::serializer::MeshNodeSaveData& data)
+    {
+        if constexpr (std::is_same_v<Archive, BinaryInputArchive>)
+        {
+            archive(nvp(data,base));
+            loadRawVector(archive, data.vertices);
+            loadRawVector(archive, data.indices);
+            loadRawVector(archive, data.faceAttributes);
+            archive(nvp(data,status));
+        }
+        else
+        {
+            archive(nvp(data,base), nvp(data,vertices), nvp(data,indices), nvp(data,faceAttributes), nvp(data,status));
+        }
     }
 
     // Serialization for TransformNodeSaveData
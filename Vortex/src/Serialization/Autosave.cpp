@@ -0,0 +1,875 @@
+#include "Autosave.h"
+#include <filesystem>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+#include "ArchiveFunctions.h"
+#include "SceneContainer.h"
+#include <cereal/archives/binary.hpp>
+#include "Core/Hashing.h"
+#include "Core/Options.h"
+#include "Core/ThreadPool.h"
+#include "Scene/Scene.h"
+#include "Scene/SceneIndexManager.h"
+#include "Scene/Nodes/Renderer.h"
+
+namespace cereal
+{
+	template<class Archive>
+	void serialize(Archive& archive, vtx::serializer::DeltaRecord& data)
+	{
+		archive(nvp(data, list), nvp(data, UID), nvp(data, payload));
+	}
+
+	template<class Archive>
+	void serialize(Archive& archive, vtx::serializer::DeltaRemoval& data)
+	{
+		archive(nvp(data, list), nvp(data, UID));
+	}
+
+	template<class Archive>
+	void serialize(Archive& archive, vtx::serializer::DeltaSaveData& data)
+	{
+		archive(nvp(data, sequence), nvp(data, baseChecksum), nvp(data, activeRendererUID), nvp(data, activeCameraUID),
+				nvp(data, sceneRootUID), nvp(data, records), nvp(data, removals));
+	}
+}
+
+namespace vtx::serializer
+{
+	// GraphSaveData vectors, records and removals refer to them by index
+	enum SaveDataList : uint32_t
+	{
+		SL_MESHES,
+		SL_TRANSFORMS,
+		SL_MATERIALS,
+		SL_INSTANCES,
+		SL_GROUPS,
+		SL_ENVIRONMENT_LIGHTS,
+		SL_CAMERAS,
+		SL_RENDERERS,
+		SL_SHADER_NODES
+	};
+
+	template<typename F>
+	static void forEachSaveDataList(GraphSaveData& graphSaveData, F&& function)
+	{
+		function(SL_MESHES, graphSaveData.meshes);
+		function(SL_TRANSFORMS, graphSaveData.transforms);
+		function(SL_MATERIALS, graphSaveData.materials);
+		function(SL_INSTANCES, graphSaveData.instances);
+		function(SL_GROUPS, graphSaveData.groups);
+		function(SL_ENVIRONMENT_LIGHTS, graphSaveData.environmentLights);
+		function(SL_CAMERAS, graphSaveData.cameras);
+		function(SL_RENDERERS, graphSaveData.renderers);
+		function(SL_SHADER_NODES, graphSaveData.shaderNodes);
+	}
+
+	static uint64_t recordKey(const uint32_t list, const vtxID UID)
+	{
+		return (uint64_t)list << 32 | (uint64_t)UID;
+	}
+
+	template<typename SaveDataStruct>
+	static std::string encodeRecord(const SaveDataStruct& saveData)
+	{
+		std::ostringstream stream(std::ios::binary);
+		{
+			cereal::BinaryOutputArchive archive(stream);
+			archive(saveData);
+		}
+		return stream.str();
+	}
+
+	template<typename SaveDataStruct>
+	static void decodeRecord(const std::string& payload, SaveDataStruct& saveData)
+	{
+		std::istringstream         stream(payload, std::ios::binary);
+		cereal::BinaryInputArchive archive(stream);
+		archive(saveData);
+	}
+
+	// Meshes are too large to be encoded on every snapshot, the fingerprint only covers their name, status, sizes and the file
+	// of deferred arrays. Any change of the arrays is reported by the caller through the change epoch of the scene index
+	// manager, which also covers a mesh deleted and created again under the same UID. The addresses of the arrays are left
+	// out on purpose, arrays replaced by new ones allocated at the same place would look unchanged.
+	static uint64_t meshFingerprint(const MeshNodeSaveData& mesh)
+	{
+		uint64_t hash = utl::hashString(mesh.base.name);
+		hash = utl::hashValue(mesh.status, hash);
+		hash = utl::hashString(mesh.deferredSource ? mesh.deferredSource->getFilePath() : std::string(), hash);
+		hash = utl::hashValue(mesh.getVertices().size(), hash);
+		hash = utl::hashValue(mesh.getIndices().size(), hash);
+		hash = utl::hashValue(mesh.getFaceAttributes().size(), hash);
+		return hash;
+	}
+
+	// Snapshot of the record content, used to compare two graphs
+	static std::map<uint64_t, uint64_t> recordDigest(GraphSaveData& graphSaveData)
+	{
+		std::map<uint64_t, uint64_t> digest;
+		forEachSaveDataList(graphSaveData, [&digest](const uint32_t list, auto& saveDataStructs)
+		{
+			for (const auto& saveData : saveDataStructs)
+			{
+				digest[recordKey(list, saveData.base.UID)] = utl::hashString(encodeRecord(saveData));
+			}
+		});
+		return digest;
+	}
+
+	static bool writeDelta(const std::string& filePath, const DeltaSaveData& delta)
+	{
+		const std::string tempPath = filePath + ".tmp";
+		try
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			if (!file)
+			{
+				VTX_ERROR("Autosave: could not open {} for writing", tempPath);
+				return false;
+			}
+			cereal::BinaryOutputArchive archive(file);
+			archive(delta);
+		}
+		catch (const std::exception& e)
+		{
+			VTX_ERROR("Autosave: failed to write {}: {}", tempPath, e.what());
+			return false;
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempPath, filePath, error);
+		if (error)
+		{
+			VTX_ERROR("Autosave: could not move {} to {}: {}", tempPath, filePath, error.message());
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+		return true;
+	}
+
+	static bool readDelta(const std::string& filePath, DeltaSaveData& delta)
+	{
+		try
+		{
+			std::ifstream              file(filePath, std::ios::binary);
+			cereal::BinaryInputArchive archive(file);
+			archive(delta);
+		}
+		catch (const std::exception& e)
+		{
+			VTX_ERROR("Autosave: failed to read {}: {}", filePath, e.what());
+			return false;
+		}
+		return true;
+	}
+
+	// Applies the deltas following the base in order. Stops at the first delta which is missing, unreadable or was written
+	// against another base, the ones after it can't be applied either. Returns the number of applied deltas.
+	static uint32_t applyDeltas(const std::string& basePath, const uint64_t baseChecksum, GraphSaveData& graphSaveData, std::set<vtxID>* upsertedMeshes)
+	{
+		uint32_t sequence = 1;
+		for (;; ++sequence)
+		{
+			const std::string deltaPath = Autosave::getDeltaPath(basePath, sequence);
+			if (!std::filesystem::exists(deltaPath))
+			{
+				break;
+			}
+			DeltaSaveData delta;
+			if (!readDelta(deltaPath, delta))
+			{
+				break;
+			}
+			if (delta.baseChecksum != baseChecksum || delta.sequence != sequence)
+			{
+				VTX_WARN("Autosave: {} was written for another base, it and the following deltas are ignored", deltaPath);
+				break;
+			}
+			Autosave::applyDelta(graphSaveData, delta);
+			if (upsertedMeshes != nullptr)
+			{
+				for (const DeltaRecord& record : delta.records)
+				{
+					if (record.list == SL_MESHES)
+					{
+						upsertedMeshes->insert(record.UID);
+					}
+				}
+			}
+		}
+		return sequence - 1;
+	}
+
+	static void removeDeltas(const std::string& basePath)
+	{
+		std::error_code error;
+		for (uint32_t sequence = 1; std::filesystem::exists(Autosave::getDeltaPath(basePath, sequence), error); ++sequence)
+		{
+			std::filesystem::remove(Autosave::getDeltaPath(basePath, sequence), error);
+		}
+	}
+
+	// Base of a new session, named after the current time so that an earlier session or scene is kept for recovery
+	static std::string createSessionBasePath()
+	{
+		const std::string folder = getOptions()->autosaveFolder;
+		const std::string name   = "autosave_" + utl::getDateTime();
+		std::string       path   = folder + name + ".vtxc";
+		std::error_code   error;
+		for (int suffix = 1; std::filesystem::exists(path, error); ++suffix)
+		{
+			path = folder + name + "_" + std::to_string(suffix) + ".vtxc";
+		}
+		return path;
+	}
+
+	// The base is written on the thread pool while the scene keeps changing, the arrays read from the mesh nodes are copied.
+	// Above the copy budget the copies would make a large scene need twice its memory, the arrays are left in the nodes and
+	// false is returned, the base has to be written before the scene changes. Deferred meshes are written from their file,
+	// which their source keeps mapped.
+	static bool detachMeshes(GraphSaveData& graphSaveData)
+	{
+		uint64_t size = 0;
+		for (const MeshNodeSaveData& mesh : graphSaveData.meshes)
+		{
+			if (mesh.sourceNode)
+			{
+				size += mesh.getVertices().size() * sizeof(graph::VertexAttributes) + mesh.getIndices().size() * sizeof(vtxID) +
+					mesh.getFaceAttributes().size() * sizeof(graph::FaceAttributes);
+			}
+		}
+		if (size > (uint64_t)std::max(getOptions()->autosaveCopyBudget, 0) * 1024 * 1024)
+		{
+			VTX_INFO("Autosave: {} MB of mesh arrays exceed the copy budget, the base is written in place", size / (1024 * 1024));
+			return false;
+		}
+
+		utl::parallelFor(graphSaveData.meshes.size(), [&graphSaveData](const size_t i)
+		{
+			MeshNodeSaveData& mesh = graphSaveData.meshes[i];
+			if (mesh.sourceNode)
+			{
+				mesh.vertices       = mesh.getVertices();
+				mesh.indices        = mesh.getIndices();
+				mesh.faceAttributes = mesh.getFaceAttributes();
+				mesh.sourceNode     = nullptr;
+			}
+		}, 1);
+		return true;
+	}
+
+	Autosave* Autosave::get()
+	{
+		static Autosave autosave;
+		return &autosave;
+	}
+
+	void Autosave::update()
+	{
+		const Options* options = getOptions();
+		if (!options->enableAutosave || sinceLastSnapshot.elapsed() < options->autosaveInterval)
+		{
+			return;
+		}
+		// The previous snapshot is still being written, try again next frame
+		if (isWriting())
+		{
+			return;
+		}
+		snapshot();
+		sinceLastSnapshot.reset();
+	}
+
+	bool Autosave::snapshot()
+	{
+		if (isWriting())
+		{
+			return false;
+		}
+
+		const graph::Scene* scene = graph::Scene::get();
+		if (!scene->renderer || !scene->renderer->sceneRoot)
+		{
+			return false;
+		}
+
+		createBasePath();
+		const std::shared_ptr<graph::SceneIndexManager> sim   = graph::Scene::getSim();
+		const uint64_t                                  epoch = sim->getChangeEpoch();
+
+		auto graphSaveData = std::make_shared<GraphSaveData>();
+		graphSaveData->prepareSaveData(basePath, false);
+
+		const uint64_t previousEpoch = lastSnapshotEpoch;
+		const bool     isTaken       = snapshot(graphSaveData, [&sim, previousEpoch](const MeshNodeSaveData& mesh)
+		{
+			return sim->getLastChangeEpoch(mesh.base.UID) > previousEpoch;
+		});
+		if (isTaken)
+		{
+			lastSnapshotEpoch = epoch;
+		}
+		return isTaken;
+	}
+
+	bool Autosave::snapshot(const std::shared_ptr<GraphSaveData>& graphSaveData, const std::function<bool(const MeshNodeSaveData&)>& isMeshChanged)
+	{
+		if (isWriting())
+		{
+			return false;
+		}
+
+		Timer timer;
+		createBasePath();
+		if (baseChecksum == 0)
+		{
+			// The state of the records is taken now, the deltas which follow are written against it
+			sequence = 0;
+			diff(*graphSaveData, nullptr, true);
+			const std::string path = basePath;
+			auto writeTask = [graphSaveData, path]()
+			{
+				WriteResult result;
+				result.newBaseChecksum = writeBase(path, *graphSaveData);
+				result.isWritten       = result.newBaseChecksum != 0;
+				return result;
+			};
+			if (!detachMeshes(*graphSaveData))
+			{
+				// The arrays are read from the nodes, they can't change before the base is written
+				std::promise<WriteResult> written;
+				written.set_value(writeTask());
+				pendingWrite = written.get_future();
+				VTX_INFO("Autosave: base for {} written in {} ms", basePath, timer.elapsedMillis());
+				return true;
+			}
+			VTX_INFO("Autosave: base for {} prepared in {} ms", basePath, timer.elapsedMillis());
+			pendingWrite = ThreadPool::get()->submit(writeTask);
+			return true;
+		}
+
+		auto delta = std::make_shared<DeltaSaveData>(diff(*graphSaveData, isMeshChanged, false));
+		if (delta->records.empty() && delta->removals.empty())
+		{
+			return true;
+		}
+		delta->sequence     = ++sequence;
+		delta->baseChecksum = baseChecksum;
+		VTX_INFO("Autosave: delta {} with {} changed and {} removed nodes prepared in {} ms", sequence, delta->records.size(), delta->removals.size(), timer.elapsedMillis());
+
+		const bool        isCompacting = (int)sequence >= getOptions()->autosaveMaxDeltas;
+		const std::string path         = basePath;
+		pendingWrite = ThreadPool::get()->submit([delta, path, isCompacting]()
+		{
+			WriteResult result;
+			result.isWritten = writeDelta(getDeltaPath(path, delta->sequence), *delta);
+			if (result.isWritten && isCompacting)
+			{
+				result.newBaseChecksum = foldDeltas(path);
+			}
+			return result;
+		});
+		return true;
+	}
+
+	void Autosave::reset(const std::string& newBasePath)
+	{
+		wait();
+		recordHashes.clear();
+		basePath = newBasePath;
+		baseChecksum      = 0;
+		sequence          = 0;
+		lastSnapshotEpoch = 0;
+		sinceLastSnapshot.reset();
+	}
+
+	void Autosave::wait()
+	{
+		if (pendingWrite.valid())
+		{
+			finishWrite();
+		}
+	}
+
+	void Autosave::createBasePath()
+	{
+		if (basePath.empty())
+		{
+			basePath = createSessionBasePath();
+			utl::createDirectory(basePath);
+		}
+	}
+
+	bool Autosave::isWriting()
+	{
+		if (!pendingWrite.valid())
+		{
+			return false;
+		}
+		if (pendingWrite.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			return true;
+		}
+		finishWrite();
+		return false;
+	}
+
+	void Autosave::finishWrite()
+	{
+		const WriteResult result = pendingWrite.get();
+		if (!result.isWritten)
+		{
+			// The base or the delta is lost, the following deltas would not apply, start over with a new base
+			recordHashes.clear();
+			baseChecksum = 0;
+			sequence     = 0;
+		}
+		else if (result.newBaseChecksum != 0)
+		{
+			baseChecksum = result.newBaseChecksum;
+			sequence     = 0;
+		}
+	}
+
+	bool Autosave::compact()
+	{
+		wait();
+		if (baseChecksum == 0 || sequence == 0)
+		{
+			return baseChecksum != 0;
+		}
+		const uint64_t checksum = foldDeltas(basePath);
+		if (checksum == 0)
+		{
+			return false;
+		}
+		baseChecksum = checksum;
+		sequence     = 0;
+		return true;
+	}
+
+	std::string Autosave::getBasePath() const
+	{
+		return basePath;
+	}
+
+	std::string Autosave::getDeltaPath(const std::string& basePath, const uint32_t sequence)
+	{
+		return basePath + ".delta." + std::to_string(sequence);
+	}
+
+	uint64_t Autosave::writeBase(const std::string& basePath, GraphSaveData& graphSaveData)
+	{
+		Timer timer;
+		if (!writeSceneContainer(basePath, graphSaveData))
+		{
+			return 0;
+		}
+		uint64_t checksum;
+		{
+			SceneContainerReader reader;
+			if (!reader.open(basePath))
+			{
+				return 0;
+			}
+			checksum = reader.getMetadataChecksum();
+		}
+
+		// Deltas of a previous base written to the same path, after a failed write
+		removeDeltas(basePath);
+		VTX_INFO("Autosave: base written to {} in {} ms", basePath, timer.elapsedMillis());
+		return checksum;
+	}
+
+	DeltaSaveData Autosave::diff(GraphSaveData& graphSaveData, const std::function<bool(const MeshNodeSaveData&)>& isMeshChanged, const bool isBase)
+	{
+		DeltaSaveData delta;
+		delta.activeRendererUID = graphSaveData.activeRendererUID;
+		delta.activeCameraUID   = graphSaveData.activeCameraUID;
+		delta.sceneRootUID      = graphSaveData.sceneRootUID;
+
+		std::map<uint64_t, uint64_t> hashes;
+		forEachSaveDataList(graphSaveData, [&](const uint32_t list, auto& saveDataStructs)
+		{
+			using SaveDataStruct = typename std::decay_t<decltype(saveDataStructs)>::value_type;
+
+			const size_t             count = saveDataStructs.size();
+			std::vector<uint64_t>    recordHash(count);
+			std::vector<std::string> payloads(count);
+			std::vector<char>        isChanged(count, 0);
+			utl::parallelFor(count, [&](const size_t i)
+			{
+				const SaveDataStruct& saveData = saveDataStructs[i];
+				const auto            previous = recordHashes.find(recordKey(list, saveData.base.UID));
+				if constexpr (std::is_same_v<SaveDataStruct, MeshNodeSaveData>)
+				{
+					recordHash[i] = meshFingerprint(saveData);
+					isChanged[i]  = previous == recordHashes.end() || previous->second != recordHash[i] || (isMeshChanged && isMeshChanged(saveData));
+					if (isChanged[i] && !isBase)
+					{
+						payloads[i] = encodeRecord(saveData);
+					}
+				}
+				else
+				{
+					std::string payload = encodeRecord(saveData);
+					recordHash[i]       = utl::hashString(payload);
+					isChanged[i]        = previous == recordHashes.end() || previous->second != recordHash[i];
+					if (isChanged[i] && !isBase)
+					{
+						payloads[i] = std::move(payload);
+					}
+				}
+			}, list == SL_MESHES ? 1 : 64);
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				const vtxID UID = saveDataStructs[i].base.UID;
+				hashes[recordKey(list, UID)] = recordHash[i];
+				if (isChanged[i] && !isBase)
+				{
+					delta.records.push_back({ list, UID, std::move(payloads[i]) });
+				}
+			}
+		});
+
+		for (const auto& [key, hash] : recordHashes)
+		{
+			if (hashes.find(key) == hashes.end())
+			{
+				delta.removals.push_back({ (uint32_t)(key >> 32), (vtxID)(key & 0xFFFFFFFFu) });
+			}
+		}
+		recordHashes = std::move(hashes);
+		return delta;
+	}
+
+	bool Autosave::replay(const std::string& basePath, GraphSaveData& graphSaveData)
+	{
+		Timer    timer;
+		uint64_t checksum = 0;
+		if (!readSceneContainer(basePath, graphSaveData, &checksum))
+		{
+			return false;
+		}
+
+		uint32_t numDeltas = 0;
+		try
+		{
+			numDeltas = applyDeltas(basePath, checksum, graphSaveData, nullptr);
+		}
+		catch (const std::exception& e)
+		{
+			VTX_ERROR("Autosave: failed to apply the deltas of {}: {}", basePath, e.what());
+			return false;
+		}
+		if (numDeltas != 0)
+		{
+			VTX_INFO("Autosave: {} replayed with {} deltas in {} ms", basePath, numDeltas, timer.elapsedMillis());
+		}
+		return true;
+	}
+
+	uint64_t Autosave::foldDeltas(const std::string& basePath)
+	{
+		Timer             timer;
+		const std::string compactedPath = basePath + ".compacted";
+		uint32_t          numDeltas     = 0;
+		{
+			SceneContainerReader base;
+			GraphSaveData        graphSaveData;
+			if (!base.open(basePath) || !decodeSceneMetadata(base, graphSaveData))
+			{
+				return 0;
+			}
+
+			std::set<vtxID> upsertedMeshes;
+			try
+			{
+				numDeltas = applyDeltas(basePath, base.getMetadataChecksum(), graphSaveData, &upsertedMeshes);
+			}
+			catch (const std::exception& e)
+			{
+				VTX_ERROR("Autosave: failed to apply the deltas of {}: {}", basePath, e.what());
+				return 0;
+			}
+			if (numDeltas == 0)
+			{
+				return base.getMetadataChecksum();
+			}
+
+			SceneContainerWriter writer;
+			for (const MeshNodeSaveData& mesh : graphSaveData.meshes)
+			{
+				if (upsertedMeshes.count(mesh.base.UID) != 0)
+				{
+					writer.addSection(SK_MESH_VERTICES, mesh.base.UID, mesh.getVertices());
+					writer.addSection(SK_MESH_INDICES, mesh.base.UID, mesh.getIndices());
+					writer.addSection(SK_MESH_FACES, mesh.base.UID, mesh.getFaceAttributes());
+					continue;
+				}
+				// Untouched since the base, the sections are written from the mapping
+				for (const SectionKind kind : { SK_MESH_VERTICES, SK_MESH_INDICES, SK_MESH_FACES })
+				{
+					const SceneContainer::SectionEntry* entry = base.findSection(kind, mesh.base.UID);
+					if (entry == nullptr)
+					{
+						VTX_ERROR("Autosave: mesh {} has no data in {}", mesh.base.UID, basePath);
+						return 0;
+					}
+					writer.addSection(kind, mesh.base.UID, base.getSectionData(*entry), entry->count, entry->elementSize);
+				}
+			}
+			if (!writer.write(compactedPath, encodeSceneMetadata(graphSaveData)))
+			{
+				return 0;
+			}
+		}
+
+		// The base is unmapped at this point and can be replaced
+		std::error_code error;
+		std::filesystem::rename(compactedPath, basePath, error);
+		if (error)
+		{
+			VTX_ERROR("Autosave: could not move {} to {}: {}", compactedPath, basePath, error.message());
+			std::filesystem::remove(compactedPath, error);
+			return 0;
+		}
+		removeDeltas(basePath);
+
+		SceneContainerReader compacted;
+		if (!compacted.open(basePath))
+		{
+			return 0;
+		}
+		VTX_INFO("Autosave: {} deltas folded into {} in {} ms", numDeltas, basePath, timer.elapsedMillis());
+		return compacted.getMetadataChecksum();
+	}
+
+	void Autosave::applyDelta(GraphSaveData& graphSaveData, const DeltaSaveData& delta)
+	{
+		forEachSaveDataList(graphSaveData, [&delta](const uint32_t list, auto& saveDataStructs)
+		{
+			using SaveDataStruct = typename std::decay_t<decltype(saveDataStructs)>::value_type;
+
+			std::vector<const DeltaRecord*> records;
+			for (const DeltaRecord& record : delta.records)
+			{
+				if (record.list == list)
+				{
+					records.push_back(&record);
+				}
+			}
+			bool hasRemovals = false;
+			for (const DeltaRemoval& removal : delta.removals)
+			{
+				hasRemovals |= removal.list == list;
+			}
+			if (records.empty() && !hasRemovals)
+			{
+				return;
+			}
+
+			std::unordered_map<vtxID, size_t> indexOfUID;
+			indexOfUID.reserve(saveDataStructs.size() + records.size());
+			for (size_t i = 0; i < saveDataStructs.size(); ++i)
+			{
+				indexOfUID[saveDataStructs[i].base.UID] = i;
+			}
+			std::vector<char> isRemoved(saveDataStructs.size(), 0);
+			for (const DeltaRemoval& removal : delta.removals)
+			{
+				if (const auto it = indexOfUID.find(removal.UID); removal.list == list && it != indexOfUID.end())
+				{
+					isRemoved[it->second] = 1;
+				}
+			}
+
+			std::vector<SaveDataStruct> decoded(records.size());
+			utl::parallelFor(records.size(), [&](const size_t i)
+			{
+				decodeRecord(records[i]->payload, decoded[i]);
+			});
+			for (size_t i = 0; i < records.size(); ++i)
+			{
+				if (const auto it = indexOfUID.find(records[i]->UID); it != indexOfUID.end())
+				{
+					saveDataStructs[it->second] = std::move(decoded[i]);
+					isRemoved[it->second]       = 0;
+				}
+				else
+				{
+					indexOfUID[records[i]->UID] = saveDataStructs.size();
+					saveDataStructs.push_back(std::move(decoded[i]));
+					isRemoved.push_back(0);
+				}
+			}
+
+			// Removed entries are dropped keeping the order of the others
+			size_t kept = 0;
+			for (size_t i = 0; i < saveDataStructs.size(); ++i)
+			{
+				if (isRemoved[i])
+				{
+					continue;
+				}
+				if (kept != i)
+				{
+					saveDataStructs[kept] = std::move(saveDataStructs[i]);
+				}
+				++kept;
+			}
+			saveDataStructs.erase(saveDataStructs.begin() + kept, saveDataStructs.end());
+		});
+
+		graphSaveData.activeRendererUID = delta.activeRendererUID;
+		graphSaveData.activeCameraUID   = delta.activeCameraUID;
+		graphSaveData.sceneRootUID      = delta.sceneRootUID;
+	}
+
+	bool Autosave::benchmark(const size_t numNodes, const float changedFraction)
+	{
+		constexpr size_t numRounds       = 4;
+		constexpr size_t verticesPerMesh = 4096;
+		const size_t     numMeshes       = std::max<size_t>(numNodes / 1000, 1);
+		const size_t     numChanged      = std::max<size_t>((size_t)((float)numNodes * changedFraction), 1);
+
+		// Transforms and groups, plus a few meshes
+		GraphSaveData graphSaveData;
+		vtxID         nextUID = 1;
+		auto makeBase = [&nextUID](const std::string& name, const graph::NodeType type)
+		{
+			BaseNodeSaveData base;
+			base.UID  = nextUID++;
+			base.TID  = base.UID;
+			base.name = name + "_" + std::to_string(base.UID);
+			base.type = type;
+			return base;
+		};
+		auto addTransform = [&]()
+		{
+			TransformNodeSaveData transform;
+			transform.base            = makeBase("Transform", graph::NT_TRANSFORM);
+			transform.affineTransform = math::affine3f(math::Identity);
+			graphSaveData.transforms.push_back(std::move(transform));
+		};
+		auto addMesh = [&]()
+		{
+			MeshNodeSaveData mesh;
+			mesh.base   = makeBase("Mesh", graph::NT_MESH);
+			mesh.status = { true, true, true };
+			mesh.vertices.resize(verticesPerMesh);
+			mesh.indices.resize(verticesPerMesh * 3);
+			mesh.faceAttributes.resize(verticesPerMesh);
+			for (size_t v = 0; v < verticesPerMesh; ++v)
+			{
+				mesh.vertices[v].position = math::vec3f((float)v, (float)mesh.base.UID, 0.0f);
+			}
+			for (size_t v = 0; v < mesh.indices.size(); ++v)
+			{
+				mesh.indices[v] = (vtxID)((v * 7919) % verticesPerMesh);
+			}
+			graphSaveData.meshes.push_back(std::move(mesh));
+		};
+		for (size_t i = 0; i < numNodes / 2; ++i)
+		{
+			addTransform();
+			GroupNodeSaveData group;
+			group.base         = makeBase("Group", graph::NT_GROUP);
+			group.transformUID = graphSaveData.transforms.back().base.UID;
+			graphSaveData.groups.push_back(std::move(group));
+		}
+		for (size_t i = 0; i < numMeshes; ++i)
+		{
+			addMesh();
+		}
+		graphSaveData.activeRendererUID = 0;
+		graphSaveData.activeCameraUID   = 0;
+		graphSaveData.sceneRootUID      = graphSaveData.groups.empty() ? 0 : graphSaveData.groups.front().base.UID;
+
+		Autosave autosave;
+		autosave.basePath = (std::filesystem::temp_directory_path() / "vortexAutosaveBenchmark.vtxc").string();
+		Timer timer;
+		autosave.diff(graphSaveData, nullptr, true);
+		autosave.baseChecksum = writeBase(autosave.basePath, graphSaveData);
+		if (autosave.baseChecksum == 0)
+		{
+			VTX_ERROR("Autosave benchmark: could not write the base");
+			return false;
+		}
+		const float    baseTime = timer.elapsedMillis();
+		const uint64_t baseSize = std::filesystem::file_size(autosave.basePath);
+		VTX_INFO("Autosave benchmark, {} nodes and {} meshes, {} changed nodes per snapshot", graphSaveData.transforms.size() + graphSaveData.groups.size(), numMeshes, numChanged);
+		VTX_INFO("    base:     {:.1f} ms, {} KB", baseTime, baseSize / 1024);
+
+		for (size_t round = 1; round <= numRounds; ++round)
+		{
+			// Transforms moved, a mesh edited in place, a group and a transform removed, a transform and a mesh added
+			for (size_t i = 0; i < numChanged; ++i)
+			{
+				graphSaveData.transforms[(round * 7919 + i * 104729) % graphSaveData.transforms.size()].affineTransform.p.x += 1.0f;
+			}
+			MeshNodeSaveData& editedMesh = graphSaveData.meshes[round % graphSaveData.meshes.size()];
+			editedMesh.vertices[round].position.z += 1.0f;
+			const vtxID editedMeshUID = editedMesh.base.UID;
+			graphSaveData.groups.pop_back();
+			graphSaveData.transforms.erase(graphSaveData.transforms.begin() + (long long)round);
+			addTransform();
+			addMesh();
+
+			timer.reset();
+			DeltaSaveData delta = autosave.diff(graphSaveData, [editedMeshUID](const MeshNodeSaveData& mesh)
+			{
+				return mesh.base.UID == editedMeshUID;
+			}, false);
+			const float diffTime = timer.elapsedMillis();
+			delta.sequence       = ++autosave.sequence;
+			delta.baseChecksum   = autosave.baseChecksum;
+			timer.reset();
+			const std::string deltaPath = getDeltaPath(autosave.basePath, delta.sequence);
+			if (!writeDelta(deltaPath, delta))
+			{
+				VTX_ERROR("Autosave benchmark: could not write {}", deltaPath);
+				return false;
+			}
+			const float writeTime = timer.elapsedMillis();
+			VTX_INFO("    delta {}:  diff {:.1f} ms, write {:.1f} ms, {} records, {} removals, {} KB",
+					 delta.sequence, diffTime, writeTime, delta.records.size(), delta.removals.size(), std::filesystem::file_size(deltaPath) / 1024);
+		}
+
+		const std::map<uint64_t, uint64_t> expected = recordDigest(graphSaveData);
+		auto isMatching = [&](const char* label)
+		{
+			GraphSaveData replayed;
+			timer.reset();
+			const bool  isReplayed = replay(autosave.basePath, replayed);
+			const float replayTime = timer.elapsedMillis();
+			const bool  isEqual    = isReplayed && recordDigest(replayed) == expected &&
+				replayed.activeRendererUID == graphSaveData.activeRendererUID && replayed.activeCameraUID == graphSaveData.activeCameraUID &&
+				replayed.sceneRootUID == graphSaveData.sceneRootUID;
+			VTX_INFO("    {}: {:.1f} ms, matches the graph: {}", label, replayTime, isEqual);
+			return isEqual;
+		};
+		bool isPassed = isMatching("replay  ");
+
+		timer.reset();
+		const uint64_t compactedChecksum = foldDeltas(autosave.basePath);
+		const float    compactTime       = timer.elapsedMillis();
+		const bool     isCompacted       = compactedChecksum != 0 && !std::filesystem::exists(getDeltaPath(autosave.basePath, 1));
+		VTX_INFO("    compact:  {:.1f} ms, deltas removed: {}", compactTime, isCompacted);
+		isPassed = isMatching("compacted") && isCompacted && isPassed;
+
+		timer.reset();
+		const std::string fullPath = (std::filesystem::temp_directory_path() / "vortexAutosaveBenchmarkFull.vtxc").string();
+		writeSceneContainer(fullPath, graphSaveData);
+		VTX_INFO("    full save: {:.1f} ms", timer.elapsedMillis());
+
+		std::error_code error;
+		removeDeltas(autosave.basePath);
+		std::filesystem::remove(autosave.basePath, error);
+		std::filesystem::remove(fullPath, error);
+		return isPassed;
+	}
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Core/Timer.h"
+#include "Core/VortexID.h"
+
+namespace vtx::serializer
+{
+	struct GraphSaveData;
+	struct MeshNodeSaveData;
+
+	// Save data of one node encoded on its own with the cereal binary archive, list is the GraphSaveData vector holding it
+	struct DeltaRecord
+	{
+		uint32_t    list = 0;
+		vtxID       UID  = 0;
+		std::string payload;
+	};
+
+	struct DeltaRemoval
+	{
+		uint32_t list = 0;
+		vtxID    UID  = 0;
+	};
+
+	// Changes of the graph save data since the previous snapshot
+	struct DeltaSaveData
+	{
+		uint32_t                  sequence          = 0; // Deltas of a base are numbered from 1
+		uint64_t                  baseChecksum      = 0; // Metadata checksum of the base container the delta applies to
+		vtxID                     activeRendererUID = 0;
+		vtxID                     activeCameraUID   = 0;
+		vtxID                     sceneRootUID      = 0;
+		std::vector<DeltaRecord>  records; // Added and changed nodes
+		std::vector<DeltaRemoval> removals;
+	};
+
+	// Incremental autosave. The first snapshot writes a base scene container, the following ones only write the save data
+	// of the nodes which changed since the previous snapshot as a delta file next to the base. Once enough deltas piled up
+	// they are folded into a new base. Each session and each loaded scene gets its own base, named after the time of its
+	// first snapshot, so the recovery data of a previous session is never overwritten.
+	// Snapshots are taken on the main thread between frames: the save data is prepared and the changed records are encoded
+	// there, the base or delta file is written and the compaction runs on the thread pool. A base whose mesh arrays exceed
+	// the copy budget is written on the main thread instead, so that the arrays don't have to be copied.
+	class Autosave
+	{
+	public:
+		// The autosave of the scene, other instances (tests, benchmark) keep their own base and records
+		static Autosave* get();
+
+		Autosave() = default;
+
+		// Takes a snapshot once the autosave interval elapsed, called once per frame
+		void update();
+
+		// Returns false if no snapshot could be taken, e.g. because the previous one is still being written
+		bool snapshot();
+
+		// Snapshot of save data prepared by the caller, isMeshChanged tells if the arrays of a mesh changed since the previous
+		// snapshot. The save data must not be modified afterwards, it may still be written on the thread pool.
+		bool snapshot(const std::shared_ptr<GraphSaveData>& graphSaveData, const std::function<bool(const MeshNodeSaveData&)>& isMeshChanged);
+
+		// The scene has been replaced, the next snapshot writes a new base at newBasePath or, if empty, under a new name
+		void reset(const std::string& newBasePath = "");
+
+		// Waits for the snapshot being written, if any
+		void wait();
+
+		// Folds the deltas written so far into a new base
+		bool compact();
+
+		std::string getBasePath() const;
+
+		static std::string getDeltaPath(const std::string& basePath, uint32_t sequence);
+
+		// Save data of the base container with its deltas applied in order. A container without deltas is simply read.
+		static bool replay(const std::string& basePath, GraphSaveData& graphSaveData);
+
+		// Rewrites the base with its deltas applied and removes the deltas, meshes which no delta touched are copied straight
+		// from the mapped base. Returns the metadata checksum of the new base, 0 on failure.
+		static uint64_t foldDeltas(const std::string& basePath);
+
+		static void applyDelta(GraphSaveData& graphSaveData, const DeltaSaveData& delta);
+
+		// Takes snapshots of a synthetic graph with a fraction of its nodes changed, added or removed between them, replays and
+		// compacts the deltas and checks the result against the graph. Logs the results and the delta and full save times,
+		// returns false if the replayed or the compacted graph doesn't match.
+		static bool benchmark(size_t numNodes = 200000, float changedFraction = 0.01f);
+
+	private:
+		struct WriteResult
+		{
+			bool     isWritten       = false;
+			uint64_t newBaseChecksum = 0; // Set if the deltas have been folded into a new base
+		};
+
+		void createBasePath();
+
+		// False once the background write is done, its result is then taken over
+		bool isWriting();
+
+		// Blocks until the background write is done and takes over its result
+		void finishWrite();
+
+		// Writes the container and removes the deltas left by a previous base at the same path. Runs on the thread pool, the
+		// mesh arrays have to be owned by the save data. Returns the metadata checksum of the base, 0 on failure.
+		static uint64_t writeBase(const std::string& basePath, GraphSaveData& graphSaveData);
+
+		// Records of the save data which differ from the previous snapshot and records of the nodes which disappeared.
+		// The encoding of meshes is skipped, they count as changed if isMeshChanged says so or if their name, status or sizes changed.
+		// With isBase only the state of the records is updated, nothing is encoded for the delta.
+		DeltaSaveData diff(GraphSaveData& graphSaveData, const std::function<bool(const MeshNodeSaveData&)>& isMeshChanged, bool isBase);
+
+		std::map<uint64_t, uint64_t> recordHashes; // By list and UID, content hash or mesh fingerprint of the last snapshot
+		std::string                  basePath;
+		uint64_t                     baseChecksum      = 0;
+		uint32_t                     sequence          = 0;
+		uint64_t                     lastSnapshotEpoch = 0;
+		Timer                        sinceLastSnapshot;
+		std::future<WriteResult>     pendingWrite;
+	};
+}
@@ -1,5 +1,9 @@
 ﻿#pragma once
 #include <string>
+#include <filesystem>
+#include <functional>
+#include "Core/Options.h"
+#include "Core/ThreadPool.h"
 #include "Scene/Graph.h"
 
 namespace vtx::serializer
@@ -7,7 +11,16 @@ namespace vtx::serializer
 	static inline std::string moveImageToSaveLocation(const std::string& saveLocation, const std::string& imagePath)
 	{
 		const std::string savePath = utl::getFolder(saveLocation) + "/textures/" + utl::getFile(imagePath);
-		utl::copyFileToDestination(imagePath, savePath);
+		// Repeated saves to the same location, like autosave snapshots, don't copy the textures again
+		std::error_code error;
+		const bool      isUpToDate = std::filesystem::exists(savePath, error) &&
+			(std::filesystem::equivalent(imagePath, savePath, error) ||
+			 (std::filesystem::file_size(imagePath, error) == std::filesystem::file_size(savePath, error) &&
+			  std::filesystem::last_write_time(savePath, error) >= std::filesystem::last_write_time(imagePath, error)));
+		if (!isUpToDate)
+		{
+			utl::copyFileToDestination(imagePath, savePath);
+		}
 		return "textures/" + utl::getFile(imagePath);
 	}
 
@@ -38,20 +51,47 @@ namespace vtx::serializer
 		MeshNodeSaveData() = default;
 		MeshNodeSaveData(const std::shared_ptr<graph::Mesh>& node, const std::string& filePath)
 			: base(node)
-			, vertices(node->vertices)
-			, indices(node->indices)
-			, faceAttributes(node->faceAttributes)
 			, status(node->status)
-		{}
+			, deferredSource(node->getPayloadSource())
+		{
+			// Deferred arrays are saved from the file they come from without loading them, unless the save replaces that file
+			std::error_code error;
+			if (deferredSource && std::filesystem::equivalent(deferredSource->getFilePath(), filePath, error))
+			{
+				deferredSource = nullptr;
+				node->loadPayload();
+			}
+			if (!deferredSource)
+			{
+				sourceNode = node;
+			}
+		}
+
+		// When saving, the arrays are read from the mesh node instead of being copied into the save data. They are empty for
+		// deferred meshes, whose arrays are read from the deferred source.
+		const std::vector<graph::VertexAttributes>& getVertices() const { return sourceNode ? sourceNode->vertices : vertices; }
+		const std::vector<vtxID>&                   getIndices() const { return sourceNode ? sourceNode->indices : indices; }
+		const std::vector<graph::FaceAttributes>&   getFaceAttributes() const { return sourceNode ? sourceNode->faceAttributes : faceAttributes; }
 
 		void restore(std::map<vtxID, vtxID>& oldToNewUIDMap, const std::string& filePath)
+		{
+			createNode(oldToNewUIDMap);
+			fillNode(filePath);
+		}
+
+		// The restore is split so that nodes are created in order on one thread and filled concurrently
+		void createNode(std::map<vtxID, vtxID>& oldToNewUIDMap)
 		{
 			restoredNode = ops::createNode<graph::Mesh>();
 			oldToNewUIDMap[base.UID] = restoredNode->getUID();
+		}
+
+		void fillNode(const std::string& filePath)
+		{
 			restoredNode->name = base.name;
-			restoredNode->vertices = vertices;
-			restoredNode->indices = indices;
-			restoredNode->faceAttributes = faceAttributes;
+			restoredNode->vertices = std::move(vertices);
+			restoredNode->indices = std::move(indices);
+			restoredNode->faceAttributes = std::move(faceAttributes);
 			restoredNode->status = status;
 		}
 
@@ -61,6 +101,8 @@ namespace vtx::serializer
 		std::vector<graph::FaceAttributes>   faceAttributes;
 		graph::MeshStatus				     status;
 
+		std::shared_ptr<const graph::MeshPayloadSource> deferredSource = nullptr;
+		std::shared_ptr<graph::Mesh> sourceNode = nullptr;
 		std::shared_ptr<graph::Mesh> restoredNode = nullptr;
 	};
 
@@ -73,9 +115,19 @@ namespace vtx::serializer
 		{}
 
 		void restore(std::map<vtxID, vtxID>& oldToNewUIDMap, const std::string& filePath)
+		{
+			createNode(oldToNewUIDMap);
+			fillNode(filePath);
+		}
+
+		void createNode(std::map<vtxID, vtxID>& oldToNewUIDMap)
 		{
 			restoredNode = ops::createNode<graph::Transform>();
 			oldToNewUIDMap[base.UID] = restoredNode->getUID();
+		}
+
+		void fillNode(const std::string& filePath)
+		{
 			restoredNode->name = base.name;
 			restoredNode->affineTransform = affineTransform;
 		}
@@ -99,9 +151,19 @@ namespace vtx::serializer
 		{}
 
 		void restore(std::map<vtxID, vtxID>& oldToNewUIDMap, const std::string& filePath)
+		{
+			createNode(oldToNewUIDMap);
+			fillNode(filePath);
+		}
+
+		void createNode(std::map<vtxID, vtxID>& oldToNewUIDMap)
 		{
 			restoredNode = ops::createNode<graph::Material>();
 			oldToNewUIDMap[base.UID] = restoredNode->getUID();
+		}
+
+		void fillNode(const std::string& filePath)
+		{
 			restoredNode->name = base.name;
 			restoredNode->materialDbName = materialDbName;
 			restoredNode->path = path;
@@ -152,9 +214,19 @@ namespace vtx::serializer
 		}
 
 		void restore(std::map<vtxID, vtxID>& oldToNewUIDMap, const std::string& filePath)
+		{
+			createNode(oldToNewUIDMap);
+			fillNode(filePath);
+		}
+
+		void createNode(std::map<vtxID, vtxID>& oldToNewUIDMap)
 		{
 			restoreNode = ops::createNode<graph::Instance>();
 			oldToNewUIDMap[base.UID] = restoreNode->getUID();
+		}
+
+		void fillNode(const std::string& filePath)
+		{
 			restoreNode->name = base.name;
 		}
 
@@ -191,9 +263,19 @@ namespace vtx::serializer
 		}
 
 		void restore(std::map<vtxID, vtxID>& oldToNewUIDMap, const std::string& filePath)
+		{
+			createNode(oldToNewUIDMap);
+			fillNode(filePath);
+		}
+
+		void createNode(std::map<vtxID, vtxID>& oldToNewUIDMap)
 		{
 			restoreNode = ops::createNode<graph::Group>();
 			oldToNewUIDMap[base.UID] = restoreNode->getUID();
+		}
+
+		void fillNode(const std::string& filePath)
+		{
 			restoreNode->name = base.name;
 		}
 
@@ -255,9 +337,19 @@ namespace vtx::serializer
 		{}
 
 		void restore(std::map<vtxID, vtxID>& oldToNewUIDMap, const std::string& filePath)
+		{
+			createNode(oldToNewUIDMap);
+			fillNode(filePath);
+		}
+
+		void createNode(std::map<vtxID, vtxID>& oldToNewUIDMap)
 		{
 			restoreNode = ops::createNode<graph::Camera>();
 			oldToNewUIDMap[base.UID] = restoreNode->getUID();
+		}
+
+		void fillNode(const std::string& filePath)
+		{
 			restoreNode->name = base.name;
 			restoreNode->fovY = fov;
 		}
@@ -306,19 +398,20 @@ namespace vtx::serializer
 	struct ExperimentManagerSaveData
 	{
 		ExperimentManagerSaveData() = default;
-		ExperimentManagerSaveData(ExperimentsManager& experimentManager, const std::string& filePath)
+		// Without isDownloadingGroundTruth the image is not read back from the device and is saved as not ready
+		ExperimentManagerSaveData(ExperimentsManager& experimentManager, const std::string& filePath, const bool isDownloadingGroundTruth = true)
 			: currentExperiment(experimentManager.currentExperiment)
 			, currentExperimentStep(experimentManager.currentExperimentStep)
 			, width(experimentManager.width)
 			, height(experimentManager.height)
-			, isGroundTruthReady(experimentManager.isGroundTruthReady)
+			, isGroundTruthReady(experimentManager.isGroundTruthReady && isDownloadingGroundTruth)
 			, maxSamples(experimentManager.maxSamples)
 		{
 			for (const Experiment& experiment : experimentManager.experiments)
 			{
 				experiments.emplace_back(experiment, filePath);
 			}
-			if(experimentManager.isGroundTruthReady)
+			if(isGroundTruthReady)
 			{
 				groundTruthImage = std::vector<math::vec3f>(experimentManager.width * experimentManager.height);
 				experimentManager.groundTruthBuffer.download(groundTruthImage.data());
@@ -362,7 +455,7 @@ namespace vtx::serializer
 	struct RendererNodeSaveData
 	{
 		RendererNodeSaveData() = default;
-		RendererNodeSaveData(const std::shared_ptr<graph::Renderer>& node, const std::string& filePath)
+		RendererNodeSaveData(const std::shared_ptr<graph::Renderer>& node, const std::string& filePath, const bool isDownloadingGroundTruth = true)
 			: base(node),
 			rendererSettings(node->settings),
 			wavefrontSettings(node->waveFrontIntegrator.settings),
@@ -370,7 +463,7 @@ namespace vtx::serializer
 			cameraUID(node->camera->getUID()),
 			sceneRootUID(node->sceneRoot->getUID()),
 			environmentLightUID(0),
-			experimentManagerSaveData(node->waveFrontIntegrator.network.experimentManager, filePath)
+			experimentManagerSaveData(node->waveFrontIntegrator.network.experimentManager, filePath, isDownloadingGroundTruth)
 		{
 			if(node->environmentLight)
 			{
@@ -768,17 +861,40 @@ namespace vtx::serializer
 	{
 		GraphSaveData() = default;
 
-		void prepareSaveData(std::string filePath)
+		// Autosave snapshots skip the download of the ground truth image, it is as large as the frame and is computed again
+		void prepareSaveData(std::string filePath, const bool isDownloadingGroundTruth = true)
 		{
 			VTX_INFO("Constructing GraphSaveData");
-			prepareSaveDataByNodeType<graph::Transform>(graph::NT_TRANSFORM, transforms, filePath);
-			prepareSaveDataByNodeType<graph::Mesh>(graph::NT_MESH, meshes, filePath);
-			prepareSaveDataByNodeType<graph::Material>(graph::NT_MATERIAL, materials, filePath);
-			prepareSaveDataByNodeType<graph::Instance>(graph::NT_INSTANCE, instances, filePath);
-			prepareSaveDataByNodeType<graph::Group>(graph::NT_GROUP, groups, filePath);
+			// These save data only read their node, the types are prepared concurrently and so are the nodes of each type.
+			// Every node keeps its slot, the result doesn't depend on the number of threads.
+			const bool isConcurrent = getOptions()->parallelSceneSerialization;
+			const std::vector<std::function<void()>> concurrentTypes = {
+				[&] { prepareSaveDataByNodeType<graph::Transform>(graph::NT_TRANSFORM, transforms, filePath, isConcurrent); },
+				[&] { prepareSaveDataByNodeType<graph::Mesh>(graph::NT_MESH, meshes, filePath, isConcurrent); },
+				[&] { prepareSaveDataByNodeType<graph::Material>(graph::NT_MATERIAL, materials, filePath, isConcurrent); },
+				[&] { prepareSaveDataByNodeType<graph::Instance>(graph::NT_INSTANCE, instances, filePath, isConcurrent); },
+				[&] { prepareSaveDataByNodeType<graph::Group>(graph::NT_GROUP, groups, filePath, isConcurrent); },
+				[&] { prepareSaveDataByNodeType<graph::Camera>(graph::NT_CAMERA, cameras, filePath, isConcurrent); }
+			};
+			if (isConcurrent)
+			{
+				utl::parallelFor(concurrentTypes.size(), [&](const size_t i) { concurrentTypes[i](); });
+			}
+			else
+			{
+				for (const std::function<void()>& prepareType : concurrentTypes)
+				{
+					prepareType();
+				}
+			}
+
+			// Environment lights and shader nodes copy their textures next to the save file, shader sockets query MDL and
+			// the renderer downloads the ground truth image, they stay on this thread
 			prepareSaveDataByNodeType<graph::EnvironmentLight>(graph::NT_ENV_LIGHT, environmentLights, filePath);
-			prepareSaveDataByNodeType<graph::Camera>(graph::NT_CAMERA, cameras, filePath);
-			prepareSaveDataByNodeType<graph::Renderer>(graph::NT_RENDERER, renderers, filePath);
+			for (const std::shared_ptr<graph::Renderer>& renderer : graph::Scene::getSim()->getAllNodeOfType<graph::Renderer>(graph::NT_RENDERER))
+			{
+				renderers.emplace_back(renderer, filePath, isDownloadingGroundTruth);
+			}
 			prepareSaveDataByNodeType<graph::shader::DiffuseReflection>(graph::NT_SHADER_DF, shaderNodes, filePath);
 			prepareSaveDataByNodeType<graph::shader::MaterialSurface>(graph::NT_SHADER_SURFACE, shaderNodes, filePath);
 			prepareSaveDataByNodeType<graph::shader::Material>(graph::NT_SHADER_MATERIAL, shaderNodes, filePath);
@@ -800,10 +916,20 @@ namespace vtx::serializer
 		}
 
 		template<typename NodeType, typename SaveDataStruct>
-		void prepareSaveDataByNodeType(graph::NodeType type, std::vector<SaveDataStruct>& saveDataStructs, const std::string& filePath)
+		void prepareSaveDataByNodeType(graph::NodeType type, std::vector<SaveDataStruct>& saveDataStructs, const std::string& filePath, const bool isConcurrent = false)
 		{
 			const std::vector<std::shared_ptr<NodeType>> allNodes = graph::Scene::getSim()->getAllNodeOfType<NodeType>(type);
-			saveDataStructs.reserve(allNodes.size());
+			if (isConcurrent)
+			{
+				const size_t first = saveDataStructs.size();
+				saveDataStructs.resize(first + allNodes.size());
+				utl::parallelFor(allNodes.size(), [&](const size_t i)
+				{
+					saveDataStructs[first + i] = SaveDataStruct(allNodes[i], filePath);
+				}, 64);
+				return;
+			}
+			saveDataStructs.reserve(saveDataStructs.size() + allNodes.size());
 			for (const auto& node : allNodes)
 			{
 				SaveDataStruct saveData(node, filePath);
@@ -819,6 +945,29 @@ namespace vtx::serializer
 				saveData.restore(oldToNewUIDMap, filePath);
 			}
 		}
+		// Creates the nodes in order on this thread, so they get the ids of a serial restore, then moves the save data into
+		// them concurrently. Only for save data whose fillNode writes nothing but its own node.
+		template<typename SaveDataStruct>
+		void restoreSaveDataConcurrently(std::vector<SaveDataStruct>& saveDataStructs, std::map<vtxID, vtxID>& oldToNewUIDMap, const std::string& filePath)
+		{
+			for (SaveDataStruct& saveData : saveDataStructs)
+			{
+				saveData.createNode(oldToNewUIDMap);
+			}
+			if (getOptions()->parallelSceneSerialization)
+			{
+				utl::parallelFor(saveDataStructs.size(), [&](const size_t i)
+				{
+					saveDataStructs[i].fillNode(filePath);
+				}, 64);
+				return;
+			}
+			for (SaveDataStruct& saveData : saveDataStructs)
+			{
+				saveData.fillNode(filePath);
+			}
+		}
+
 		template<typename SaveDataStruct>
 		void linkNodes(std::vector<SaveDataStruct>& saveDataStructs, std::map<vtxID, vtxID>& oldToNewUIDMap)
 		{
@@ -828,17 +977,33 @@ namespace vtx::serializer
 			}
 		}
 
+		// Calls function(saveDataStructs) for every node list, in the order they are restored
+		template<typename F>
+		void forEachNodeList(F&& function)
+		{
+			function(transforms);
+			function(meshes);
+			function(materials);
+			function(instances);
+			function(groups);
+			function(environmentLights);
+			function(cameras);
+			function(renderers);
+			function(shaderNodes);
+		}
+
 		std::tuple<std::shared_ptr<graph::Renderer>, std::shared_ptr<graph::Group>> restoreShaderGraph(const std::string& filePath)
 		{
 			VTX_INFO("Restoring shader graph");
 			std::map<vtxID, vtxID> oldToNewUIDMap;
-			restoreSaveData(transforms, oldToNewUIDMap, filePath);
-			restoreSaveData(meshes, oldToNewUIDMap, filePath);
-			restoreSaveData(materials, oldToNewUIDMap, filePath);
-			restoreSaveData(instances, oldToNewUIDMap, filePath);
-			restoreSaveData(groups, oldToNewUIDMap, filePath);
+			restoreSaveDataConcurrently(transforms, oldToNewUIDMap, filePath);
+			restoreSaveDataConcurrently(meshes, oldToNewUIDMap, filePath);
+			restoreSaveDataConcurrently(materials, oldToNewUIDMap, filePath);
+			restoreSaveDataConcurrently(instances, oldToNewUIDMap, filePath);
+			restoreSaveDataConcurrently(groups, oldToNewUIDMap, filePath);
+			// Environment lights create their texture from the file, renderers rebuild their experiments and shader nodes query MDL
 			restoreSaveData(environmentLights, oldToNewUIDMap, filePath);
-			restoreSaveData(cameras, oldToNewUIDMap, filePath);
+			restoreSaveDataConcurrently(cameras, oldToNewUIDMap, filePath);
 			restoreSaveData(renderers, oldToNewUIDMap, filePath);
 			restoreSaveData(shaderNodes, oldToNewUIDMap, filePath);
 			VTX_INFO("Linking shader graph");
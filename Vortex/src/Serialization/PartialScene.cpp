@@ -0,0 +1,315 @@
+#include "PartialScene.h"
+#include <fstream>
+#include <unordered_set>
+#include "ArchiveFunctions.h"
+#include "SceneContainer.h"
+#include <cereal/archives/binary.hpp>
+#include <cereal/archives/xml.hpp>
+#include "Core/Log.h"
+#include "Core/Timer.h"
+
+namespace vtx::serializer
+{
+	static void collectReferences(const MeshNodeSaveData& saveData, std::vector<vtxID>& references)
+	{
+	}
+
+	static void collectReferences(const TransformNodeSaveData& saveData, std::vector<vtxID>& references)
+	{
+	}
+
+	static void collectReferences(const MaterialNodeSaveData& saveData, std::vector<vtxID>& references)
+	{
+		references.push_back(saveData.materialGraphUID);
+	}
+
+	static void collectReferences(const InstanceNodeSaveData& saveData, std::vector<vtxID>& references)
+	{
+		references.push_back(saveData.transformUID);
+		references.push_back(saveData.childUID);
+		for (const MaterialSlotSaveData& materialSlot : saveData.materialSlots)
+		{
+			references.push_back(materialSlot.materialUID);
+		}
+	}
+
+	static void collectReferences(const GroupNodeSaveData& saveData, std::vector<vtxID>& references)
+	{
+		references.push_back(saveData.transformUID);
+		references.insert(references.end(), saveData.childUIDs.begin(), saveData.childUIDs.end());
+	}
+
+	static void collectReferences(const EnvironmentLightNodeSaveData& saveData, std::vector<vtxID>& references)
+	{
+		references.push_back(saveData.transformUID);
+	}
+
+	static void collectReferences(const CameraNodeSaveData& saveData, std::vector<vtxID>& references)
+	{
+		references.push_back(saveData.transformUID);
+	}
+
+	static void collectReferences(const RendererNodeSaveData& saveData, std::vector<vtxID>& references)
+	{
+		references.push_back(saveData.cameraUID);
+		references.push_back(saveData.sceneRootUID);
+		if (saveData.environmentLightUID != 0)
+		{
+			references.push_back(saveData.environmentLightUID);
+		}
+	}
+
+	static void collectReferences(const BaseShaderNodeSaveData& saveData, std::vector<vtxID>& references)
+	{
+		for (const auto& [socketName, socket] : saveData.shaderSocketSaveData)
+		{
+			if (socket.socketNodeInputUID != 0)
+			{
+				references.push_back(socket.socketNodeInputUID);
+			}
+		}
+	}
+
+	bool PartialScene::open(const std::string& path)
+	{
+		close();
+		Timer timer;
+		filePath = path;
+
+		const std::string fileExtension = utl::getFileExtension(filePath);
+		if (isSceneContainerFile(filePath))
+		{
+			// Only the metadata is decoded, the mesh sections stay in the mapped file
+			reader = std::make_shared<SceneContainerReader>();
+			if (!reader->open(filePath) || !decodeSceneMetadata(*reader, graphSaveData))
+			{
+				close();
+				return false;
+			}
+			publishPreparedData(reader);
+		}
+		else if (fileExtension == "vtx" || fileExtension == "xml")
+		{
+			try
+			{
+				if (fileExtension == "vtx")
+				{
+					std::ifstream              file(filePath, std::ios::binary);
+					cereal::BinaryInputArchive archive(file);
+					archive(graphSaveData);
+				}
+				else
+				{
+					std::ifstream           file(filePath);
+					cereal::XMLInputArchive archive(file);
+					archive(graphSaveData);
+				}
+			}
+			catch (const std::exception& e)
+			{
+				VTX_ERROR("Partial scene: could not read {}: {}", filePath, e.what());
+				close();
+				return false;
+			}
+		}
+		else
+		{
+			VTX_ERROR("Partial scene: unsupported file extension: {}", fileExtension);
+			return false;
+		}
+
+		graphSaveData.forEachNodeList([this](auto& saveDataStructs)
+		{
+			for (const auto& saveData : saveDataStructs)
+			{
+				SceneTocEntry entry;
+				entry.UID         = saveData.base.UID;
+				entry.type        = saveData.base.type;
+				entry.name        = saveData.base.name;
+				entry.payloadSize = 0;
+				collectReferences(saveData, entry.references);
+				entryOfUID[entry.UID] = tableOfContents.size();
+				tableOfContents.push_back(std::move(entry));
+			}
+		});
+		for (const MeshNodeSaveData& mesh : graphSaveData.meshes)
+		{
+			uint64_t& payloadSize = tableOfContents[entryOfUID[mesh.base.UID]].payloadSize;
+			if (reader)
+			{
+				for (const SectionKind kind : { SK_MESH_VERTICES, SK_MESH_INDICES, SK_MESH_FACES })
+				{
+					if (const SceneContainer::SectionEntry* section = reader->findSection(kind, mesh.base.UID))
+					{
+						payloadSize += section->count * section->elementSize;
+					}
+				}
+			}
+			else
+			{
+				payloadSize = mesh.vertices.size() * sizeof(graph::VertexAttributes) + mesh.indices.size() * sizeof(vtxID) +
+					mesh.faceAttributes.size() * sizeof(graph::FaceAttributes);
+			}
+		}
+
+		VTX_INFO("Partial scene: {} opened with {} nodes in {} ms", filePath, tableOfContents.size(), timer.elapsedMillis());
+		return true;
+	}
+
+	void PartialScene::close()
+	{
+		filePath.clear();
+		graphSaveData = GraphSaveData();
+		reader.reset();
+		tableOfContents.clear();
+		entryOfUID.clear();
+		oldToNewUIDMap.clear();
+	}
+
+	bool PartialScene::isOpen() const
+	{
+		return !filePath.empty();
+	}
+
+	const std::vector<SceneTocEntry>& PartialScene::getTableOfContents() const
+	{
+		return tableOfContents;
+	}
+
+	const SceneTocEntry* PartialScene::findEntry(const vtxID savedUID) const
+	{
+		const auto it = entryOfUID.find(savedUID);
+		return it == entryOfUID.end() ? nullptr : &tableOfContents[it->second];
+	}
+
+	vtxID PartialScene::getSceneRootUID() const
+	{
+		return graphSaveData.sceneRootUID;
+	}
+
+	vtxID PartialScene::getActiveRendererUID() const
+	{
+		return graphSaveData.activeRendererUID;
+	}
+
+	template<typename SaveDataStruct>
+	void PartialScene::linkRestored(std::vector<SaveDataStruct>& saveDataStructs, const std::vector<vtxID>& restored)
+	{
+		const std::unordered_set<vtxID> isRestored(restored.begin(), restored.end());
+		for (SaveDataStruct& saveData : saveDataStructs)
+		{
+			if (isRestored.count(saveData.base.UID) != 0)
+			{
+				saveData.link(oldToNewUIDMap);
+			}
+		}
+	}
+
+	std::vector<std::shared_ptr<graph::Node>> PartialScene::loadSubtrees(const std::vector<vtxID>& savedUIDs)
+	{
+		Timer timer;
+
+		// The saved nodes reachable from the requested ones which have not been restored yet
+		std::unordered_set<vtxID> selection;
+		std::vector<vtxID>        pending;
+		for (const vtxID UID : savedUIDs)
+		{
+			if (entryOfUID.count(UID) != 0 && oldToNewUIDMap.count(UID) == 0 && selection.insert(UID).second)
+			{
+				pending.push_back(UID);
+			}
+		}
+		while (!pending.empty())
+		{
+			const vtxID UID = pending.back();
+			pending.pop_back();
+			for (const vtxID reference : tableOfContents[entryOfUID[UID]].references)
+			{
+				if (entryOfUID.count(reference) != 0 && oldToNewUIDMap.count(reference) == 0 && selection.insert(reference).second)
+				{
+					pending.push_back(reference);
+				}
+			}
+		}
+
+		// Restored in the same order as a full load, then linked once every node they refer to exists
+		std::vector<vtxID> restored;
+		graphSaveData.forEachNodeList([&](auto& saveDataStructs)
+		{
+			for (auto& saveData : saveDataStructs)
+			{
+				if (selection.count(saveData.base.UID) != 0)
+				{
+					saveData.restore(oldToNewUIDMap, filePath);
+					restored.push_back(saveData.base.UID);
+				}
+			}
+		});
+		if (reader)
+		{
+			for (MeshNodeSaveData& mesh : graphSaveData.meshes)
+			{
+				if (selection.count(mesh.base.UID) == 0)
+				{
+					continue;
+				}
+				mesh.restoredNode->setPayloadSource(std::make_shared<ContainerMeshSource>(reader, mesh.base.UID));
+			}
+		}
+		linkRestored(graphSaveData.materials, restored);
+		linkRestored(graphSaveData.instances, restored);
+		linkRestored(graphSaveData.groups, restored);
+		linkRestored(graphSaveData.cameras, restored);
+		linkRestored(graphSaveData.renderers, restored);
+		linkRestored(graphSaveData.shaderNodes, restored);
+
+		std::vector<std::shared_ptr<graph::Node>> nodes;
+		nodes.reserve(savedUIDs.size());
+		for (const vtxID UID : savedUIDs)
+		{
+			nodes.push_back(getRestoredNode(UID));
+		}
+		if (!restored.empty())
+		{
+			VTX_INFO("Partial scene: restored {} nodes for {} requested in {} ms", restored.size(), savedUIDs.size(), timer.elapsedMillis());
+		}
+		return nodes;
+	}
+
+	std::vector<std::shared_ptr<graph::Node>> PartialScene::loadNodesOfType(const graph::NodeType type)
+	{
+		std::vector<vtxID> savedUIDs;
+		for (const SceneTocEntry& entry : tableOfContents)
+		{
+			if (entry.type == type)
+			{
+				savedUIDs.push_back(entry.UID);
+			}
+		}
+		return loadSubtrees(savedUIDs);
+	}
+
+	std::tuple<std::shared_ptr<graph::Renderer>, std::shared_ptr<graph::Group>> PartialScene::loadScene()
+	{
+		std::vector<vtxID> savedUIDs;
+		savedUIDs.reserve(tableOfContents.size());
+		for (const SceneTocEntry& entry : tableOfContents)
+		{
+			savedUIDs.push_back(entry.UID);
+		}
+		loadSubtrees(savedUIDs);
+
+		return std::make_tuple(graph::nodeCast<graph::Renderer>(getRestoredNode(graphSaveData.activeRendererUID)),
+							   graph::nodeCast<graph::Group>(getRestoredNode(graphSaveData.sceneRootUID)));
+	}
+
+	std::shared_ptr<graph::Node> PartialScene::getRestoredNode(const vtxID savedUID) const
+	{
+		const auto it = oldToNewUIDMap.find(savedUID);
+		if (it == oldToNewUIDMap.end())
+		{
+			return nullptr;
+		}
+		return graph::Scene::getSim()->getNode<graph::Node>(it->second);
+	}
+}
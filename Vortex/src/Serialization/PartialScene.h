@@ -0,0 +1,69 @@
+#pragma once
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "NodeSaveData.h"
+
+namespace vtx::serializer
+{
+	class SceneContainerReader;
+
+	struct SceneTocEntry
+	{
+		vtxID              UID; // UID in the saved scene
+		graph::NodeType    type;
+		std::string        name;
+		std::vector<vtxID> references;  // Saved UIDs of the nodes restored along with this one: transform, children, materials, shader inputs
+		uint64_t           payloadSize; // Bytes of mesh data
+	};
+
+	// Saved scene opened without restoring it. The table of contents lists every saved node, subtrees and node types are restored
+	// on request together with the nodes they reference. Meshes of a .vtxc container are restored as handles whose arrays are
+	// read from the mapped file on first access, the file stays mapped until all of them are loaded or released. Saving such
+	// a mesh to another container copies its sections from the mapped file without loading it.
+	// Other formats have to be parsed in full when opened, their meshes are restored with their arrays.
+	class PartialScene
+	{
+	public:
+		bool open(const std::string& filePath);
+
+		// Nodes restored so far are kept
+		void close();
+
+		bool isOpen() const;
+
+		const std::vector<SceneTocEntry>& getTableOfContents() const;
+
+		// nullptr if the UID is not part of the saved scene
+		const SceneTocEntry* findEntry(vtxID savedUID) const;
+
+		vtxID getSceneRootUID() const;
+
+		vtxID getActiveRendererUID() const;
+
+		// Restores the saved nodes and everything they reference, nodes restored by earlier calls are reused.
+		// Returns the restored nodes in the order of the UIDs, nullptr for UIDs which are not part of the saved scene.
+		std::vector<std::shared_ptr<graph::Node>> loadSubtrees(const std::vector<vtxID>& savedUIDs);
+
+		std::vector<std::shared_ptr<graph::Node>> loadNodesOfType(graph::NodeType type);
+
+		// Restores the whole scene, returns the active renderer and the scene root
+		std::tuple<std::shared_ptr<graph::Renderer>, std::shared_ptr<graph::Group>> loadScene();
+
+		// nullptr if the node has not been restored
+		std::shared_ptr<graph::Node> getRestoredNode(vtxID savedUID) const;
+
+	private:
+		template<typename SaveDataStruct>
+		void linkRestored(std::vector<SaveDataStruct>& saveDataStructs, const std::vector<vtxID>& restored);
+
+		std::string                           filePath;
+		GraphSaveData                         graphSaveData;
+		std::shared_ptr<SceneContainerReader> reader;
+		std::vector<SceneTocEntry>            tableOfContents;
+		std::unordered_map<vtxID, size_t>     entryOfUID;
+		std::map<vtxID, vtxID>                oldToNewUIDMap;
+	};
+}
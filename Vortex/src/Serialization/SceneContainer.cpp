@@ -0,0 +1,630 @@
+#include "SceneContainer.h"
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <sstream>
+#include "ArchiveFunctions.h"
+#include <cereal/archives/binary.hpp>
+#include "Core/Hashing.h"
+#include "Core/Options.h"
+#include "Core/ThreadPool.h"
+#include "Core/Timer.h"
+
+namespace vtx::serializer
+{
+	// Mesh entry of the metadata, the arrays are stored in sections keyed by the mesh UID
+	struct MeshSectionsSaveData
+	{
+		BaseNodeSaveData  base;
+		graph::MeshStatus status;
+	};
+}
+
+namespace cereal
+{
+	template<class Archive>
+	void serialize(Archive& archive, vtx::serializer::MeshSectionsSaveData& data)
+	{
+		archive(nvp(data, base), nvp(data, status));
+	}
+}
+
+namespace vtx::serializer
+{
+	static constexpr char containerMagic[8] = { 'V', 'T', 'X', 'S', 'C', 'E', 'N', 'E' };
+
+	static uint64_t alignOffset(const uint64_t offset)
+	{
+		return (offset + SceneContainer::alignment - 1) & ~(SceneContainer::alignment - 1);
+	}
+
+	void SceneContainerWriter::addSection(const SectionKind kind, const uint64_t ownerUID, const void* data, const uint64_t count, const uint32_t elementSize)
+	{
+		SceneContainer::SectionEntry entry{};
+		entry.kind        = kind;
+		entry.elementSize = elementSize;
+		entry.ownerUID    = ownerUID;
+		entry.count       = count;
+		entries.push_back(entry);
+		sectionData.push_back(data);
+	}
+
+	bool SceneContainerWriter::write(const std::string& filePath, const std::string& metadata)
+	{
+		Timer timer;
+
+		SceneContainer::Header header{};
+		std::memcpy(header.magic, containerMagic, sizeof(containerMagic));
+		header.version            = SceneContainer::version;
+		header.vertexSize         = sizeof(graph::VertexAttributes);
+		header.numSections        = entries.size();
+		header.sectionTableOffset = sizeof(SceneContainer::Header);
+		header.metadataOffset     = header.sectionTableOffset + entries.size() * sizeof(SceneContainer::SectionEntry);
+		header.metadataSize       = metadata.size();
+		header.metadataChecksum   = utl::hashBytes(metadata.data(), metadata.size());
+
+		// The layout is fixed before anything is written, sections are then checksummed and written independently
+		uint64_t offset = header.metadataOffset + header.metadataSize;
+		for (SceneContainer::SectionEntry& entry : entries)
+		{
+			entry.offset = alignOffset(offset);
+			offset       = entry.offset + entry.count * entry.elementSize;
+		}
+		header.fileSize = offset;
+
+		const bool isConcurrent = getOptions()->parallelSceneSerialization;
+		auto computeChecksum = [this](const size_t i)
+		{
+			entries[i].checksum = utl::hashBytesParallel(sectionData[i], entries[i].count * entries[i].elementSize);
+		};
+		if (isConcurrent)
+		{
+			utl::parallelFor(entries.size(), computeChecksum);
+		}
+		else
+		{
+			for (size_t i = 0; i < entries.size(); ++i)
+			{
+				computeChecksum(i);
+			}
+		}
+
+		const std::string tempPath = filePath + ".tmp";
+		if (isConcurrent)
+		{
+			if (!writeConcurrently(tempPath, header, metadata))
+			{
+				std::error_code error;
+				std::filesystem::remove(tempPath, error);
+				return false;
+			}
+		}
+		else
+		{
+			std::ofstream outFile(tempPath, std::ios::binary | std::ios::trunc);
+			if (!outFile)
+			{
+				VTX_ERROR("Scene container: failed to open {} for writing", tempPath);
+				return false;
+			}
+
+			uint64_t written = 0;
+			auto writeAt = [&outFile, &written](const uint64_t position, const void* data, const uint64_t size)
+			{
+				static constexpr char zeros[SceneContainer::alignment] = {};
+				outFile.write(zeros, (std::streamsize)(position - written));
+				outFile.write(static_cast<const char*>(data), (std::streamsize)size);
+				written = position + size;
+			};
+
+			writeAt(0, &header, sizeof(SceneContainer::Header));
+			writeAt(written, entries.data(), entries.size() * sizeof(SceneContainer::SectionEntry));
+			writeAt(written, metadata.data(), metadata.size());
+			for (size_t i = 0; i < entries.size(); ++i)
+			{
+				writeAt(entries[i].offset, sectionData[i], entries[i].count * entries[i].elementSize);
+			}
+
+			if (!outFile.good())
+			{
+				VTX_ERROR("Scene container: failed writing {}", tempPath);
+				outFile.close();
+				std::filesystem::remove(tempPath);
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempPath, filePath, error);
+		if (error)
+		{
+			VTX_ERROR("Scene container: failed to move {} to {}: {}", tempPath, filePath, error.message());
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+
+		VTX_INFO("Scene container: {} sections ({} MB) written to {} in {} ms", entries.size(), header.fileSize / (1024 * 1024), filePath, timer.elapsedMillis());
+		return true;
+	}
+
+	bool SceneContainerWriter::writeConcurrently(const std::string& tempPath, const SceneContainer::Header& header, const std::string& metadata) const
+	{
+		{
+			std::ofstream outFile(tempPath, std::ios::binary | std::ios::trunc);
+			if (!outFile)
+			{
+				VTX_ERROR("Scene container: failed to open {} for writing", tempPath);
+				return false;
+			}
+			outFile.write(reinterpret_cast<const char*>(&header), sizeof(SceneContainer::Header));
+			outFile.write(reinterpret_cast<const char*>(entries.data()), (std::streamsize)(entries.size() * sizeof(SceneContainer::SectionEntry)));
+			outFile.write(metadata.data(), (std::streamsize)metadata.size());
+			if (!outFile.good())
+			{
+				VTX_ERROR("Scene container: failed writing {}", tempPath);
+				return false;
+			}
+		}
+
+		// Extending the file fills the alignment padding with zeros, the sections are then written at their offsets
+		std::error_code error;
+		std::filesystem::resize_file(tempPath, header.fileSize, error);
+		if (error)
+		{
+			VTX_ERROR("Scene container: failed to resize {}: {}", tempPath, error.message());
+			return false;
+		}
+
+		// Consecutive sections are split in ranges of similar size, each range is written through its own stream
+		const uint64_t totalSize = header.fileSize - header.metadataOffset;
+		const size_t   numRanges = std::max<size_t>(1, std::min<size_t>(entries.size(), ThreadPool::get()->getNumberOfWorkers() + 1));
+		std::vector<size_t> rangeStarts = { 0 };
+		uint64_t            rangeSize   = 0;
+		for (size_t i = 0; i < entries.size(); ++i)
+		{
+			if (rangeSize * numRanges >= totalSize && rangeStarts.size() < numRanges)
+			{
+				rangeStarts.push_back(i);
+				rangeSize = 0;
+			}
+			rangeSize += entries[i].count * entries[i].elementSize;
+		}
+		rangeStarts.push_back(entries.size());
+
+		std::atomic<bool> isWritten = true;
+		utl::parallelFor(rangeStarts.size() - 1, [&](const size_t range)
+		{
+			std::ofstream outFile(tempPath, std::ios::binary | std::ios::in | std::ios::out);
+			for (size_t i = rangeStarts[range]; outFile && i < rangeStarts[range + 1]; ++i)
+			{
+				outFile.seekp((std::streamoff)entries[i].offset);
+				outFile.write(static_cast<const char*>(sectionData[i]), (std::streamsize)(entries[i].count * entries[i].elementSize));
+			}
+			if (!outFile.good())
+			{
+				isWritten = false;
+			}
+		});
+		if (!isWritten)
+		{
+			VTX_ERROR("Scene container: failed writing the sections of {}", tempPath);
+			return false;
+		}
+		return true;
+	}
+
+	bool SceneContainerReader::open(const std::string& path)
+	{
+		close();
+		filePath = path;
+		if (!file.open(filePath))
+		{
+			VTX_ERROR("Scene container: could not map {}", filePath);
+			return false;
+		}
+
+		const auto*  data = static_cast<const char*>(file.getData());
+		const size_t size = file.getSize();
+
+		// The ranges are checked before any offset is computed from them, corrupt counts could overflow the computation
+		const auto* header = reinterpret_cast<const SceneContainer::Header*>(data);
+		if (size < sizeof(SceneContainer::Header) ||
+			std::memcmp(header->magic, containerMagic, sizeof(containerMagic)) != 0 ||
+			header->version != SceneContainer::version ||
+			header->vertexSize != sizeof(graph::VertexAttributes) ||
+			header->fileSize != size ||
+			header->sectionTableOffset != sizeof(SceneContainer::Header) ||
+			!file.containsRange(header->sectionTableOffset, header->numSections, sizeof(SceneContainer::SectionEntry)) ||
+			header->metadataOffset != header->sectionTableOffset + header->numSections * sizeof(SceneContainer::SectionEntry) ||
+			!file.containsRange(header->metadataOffset, header->metadataSize, 1))
+		{
+			VTX_ERROR("Scene container: {} is not a valid scene container or is truncated", filePath);
+			close();
+			return false;
+		}
+
+		if (utl::hashBytes(data + header->metadataOffset, header->metadataSize) != header->metadataChecksum)
+		{
+			VTX_ERROR("Scene container: metadata checksum mismatch in {}", filePath);
+			close();
+			return false;
+		}
+
+		const auto* entries = reinterpret_cast<const SceneContainer::SectionEntry*>(data + header->sectionTableOffset);
+		sections.assign(entries, entries + header->numSections);
+		for (size_t i = 0; i < sections.size(); ++i)
+		{
+			const SceneContainer::SectionEntry& entry = sections[i];
+			if (!file.containsRange(entry.offset, entry.count, entry.elementSize))
+			{
+				VTX_ERROR("Scene container: section {} of {} is out of bounds", i, filePath);
+				close();
+				return false;
+			}
+			sectionOfKey[{ entry.kind, entry.ownerUID }] = i;
+		}
+		return true;
+	}
+
+	void SceneContainerReader::close()
+	{
+		file.close();
+		sections.clear();
+		sectionOfKey.clear();
+	}
+
+	std::string SceneContainerReader::getMetadata() const
+	{
+		if (!file.isValid())
+		{
+			return {};
+		}
+		const auto* data   = static_cast<const char*>(file.getData());
+		const auto* header = reinterpret_cast<const SceneContainer::Header*>(data);
+		return std::string(data + header->metadataOffset, header->metadataSize);
+	}
+
+	uint64_t SceneContainerReader::getMetadataChecksum() const
+	{
+		if (!file.isValid())
+		{
+			return 0;
+		}
+		return static_cast<const SceneContainer::Header*>(file.getData())->metadataChecksum;
+	}
+
+	const void* SceneContainerReader::getSectionData(const SceneContainer::SectionEntry& entry) const
+	{
+		return static_cast<const char*>(file.getData()) + entry.offset;
+	}
+
+	const std::vector<SceneContainer::SectionEntry>& SceneContainerReader::getSections() const
+	{
+		return sections;
+	}
+
+	const std::string& SceneContainerReader::getFilePath() const
+	{
+		return filePath;
+	}
+
+	const SceneContainer::SectionEntry* SceneContainerReader::findSection(const SectionKind kind, const uint64_t ownerUID) const
+	{
+		const auto it = sectionOfKey.find({ kind, ownerUID });
+		return it == sectionOfKey.end() ? nullptr : &sections[it->second];
+	}
+
+	bool SceneContainerReader::copySection(const SceneContainer::SectionEntry& entry, void* destination) const
+	{
+		const uint64_t size = entry.count * entry.elementSize;
+		if (size == 0)
+		{
+			return true;
+		}
+		std::memcpy(destination, static_cast<const char*>(file.getData()) + entry.offset, size);
+		if (utl::hashBytesParallel(destination, size) != entry.checksum)
+		{
+			VTX_ERROR("Scene container: checksum mismatch in section of kind {} owned by {} in {}", entry.kind, entry.ownerUID, filePath);
+			return false;
+		}
+		return true;
+	}
+
+	ContainerMeshSource::ContainerMeshSource(std::shared_ptr<const SceneContainerReader> reader, const vtxID savedUID) :
+		reader(std::move(reader)),
+		savedUID(savedUID)
+	{
+	}
+
+	bool ContainerMeshSource::read(graph::MeshPayload& payload) const
+	{
+		return reader->readSection(SK_MESH_VERTICES, savedUID, payload.vertices) &&
+			reader->readSection(SK_MESH_INDICES, savedUID, payload.indices) &&
+			reader->readSection(SK_MESH_FACES, savedUID, payload.faceAttributes);
+	}
+
+	const std::string& ContainerMeshSource::getFilePath() const
+	{
+		return reader->getFilePath();
+	}
+
+	bool ContainerMeshSource::addSections(SceneContainerWriter& writer, const uint64_t ownerUID) const
+	{
+		for (const SectionKind kind : { SK_MESH_VERTICES, SK_MESH_INDICES, SK_MESH_FACES })
+		{
+			const SceneContainer::SectionEntry* entry = reader->findSection(kind, savedUID);
+			if (entry == nullptr)
+			{
+				VTX_ERROR("Scene container: mesh {} has no data in {}", savedUID, reader->getFilePath());
+				return false;
+			}
+			writer.addSection(kind, ownerUID, reader->getSectionData(*entry), entry->count, entry->elementSize);
+		}
+		return true;
+	}
+
+	bool isSceneContainerFile(const std::string& filePath)
+	{
+		return utl::getFileExtension(filePath) == "vtxc";
+	}
+
+	std::string encodeSceneMetadata(GraphSaveData& graphSaveData)
+	{
+		std::vector<MeshSectionsSaveData> meshSections;
+		meshSections.reserve(graphSaveData.meshes.size());
+		for (const MeshNodeSaveData& mesh : graphSaveData.meshes)
+		{
+			meshSections.push_back({ mesh.base, mesh.status });
+		}
+
+		// The meshes are taken out of the graph while the metadata is archived so that their arrays are not part of it
+		std::vector<MeshNodeSaveData> meshes = std::move(graphSaveData.meshes);
+		graphSaveData.meshes.clear();
+		std::stringstream metadataStream;
+		{
+			cereal::BinaryOutputArchive archive(metadataStream);
+			archive(graphSaveData, meshSections);
+		}
+		graphSaveData.meshes = std::move(meshes);
+		return metadataStream.str();
+	}
+
+	bool decodeSceneMetadata(const SceneContainerReader& reader, GraphSaveData& graphSaveData)
+	{
+		std::vector<MeshSectionsSaveData> meshSections;
+		try
+		{
+			std::istringstream         metadataStream(reader.getMetadata());
+			cereal::BinaryInputArchive archive(metadataStream);
+			archive(graphSaveData, meshSections);
+		}
+		catch (const std::exception& e)
+		{
+			VTX_ERROR("Scene container: failed to read the graph metadata: {}", e.what());
+			return false;
+		}
+
+		graphSaveData.meshes.resize(meshSections.size());
+		for (size_t i = 0; i < meshSections.size(); ++i)
+		{
+			graphSaveData.meshes[i].base   = meshSections[i].base;
+			graphSaveData.meshes[i].status = meshSections[i].status;
+		}
+		return true;
+	}
+
+	bool writeSceneContainer(const std::string& filePath, GraphSaveData& graphSaveData, const bool isEmbeddingPreparedData)
+	{
+		SceneContainerWriter           writer;
+		std::deque<graph::MeshPayload> deferredPayloads;
+		for (const MeshNodeSaveData& mesh : graphSaveData.meshes)
+		{
+			if (mesh.deferredSource)
+			{
+				// Not loaded yet, the sections are written from the file the mesh comes from
+				if (const auto* containerSource = dynamic_cast<const ContainerMeshSource*>(mesh.deferredSource.get()))
+				{
+					if (!containerSource->addSections(writer, mesh.base.UID))
+					{
+						return false;
+					}
+					continue;
+				}
+				graph::MeshPayload& payload = deferredPayloads.emplace_back();
+				if (!mesh.deferredSource->read(payload))
+				{
+					VTX_ERROR("Scene container: could not read the data of mesh {} from {}", mesh.base.UID, mesh.deferredSource->getFilePath());
+					return false;
+				}
+				writer.addSection(SK_MESH_VERTICES, mesh.base.UID, payload.vertices);
+				writer.addSection(SK_MESH_INDICES, mesh.base.UID, payload.indices);
+				writer.addSection(SK_MESH_FACES, mesh.base.UID, payload.faceAttributes);
+				continue;
+			}
+			writer.addSection(SK_MESH_VERTICES, mesh.base.UID, mesh.getVertices());
+			writer.addSection(SK_MESH_INDICES, mesh.base.UID, mesh.getIndices());
+			writer.addSection(SK_MESH_FACES, mesh.base.UID, mesh.getFaceAttributes());
+		}
+
+		std::vector<graph::PreparedData> preparedData;
+		if (isEmbeddingPreparedData)
+		{
+			preparedData = graph::PreparedDataStore::collect();
+			for (const graph::PreparedData& data : preparedData)
+			{
+				writer.addSection((SectionKind)(SK_PREPARED_DATA + data.kind), data.key, data.blob);
+			}
+		}
+		return writer.write(filePath, encodeSceneMetadata(graphSaveData));
+	}
+
+	void publishPreparedData(const std::shared_ptr<SceneContainerReader>& reader)
+	{
+		graph::PreparedDataStore* store       = graph::PreparedDataStore::get();
+		size_t                    numSections = 0;
+		for (const SceneContainer::SectionEntry& entry : reader->getSections())
+		{
+			if (entry.kind >= SK_PREPARED_DATA && entry.kind < SK_COUNT && entry.elementSize == 1)
+			{
+				store->add((graph::PreparedDataKind)(entry.kind - SK_PREPARED_DATA), entry.ownerUID, reader->getSectionData(entry), entry.count, entry.checksum, reader, reader->getFilePath());
+				++numSections;
+			}
+		}
+		if (numSections != 0)
+		{
+			VTX_INFO("Scene container: {} prepared data sections available", numSections);
+		}
+	}
+
+	bool readSceneContainer(const std::string& filePath, GraphSaveData& graphSaveData, uint64_t* metadataChecksum)
+	{
+		Timer timer;
+		auto  reader = std::make_shared<SceneContainerReader>();
+		if (!reader->open(filePath) || !decodeSceneMetadata(*reader, graphSaveData))
+		{
+			return false;
+		}
+		if (metadataChecksum != nullptr)
+		{
+			*metadataChecksum = reader->getMetadataChecksum();
+		}
+		publishPreparedData(reader);
+
+		std::atomic<bool> isValid = true;
+		auto readMesh = [&](const size_t i)
+		{
+			MeshNodeSaveData& mesh = graphSaveData.meshes[i];
+			if (!reader->readSection(SK_MESH_VERTICES, mesh.base.UID, mesh.vertices) ||
+				!reader->readSection(SK_MESH_INDICES, mesh.base.UID, mesh.indices) ||
+				!reader->readSection(SK_MESH_FACES, mesh.base.UID, mesh.faceAttributes))
+			{
+				isValid = false;
+			}
+		};
+		if (getOptions()->parallelSceneSerialization)
+		{
+			utl::parallelFor(graphSaveData.meshes.size(), readMesh);
+		}
+		else
+		{
+			for (size_t i = 0; i < graphSaveData.meshes.size(); ++i)
+			{
+				readMesh(i);
+			}
+		}
+		if (!isValid)
+		{
+			VTX_ERROR("Scene container: missing or corrupted mesh data in {}", filePath);
+			return false;
+		}
+
+		VTX_INFO("Scene container: {} loaded in {} ms", filePath, timer.elapsedMillis());
+		return true;
+	}
+
+	GraphSaveData createSyntheticMeshSaveData(const size_t numMeshes, const size_t verticesPerMesh)
+	{
+		GraphSaveData source;
+		source.activeRendererUID = 0;
+		source.activeCameraUID   = 0;
+		source.sceneRootUID      = 0;
+		source.meshes.resize(numMeshes);
+		utl::parallelFor(numMeshes, [&](const size_t i)
+		{
+			MeshNodeSaveData& mesh = source.meshes[i];
+			mesh.base.UID          = (vtxID)(i + 1);
+			mesh.base.TID          = (vtxID)(i + 1);
+			mesh.base.name         = "Mesh_" + std::to_string(i);
+			mesh.base.type         = graph::NT_MESH;
+			mesh.status            = { true, true, true };
+			mesh.vertices.resize(verticesPerMesh);
+			mesh.indices.resize(verticesPerMesh * 3);
+			mesh.faceAttributes.resize(verticesPerMesh);
+			for (size_t v = 0; v < verticesPerMesh; ++v)
+			{
+				const float value = (float)(i * verticesPerMesh + v);
+				mesh.vertices[v]  = { { value, value + 1.0f, value + 2.0f }, { value, 0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f } };
+				mesh.faceAttributes[v].materialSlotId = (unsigned)(v % 7);
+			}
+			for (size_t v = 0; v < mesh.indices.size(); ++v)
+			{
+				mesh.indices[v] = (vtxID)((v * 7919) % verticesPerMesh);
+			}
+		});
+		return source;
+	}
+
+	bool isMeshSaveDataMatching(const GraphSaveData& source, const GraphSaveData& loaded)
+	{
+		bool isMatching = loaded.meshes.size() == source.meshes.size();
+		for (size_t i = 0; isMatching && i < source.meshes.size(); ++i)
+		{
+			const MeshNodeSaveData& a = source.meshes[i];
+			const MeshNodeSaveData& b = loaded.meshes[i];
+			isMatching = a.base.UID == b.base.UID && a.base.name == b.base.name &&
+				a.getVertices().size() == b.getVertices().size() && a.getIndices() == b.getIndices() &&
+				a.getFaceAttributes().size() == b.getFaceAttributes().size() &&
+				std::memcmp(a.getVertices().data(), b.getVertices().data(), a.getVertices().size() * sizeof(graph::VertexAttributes)) == 0 &&
+				std::memcmp(a.getFaceAttributes().data(), b.getFaceAttributes().data(), a.getFaceAttributes().size() * sizeof(graph::FaceAttributes)) == 0;
+		}
+		return isMatching;
+	}
+
+	void benchmarkSceneContainer(const size_t numMeshes, const size_t verticesPerMesh)
+	{
+		GraphSaveData source = createSyntheticMeshSaveData(numMeshes, verticesPerMesh);
+
+		const std::filesystem::path folder        = std::filesystem::temp_directory_path();
+		const std::string           cerealPath    = (folder / "vortexContainerBenchmark.vtx").string();
+		const std::string           containerPath = (folder / "vortexContainerBenchmark.vtxc").string();
+		const size_t                sizeMB        = numMeshes * verticesPerMesh * (sizeof(graph::VertexAttributes) + 3 * sizeof(vtxID) + sizeof(graph::FaceAttributes)) / (1024 * 1024);
+
+		Timer timer;
+		{
+			std::ofstream               file(cerealPath, std::ios::binary);
+			cereal::BinaryOutputArchive archive(file);
+			archive(source);
+		}
+		const float cerealSaveTime = timer.elapsedMillis();
+		timer.reset();
+		{
+			GraphSaveData              loaded;
+			std::ifstream              file(cerealPath, std::ios::binary);
+			cereal::BinaryInputArchive archive(file);
+			archive(loaded);
+		}
+		const float cerealLoadTime = timer.elapsedMillis();
+
+		std::error_code error;
+		std::filesystem::remove(cerealPath, error);
+		VTX_INFO("Scene container benchmark, {} meshes ({} MB)", numMeshes, sizeMB);
+		VTX_INFO("    cereal binary:          save {:.1f} ms, load {:.1f} ms", cerealSaveTime, cerealLoadTime);
+
+		// The container is written and read on one thread and then on the thread pool, both files have to be identical
+		bool&      isParallel  = getOptions()->parallelSceneSerialization;
+		const bool wasParallel = isParallel;
+		uint64_t   fileHashes[2] = {};
+		for (const bool parallel : { false, true })
+		{
+			isParallel = parallel;
+
+			timer.reset();
+			const bool  isWritten = writeSceneContainer(containerPath, source);
+			const float saveTime  = timer.elapsedMillis();
+			fileHashes[parallel]  = isWritten ? utl::hashFile(containerPath) : 0;
+			timer.reset();
+			GraphSaveData loaded;
+			const bool    isRead   = isWritten && readSceneContainer(containerPath, loaded);
+			const float   loadTime = timer.elapsedMillis();
+
+			const bool isMatching = isRead && isMeshSaveDataMatching(source, loaded);
+			std::filesystem::remove(containerPath, error);
+
+			VTX_INFO("    container, {}: save {:.1f} ms, load {:.1f} ms, round trip {}", parallel ? "parallel" : "serial  ",
+					 saveTime, loadTime, isMatching ? "matches" : "FAILED");
+		}
+		isParallel = wasParallel;
+		VTX_INFO("    serial and parallel files are {}", fileHashes[0] != 0 && fileHashes[0] == fileHashes[1] ? "identical" : "DIFFERENT");
+	}
+}
@@ -0,0 +1,173 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Core/Utils.h"
+#include "Core/VortexID.h"
+#include "Scene/Nodes/Mesh.h"
+#include "Scene/Utility/PreparedDataStore.h"
+
+namespace vtx::serializer
+{
+	struct GraphSaveData;
+
+	enum SectionKind : uint32_t
+	{
+		SK_MESH_VERTICES,
+		SK_MESH_INDICES,
+		SK_MESH_FACES,
+		// Followed by one kind per graph::PreparedDataKind, the sections are byte blobs owned by the key of the data
+		SK_PREPARED_DATA,
+
+		SK_COUNT = SK_PREPARED_DATA + graph::PD_COUNT
+	};
+
+	// Sectioned binary scene file (.vtxc). The graph metadata is a small cereal blob, every large array is stored as a raw
+	// section, 64 bytes aligned and checksummed, so that the file can be memory mapped and the arrays copied straight into place.
+	// Layout: Header | SectionEntry table | metadata | sections
+	struct SceneContainer
+	{
+		static constexpr uint32_t version   = 1;
+		static constexpr uint64_t alignment = 64;
+
+		struct Header
+		{
+			char     magic[8];
+			uint32_t version;
+			uint32_t vertexSize;
+			uint64_t numSections;
+			uint64_t sectionTableOffset;
+			uint64_t metadataOffset;
+			uint64_t metadataSize;
+			uint64_t metadataChecksum;
+			uint64_t fileSize;
+		};
+
+		struct SectionEntry
+		{
+			uint32_t kind;
+			uint32_t elementSize;
+			uint64_t ownerUID;
+			uint64_t offset;
+			uint64_t count;
+			uint64_t checksum;
+		};
+	};
+
+	class SceneContainerWriter
+	{
+	public:
+		// The data is referenced, not copied, it has to stay alive until write() returns
+		void addSection(SectionKind kind, uint64_t ownerUID, const void* data, uint64_t count, uint32_t elementSize);
+
+		template<typename T>
+		void addSection(const SectionKind kind, const uint64_t ownerUID, const std::vector<T>& data)
+		{
+			addSection(kind, ownerUID, data.data(), data.size(), sizeof(T));
+		}
+
+		// Writes to a temporary file which replaces filePath once complete
+		bool write(const std::string& filePath, const std::string& metadata);
+
+	private:
+		// Sections are written through one stream per range of sections, the bytes are the same as a sequential write
+		bool writeConcurrently(const std::string& tempPath, const SceneContainer::Header& header, const std::string& metadata) const;
+
+		std::vector<SceneContainer::SectionEntry> entries;
+		std::vector<const void*>                  sectionData;
+	};
+
+	class SceneContainerReader
+	{
+	public:
+		// Maps the file and validates its header, section table and metadata
+		bool open(const std::string& filePath);
+
+		void close();
+
+		std::string getMetadata() const;
+
+		// Identifies the content of the metadata, and so the graph saved in the container
+		uint64_t getMetadataChecksum() const;
+
+		const std::vector<SceneContainer::SectionEntry>& getSections() const;
+
+		const std::string& getFilePath() const;
+
+		// Returns nullptr if the file has no such section
+		const SceneContainer::SectionEntry* findSection(SectionKind kind, uint64_t ownerUID) const;
+
+		// Mapped content of the section, valid while the container is open. The checksum is not verified.
+		const void* getSectionData(const SceneContainer::SectionEntry& entry) const;
+
+		// Copies the section into the vector, returns false if it is missing, of another element type or its checksum doesn't match
+		template<typename T>
+		bool readSection(const SectionKind kind, const uint64_t ownerUID, std::vector<T>& data) const
+		{
+			const SceneContainer::SectionEntry* entry = findSection(kind, ownerUID);
+			if (entry == nullptr || entry->elementSize != sizeof(T))
+			{
+				return false;
+			}
+			data.resize(entry->count);
+			return copySection(*entry, data.data());
+		}
+
+	private:
+		bool copySection(const SceneContainer::SectionEntry& entry, void* destination) const;
+
+		utl::MappedFile                                 file;
+		std::string                                     filePath;
+		std::vector<SceneContainer::SectionEntry>       sections;
+		std::map<std::pair<uint32_t, uint64_t>, size_t> sectionOfKey;
+	};
+
+	// Arrays of a deferred mesh, the sections of the mesh in a container which stays mapped as long as the source is alive
+	class ContainerMeshSource : public graph::MeshPayloadSource
+	{
+	public:
+		ContainerMeshSource(std::shared_ptr<const SceneContainerReader> reader, vtxID savedUID);
+
+		bool read(graph::MeshPayload& payload) const override;
+
+		const std::string& getFilePath() const override;
+
+		// Adds the sections of the mesh under ownerUID, the writer references the mapping. Returns false if a section is missing.
+		bool addSections(SceneContainerWriter& writer, uint64_t ownerUID) const;
+
+	private:
+		std::shared_ptr<const SceneContainerReader> reader;
+		vtxID                                       savedUID;
+	};
+
+	bool isSceneContainerFile(const std::string& filePath);
+
+	// Metadata blob of the graph, meshes only contribute their base data and status, their arrays are stored in sections
+	std::string encodeSceneMetadata(GraphSaveData& graphSaveData);
+
+	// Restores the graph from the metadata of the container, the meshes are left without their arrays
+	bool decodeSceneMetadata(const SceneContainerReader& reader, GraphSaveData& graphSaveData);
+
+	// The mesh arrays are written from the mesh nodes, the save data or the file a deferred mesh was loaded from directly,
+	// the metadata holds everything else.
+	// The data prepared by the current scene nodes is embedded on request, see graph::PreparedDataStore.
+	bool writeSceneContainer(const std::string& filePath, GraphSaveData& graphSaveData, bool isEmbeddingPreparedData = false);
+
+	// Makes the prepared data sections of the container available to the nodes, the store keeps the reader open until the
+	// scene is replaced or the file is saved over
+	void publishPreparedData(const std::shared_ptr<SceneContainerReader>& reader);
+
+	bool readSceneContainer(const std::string& filePath, GraphSaveData& graphSaveData, uint64_t* metadataChecksum = nullptr);
+
+	// Meshes with distinct arrays, without graph nodes
+	GraphSaveData createSyntheticMeshSaveData(size_t numMeshes, size_t verticesPerMesh);
+
+	// True if both hold the same meshes with identical arrays
+	bool isMeshSaveDataMatching(const GraphSaveData& source, const GraphSaveData& loaded);
+
+	// Round trips synthetic meshes through the cereal binary format and through the container, serially and in parallel.
+	// Logs the save and load times, whether the loaded data matches and whether both containers are byte identical
+	void benchmarkSceneContainer(size_t numMeshes = 32, size_t verticesPerMesh = 1 << 18);
+}
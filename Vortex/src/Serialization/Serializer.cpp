@@ -1,4 +1,5 @@
 #include "Serializer.h"
+#include <filesystem>
 #include <fstream>
 #include "Core/Log.h"
 #include "Scene/Scene.h"
@@ -7,6 +8,9 @@
 #include "Scene/Utility/Operations.h"
 
 #include "ArchiveFunctions.h"
+#include "Autosave.h"
+#include "PartialScene.h"
+#include "SceneContainer.h"
 #include <cereal/cereal.hpp>
 #include <cereal/archives/xml.hpp>
 //#include <cereal/archives/json.hpp>
@@ -22,7 +26,7 @@ namespace vtx::serializer
 
 			const std::string fileExtension = utl::getFileExtension(filePath);
             std::ifstream file;
-            if (fileExtension == "vtx") {
+            if (fileExtension == "vtx" || fileExtension == "vtxc") {
                 file.open(filePath, std::ios::binary);
             }
             else {
@@ -41,6 +45,7 @@ namespace vtx::serializer
 
 
             GraphSaveData graphSaveData;
+            bool isRestored = false;
             if (fileExtension == "json")
             {
                 //cereal::JSONInputArchive archiveIn(file);
@@ -56,16 +61,42 @@ namespace vtx::serializer
                 cereal::BinaryInputArchive archiveIn(file);
                 archiveIn(graphSaveData);
             }
+            else if (fileExtension == "vtxc")
+            {
+                // the container is memory mapped, the stream is only used to check the file can be opened.
+                // Autosave deltas next to the container are applied on top of it
+                file.close();
+                if (getOptions()->lazyMeshLoading && !std::filesystem::exists(Autosave::getDeltaPath(filePath, 1)))
+                {
+                    // meshes are restored as handles, their arrays are read from the mapped file on first access
+                    PartialScene partialScene;
+                    if (!partialScene.open(filePath))
+                    {
+                        return false;
+                    }
+                    std::tie(rendererNode, sceneRootNode) = partialScene.loadScene();
+                    isRestored = true;
+                }
+                else if (!Autosave::replay(filePath, graphSaveData))
+                {
+                    return false;
+                }
+            }
             else
             {
                 VTX_ERROR("Unsupported file extension: {0}", fileExtension);
                 return false;
             }
-            const auto [_renderer, _sceneRoot] = graphSaveData.restoreShaderGraph(filePath);
-            rendererNode = _renderer;
-            sceneRootNode = _sceneRoot;
+            if (!isRestored)
+            {
+                const auto [_renderer, _sceneRoot] = graphSaveData.restoreShaderGraph(filePath);
+                rendererNode = _renderer;
+                sceneRootNode = _sceneRoot;
+            }
 
             graph::Scene* scene = graph::Scene::get();
+            // the replaced scene is released in bulk once the new one is connected
+            std::vector<std::shared_ptr<graph::Node>> replacedNodes;
             if (sceneRootNode) {
                 // if the scene is not imported we replace the old scene root with the new one
                 if (importScene)
@@ -74,6 +105,7 @@ namespace vtx::serializer
                 }
                 else
                 {
+                    replacedNodes.push_back(scene->sceneRoot);
                     scene->sceneRoot = sceneRootNode;
                 }
             }
@@ -85,6 +117,7 @@ namespace vtx::serializer
             if (rendererNode)
             {
                 // if there is a renderer node we replace the old one
+                replacedNodes.push_back(scene->renderer);
                 scene->renderer = rendererNode;
             }
             else if (!scene->renderer)
@@ -102,6 +135,7 @@ namespace vtx::serializer
             }
             // we make sure the renderer node is connected to the scene root
             scene->renderer->sceneRoot = scene->sceneRoot;
+            ops::releaseNodes(std::move(replacedNodes));
         }
         catch (const std::exception& e)
         {
@@ -121,6 +155,19 @@ namespace vtx::serializer
     {
         try
         {
+            if (isSceneContainerFile(filePath))
+            {
+                // The file may be mapped by the loaded scene. The mappings are released before it is replaced: a pending
+                // autosave may hold deferred meshes, the save data loads the meshes deferred to this file and the store
+                // drops the prepared data embedded in it
+                Autosave::get()->wait();
+                GraphSaveData graphSaveData;
+                graphSaveData.prepareSaveData(filePath);
+                graph::PreparedDataStore::get()->releaseFile(filePath);
+                writeSceneContainer(filePath, graphSaveData, getOptions()->embedPreparedData);
+                return;
+            }
+
             std::ofstream file;
             const std::string fileExtension = utl::getFileExtension(filePath);
 
@@ -0,0 +1,249 @@
+#include "TestCases.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <set>
+#include "Core/Options.h"
+#include "Scene/Nodes/Mesh.h"
+#include "Scene/Utility/Operations.h"
+#include "Serialization/Autosave.h"
+#include "Serialization/NodeSaveData.h"
+
+namespace vtx::test
+{
+	// Save data of a small graph, the meshes read their arrays from mesh nodes like the save data of a scene
+	struct AutosaveGraph
+	{
+		serializer::GraphSaveData                 saveData;
+		std::vector<std::shared_ptr<graph::Mesh>> meshNodes;
+		vtxID                                     nextUID = 1;
+
+		serializer::BaseNodeSaveData makeBase(const std::string& name, const graph::NodeType type)
+		{
+			serializer::BaseNodeSaveData base;
+			base.UID  = nextUID++;
+			base.TID  = base.UID;
+			base.name = name + "_" + std::to_string(base.UID);
+			base.type = type;
+			return base;
+		}
+
+		void addTransform(const float x)
+		{
+			serializer::TransformNodeSaveData transform;
+			transform.base            = makeBase("Transform", graph::NT_TRANSFORM);
+			transform.affineTransform = math::affine3f::translate(math::vec3f(x, 0.0f, 0.0f));
+			saveData.transforms.push_back(std::move(transform));
+		}
+
+		void addMesh(const size_t numVertices)
+		{
+			const std::shared_ptr<graph::Mesh> node = ops::createNode<graph::Mesh>();
+			node->vertices.resize(numVertices);
+			for (size_t v = 0; v < numVertices; ++v)
+			{
+				node->vertices[v].position = math::vec3f((float)v, (float)nextUID, 0.0f);
+			}
+			node->indices.resize(3 * numVertices);
+			for (size_t v = 0; v < node->indices.size(); ++v)
+			{
+				node->indices[v] = (vtxID)((v * 31) % numVertices);
+			}
+			node->faceAttributes.resize(numVertices);
+			node->status.hasFaceAttributes = true;
+
+			serializer::MeshNodeSaveData mesh(node, "");
+			mesh.base = makeBase("Mesh", graph::NT_MESH);
+			saveData.meshes.push_back(std::move(mesh));
+			meshNodes.push_back(node);
+		}
+
+		// The autosave keeps the save data until it is written, each snapshot gets its own copy
+		std::shared_ptr<serializer::GraphSaveData> copy() const
+		{
+			return std::make_shared<serializer::GraphSaveData>(saveData);
+		}
+	};
+
+	template<typename T>
+	static bool isArrayMatching(const std::vector<T>& a, const std::vector<T>& b)
+	{
+		return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+	}
+
+	// Same nodes with the same content, in any order
+	static bool isGraphMatching(const serializer::GraphSaveData& expected, const serializer::GraphSaveData& replayed)
+	{
+		if (expected.transforms.size() != replayed.transforms.size() || expected.meshes.size() != replayed.meshes.size() ||
+			expected.sceneRootUID != replayed.sceneRootUID)
+		{
+			return false;
+		}
+		std::map<vtxID, const serializer::TransformNodeSaveData*> transforms;
+		for (const serializer::TransformNodeSaveData& transform : replayed.transforms)
+		{
+			transforms[transform.base.UID] = &transform;
+		}
+		for (const serializer::TransformNodeSaveData& transform : expected.transforms)
+		{
+			const auto it = transforms.find(transform.base.UID);
+			if (it == transforms.end() || it->second->base.name != transform.base.name || !(it->second->affineTransform == transform.affineTransform))
+			{
+				return false;
+			}
+		}
+		std::map<vtxID, const serializer::MeshNodeSaveData*> meshes;
+		for (const serializer::MeshNodeSaveData& mesh : replayed.meshes)
+		{
+			meshes[mesh.base.UID] = &mesh;
+		}
+		for (const serializer::MeshNodeSaveData& mesh : expected.meshes)
+		{
+			const auto it = meshes.find(mesh.base.UID);
+			if (it == meshes.end() || !isArrayMatching(it->second->getVertices(), mesh.getVertices()) ||
+				!isArrayMatching(it->second->getIndices(), mesh.getIndices()) || !isArrayMatching(it->second->getFaceAttributes(), mesh.getFaceAttributes()))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static bool isReplayMatching(const std::string& basePath, const AutosaveGraph& graph)
+	{
+		serializer::GraphSaveData replayed;
+		return serializer::Autosave::replay(basePath, replayed) && isGraphMatching(graph.saveData, replayed);
+	}
+
+	static bool isDeltaWritten(const std::string& basePath, const uint32_t sequence)
+	{
+		return std::filesystem::exists(serializer::Autosave::getDeltaPath(basePath, sequence));
+	}
+
+	bool testAutosave()
+	{
+		const std::string basePath = (std::filesystem::temp_directory_path() / "vortexAutosaveTest.vtxc").string();
+		AutosaveGraph     graph;
+		for (int i = 0; i < 6; ++i)
+		{
+			graph.addTransform((float)i);
+		}
+		graph.addMesh(64);
+		graph.addMesh(96);
+		graph.saveData.activeRendererUID = 0;
+		graph.saveData.activeCameraUID   = 0;
+		graph.saveData.sceneRootUID      = graph.saveData.transforms.front().base.UID;
+
+		std::set<vtxID> editedMeshes;
+		auto isMeshChanged = [&editedMeshes](const serializer::MeshNodeSaveData& mesh)
+		{
+			return editedMeshes.count(mesh.base.UID) != 0;
+		};
+
+		serializer::Autosave autosave;
+		autosave.reset(basePath);
+		bool isPassed = check(autosave.snapshot(graph.copy(), isMeshChanged), "base snapshot taken");
+		autosave.wait();
+		isPassed = check(std::filesystem::exists(basePath) && isReplayMatching(basePath, graph), "base replays to the graph") && isPassed;
+
+		// Nothing changed, no delta
+		isPassed = check(autosave.snapshot(graph.copy(), isMeshChanged), "unchanged snapshot taken") && isPassed;
+		autosave.wait();
+		isPassed = check(!isDeltaWritten(basePath, 1), "unchanged graph writes no delta") && isPassed;
+
+		// A node removed between two deltas
+		graph.saveData.transforms[1].affineTransform.p.y = 2.0f;
+		isPassed = check(autosave.snapshot(graph.copy(), isMeshChanged), "first delta taken") && isPassed;
+		autosave.wait();
+		const vtxID removedUID = graph.saveData.transforms[3].base.UID;
+		graph.saveData.transforms.erase(graph.saveData.transforms.begin() + 3);
+		isPassed = check(autosave.snapshot(graph.copy(), isMeshChanged), "delta with a removal taken") && isPassed;
+		autosave.wait();
+		serializer::GraphSaveData afterRemoval;
+		bool isRemoved = serializer::Autosave::replay(basePath, afterRemoval) && isGraphMatching(graph.saveData, afterRemoval);
+		for (const serializer::TransformNodeSaveData& transform : afterRemoval.transforms)
+		{
+			isRemoved = isRemoved && transform.base.UID != removedUID;
+		}
+		isPassed = check(isDeltaWritten(basePath, 2) && isRemoved, "node removed between deltas is gone after the replay") && isPassed;
+
+		// A mesh edited in place: same arrays, same sizes, the change is known through its report
+		graph.meshNodes[0]->vertices[5].position.z = 7.0f;
+		editedMeshes = { graph.saveData.meshes[0].base.UID };
+		isPassed = check(autosave.snapshot(graph.copy(), isMeshChanged), "mesh edit snapshot taken") && isPassed;
+		autosave.wait();
+		editedMeshes.clear();
+		isPassed = check(isDeltaWritten(basePath, 3) && isReplayMatching(basePath, graph), "mesh edited in place replays with its new arrays") && isPassed;
+
+		// A mesh replaced by a new one under the same UID whose arrays are at the same address, with the same sizes and
+		// name. Only its report tells it apart, as the change epoch does for a node created again.
+		{
+			const std::shared_ptr<graph::Mesh> replaced    = graph.meshNodes[1];
+			const std::shared_ptr<graph::Mesh> replacement = ops::createNode<graph::Mesh>();
+			const void* const                  address     = replaced->vertices.data();
+			replacement->vertices       = std::move(replaced->vertices);
+			replacement->indices        = std::move(replaced->indices);
+			replacement->faceAttributes = std::move(replaced->faceAttributes);
+			replacement->status         = replaced->status;
+			for (graph::VertexAttributes& vertex : replacement->vertices)
+			{
+				vertex.position.x = -vertex.position.x;
+			}
+			serializer::MeshNodeSaveData mesh(replacement, "");
+			mesh.base                  = graph.saveData.meshes[1].base;
+			graph.saveData.meshes[1]   = std::move(mesh);
+			graph.meshNodes[1]         = replacement;
+			isPassed = check(replacement->vertices.data() == address, "replacement arrays at the same address") && isPassed;
+		}
+		editedMeshes = { graph.saveData.meshes[1].base.UID };
+		isPassed = check(autosave.snapshot(graph.copy(), isMeshChanged), "mesh replacement snapshot taken") && isPassed;
+		autosave.wait();
+		editedMeshes.clear();
+		isPassed = check(isDeltaWritten(basePath, 4) && isReplayMatching(basePath, graph), "mesh replaced at the same address replays with the new arrays") && isPassed;
+
+		// Crash before the compaction: a delta and a compacted base were being written when the session ended
+		const std::string pendingDeltaPath = serializer::Autosave::getDeltaPath(basePath, 5) + ".tmp";
+		const std::string compactedPath    = basePath + ".compacted";
+		for (const std::string& path : { pendingDeltaPath, compactedPath })
+		{
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+			file << "partially written";
+		}
+		isPassed = check(isReplayMatching(basePath, graph), "crashed session replays to the last delta") && isPassed;
+		const uint64_t foldedChecksum = serializer::Autosave::foldDeltas(basePath);
+		isPassed = check(foldedChecksum != 0 && !isDeltaWritten(basePath, 1) && isReplayMatching(basePath, graph), "crashed session folds into a new base") && isPassed;
+
+		// Compaction of a running session, the deltas which follow are written against the new base. Its base is over the
+		// copy budget and written in place.
+		int&      copyBudget    = getOptions()->autosaveCopyBudget;
+		const int oldCopyBudget = copyBudget;
+		copyBudget              = 0;
+		serializer::Autosave session;
+		session.reset(basePath);
+		isPassed = check(session.snapshot(graph.copy(), isMeshChanged), "second session base taken") && isPassed;
+		session.wait();
+		copyBudget = oldCopyBudget;
+		isPassed   = check(isReplayMatching(basePath, graph), "base over the copy budget replays to the graph") && isPassed;
+		graph.saveData.transforms[0].affineTransform.p.z = 3.0f;
+		graph.addTransform(10.0f);
+		isPassed = check(session.snapshot(graph.copy(), isMeshChanged), "second session delta taken") && isPassed;
+		session.wait();
+		isPassed = check(session.compact() && !isDeltaWritten(basePath, 1) && isReplayMatching(basePath, graph), "compacted session replays to the graph") && isPassed;
+		graph.saveData.transforms.erase(graph.saveData.transforms.begin());
+		graph.saveData.sceneRootUID = graph.saveData.transforms.front().base.UID;
+		isPassed = check(session.snapshot(graph.copy(), isMeshChanged), "delta after the compaction taken") && isPassed;
+		session.wait();
+		isPassed = check(isDeltaWritten(basePath, 1) && isReplayMatching(basePath, graph), "delta after the compaction applies to the new base") && isPassed;
+
+		std::error_code error;
+		for (uint32_t sequence = 1; sequence <= 8; ++sequence)
+		{
+			std::filesystem::remove(serializer::Autosave::getDeltaPath(basePath, sequence), error);
+		}
+		std::filesystem::remove(pendingDeltaPath, error);
+		std::filesystem::remove(compactedPath, error);
+		std::filesystem::remove(basePath, error);
+		return isPassed;
+	}
+}
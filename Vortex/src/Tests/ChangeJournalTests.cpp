@@ -0,0 +1,114 @@
+#include "TestCases.h"
+#include <algorithm>
+#include "Device/UploadCode/DeviceDataCoordinator.h"
+#include "Scene/Scene.h"
+#include "Scene/SceneIndexManager.h"
+#include "Scene/Nodes/Group.h"
+#include "Scene/Nodes/Transform.h"
+#include "Scene/Utility/Operations.h"
+
+namespace vtx::test
+{
+	static std::vector<vtxID> sorted(std::vector<vtxID> ids)
+	{
+		std::sort(ids.begin(), ids.end());
+		return ids;
+	}
+
+	static std::vector<vtxID> getUIDs(const std::vector<std::shared_ptr<graph::Transform>>& transforms)
+	{
+		std::vector<vtxID> ids;
+		for (const std::shared_ptr<graph::Transform>& transform : transforms)
+		{
+			ids.push_back(transform->getUID());
+		}
+		return sorted(ids);
+	}
+
+	bool testChangeJournal()
+	{
+		using Counters = graph::SceneIndexManager::ChangeJournalCounters;
+		const std::shared_ptr<graph::SceneIndexManager> sim = graph::Scene::getSim();
+		sim->takeChangedNodes(graph::NT_TRANSFORM);
+		sim->takeChangedNodes(graph::NT_GROUP);
+		sim->cleanDeletedNodesByType(graph::NT_TRANSFORM);
+		const Counters start = sim->getChangeJournalCounters();
+		bool           isPassed = true;
+
+		// Recording a node lists it once
+		std::vector<std::shared_ptr<graph::Transform>> transforms;
+		for (int i = 0; i < 5; ++i)
+		{
+			transforms.push_back(ops::createNode<graph::Transform>());
+		}
+		const std::shared_ptr<graph::Group> group = ops::createNode<graph::Group>();
+		Counters counters = sim->getChangeJournalCounters();
+		isPassed = check(counters.markedNodes == start.markedNodes + 6, "recorded nodes are listed") && isPassed;
+		isPassed = check(counters.pendingNodes == start.pendingNodes + 6, "recorded nodes are pending") && isPassed;
+
+		// Listed nodes aren't listed again, but every change advances the epoch
+		const uint64_t epoch = sim->getChangeEpoch();
+		for (int i = 0; i < 3; ++i)
+		{
+			transforms[0]->markChanged();
+		}
+		counters = sim->getChangeJournalCounters();
+		isPassed = check(counters.markedNodes == start.markedNodes + 6, "listed node is not listed twice") && isPassed;
+		isPassed = check(sim->getChangeEpoch() == epoch + 3, "every change advances the epoch") && isPassed;
+		isPassed = check(sim->getLastChangeEpoch(transforms[0]->getUID()) == epoch + 3, "last change epoch of the node") && isPassed;
+		isPassed = check(sim->getLastChangeEpoch(transforms[1]->getUID()) <= epoch, "other nodes keep their epoch") && isPassed;
+
+		// A node deleted while listed is dropped, even if its id is handed to a new node which is listed itself
+		const vtxID deletedUID = transforms.back()->getUID();
+		transforms.pop_back();
+		const std::vector<math::vec2ui> deleted = sim->getDeletedNodesByType(graph::NT_TRANSFORM);
+		isPassed = check(deleted.size() == 1 && deleted[0].x == deletedUID, "deleted node is reported") && isPassed;
+		sim->cleanDeletedNodesByType(graph::NT_TRANSFORM);
+		transforms.push_back(ops::createNode<graph::Transform>());
+
+		const std::vector<vtxID> taken = sorted(sim->takeChangedNodes(graph::NT_TRANSFORM));
+		isPassed = check(taken == getUIDs(transforms), "journal lists exactly the live changed transforms") && isPassed;
+		isPassed = check(std::adjacent_find(taken.begin(), taken.end()) == taken.end(), "journal lists every node once") && isPassed;
+		isPassed = check(std::find(taken.begin(), taken.end(), group->getUID()) == taken.end(), "journal is kept per type") && isPassed;
+		isPassed = check(sim->takeChangedNodes(graph::NT_TRANSFORM).empty(), "taken journal is empty") && isPassed;
+
+		counters = sim->getChangeJournalCounters();
+		isPassed = check(counters.takenNodes == start.takenNodes + transforms.size(), "taken nodes are counted") && isPassed;
+		isPassed = check(counters.markedNodes == start.markedNodes + 7, "new node on a reused id is listed") && isPassed;
+		isPassed = check(counters.pendingNodes == start.pendingNodes + 1, "only the group is pending") && isPassed;
+		isPassed = check(sim->takeChangedNodes(graph::NT_GROUP) == std::vector<vtxID>{ group->getUID() }, "group journal") && isPassed;
+
+		// Nodes failing to synchronize stay listed for the next sync, the others leave the journal
+		transforms[1]->markChanged();
+		transforms[2]->markChanged();
+		const vtxID                          failingUID = transforms[1]->getUID();
+		device::DeviceDataCoordinator::SyncCounters syncCounters;
+		std::vector<vtxID>                   synced;
+		const auto syncFunction = [&](const std::shared_ptr<graph::Transform>& transform)
+		{
+			synced.push_back(transform->getUID());
+			return transform->getUID() != failingUID;
+		};
+		device::DeviceDataCoordinator::syncChangedNodes<graph::Transform>(graph::NT_TRANSFORM, syncCounters, syncFunction);
+		isPassed = check(sorted(synced) == sorted({ failingUID, transforms[2]->getUID() }), "changed nodes are synchronized") && isPassed;
+		isPassed = check(syncCounters.visitedNodes == 2 && syncCounters.pendingNodes == 1, "sync counters") && isPassed;
+
+		synced.clear();
+		syncCounters = {};
+		device::DeviceDataCoordinator::syncChangedNodes<graph::Transform>(graph::NT_TRANSFORM, syncCounters, [&](const std::shared_ptr<graph::Transform>& transform)
+		{
+			synced.push_back(transform->getUID());
+			return true;
+		});
+		isPassed = check(synced == std::vector<vtxID>{ failingUID }, "pending node is synchronized again") && isPassed;
+		isPassed = check(syncCounters.visitedNodes == 1 && syncCounters.pendingNodes == 0, "sync counters of the retry") && isPassed;
+
+		syncCounters = {};
+		device::DeviceDataCoordinator::syncChangedNodes<graph::Transform>(graph::NT_TRANSFORM, syncCounters, syncFunction);
+		isPassed = check(syncCounters.visitedNodes == 0, "idle sync visits no node") && isPassed;
+
+		transforms.clear();
+		sim->cleanDeletedNodesByType(graph::NT_TRANSFORM);
+		return isPassed;
+	}
+}
@@ -0,0 +1,102 @@
+#include "TestCases.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include "Scene/Nodes/Mesh.h"
+#include "Scene/Utility/Operations.h"
+
+namespace vtx::test
+{
+	static std::shared_ptr<graph::Mesh> createSizedMesh(const size_t numVertices)
+	{
+		const std::shared_ptr<graph::Mesh> mesh = ops::createNode<graph::Mesh>();
+		mesh->vertices.resize(numVertices);
+		mesh->indices.resize(3 * (numVertices - 2));
+		for (size_t t = 0; t + 2 < numVertices; ++t)
+		{
+			mesh->indices[3 * t]     = (vtxID)t;
+			mesh->indices[3 * t + 1] = (vtxID)(t + 1);
+			mesh->indices[3 * t + 2] = (vtxID)(t + 2);
+		}
+		return mesh;
+	}
+
+	bool testCompactVertices()
+	{
+		// Random vertices over the bounds, plus the corners of the bounds and the axis directions as normals and tangents
+		std::mt19937                          generator(7);
+		std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+		const math::vec3f                     boundsMin(-3.0f, -1.0f, 2.0f);
+		const math::vec3f                     boundsExtent(6.0f, 2.0f, 10.0f);
+		const math::vec3f                     axes[] = { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f },
+														 { -1.0f, 0.0f, 0.0f }, { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, -1.0f } };
+		auto randomVector = [&]()
+		{
+			return math::vec3f(distribution(generator), distribution(generator), distribution(generator));
+		};
+
+		const std::shared_ptr<graph::Mesh> mesh = ops::createNode<graph::Mesh>();
+		for (size_t v = 0; v < 100000; ++v)
+		{
+			graph::VertexAttributes vertex{};
+			vertex.position  = boundsMin + boundsExtent * (randomVector() * 0.5f + math::vec3f(0.5f));
+			vertex.texCoord  = math::vec3f(4.0f * distribution(generator), 4.0f * distribution(generator), 0.0f);
+			vertex.normal    = v < 6 ? axes[v] : math::normalize(randomVector());
+			vertex.tangent   = v < 6 ? axes[(v + 1) % 6] : math::normalize(cross(vertex.normal, randomVector()));
+			vertex.bitangent = cross(vertex.normal, vertex.tangent) * (v % 2 == 0 ? 1.0f : -1.0f);
+			mesh->vertices.push_back(vertex);
+		}
+		mesh->vertices[0].position = boundsMin;
+		mesh->vertices[1].position = boundsMin + boundsExtent;
+
+		std::vector<graph::CompactVertexAttributes> compactVertices;
+		const graph::CompactVertexBounds            bounds = ops::computeCompactVertexBounds(mesh);
+		ops::encodeCompactVertices(mesh, bounds, compactVertices);
+		bool isPassed = check(compactVertices.size() == mesh->vertices.size(), "every vertex encoded");
+		isPassed = check(bounds.min == boundsMin && bounds.extent == boundsExtent, "bounds span the positions") && isPassed;
+
+		// Largest errors: positions in quantisation steps, uvs relative to their value, directions per component
+		float positionError = 0.0f;
+		float texCoordError = 0.0f;
+		float normalError   = 0.0f;
+		float tangentError  = 0.0f;
+		bool  isSignKept    = true;
+		for (size_t v = 0; v < compactVertices.size(); ++v)
+		{
+			const graph::VertexAttributes& vertex  = mesh->vertices[v];
+			const graph::VertexAttributes  decoded = graph::decodeVertex(compactVertices[v], bounds);
+			for (int i = 0; i < 3; ++i)
+			{
+				positionError = std::max(positionError, std::fabs(decoded.position[i] - vertex.position[i]) * (float)graph::compact::positionMax / boundsExtent[i]);
+				normalError   = std::max(normalError, std::fabs(decoded.normal[i] - vertex.normal[i]));
+				tangentError  = std::max(tangentError, std::fabs(decoded.tangent[i] - vertex.tangent[i]));
+			}
+			for (int i = 0; i < 2; ++i)
+			{
+				texCoordError = std::max(texCoordError, std::fabs(decoded.texCoord[i] - vertex.texCoord[i]) / std::max(std::fabs(vertex.texCoord[i]), 1.0f / 16384.0f));
+			}
+			isSignKept = isSignKept && decoded.texCoord.z == 0.0f && math::dot(decoded.bitangent, vertex.bitangent) > 0.99f;
+		}
+		// Half a step of rounding, the rest is the float precision of the 21 bit positions
+		isPassed = check(positionError <= 1.0f, "positions within a quantisation step") && isPassed;
+		isPassed = check(texCoordError <= 1.0f / 2048.0f, "uvs within the half float precision") && isPassed;
+		isPassed = check(normalError <= 1.5e-4f, "octahedral normals within the 16 bit bound") && isPassed;
+		isPassed = check(tangentError <= 3e-4f, "octahedral tangents within the 15 bit bound") && isPassed;
+		isPassed = check(isSignKept, "bitangent sign kept") && isPassed;
+
+		// Exact values stay exact
+		isPassed = check(graph::compact::halfToFloat(graph::compact::floatToHalf(0.5f)) == 0.5f && graph::compact::halfToFloat(graph::compact::floatToHalf(-2.0f)) == -2.0f, "exact uvs round trip") && isPassed;
+
+		// 16 bit indices up to 65535 vertices, the largest index 65534 still fits
+		isPassed = check(ops::hasShortIndices(65535) && !ops::hasShortIndices(65536), "16 bit indices below 65536 vertices") && isPassed;
+		const std::shared_ptr<graph::Mesh> shortMesh = createSizedMesh(65535);
+		const std::shared_ptr<graph::Mesh> longMesh  = createSizedMesh(65536);
+		const vtxID                        maxIndex  = *std::max_element(shortMesh->indices.begin(), shortMesh->indices.end());
+		isPassed = check((vtxID)(uint16_t)maxIndex == maxIndex, "largest index of a 65535 vertex mesh fits 16 bits") && isPassed;
+		const ops::VertexMemoryReport report = ops::reportVertexMemory({ shortMesh, longMesh });
+		isPassed = check(report.meshes == 2 && report.shortIndexMeshes == 1, "only the 65535 vertex mesh gets 16 bit indices") && isPassed;
+		isPassed = check(report.compactBytes == (65535 + 65536) * sizeof(graph::CompactVertexAttributes) +
+						 shortMesh->indices.size() * sizeof(uint16_t) + longMesh->indices.size() * sizeof(vtxID), "compact size counts the index widths") && isPassed;
+		return isPassed;
+	}
+}
@@ -0,0 +1,106 @@
+#include "TestCases.h"
+#include <cmath>
+#include <random>
+#include "Scene/Nodes/EnvironmentLight.h"
+
+namespace vtx::test
+{
+	// Lat-long map with a sky gradient, noise, a small bright sun and a black ground, rgba float
+	static std::vector<float> createEnvironmentMap(const unsigned int width, const unsigned int height)
+	{
+		std::mt19937                          rng(42);
+		std::uniform_real_distribution<float> noise(0.0f, 0.2f);
+		std::vector<float>                    pixels((size_t)width * height * 4, 0.0f);
+		for (unsigned int y = 0; y < height; ++y)
+		{
+			for (unsigned int x = 0; x < width; ++x)
+			{
+				float* p = pixels.data() + ((size_t)y * width + x) * 4;
+				p[3]     = 1.0f;
+				if (y >= height * 3 / 4)
+				{
+					continue;
+				}
+				const float sky  = 0.2f + (float)y / (float)height;
+				const float dx   = (float)x - (float)width * 0.3f;
+				const float dy   = (float)y - (float)height * 0.2f;
+				const float sun  = dx * dx + dy * dy < 9.0f ? 500.0f : 0.0f;
+				p[0] = sky * 0.6f + noise(rng) + sun;
+				p[1] = sky * 0.8f + noise(rng) + sun;
+				p[2] = sky + noise(rng) + sun;
+			}
+		}
+		return pixels;
+	}
+
+	static bool checkEnvironmentMap(const unsigned int width, const unsigned int height, const std::vector<float>& pixels, const std::string& label)
+	{
+		std::vector<float>     importance;
+		std::vector<AliasData> aliasMap;
+		const float            invIntegral = graph::buildEnvironmentSampling(pixels.data(), width, height, false, importance, aliasMap);
+		const size_t           size        = aliasMap.size();
+		bool                   isPassed    = check(size == (size_t)width * height, label + " alias map size");
+		if (!isPassed)
+		{
+			return false;
+		}
+
+		double sum = 0.0;
+		for (const float value : importance)
+		{
+			sum += value;
+		}
+		if (sum <= 0.0)
+		{
+			// A black map is sampled uniformly over the sphere
+			isPassed = check(invIntegral == 0.0f, label + " inverse integral of a black map") && isPassed;
+			for (const AliasData& entry : aliasMap)
+			{
+				isPassed = checkNear(entry.pdf, 0.25 / M_PI, 1e-6, label + " uniform pdf") && isPassed;
+			}
+			return isPassed;
+		}
+		isPassed = checkNear(invIntegral, 1.0 / sum, 1e-5 / sum, label + " inverse integral") && isPassed;
+
+		// Exact probability of every texel: picked as the column with probability q, or as the alias of other columns
+		std::vector<double> probability(size, 0.0);
+		for (size_t i = 0; i < size; ++i)
+		{
+			const double q = std::min((double)aliasMap[i].q, 1.0);
+			probability[i] += q / (double)size;
+			if (aliasMap[i].alias >= size)
+			{
+				return check(false, label + " alias out of range");
+			}
+			probability[aliasMap[i].alias] += (1.0 - q) / (double)size;
+		}
+		size_t numMismatches = 0;
+		for (size_t i = 0; i < size; ++i)
+		{
+			const double expected = (double)importance[i] / sum;
+			if (std::abs(probability[i] - expected) > 1e-3 * expected + 1e-4 / (double)size)
+			{
+				if (numMismatches++ < 8)
+				{
+					checkNear(probability[i], expected, 1e-3 * expected + 1e-4 / (double)size, label + " probability of texel " + std::to_string(i));
+				}
+			}
+		}
+		isPassed = check(numMismatches == 0, label + " " + std::to_string(numMismatches) + " texels sampled with the wrong probability") && isPassed;
+
+		// Histogram of the sampled texels and pdf integral over the sphere
+		isPassed = check(graph::validateEnvironmentSampling(aliasMap, importance, width, height, label), label + " sampled histogram") && isPassed;
+		return isPassed;
+	}
+
+	bool testEnvironmentSampling()
+	{
+		bool isPassed = true;
+		for (const auto& [width, height] : { std::pair<unsigned, unsigned>{ 512, 256 }, std::pair<unsigned, unsigned>{ 1031, 517 } })
+		{
+			isPassed = checkEnvironmentMap(width, height, createEnvironmentMap(width, height), "map " + std::to_string(width) + "x" + std::to_string(height)) && isPassed;
+		}
+		const std::vector<float> black(64 * 32 * 4, 0.0f);
+		return checkEnvironmentMap(64, 32, black, "black map") && isPassed;
+	}
+}
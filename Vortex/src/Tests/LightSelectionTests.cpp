@@ -0,0 +1,149 @@
+#include "TestCases.h"
+#include <cfloat>
+#include <random>
+#include "Core/Log.h"
+#include "Device/Structs/LightSelection.h"
+#include "Device/UploadCode/UploadFunctions.h"
+
+namespace vtx::test
+{
+	// Probability of every light reached from the node, by walking every branch of the tree
+	static void enumerateBvh(const LightSelection& selection, const int nodeIndex, const double probability, const math::vec3f& point, std::vector<double>& pdfs)
+	{
+		const LightBvhNode& node = selection.bvhNodes[nodeIndex];
+		if (node.children[0] < 0)
+		{
+			pdfs[node.light] += probability;
+			return;
+		}
+		const double p0 = lightSelection::firstChildProbability(selection, node, point);
+		enumerateBvh(selection, node.children[0], probability * p0, point, pdfs);
+		enumerateBvh(selection, node.children[1], probability * (1.0 - p0), point, pdfs);
+	}
+
+	static std::vector<LightBounds> createLights(const int numLights, const int numInfinite)
+	{
+		std::mt19937                          rng(1234);
+		std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+		std::uniform_real_distribution<float> size(0.01f, 2.0f);
+		std::uniform_real_distribution<float> power(0.1f, 100.0f);
+		std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+
+		std::vector<LightBounds> lights(numLights);
+		for (int i = 0; i < numLights; ++i)
+		{
+			LightBounds& light = lights[i];
+			light.power        = power(rng);
+			if (i < numInfinite)
+			{
+				light.isInfinite = true;
+				continue;
+			}
+			const math::vec3f center(position(rng), position(rng), position(rng));
+			const math::vec3f extent(size(rng), size(rng), size(rng));
+			light.boundsMin = center - extent;
+			light.boundsMax = center + extent;
+			if (i % 3 != 0)
+			{
+				// One light in three emits on both sides
+				math::vec3f axis(direction(rng), direction(rng), direction(rng));
+				light.axis     = dot(axis, axis) > 1e-4f ? math::normalize(axis) : math::vec3f(0.0f, 0.0f, 1.0f);
+				light.cosTheta = 0.5f * (direction(rng) + 1.0f);
+			}
+		}
+		return lights;
+	}
+
+	// The selection is built as for the device, the infinite lights of the copy are scaled to the scene size
+	static bool checkSelection(std::vector<LightBounds> lights, const bool useBvh, const math::vec3f& point)
+	{
+		device::HostLightSelection host      = device::buildLightSelection(lights, useBvh);
+		const LightSelection       selection = host.getHostView();
+		const int                  numLights = (int)lights.size();
+		const std::string          label     = useBvh ? "bvh" : "alias table";
+		bool                       isPassed  = true;
+
+		std::vector<double> expected(numLights, 0.0);
+		if (useBvh)
+		{
+			for (const int light : host.infiniteLights)
+			{
+				expected[light] = host.aliasTable[light].pdf;
+			}
+			enumerateBvh(selection, 0, 1.0 - selection.infiniteProbability, point, expected);
+		}
+		else
+		{
+			double totalPower = 0.0;
+			for (const LightBounds& light : lights)
+			{
+				totalPower += light.power;
+			}
+			for (int i = 0; i < numLights; ++i)
+			{
+				expected[i] = lights[i].power / totalPower;
+			}
+		}
+
+		double sum = 0.0;
+		for (int i = 0; i < numLights; ++i)
+		{
+			const double pdf = lightSelection::pdf(selection, point, i);
+			isPassed = checkNear(pdf, expected[i], 1e-5 + 1e-4 * expected[i], label + " pdf of light " + std::to_string(i)) && isPassed;
+			sum += pdf;
+		}
+		isPassed = checkNear(sum, 1.0, 1e-4, label + " pdf sum") && isPassed;
+
+		// Stratified samples, the histogram converges to the pdfs much faster than with random numbers
+		constexpr int       numSamples = 1 << 20;
+		std::vector<double> histogram(numLights, 0.0);
+		for (int s = 0; s < numSamples; ++s)
+		{
+			float     samplePdf;
+			const int light = lightSelection::sample(selection, point, ((float)s + 0.5f) / (float)numSamples, &samplePdf);
+			if (light < 0 || light >= numLights)
+			{
+				return check(false, label + " sampled an invalid light");
+			}
+			histogram[light] += 1.0 / numSamples;
+			if (s % 997 == 0)
+			{
+				isPassed = checkNear(samplePdf, lightSelection::pdf(selection, point, light), 1e-5 + 1e-4 * samplePdf, label + " sample pdf of light " + std::to_string(light)) && isPassed;
+			}
+		}
+		for (int i = 0; i < numLights; ++i)
+		{
+			isPassed = checkNear(histogram[i], expected[i], 1e-4 + 0.02 * expected[i], label + " sampling frequency of light " + std::to_string(i)) && isPassed;
+		}
+		return isPassed;
+	}
+
+	bool testLightSelection()
+	{
+		const std::vector<LightBounds> lights = createLights(300, 2);
+
+		// The environment power becomes the power through a disk as big as the scene
+		math::vec3f sceneMin(FLT_MAX);
+		math::vec3f sceneMax(-FLT_MAX);
+		for (const LightBounds& light : lights)
+		{
+			if (!light.isInfinite)
+			{
+				sceneMin = min(sceneMin, light.boundsMin);
+				sceneMax = max(sceneMax, light.boundsMax);
+			}
+		}
+		const double             sceneRadius = 0.5 * (double)math::length(sceneMax - sceneMin);
+		std::vector<LightBounds> scaled      = lights;
+		device::buildLightSelection(scaled, false);
+		bool isPassed = checkNear(scaled[0].power, lights[0].power * M_PI * sceneRadius * sceneRadius, 1e-4 * scaled[0].power, "environment power scaled by the scene cross-section");
+		isPassed = check(scaled[2].power == lights[2].power, "finite light power unchanged") && isPassed;
+
+		isPassed = checkSelection(lights, false, math::vec3f(0.0f)) && isPassed;
+		for (const math::vec3f& point : { math::vec3f(0.0f), math::vec3f(40.0f, -10.0f, 5.0f), math::vec3f(-200.0f, 0.0f, 0.0f) })
+		{
+			isPassed = checkSelection(lights, true, point) && isPassed;
+		}
+		return isPassed;
+	}
+}
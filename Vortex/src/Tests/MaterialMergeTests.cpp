@@ -0,0 +1,50 @@
+#include "TestCases.h"
+#include "Scene/Utility/ModelLoader.h"
+
+namespace vtx::test
+{
+	bool testMaterialMerge()
+	{
+		importer::AssimpMaterialProperties base;
+		base.name           = "Painted metal";
+		base.diffuse        = { "textures/paint.png", math::vec3f(0.8f, 0.1f, 0.1f) };
+		base.roughness      = { "", 0.35f };
+		base.metallic       = { "", 1.0f };
+		base.normal         = { "textures/paint_normal.png", -1.0f };
+
+		enum Case
+		{
+			C_BASE,
+			C_RENAMED,
+			C_OTHER_ROUGHNESS,
+			C_OTHER_TEXTURE,
+			C_OTHER_COLOR,
+			C_RENAMED_OTHER_ROUGHNESS,
+			C_OTHER_OPACITY,
+			C_COPY_OF_OTHER_ROUGHNESS,
+			C_COUNT
+		};
+		std::vector<importer::AssimpMaterialProperties> materials(C_COUNT, base);
+		materials[C_RENAMED].name                        = "Painted metal.001";
+		materials[C_OTHER_ROUGHNESS].roughness.value     = 0.36f;
+		materials[C_OTHER_TEXTURE].diffuse.path          = "textures/paint_worn.png";
+		materials[C_OTHER_COLOR].diffuse.value.y         = 0.2f;
+		materials[C_RENAMED_OTHER_ROUGHNESS].name        = "Painted metal.002";
+		materials[C_RENAMED_OTHER_ROUGHNESS].roughness   = materials[C_OTHER_ROUGHNESS].roughness;
+		materials[C_OTHER_OPACITY].opacity.path          = base.diffuse.path;
+		materials[C_COPY_OF_OTHER_ROUGHNESS]             = materials[C_OTHER_ROUGHNESS];
+
+		const std::vector<size_t> firstIdentical = importer::findIdenticalMaterials(materials);
+		bool isPassed = check(firstIdentical.size() == C_COUNT && firstIdentical[C_BASE] == C_BASE, "first material kept");
+		isPassed = check(firstIdentical[C_RENAMED] == C_BASE && importer::hashMaterialProperties(materials[C_RENAMED]) == importer::hashMaterialProperties(base),
+						 "names are ignored") && isPassed;
+		isPassed = check(firstIdentical[C_OTHER_ROUGHNESS] == C_OTHER_ROUGHNESS, "different value kept apart") && isPassed;
+		isPassed = check(firstIdentical[C_OTHER_TEXTURE] == C_OTHER_TEXTURE, "different texture kept apart") && isPassed;
+		isPassed = check(firstIdentical[C_OTHER_COLOR] == C_OTHER_COLOR, "different color component kept apart") && isPassed;
+		isPassed = check(firstIdentical[C_OTHER_OPACITY] == C_OTHER_OPACITY, "parameter set on one material only kept apart") && isPassed;
+		isPassed = check(firstIdentical[C_RENAMED_OTHER_ROUGHNESS] == C_OTHER_ROUGHNESS && firstIdentical[C_COPY_OF_OTHER_ROUGHNESS] == C_OTHER_ROUGHNESS,
+						 "later copies merged into the first material with their parameters") && isPassed;
+		isPassed = check(!importer::isSameMaterial(base, materials[C_OTHER_ROUGHNESS]) && importer::isSameMaterial(base, materials[C_RENAMED]), "comparison matches the merge") && isPassed;
+		return isPassed;
+	}
+}
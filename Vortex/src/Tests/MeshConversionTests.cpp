@@ -0,0 +1,126 @@
+#include "TestCases.h"
+#include <cstring>
+#include "Scene/Nodes/Mesh.h"
+#include "Scene/Utility/ModelLoader.h"
+#include "Scene/Utility/Operations.h"
+
+namespace vtx::test
+{
+	// Strip of numQuads quads split in triangles, plus one quad face the conversion skips. The arrays are freed by aiMesh.
+	static std::unique_ptr<aiMesh> createAssimpMesh(const unsigned numQuads, const bool hasNormals, const bool hasTangents, const bool hasTexCoords)
+	{
+		auto mesh          = std::make_unique<aiMesh>();
+		mesh->mNumVertices = 2 * (numQuads + 1);
+		mesh->mVertices    = new aiVector3D[mesh->mNumVertices];
+		if (hasNormals)
+		{
+			mesh->mNormals = new aiVector3D[mesh->mNumVertices];
+		}
+		if (hasTangents)
+		{
+			mesh->mTangents   = new aiVector3D[mesh->mNumVertices];
+			mesh->mBitangents = new aiVector3D[mesh->mNumVertices];
+		}
+		if (hasTexCoords)
+		{
+			mesh->mTextureCoords[0]   = new aiVector3D[mesh->mNumVertices];
+			mesh->mNumUVComponents[0] = 2;
+		}
+		for (unsigned v = 0; v < mesh->mNumVertices; ++v)
+		{
+			const float x = (float)(v / 2);
+			const float y = (float)(v % 2);
+			mesh->mVertices[v] = aiVector3D(x, y, 0.1f * x * x);
+			if (hasNormals)
+			{
+				mesh->mNormals[v] = aiVector3D(-0.2f * x, 0.0f, 1.0f);
+			}
+			if (hasTangents)
+			{
+				mesh->mTangents[v]   = aiVector3D(1.0f, 0.0f, 0.2f * x);
+				mesh->mBitangents[v] = aiVector3D(0.0f, 1.0f, 0.0f);
+			}
+			if (hasTexCoords)
+			{
+				mesh->mTextureCoords[0][v] = aiVector3D(x / (float)numQuads, y, 0.0f);
+			}
+		}
+
+		mesh->mNumFaces = 2 * numQuads + 1;
+		mesh->mFaces    = new aiFace[mesh->mNumFaces];
+		auto setFace = [&mesh](const unsigned face, std::initializer_list<unsigned> indices)
+		{
+			mesh->mFaces[face].mNumIndices = (unsigned)indices.size();
+			mesh->mFaces[face].mIndices    = new unsigned int[indices.size()];
+			std::copy(indices.begin(), indices.end(), mesh->mFaces[face].mIndices);
+		};
+		for (unsigned q = 0; q < numQuads; ++q)
+		{
+			setFace(2 * q, { 2 * q, 2 * q + 2, 2 * q + 3 });
+			setFace(2 * q + 1, { 2 * q, 2 * q + 3, 2 * q + 1 });
+		}
+		setFace(2 * numQuads, { 0, 2, 3, 1 });
+		return mesh;
+	}
+
+	template<typename T>
+	static bool isArrayMatching(const std::vector<T>& a, const std::vector<T>& b)
+	{
+		return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+	}
+
+	static bool isMeshMatching(const graph::Mesh& a, const graph::Mesh& b)
+	{
+		return isArrayMatching(a.vertices, b.vertices) && isArrayMatching(a.indices, b.indices) && isArrayMatching(a.faceAttributes, b.faceAttributes) &&
+			a.status.hasNormals == b.status.hasNormals && a.status.hasTangents == b.status.hasTangents && a.status.hasFaceAttributes == b.status.hasFaceAttributes;
+	}
+
+	bool testMeshConversion()
+	{
+		std::vector<std::unique_ptr<aiMesh>> assimpMeshes;
+		for (unsigned i = 0; i < 24; ++i)
+		{
+			assimpMeshes.push_back(createAssimpMesh(16 + 37 * i, i % 2 == 0, i % 3 == 0, i % 4 != 3));
+		}
+
+		bool isPassed = true;
+		for (const importer::SwapType swap : { importer::SwapType::None, importer::SwapType::yToZ })
+		{
+			// Parallel conversion as done by the import, serial conversion of the same meshes into other nodes
+			std::vector<importer::MeshConversionJob>  jobs;
+			std::vector<std::shared_ptr<graph::Mesh>> serialMeshes;
+			for (const std::unique_ptr<aiMesh>& assimpMesh : assimpMeshes)
+			{
+				jobs.push_back({ assimpMesh.get(), ops::createNode<graph::Mesh>(), swap });
+				serialMeshes.push_back(ops::createNode<graph::Mesh>());
+			}
+			importer::convertMeshes(jobs);
+			for (size_t i = 0; i < assimpMeshes.size(); ++i)
+			{
+				importer::fillMeshNode(assimpMeshes[i].get(), serialMeshes[i], swap);
+			}
+
+			const std::string swapName = swap == importer::SwapType::yToZ ? " (y to z)" : "";
+			bool              isMatching = true;
+			bool              isComplete = true;
+			for (size_t i = 0; i < assimpMeshes.size(); ++i)
+			{
+				const graph::Mesh& mesh = *jobs[i].meshNode;
+				isMatching = isMatching && isMeshMatching(mesh, *serialMeshes[i]);
+				isComplete = isComplete && mesh.vertices.size() == assimpMeshes[i]->mNumVertices &&
+					mesh.indices.size() == 3 * (assimpMeshes[i]->mNumFaces - 1) && mesh.faceAttributes.size() == assimpMeshes[i]->mNumFaces - 1;
+			}
+			isPassed = check(isMatching, "parallel and serial conversions give identical meshes" + swapName) && isPassed;
+			isPassed = check(isComplete, "every triangle converted and the quad skipped" + swapName) && isPassed;
+
+			// Positions are swizzled and the winding flipped along with them
+			const graph::Mesh& first     = *jobs[0].meshNode;
+			const aiFace&      firstFace = assimpMeshes[0]->mFaces[0];
+			const aiVector3D&  position  = assimpMeshes[0]->mVertices[5];
+			const bool         isSwapped = swap == importer::SwapType::yToZ;
+			isPassed = check(first.vertices[5].position == math::vec3f(position.x, isSwapped ? position.z : position.y, isSwapped ? position.y : position.z) &&
+							 first.indices[1] == firstFace.mIndices[isSwapped ? 2 : 1] && first.indices[2] == firstFace.mIndices[isSwapped ? 1 : 2], "vertices and winding follow the swap" + swapName) && isPassed;
+		}
+		return isPassed;
+	}
+}
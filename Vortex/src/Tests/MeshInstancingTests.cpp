@@ -0,0 +1,99 @@
+#include "TestCases.h"
+#include <cmath>
+#include "Scene/Nodes/Instance.h"
+#include "Scene/Nodes/Mesh.h"
+#include "Scene/Nodes/Transform.h"
+#include "Scene/Utility/Operations.h"
+
+namespace vtx::test
+{
+	// Bumpy grid, the vertices are placed by the transform and the one at movedVertex is moved up by offset
+	static std::shared_ptr<graph::Mesh> createInstancingMesh(const math::affine3f& transform, const size_t movedVertex = 0, const float offset = 0.0f)
+	{
+		constexpr unsigned int             resolution = 8;
+		const std::shared_ptr<graph::Mesh> mesh       = ops::createNode<graph::Mesh>();
+		for (unsigned int y = 0; y <= resolution; ++y)
+		{
+			for (unsigned int x = 0; x <= resolution; ++x)
+			{
+				graph::VertexAttributes vertex{};
+				math::vec3f             position((float)x, (float)y, 0.3f * std::sin((float)x * 0.9f) * std::cos((float)y * 0.6f));
+				if (mesh->vertices.size() == movedVertex)
+				{
+					position.z += offset;
+				}
+				vertex.position = math::transformPoint3F(transform, position);
+				vertex.normal   = math::transformVector3F(transform, math::vec3f(0.0f, 0.0f, 1.0f));
+				vertex.texCoord = math::vec3f((float)x / resolution, (float)y / resolution, 0.0f);
+				mesh->vertices.push_back(vertex);
+			}
+		}
+		for (unsigned int y = 0; y < resolution; ++y)
+		{
+			for (unsigned int x = 0; x < resolution; ++x)
+			{
+				const vtxID corner = y * (resolution + 1) + x;
+				for (const vtxID index : { corner, corner + 1, corner + resolution + 2, corner, corner + resolution + 2, corner + resolution + 1 })
+				{
+					mesh->indices.push_back(index);
+				}
+			}
+		}
+		mesh->faceAttributes.resize(mesh->indices.size() / 3);
+		mesh->status.hasFaceAttributes = true;
+		return mesh;
+	}
+
+	bool testMeshInstancing()
+	{
+		constexpr float      tolerance = 1e-3f;
+		const math::affine3f identity  = math::affine3f(math::Identity);
+		const math::affine3f rigid     = math::affine3f::translate(math::vec3f(5.0f, -2.0f, 3.0f)) * math::affine3f::rotate(math::normalize(math::vec3f(1.0f, 2.0f, 0.5f)), 1.1f);
+		const size_t         lastVertex = 80;
+
+		enum Case
+		{
+			C_ORIGINAL,
+			C_EXACT_COPY,
+			C_RIGID_COPY,
+			C_WITHIN_TOLERANCE,
+			C_NEAR_MISS,
+			C_SCALED,
+			C_COUNT
+		};
+		std::vector<std::shared_ptr<graph::Mesh>> meshes(C_COUNT);
+		meshes[C_ORIGINAL]         = createInstancingMesh(identity);
+		meshes[C_EXACT_COPY]       = createInstancingMesh(identity);
+		meshes[C_RIGID_COPY]       = createInstancingMesh(rigid);
+		meshes[C_WITHIN_TOLERANCE] = createInstancingMesh(identity, lastVertex, 0.3f * tolerance);
+		meshes[C_NEAR_MISS]        = createInstancingMesh(identity, lastVertex, 3.0f * tolerance);
+		meshes[C_SCALED]           = createInstancingMesh(math::affine3f::scale(math::vec3f(2.0f)));
+
+		std::vector<std::shared_ptr<graph::Instance>> instances(C_COUNT);
+		for (size_t i = 0; i < instances.size(); ++i)
+		{
+			instances[i] = ops::createNode<graph::Instance>();
+			instances[i]->setChild(meshes[i]);
+		}
+
+		const size_t numReplaced = ops::instanceDuplicateMeshes(instances, true, tolerance);
+		bool         isPassed    = check(numReplaced == 3, "exact, rigid and within tolerance copies replaced");
+		isPassed = check(instances[C_EXACT_COPY]->getChild() == meshes[C_ORIGINAL], "exact copy instances the original") && isPassed;
+		isPassed = check(instances[C_EXACT_COPY]->transform->affineTransform == identity, "exact copy keeps its transform") && isPassed;
+		isPassed = check(instances[C_RIGID_COPY]->getChild() == meshes[C_ORIGINAL], "rigidly transformed copy instances the original") && isPassed;
+		isPassed = check(instances[C_WITHIN_TOLERANCE]->getChild() == meshes[C_ORIGINAL], "copy within tolerance instances the original") && isPassed;
+		isPassed = check(instances[C_NEAR_MISS]->getChild() == meshes[C_NEAR_MISS], "copy just over the tolerance keeps its mesh") && isPassed;
+		isPassed = check(instances[C_SCALED]->getChild() == meshes[C_SCALED], "scaled copy keeps its mesh") && isPassed;
+
+		// The rigid copy is rendered at the same place through the instance transform
+		const math::affine3f& placement = instances[C_RIGID_COPY]->transform->affineTransform;
+		double                maxError  = 0.0;
+		for (size_t i = 0; i < meshes[C_ORIGINAL]->vertices.size(); ++i)
+		{
+			const math::vec3f placed = math::transformPoint3F(placement, meshes[C_ORIGINAL]->vertices[i].position);
+			maxError = std::max(maxError, (double)math::length(placed - meshes[C_RIGID_COPY]->vertices[i].position));
+		}
+		isPassed = checkNear(maxError, 0.0, tolerance, "rigid copy placed by its instance transform") && isPassed;
+		return isPassed;
+	}
+}
@@ -0,0 +1,157 @@
+#include "TestCases.h"
+#include <cmath>
+#include <random>
+#include "Device/Structs/MeshLightSampling.h"
+#include "Scene/Nodes/Mesh.h"
+#include "Scene/Nodes/MeshLight.h"
+#include "Scene/Utility/Operations.h"
+
+namespace vtx::test
+{
+	// Bumpy jittered grid, so that the triangles have different areas and orientations. One triangle in three uses
+	// another material slot and is not part of the light.
+	static std::shared_ptr<graph::Mesh> createLightMesh(const unsigned int resolution)
+	{
+		std::mt19937                          rng(7);
+		std::uniform_real_distribution<float> jitter(-0.3f, 0.3f);
+		const std::shared_ptr<graph::Mesh>    mesh = ops::createNode<graph::Mesh>();
+		for (unsigned int y = 0; y <= resolution; ++y)
+		{
+			for (unsigned int x = 0; x <= resolution; ++x)
+			{
+				graph::VertexAttributes vertex{};
+				const float             u = (float)x + jitter(rng);
+				const float             v = (float)y + jitter(rng);
+				vertex.position = math::vec3f(u, v, 0.5f * std::sin(u * 0.7f) * std::cos(v * 0.4f));
+				mesh->vertices.push_back(vertex);
+			}
+		}
+		for (unsigned int y = 0; y < resolution; ++y)
+		{
+			for (unsigned int x = 0; x < resolution; ++x)
+			{
+				const vtxID corner = y * (resolution + 1) + x;
+				for (const vtxID index : { corner, corner + 1, corner + resolution + 2, corner, corner + resolution + 2, corner + resolution + 1 })
+				{
+					mesh->indices.push_back(index);
+				}
+			}
+		}
+		mesh->faceAttributes.resize(mesh->indices.size() / 3);
+		for (size_t i = 0; i < mesh->faceAttributes.size(); ++i)
+		{
+			mesh->faceAttributes[i].materialSlotId = (i % 3 == 2) ? 1 : 0;
+		}
+		mesh->status.hasFaceAttributes = true;
+		return mesh;
+	}
+
+	// Quadratic function integrated over the light
+	static double integrand(const math::vec3f& p)
+	{
+		return 1.0 + 0.1 * (double)p.x * (double)p.x + 0.05 * (double)p.y * (double)p.z;
+	}
+
+	bool testMeshLightAreaPdf()
+	{
+		const std::shared_ptr<graph::Mesh>              mesh  = createLightMesh(24);
+		const std::shared_ptr<graph::EmissiveTriangles> table = graph::MeshLight::getEmissiveTriangles(mesh, 0);
+		bool isPassed = check(table != nullptr && !table->triangleIndices.empty(), "emissive triangles built");
+		if (!isPassed)
+		{
+			return false;
+		}
+
+		// Non-uniform scale after a rotation about z, plus a translation
+		const float angle    = 0.6f;
+		const float scale[3] = { 3.0f, 0.5f, 1.5f };
+		const float rotation[3][3] = {
+			{ std::cos(angle), -std::sin(angle), 0.0f },
+			{ std::sin(angle), std::cos(angle), 0.0f },
+			{ 0.0f, 0.0f, 1.0f } };
+		const float translation[3] = { 1.0f, -2.0f, 0.5f };
+		float rowMajor[12];
+		for (int i = 0; i < 3; ++i)
+		{
+			for (int j = 0; j < 3; ++j)
+			{
+				rowMajor[i * 4 + j] = scale[i] * rotation[i][j];
+			}
+			rowMajor[i * 4 + 3] = translation[i];
+		}
+		const math::affine3f transform(rowMajor);
+		isPassed = check(meshLightSampling::uniformAreaScale(transform) < 0.0f, "transform detected as non-uniform") && isPassed;
+
+		// Brute force: every triangle of the light in world space, its exact selection probability from the alias table
+		// and the integral of the quadratic integrand with the edge midpoint rule, exact for quadratics
+		const size_t        numTriangles = table->triangleIndices.size();
+		std::vector<double> probability(numTriangles, 0.0);
+		for (size_t i = 0; i < numTriangles; ++i)
+		{
+			const double q = std::min((double)table->aliasMap[i].q, 1.0);
+			probability[i] += q / (double)numTriangles;
+			probability[table->aliasMap[i].alias] += (1.0 - q) / (double)numTriangles;
+		}
+
+		double worldArea = 0.0;
+		double integral  = 0.0;
+		size_t numPdfMismatches = 0;
+		auto getVertex = [&](const size_t triangle, const size_t corner)
+		{
+			return mesh->vertices[mesh->indices[table->triangleIndices[triangle] * 3 + corner]].position;
+		};
+		for (size_t i = 0; i < numTriangles; ++i)
+		{
+			const math::vec3f v0 = getVertex(i, 0);
+			const math::vec3f v1 = getVertex(i, 1);
+			const math::vec3f v2 = getVertex(i, 2);
+			const math::vec3f w0 = math::transformPoint3F(transform, v0);
+			const math::vec3f w1 = math::transformPoint3F(transform, v1);
+			const math::vec3f w2 = math::transformPoint3F(transform, v2);
+			const double      area = 0.5 * (double)math::length(cross(w1 - w0, w2 - w0));
+			worldArea += area;
+			integral += area / 3.0 * (integrand((w0 + w1) * 0.5f) + integrand((w1 + w2) * 0.5f) + integrand((w2 + w0) * 0.5f));
+
+			// Density of the sampled points on this triangle against the pdf evaluated by the renderer
+			const double expected = probability[i] / area;
+			const double pdf      = meshLightSampling::areaPdf(meshLightSampling::triangleArea(v0, v1, v2), table->area, meshLightSampling::worldTriangleArea(transform, v0, v1, v2));
+			if (!(std::abs(pdf - expected) <= 1e-3 * expected) && numPdfMismatches++ < 8)
+			{
+				checkNear(pdf, expected, 1e-3 * expected, "area pdf of triangle " + std::to_string(i));
+			}
+		}
+		isPassed = check(numPdfMismatches == 0, std::to_string(numPdfMismatches) + " triangles with a wrong area pdf") && isPassed;
+		isPassed = checkNear(table->computeWorldArea(transform), worldArea, 1e-4 * worldArea, "world area of the light") && isPassed;
+
+		// Monte Carlo estimate with the sampling of the renderer: alias table, then uniform point on the triangle
+		constexpr int                         numSamples = 1 << 18;
+		std::mt19937                          rng(11);
+		std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+		double                                sum        = 0.0;
+		double                                sumSquares = 0.0;
+		for (int s = 0; s < numSamples; ++s)
+		{
+			float     selectionPdf;
+			const int local = lightSelection::sampleAliasTable(table->aliasMap.data(), (int)numTriangles, uniform(rng), &selectionPdf);
+			float     b1    = uniform(rng);
+			float     b2    = uniform(rng);
+			if (b1 + b2 > 1.0f)
+			{
+				b1 = 1.0f - b1;
+				b2 = 1.0f - b2;
+			}
+			const math::vec3f v0    = getVertex(local, 0);
+			const math::vec3f v1    = getVertex(local, 1);
+			const math::vec3f v2    = getVertex(local, 2);
+			const math::vec3f point = math::transformPoint3F(transform, v0 + (v1 - v0) * b1 + (v2 - v0) * b2);
+			const float       pdf   = meshLightSampling::areaPdf(meshLightSampling::triangleArea(v0, v1, v2), table->area, meshLightSampling::worldTriangleArea(transform, v0, v1, v2));
+			const double      value = pdf > 0.0f ? integrand(point) / (double)pdf : 0.0;
+			sum += value;
+			sumSquares += value * value;
+		}
+		const double mean          = sum / numSamples;
+		const double standardError = std::sqrt(std::max(sumSquares / numSamples - mean * mean, 0.0) / numSamples);
+		isPassed = checkNear(mean, integral, 5.0 * standardError + 1e-4 * integral, "sampled integral over the light") && isPassed;
+		return isPassed;
+	}
+}
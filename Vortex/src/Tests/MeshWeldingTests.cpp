@@ -0,0 +1,107 @@
+#include "TestCases.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include "Scene/Nodes/Mesh.h"
+#include "Scene/Utility/Operations.h"
+
+namespace vtx::test
+{
+	// Triangle by the grid points of its corners and its material slot. The corners are rotated so that the smallest comes
+	// first, which keeps the winding.
+	using TriangleKey = std::array<int64_t, 4>;
+
+	static std::vector<TriangleKey> collectTriangles(const graph::Mesh& mesh, const float spacing, const int64_t resolution)
+	{
+		std::vector<TriangleKey> triangles;
+		for (size_t t = 0; t + 2 < mesh.indices.size(); t += 3)
+		{
+			int64_t corners[3];
+			for (int k = 0; k < 3; ++k)
+			{
+				const math::vec3f& position = mesh.vertices[mesh.indices[t + k]].position;
+				corners[k] = std::llround(position.x / spacing) + (resolution + 1) * std::llround(position.y / spacing);
+			}
+			const int first = (int)(std::min_element(corners, corners + 3) - corners);
+			triangles.push_back({ corners[first], corners[(first + 1) % 3], corners[(first + 2) % 3], (int64_t)mesh.faceAttributes[t / 3].materialSlotId });
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	bool testMeshWelding()
+	{
+		// Unwelded grid, every triangle has its own corners. The grid points lie on the boundaries of the weld cells and the
+		// copies of a point are moved to either side of them, so matching copies are found in the neighbouring cells.
+		constexpr int64_t                  resolution = 24;
+		constexpr float                    spacing    = 0.01f;
+		ops::WeldTolerances                tolerances;
+		tolerances.position                           = 1e-3f;
+		const std::shared_ptr<graph::Mesh> mesh       = ops::createNode<graph::Mesh>();
+		auto addCorner = [&](const int64_t x, const int64_t y, const size_t copy)
+		{
+			const float jitter = (copy % 2 == 0 ? 0.3f : -0.3f) * tolerances.position;
+			graph::VertexAttributes vertex{};
+			vertex.position = math::vec3f((float)x * spacing + jitter, (float)y * spacing - jitter, 0.5f + jitter);
+			vertex.normal   = math::vec3f(0.0f, 0.0f, 1.0f);
+			vertex.texCoord = math::vec3f((float)x / resolution, (float)y / resolution, 0.0f);
+			mesh->indices.push_back((vtxID)mesh->vertices.size());
+			mesh->vertices.push_back(vertex);
+		};
+		for (int64_t y = 0; y < resolution; ++y)
+		{
+			for (int64_t x = 0; x < resolution; ++x)
+			{
+				const size_t copy = mesh->indices.size() / 3;
+				addCorner(x, y, copy);
+				addCorner(x + 1, y, copy + 1);
+				addCorner(x + 1, y + 1, copy);
+				addCorner(x, y, copy + 1);
+				addCorner(x + 1, y + 1, copy);
+				addCorner(x, y + 1, copy + 1);
+				mesh->faceAttributes.push_back({ (unsigned)(y % 3) });
+				mesh->faceAttributes.push_back({ (unsigned)(x % 2 + 3) });
+			}
+		}
+		mesh->status.hasNormals        = true;
+		mesh->status.hasFaceAttributes = true;
+
+		const std::vector<TriangleKey> before        = collectTriangles(*mesh, spacing, resolution);
+		const ops::WeldingStats        stats         = ops::weldMeshVertices(mesh, tolerances);
+		const size_t                   numGridPoints = (size_t)((resolution + 1) * (resolution + 1));
+
+		bool isPassed = check(stats.verticesBefore == 6 * resolution * resolution && stats.verticesAfter == numGridPoints && mesh->vertices.size() == numGridPoints,
+							  "copies within tolerance welded across cell boundaries");
+		bool isIndexed = mesh->indices.size() == before.size() * 3;
+		for (const vtxID index : mesh->indices)
+		{
+			isIndexed = isIndexed && index < mesh->vertices.size();
+		}
+		isPassed = check(isIndexed, "welded indices within the vertices") && isPassed;
+		isPassed = check(isIndexed && collectTriangles(*mesh, spacing, resolution) == before, "welding and reordering keep the triangles, their winding and face attributes") && isPassed;
+
+		// The vertices are sorted by first use in the reordered triangles
+		vtxID nextVertex = 0;
+		bool  isSorted   = true;
+		for (const vtxID index : mesh->indices)
+		{
+			isSorted = isSorted && index <= nextVertex;
+			nextVertex = std::max<vtxID>(nextVertex, index + 1);
+		}
+		isPassed = check(isSorted, "vertices sorted by first use") && isPassed;
+
+		// Copies just over the tolerance stay apart
+		const std::shared_ptr<graph::Mesh> apart = ops::createNode<graph::Mesh>();
+		for (int k = 0; k < 6; ++k)
+		{
+			graph::VertexAttributes vertex{};
+			vertex.position = math::vec3f((float)(k % 3 == 1), (float)(k % 3 == 2), k < 3 ? 0.0f : 1.5f * tolerances.position);
+			vertex.normal   = math::vec3f(0.0f, 0.0f, 1.0f);
+			apart->vertices.push_back(vertex);
+			apart->indices.push_back((vtxID)k);
+		}
+		apart->faceAttributes.resize(2);
+		isPassed = check(ops::weldMeshVertices(apart, tolerances).verticesAfter == 6, "copies over the tolerance are kept") && isPassed;
+		return isPassed;
+	}
+}
@@ -0,0 +1,89 @@
+#include "TestCases.h"
+#include <set>
+#include <type_traits>
+#include "Scene/Graph.h"
+#include "Scene/Utility/Operations.h"
+
+namespace vtx::test
+{
+	template<class... Targets>
+	struct CastTargets
+	{
+		// nodeCast gives the node exactly when dynamic_pointer_cast does
+		static bool isCastMatching(const std::shared_ptr<graph::Node>& node)
+		{
+			return ((graph::nodeCast<Targets>(node) == std::dynamic_pointer_cast<Targets>(node)) && ...);
+		}
+
+		// The type range of every target holds the node type of a class exactly when the class derives from the target
+		template<class Class>
+		static bool isRangeMatching(const graph::NodeType type)
+		{
+			return ((graph::isNodeOfType<Targets>(type) == std::is_base_of_v<Targets, Class>) && ...);
+		}
+	};
+
+	using NodeClasses = CastTargets<graph::Group, graph::Instance, graph::Mesh, graph::Transform, graph::MeshLight, graph::EnvironmentLight,
+									graph::Camera, graph::Renderer, graph::Material, graph::Texture, graph::BsdfMeasurement, graph::LightProfile,
+									graph::shader::ShaderNode, graph::shader::DiffuseReflection, graph::shader::Material, graph::shader::MaterialSurface,
+									graph::shader::ImportedNode, graph::shader::TextureTransform, graph::shader::NormalTexture, graph::shader::MonoTexture,
+									graph::shader::ColorTexture, graph::shader::BumpTexture, graph::shader::NormalMix, graph::shader::GetChannel,
+									graph::shader::PrincipledMaterial>;
+
+	template<class Class>
+	static bool isNodeCastMatching(std::set<graph::NodeType>& coveredTypes)
+	{
+		const std::shared_ptr<Class> node = ops::createNode<Class>();
+		coveredTypes.insert(node->getType());
+		return NodeClasses::isCastMatching(node) && NodeClasses::isRangeMatching<Class>(node->getType()) &&
+			graph::nodeCast<graph::Node>(node) == node && node->template as<Class>() == node;
+	}
+
+	// Classes which need the device or the mdl sdk to be constructed are checked on the node type they are constructed with
+	template<class Class>
+	static bool isNodeTypeMatching(const graph::NodeType type, std::set<graph::NodeType>& coveredTypes)
+	{
+		coveredTypes.insert(type);
+		return NodeClasses::isRangeMatching<Class>(type);
+	}
+
+	bool testNodeCasts()
+	{
+		std::set<graph::NodeType> coveredTypes;
+		bool isPassed = check(isNodeCastMatching<graph::Group>(coveredTypes), "group casts");
+		isPassed = check(isNodeCastMatching<graph::Instance>(coveredTypes), "instance casts") && isPassed;
+		isPassed = check(isNodeCastMatching<graph::Mesh>(coveredTypes), "mesh casts") && isPassed;
+		isPassed = check(isNodeCastMatching<graph::Transform>(coveredTypes), "transform casts") && isPassed;
+		isPassed = check(isNodeCastMatching<graph::MeshLight>(coveredTypes), "mesh light casts") && isPassed;
+		isPassed = check(isNodeCastMatching<graph::EnvironmentLight>(coveredTypes), "environment light casts") && isPassed;
+		isPassed = check(isNodeCastMatching<graph::Camera>(coveredTypes), "camera casts") && isPassed;
+		isPassed = check(isNodeCastMatching<graph::Material>(coveredTypes), "material casts") && isPassed;
+		isPassed = check(isNodeCastMatching<graph::Texture>(coveredTypes), "texture casts") && isPassed;
+		isPassed = check(isNodeCastMatching<graph::BsdfMeasurement>(coveredTypes), "bsdf measurement casts") && isPassed;
+		isPassed = check(isNodeCastMatching<graph::LightProfile>(coveredTypes), "light profile casts") && isPassed;
+		isPassed = check(NodeClasses::isCastMatching(nullptr) && graph::nodeCast<graph::Group>(nullptr) == nullptr, "null node casts") && isPassed;
+
+		isPassed = check(isNodeTypeMatching<graph::Renderer>(graph::NT_RENDERER, coveredTypes), "renderer type range") && isPassed;
+		isPassed = check(isNodeTypeMatching<graph::shader::DiffuseReflection>(graph::NT_SHADER_DF, coveredTypes) &&
+						 isNodeTypeMatching<graph::shader::Material>(graph::NT_SHADER_MATERIAL, coveredTypes) &&
+						 isNodeTypeMatching<graph::shader::MaterialSurface>(graph::NT_SHADER_SURFACE, coveredTypes) &&
+						 isNodeTypeMatching<graph::shader::ImportedNode>(graph::NT_SHADER_IMPORTED, coveredTypes) &&
+						 isNodeTypeMatching<graph::shader::TextureTransform>(graph::NT_SHADER_COORDINATE, coveredTypes) &&
+						 isNodeTypeMatching<graph::shader::NormalTexture>(graph::NT_SHADER_NORMAL_TEXTURE, coveredTypes) &&
+						 isNodeTypeMatching<graph::shader::MonoTexture>(graph::NT_SHADER_MONO_TEXTURE, coveredTypes) &&
+						 isNodeTypeMatching<graph::shader::ColorTexture>(graph::NT_SHADER_COLOR_TEXTURE, coveredTypes) &&
+						 isNodeTypeMatching<graph::shader::BumpTexture>(graph::NT_SHADER_BUMP_TEXTURE, coveredTypes) &&
+						 isNodeTypeMatching<graph::shader::NormalMix>(graph::NT_NORMAL_MIX, coveredTypes) &&
+						 isNodeTypeMatching<graph::shader::GetChannel>(graph::NT_GET_CHANNEL, coveredTypes) &&
+						 isNodeTypeMatching<graph::shader::PrincipledMaterial>(graph::NT_PRINCIPLED_MATERIAL, coveredTypes), "shader node type ranges") && isPassed;
+
+		// Every node type but the abstract light has been checked on its class
+		bool isCovered = true;
+		for (int type = 0; type < graph::NT_NUM_NODE_TYPES; ++type)
+		{
+			isCovered = isCovered && (type == graph::NT_LIGHT || coveredTypes.count((graph::NodeType)type) != 0);
+		}
+		isPassed = check(isCovered, "every node type checked") && isPassed;
+		return isPassed;
+	}
+}
@@ -0,0 +1,155 @@
+#include "TestCases.h"
+#include <cstring>
+#include <filesystem>
+#include "Scene/Nodes/Group.h"
+#include "Scene/Nodes/Instance.h"
+#include "Scene/Nodes/Mesh.h"
+#include "Scene/Nodes/Transform.h"
+#include "Scene/Utility/Operations.h"
+#include "Serialization/PartialScene.h"
+#include "Serialization/SceneContainer.h"
+
+namespace vtx::test
+{
+	static uint64_t payloadSize(const graph::Mesh& mesh)
+	{
+		return mesh.vertices.size() * sizeof(graph::VertexAttributes) + mesh.indices.size() * sizeof(vtxID) + mesh.faceAttributes.size() * sizeof(graph::FaceAttributes);
+	}
+
+	template<typename T>
+	static bool isArrayMatching(const std::vector<T>& a, const std::vector<T>& b)
+	{
+		return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+	}
+
+	static bool isMeshMatching(const graph::Mesh& mesh, const std::vector<graph::VertexAttributes>& vertices, const std::vector<vtxID>& indices, const std::vector<graph::FaceAttributes>& faceAttributes)
+	{
+		return isArrayMatching(mesh.vertices, vertices) && isArrayMatching(mesh.indices, indices) && isArrayMatching(mesh.faceAttributes, faceAttributes);
+	}
+
+	bool testPartialScene()
+	{
+		// A root group with one instance per mesh, the meshes have different sizes
+		const std::shared_ptr<graph::Group> root = ops::createNode<graph::Group>();
+		root->name = "Root";
+		std::vector<std::shared_ptr<graph::Mesh>>     meshes(8);
+		std::vector<std::shared_ptr<graph::Instance>> instances(meshes.size());
+		for (size_t i = 0; i < meshes.size(); ++i)
+		{
+			meshes[i]       = ops::createNode<graph::Mesh>();
+			meshes[i]->name = "Mesh_" + std::to_string(i);
+			meshes[i]->vertices.resize(64 + 16 * i);
+			for (size_t v = 0; v < meshes[i]->vertices.size(); ++v)
+			{
+				meshes[i]->vertices[v].position = math::vec3f((float)v, (float)i, 1.0f);
+			}
+			meshes[i]->indices.resize(3 * meshes[i]->vertices.size());
+			for (size_t v = 0; v < meshes[i]->indices.size(); ++v)
+			{
+				meshes[i]->indices[v] = (vtxID)((v * 13) % meshes[i]->vertices.size());
+			}
+			meshes[i]->faceAttributes.resize(meshes[i]->vertices.size());
+			meshes[i]->status.hasFaceAttributes = true;
+
+			instances[i]       = ops::createNode<graph::Instance>();
+			instances[i]->name = "Instance_" + std::to_string(i);
+			instances[i]->setChild(meshes[i]);
+			instances[i]->transform->affineTransform = math::affine3f::translate(math::vec3f((float)i, 0.0f, 0.0f));
+			root->addChild(instances[i]);
+		}
+
+		serializer::GraphSaveData saveData;
+		saveData.transforms.emplace_back(root->transform, "");
+		for (size_t i = 0; i < meshes.size(); ++i)
+		{
+			saveData.transforms.emplace_back(instances[i]->transform, "");
+			saveData.meshes.emplace_back(meshes[i], "");
+			saveData.instances.emplace_back(instances[i], "");
+		}
+		saveData.groups.emplace_back(root, "");
+		saveData.activeRendererUID = 0;
+		saveData.activeCameraUID   = 0;
+		saveData.sceneRootUID      = root->getUID();
+
+		const std::filesystem::path folder    = std::filesystem::temp_directory_path();
+		const std::string           path      = (folder / "vortexPartialSceneTest.vtxc").string();
+		const std::string           savedPath = (folder / "vortexPartialSceneTest_saved.vtxc").string();
+		bool                        isPassed  = check(serializer::writeSceneContainer(path, saveData), "container written");
+
+		// Table of contents
+		serializer::PartialScene scene;
+		isPassed = check(scene.open(path), "container opened") && isPassed;
+		const size_t numSaved = saveData.transforms.size() + saveData.meshes.size() + saveData.instances.size() + saveData.groups.size();
+		isPassed = check(scene.getTableOfContents().size() == numSaved, "table of contents lists every saved node") && isPassed;
+		bool isSizeMatching = true;
+		for (const std::shared_ptr<graph::Mesh>& mesh : meshes)
+		{
+			const serializer::SceneTocEntry* entry = scene.findEntry(mesh->getUID());
+			isSizeMatching = isSizeMatching && entry != nullptr && entry->type == graph::NT_MESH && entry->payloadSize == payloadSize(*mesh);
+		}
+		isPassed = check(isSizeMatching, "table of contents gives the mesh data sizes") && isPassed;
+
+		// One subtree, the instance brings its transform and mesh along, the mesh arrays stay in the file
+		const std::vector<std::shared_ptr<graph::Node>> subtree = scene.loadSubtrees({ instances[2]->getUID() });
+		isPassed = check(subtree.size() == 1 && graph::nodeCast<graph::Instance>(subtree[0]) != nullptr, "requested instance restored") && isPassed;
+		const std::shared_ptr<graph::Mesh> restoredMesh = graph::nodeCast<graph::Mesh>(scene.getRestoredNode(meshes[2]->getUID()));
+		isPassed = check(restoredMesh != nullptr && restoredMesh->getPayloadState() == graph::Mesh::PS_DEFERRED, "referenced mesh restored as a deferred handle") && isPassed;
+		isPassed = check(scene.getRestoredNode(meshes[3]->getUID()) == nullptr && scene.getRestoredNode(root->getUID()) == nullptr, "other nodes are not restored") && isPassed;
+		isPassed = check(restoredMesh != nullptr && restoredMesh->loadPayload() &&
+						 isMeshMatching(*restoredMesh, meshes[2]->vertices, meshes[2]->indices, meshes[2]->faceAttributes), "deferred mesh loads its arrays") && isPassed;
+
+		// Every mesh, the one restored before is reused
+		const std::vector<std::shared_ptr<graph::Node>> restoredMeshes = scene.loadNodesOfType(graph::NT_MESH);
+		bool isComplete = restoredMeshes.size() == meshes.size();
+		for (const std::shared_ptr<graph::Node>& node : restoredMeshes)
+		{
+			isComplete = isComplete && graph::nodeCast<graph::Mesh>(node) != nullptr;
+		}
+		isPassed = check(isComplete, "every mesh restored by type") && isPassed;
+		isPassed = check(isComplete && restoredMeshes[2] == restoredMesh, "restored nodes are reused") && isPassed;
+
+		if (isComplete)
+		{
+			// Saved to another container, the deferred meshes are written from the mapped file without being loaded
+			serializer::GraphSaveData resaved;
+			resaved.activeRendererUID = 0;
+			resaved.activeCameraUID   = 0;
+			resaved.sceneRootUID      = 0;
+			bool isDeferred = true;
+			for (size_t i = 0; i < restoredMeshes.size(); ++i)
+			{
+				resaved.meshes.emplace_back(graph::nodeCast<graph::Mesh>(restoredMeshes[i]), savedPath);
+				isDeferred = isDeferred && (resaved.meshes.back().deferredSource != nullptr) == (i != 2);
+			}
+			isPassed = check(isDeferred, "deferred meshes are saved from their source") && isPassed;
+			isPassed = check(serializer::writeSceneContainer(savedPath, resaved), "deferred meshes written") && isPassed;
+			bool isStillDeferred = true;
+			for (size_t i = 0; i < restoredMeshes.size(); ++i)
+			{
+				isStillDeferred = isStillDeferred && (graph::nodeCast<graph::Mesh>(restoredMeshes[i])->getPayloadState() == graph::Mesh::PS_DEFERRED) == (i != 2);
+			}
+			isPassed = check(isStillDeferred, "saving doesn't load the deferred meshes") && isPassed;
+
+			serializer::GraphSaveData reread;
+			bool isMatching = serializer::readSceneContainer(savedPath, reread) && reread.meshes.size() == meshes.size();
+			for (size_t i = 0; isMatching && i < meshes.size(); ++i)
+			{
+				isMatching = isArrayMatching(reread.meshes[i].vertices, meshes[i]->vertices) && isArrayMatching(reread.meshes[i].indices, meshes[i]->indices) &&
+					isArrayMatching(reread.meshes[i].faceAttributes, meshes[i]->faceAttributes);
+			}
+			isPassed = check(isMatching, "saved container holds the original arrays") && isPassed;
+
+			// A save which replaces the file the mesh comes from loads it first
+			const std::shared_ptr<graph::Mesh> sameFileMesh = graph::nodeCast<graph::Mesh>(restoredMeshes[3]);
+			const serializer::MeshNodeSaveData sameFile(sameFileMesh, path);
+			isPassed = check(sameFile.deferredSource == nullptr && sameFileMesh->getPayloadState() == graph::Mesh::PS_LOADED &&
+							 isMeshMatching(*sameFileMesh, meshes[3]->vertices, meshes[3]->indices, meshes[3]->faceAttributes), "saving over the source file loads the mesh") && isPassed;
+		}
+
+		scene.close();
+		std::error_code error;
+		std::filesystem::remove(path, error);
+		std::filesystem::remove(savedPath, error);
+		return isPassed;
+	}
+}
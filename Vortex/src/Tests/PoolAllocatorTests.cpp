@@ -0,0 +1,65 @@
+#include "TestCases.h"
+#include <cstring>
+#include "Core/PoolAllocator.h"
+
+namespace vtx::test
+{
+	bool testBlockPoolTrim()
+	{
+		constexpr size_t blockSize = 48;
+		utl::BlockPool   pool(blockSize, 16);
+		bool             isPassed = true;
+
+		// Chunks of 64, 128, 256 and 512 blocks, the first block of the last chunk stays alive
+		constexpr size_t   numBlocks = 64 + 128 + 256 + 512;
+		std::vector<void*> blocks(numBlocks);
+		for (size_t i = 0; i < numBlocks; ++i)
+		{
+			blocks[i] = pool.allocate();
+			std::memset(blocks[i], (int)(i & 0xff), blockSize);
+		}
+		isPassed = check(pool.getStats().chunks == 4, "four chunks allocated") && isPassed;
+
+		const size_t keptBlock = 64 + 128 + 256;
+		for (size_t i = 0; i < numBlocks; ++i)
+		{
+			if (i != keptBlock)
+			{
+				pool.deallocate(blocks[i]);
+			}
+		}
+		pool.trim();
+		utl::BlockPool::Stats stats = pool.getStats();
+		isPassed = check(stats.chunks == 1, "empty chunks are released while a block is alive") && isPassed;
+		isPassed = check(stats.liveBlocks == 1 && stats.freeBlocks == 511, "free blocks of the released chunks are unlinked") && isPassed;
+
+		bool isKeptIntact = true;
+		for (size_t b = 0; b < blockSize; ++b)
+		{
+			isKeptIntact = isKeptIntact && static_cast<unsigned char*>(blocks[keptBlock])[b] == (keptBlock & 0xff);
+		}
+		isPassed = check(isKeptIntact, "live block is left untouched") && isPassed;
+
+		// The remaining free blocks are handed out before a new chunk is added
+		std::vector<void*> reused(511);
+		for (void*& block : reused)
+		{
+			block = pool.allocate();
+			std::memset(block, 0xab, blockSize);
+		}
+		isPassed = check(pool.getStats().chunks == 1, "free blocks of the kept chunk are reused") && isPassed;
+		void* extra = pool.allocate();
+		isPassed = check(pool.getStats().chunks == 2, "exhausted pool grows again") && isPassed;
+
+		for (void* block : reused)
+		{
+			pool.deallocate(block);
+		}
+		pool.deallocate(extra);
+		pool.deallocate(blocks[keptBlock]);
+		pool.trim();
+		stats = pool.getStats();
+		isPassed = check(stats.chunks == 0 && stats.liveBlocks == 0 && stats.freeBlocks == 0, "empty pool releases every chunk") && isPassed;
+		return isPassed;
+	}
+}
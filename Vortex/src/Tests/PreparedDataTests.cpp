@@ -0,0 +1,105 @@
+#include "TestCases.h"
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include "Core/Options.h"
+#include "Scene/Utility/PreparedDataStore.h"
+#include "Scene/Utility/SamplingTableCache.h"
+#include "Serialization/NodeSaveData.h"
+#include "Serialization/SceneContainer.h"
+
+namespace vtx::test
+{
+	bool testPreparedData()
+	{
+		const std::filesystem::path folder    = std::filesystem::temp_directory_path();
+		const std::string           path      = (folder / "vortexPreparedDataTest.vtxc").string();
+		const std::string           stalePath = (folder / "vortexPreparedDataTest_stale.vtxc").string();
+		constexpr size_t            cdfSize   = 257;
+		graph::SamplingTableCache*  cache     = graph::SamplingTableCache::get();
+		graph::PreparedDataStore*   store     = graph::PreparedDataStore::get();
+
+		// The disk cache would serve the tables built by a previous run
+		bool&      isDiskCache  = getOptions()->samplingTableCache;
+		const bool wasDiskCache = isDiskCache;
+		isDiskCache             = false;
+
+		int  numBuilds = 0;
+		auto build     = [&numBuilds]()
+		{
+			++numBuilds;
+			graph::LightProfileSamplingTables tables;
+			tables.cdfData.resize(cdfSize);
+			for (size_t i = 0; i < cdfSize; ++i)
+			{
+				tables.cdfData[i] = (float)(i + 1) / (float)cdfSize;
+			}
+			tables.totalPower = 3.5f;
+			return tables;
+		};
+		std::vector<float> source(64);
+		for (size_t i = 0; i < source.size(); ++i)
+		{
+			source[i] = (float)i * 0.25f;
+		}
+		const uint64_t key = graph::SamplingTableCache::computeKey(source.data(), source.size(), 17);
+
+		// Tables prepared by the scene are embedded in the container and found again once it is loaded
+		serializer::GraphSaveData saveData = serializer::createSyntheticMeshSaveData(1, 16);
+		std::shared_ptr<const graph::LightProfileSamplingTables> built = cache->getLightProfileTables(key, cdfSize, build);
+		bool isPassed = check(numBuilds == 1 && built != nullptr, "tables built without prepared data");
+		isPassed = check(serializer::writeSceneContainer(path, saveData, true), "container with prepared data written") && isPassed;
+		const graph::LightProfileSamplingTables expected = *built;
+		built.reset();
+		store->clear();
+
+		serializer::GraphSaveData loaded;
+		isPassed = check(serializer::readSceneContainer(path, loaded), "container with prepared data read") && isPassed;
+		isPassed = check(store->hasKind(graph::PD_LIGHT_PROFILE_TABLES), "prepared tables published") && isPassed;
+		const std::shared_ptr<const graph::LightProfileSamplingTables> restored = cache->getLightProfileTables(key, cdfSize, build);
+		isPassed = check(numBuilds == 1, "prepared tables used instead of building them") && isPassed;
+		isPassed = check(restored != nullptr && restored->cdfData == expected.cdfData && restored->totalPower == expected.totalPower, "prepared tables round trip") && isPassed;
+
+		// Another source content has another key
+		const uint64_t otherKey = graph::SamplingTableCache::computeKey(source.data(), source.size() - 1, 17);
+		isPassed = check(cache->getLightProfileTables(otherKey, cdfSize, build) != nullptr && numBuilds == 2, "changed source key builds the tables") && isPassed;
+		store->releaseFile(path);
+
+		// Data of an older layout version or of the wrong size is ignored
+		const uint64_t      staleKeys[2] = { graph::SamplingTableCache::computeKey(source.data(), 32, 17), graph::SamplingTableCache::computeKey(source.data(), 16, 17) };
+		graph::PreparedData olderVersion;
+		olderVersion.append(expected.cdfData);
+		olderVersion.append(std::vector<float>{ expected.totalPower });
+		graph::PreparedData wrongSize;
+		wrongSize.append(std::vector<float>(cdfSize - 1, 0.5f));
+		wrongSize.append(std::vector<float>{ expected.totalPower });
+
+		serializer::SceneContainerWriter writer;
+		writer.addSection((serializer::SectionKind)(serializer::SK_PREPARED_DATA + graph::PD_LIGHT_PROFILE_TABLES),
+						  graph::PreparedDataStore::computeKey(graph::PD_LIGHT_PROFILE_TABLES, staleKeys[0], 0, graph::PreparedDataStore::version - 1), olderVersion.blob);
+		writer.addSection((serializer::SectionKind)(serializer::SK_PREPARED_DATA + graph::PD_LIGHT_PROFILE_TABLES),
+						  graph::PreparedDataStore::computeKey(graph::PD_LIGHT_PROFILE_TABLES, staleKeys[1], 0), wrongSize.blob);
+		isPassed = check(writer.write(stalePath, serializer::encodeSceneMetadata(saveData)), "container with stale prepared data written") && isPassed;
+		serializer::GraphSaveData staleLoaded;
+		isPassed = check(serializer::readSceneContainer(stalePath, staleLoaded) && store->hasKind(graph::PD_LIGHT_PROFILE_TABLES), "stale prepared data published") && isPassed;
+		const std::shared_ptr<const graph::LightProfileSamplingTables> rebuiltVersion = cache->getLightProfileTables(staleKeys[0], cdfSize, build);
+		isPassed = check(numBuilds == 3, "data of an older version builds the tables") && isPassed;
+		const std::shared_ptr<const graph::LightProfileSamplingTables> rebuiltSize = cache->getLightProfileTables(staleKeys[1], cdfSize, build);
+		isPassed = check(numBuilds == 4 && rebuiltSize->cdfData.size() == cdfSize, "data of the wrong size builds the tables") && isPassed;
+		store->releaseFile(stalePath);
+
+		// An array size close to the maximum must not wrap the bound check around
+		std::vector<char> corrupt(3 * sizeof(uint64_t), 0);
+		const uint64_t    hugeSize = std::numeric_limits<uint64_t>::max() - 4;
+		std::memcpy(corrupt.data(), &hugeSize, sizeof(uint64_t));
+		graph::PreparedDataReader reader(corrupt);
+		std::vector<char>         array;
+		isPassed = check(!reader.read(array) && !reader.isComplete(), "corrupt array size rejected") && isPassed;
+
+		isDiskCache = wasDiskCache;
+		std::error_code error;
+		std::filesystem::remove(path, error);
+		std::filesystem::remove(stalePath, error);
+		return isPassed;
+	}
+}
@@ -0,0 +1,103 @@
+#include "TestCases.h"
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include "Core/Options.h"
+#include "Serialization/NodeSaveData.h"
+#include "Serialization/SceneContainer.h"
+
+namespace vtx::test
+{
+	static std::vector<char> readBytes(const std::string& filePath)
+	{
+		std::ifstream file(filePath, std::ios::binary);
+		return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	static void writeBytes(const std::string& filePath, const std::vector<char>& bytes)
+	{
+		std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+		file.write(bytes.data(), (std::streamsize)bytes.size());
+	}
+
+	template<typename T>
+	static void patch(std::vector<char>& bytes, const size_t offset, const T value)
+	{
+		std::memcpy(bytes.data() + offset, &value, sizeof(T));
+	}
+
+	static bool isOpenRejected(const std::string& filePath, const std::vector<char>& bytes)
+	{
+		writeBytes(filePath, bytes);
+		serializer::SceneContainerReader reader;
+		return !reader.open(filePath);
+	}
+
+	bool testSceneContainer()
+	{
+		const std::filesystem::path folder       = std::filesystem::temp_directory_path();
+		const std::string           paths[2]     = { (folder / "vortexContainerTest_serial.vtxc").string(), (folder / "vortexContainerTest_parallel.vtxc").string() };
+		const std::string           corruptPath  = (folder / "vortexContainerTest_corrupt.vtxc").string();
+		serializer::GraphSaveData   source       = serializer::createSyntheticMeshSaveData(6, 3000);
+		bool                        isPassed     = true;
+
+		// Written and read on one thread and on the thread pool, the files have to be identical
+		bool&      isParallel  = getOptions()->parallelSceneSerialization;
+		const bool wasParallel = isParallel;
+		for (const bool parallel : { false, true })
+		{
+			isParallel = parallel;
+			const std::string mode = parallel ? "parallel" : "serial";
+			isPassed = check(serializer::writeSceneContainer(paths[parallel], source), mode + " container written") && isPassed;
+			serializer::GraphSaveData loaded;
+			isPassed = check(serializer::readSceneContainer(paths[parallel], loaded), mode + " container read") && isPassed;
+			isPassed = check(serializer::isMeshSaveDataMatching(source, loaded), mode + " round trip matches") && isPassed;
+		}
+		isParallel = wasParallel;
+
+		const std::vector<char> bytes = readBytes(paths[0]);
+		isPassed = check(!bytes.empty() && bytes == readBytes(paths[1]), "serial and parallel containers are byte identical") && isPassed;
+
+		// Corrupt files are rejected, including counts chosen so that the unchecked offset computations wrap around
+		serializer::SceneContainer::Header header;
+		std::memcpy(&header, bytes.data(), sizeof(header));
+		std::vector<serializer::SceneContainer::SectionEntry> entries(header.numSections);
+		std::memcpy(entries.data(), bytes.data() + header.sectionTableOffset, entries.size() * sizeof(serializer::SceneContainer::SectionEntry));
+		size_t indexSection = 0;
+		while (indexSection < entries.size() && entries[indexSection].kind != serializer::SK_MESH_INDICES)
+		{
+			++indexSection;
+		}
+		isPassed = check(indexSection < entries.size() && entries[indexSection].elementSize == 4, "container has an index section") && isPassed;
+
+		std::vector<char> corrupt(bytes.begin(), bytes.end() - 1);
+		isPassed = check(isOpenRejected(corruptPath, corrupt), "truncated container is rejected") && isPassed;
+
+		corrupt = bytes;
+		patch<uint64_t>(corrupt, offsetof(serializer::SceneContainer::Header, numSections), header.numSections + (1ull << 61));
+		isPassed = check(isOpenRejected(corruptPath, corrupt), "section count wrapping the table size is rejected") && isPassed;
+
+		corrupt = bytes;
+		patch<uint64_t>(corrupt, offsetof(serializer::SceneContainer::Header, metadataSize), UINT64_MAX - header.metadataOffset + 2);
+		isPassed = check(isOpenRejected(corruptPath, corrupt), "metadata size wrapping the file size is rejected") && isPassed;
+
+		corrupt = bytes;
+		const size_t entryOffset = header.sectionTableOffset + indexSection * sizeof(serializer::SceneContainer::SectionEntry);
+		patch<uint64_t>(corrupt, entryOffset + offsetof(serializer::SceneContainer::SectionEntry, count), 1ull << 62);
+		isPassed = check(isOpenRejected(corruptPath, corrupt), "section count wrapping the section size is rejected") && isPassed;
+
+		corrupt = bytes;
+		corrupt[entries[indexSection].offset] ^= 0x5a;
+		writeBytes(corruptPath, corrupt);
+		serializer::GraphSaveData loaded;
+		isPassed = check(!serializer::readSceneContainer(corruptPath, loaded), "corrupted section is rejected by its checksum") && isPassed;
+
+		std::error_code error;
+		for (const std::string& path : { paths[0], paths[1], corruptPath })
+		{
+			std::filesystem::remove(path, error);
+		}
+		return isPassed;
+	}
+}
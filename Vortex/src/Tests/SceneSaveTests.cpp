@@ -0,0 +1,163 @@
+#include "TestCases.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include "Core/Options.h"
+#include "Scene/Nodes/Group.h"
+#include "Scene/Nodes/Mesh.h"
+#include "Scene/Nodes/Transform.h"
+#include "Scene/Utility/Operations.h"
+#include "Serialization/ArchiveFunctions.h"
+#include "Serialization/SceneContainer.h"
+
+namespace vtx::test
+{
+	// Save data of the transforms, meshes and groups of the scene, prepared on one thread or on the thread pool
+	static serializer::GraphSaveData prepareSaveData(const bool isConcurrent)
+	{
+		serializer::GraphSaveData saveData;
+		saveData.prepareSaveDataByNodeType<graph::Transform>(graph::NT_TRANSFORM, saveData.transforms, "", isConcurrent);
+		saveData.prepareSaveDataByNodeType<graph::Mesh>(graph::NT_MESH, saveData.meshes, "", isConcurrent);
+		saveData.prepareSaveDataByNodeType<graph::Group>(graph::NT_GROUP, saveData.groups, "", isConcurrent);
+		saveData.activeRendererUID = 0;
+		saveData.activeCameraUID   = 0;
+		saveData.sceneRootUID      = 0;
+		return saveData;
+	}
+
+	static std::string encode(serializer::GraphSaveData& saveData)
+	{
+		std::stringstream stream;
+		{
+			cereal::BinaryOutputArchive archive(stream);
+			archive(saveData);
+		}
+		return stream.str();
+	}
+
+	static serializer::GraphSaveData decode(const std::string& bytes)
+	{
+		serializer::GraphSaveData saveData;
+		std::istringstream         stream(bytes);
+		cereal::BinaryInputArchive archive(stream);
+		archive(saveData);
+		return saveData;
+	}
+
+	static std::string readFile(const std::string& filePath)
+	{
+		std::ifstream file(filePath, std::ios::binary);
+		return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	// Restores the decoded save data and returns the content of the restored nodes, in restore order, without their ids
+	static std::string restoreAndDescribe(serializer::GraphSaveData& saveData, bool& isOrdered)
+	{
+		std::map<vtxID, vtxID> oldToNewUIDMap;
+		saveData.restoreSaveDataConcurrently(saveData.transforms, oldToNewUIDMap, "");
+		saveData.restoreSaveDataConcurrently(saveData.meshes, oldToNewUIDMap, "");
+		saveData.restoreSaveDataConcurrently(saveData.groups, oldToNewUIDMap, "");
+		saveData.linkNodes(saveData.groups, oldToNewUIDMap);
+
+		// Nodes are created in save data order, so their ids follow it whatever the number of threads
+		vtxID previousUID = 0;
+		isOrdered         = true;
+		std::ostringstream description;
+		for (const serializer::TransformNodeSaveData& transform : saveData.transforms)
+		{
+			isOrdered   = isOrdered && transform.restoredNode->getUID() > previousUID;
+			previousUID = transform.restoredNode->getUID();
+			description << transform.restoredNode->name;
+			description.write(reinterpret_cast<const char*>(&transform.restoredNode->affineTransform), sizeof(math::affine3f));
+		}
+		for (const serializer::MeshNodeSaveData& mesh : saveData.meshes)
+		{
+			isOrdered   = isOrdered && mesh.restoredNode->getUID() > previousUID;
+			previousUID = mesh.restoredNode->getUID();
+			const graph::Mesh& node = *mesh.restoredNode;
+			description << node.name << node.vertices.size() << ',' << node.indices.size() << ',' << node.faceAttributes.size();
+			description.write(reinterpret_cast<const char*>(node.vertices.data()), (std::streamsize)(node.vertices.size() * sizeof(graph::VertexAttributes)));
+			description.write(reinterpret_cast<const char*>(node.indices.data()), (std::streamsize)(node.indices.size() * sizeof(vtxID)));
+			description.write(reinterpret_cast<const char*>(node.faceAttributes.data()), (std::streamsize)(node.faceAttributes.size() * sizeof(graph::FaceAttributes)));
+		}
+		for (const serializer::GroupNodeSaveData& group : saveData.groups)
+		{
+			isOrdered   = isOrdered && group.restoreNode->getUID() > previousUID;
+			previousUID = group.restoreNode->getUID();
+			description << group.restoreNode->name << group.restoreNode->getChildren().size() << group.restoreNode->transform->name;
+		}
+		return description.str();
+	}
+
+	bool testSceneSaveDeterminism()
+	{
+		// Groups with their transforms, four children per group, and meshes of different sizes
+		std::vector<std::shared_ptr<graph::Group>> groups(200);
+		for (size_t i = 0; i < groups.size(); ++i)
+		{
+			groups[i]       = ops::createNode<graph::Group>();
+			groups[i]->name = "Group_" + std::to_string(i);
+			groups[i]->transform->affineTransform = math::affine3f::translate(math::vec3f((float)i, 0.5f * (float)i, -1.0f));
+			if (i > 0)
+			{
+				groups[(i - 1) / 4]->addChild(groups[i]);
+			}
+		}
+		std::vector<std::shared_ptr<graph::Mesh>> meshes(40);
+		for (size_t i = 0; i < meshes.size(); ++i)
+		{
+			meshes[i]       = ops::createNode<graph::Mesh>();
+			meshes[i]->name = "Mesh_" + std::to_string(i);
+			meshes[i]->vertices.resize(100 + 37 * i);
+			for (size_t v = 0; v < meshes[i]->vertices.size(); ++v)
+			{
+				meshes[i]->vertices[v].position = math::vec3f((float)v, (float)i, (float)(v * i));
+			}
+			meshes[i]->indices.resize(3 * meshes[i]->vertices.size());
+			for (size_t v = 0; v < meshes[i]->indices.size(); ++v)
+			{
+				meshes[i]->indices[v] = (vtxID)((v * 31) % meshes[i]->vertices.size());
+			}
+			meshes[i]->faceAttributes.resize(meshes[i]->vertices.size());
+			meshes[i]->status.hasFaceAttributes = true;
+		}
+
+		bool&      isParallel  = getOptions()->parallelSceneSerialization;
+		const bool wasParallel = isParallel;
+		bool       isPassed    = true;
+
+		// Preparation and encoding, both archives and both containers have to be byte identical
+		const std::filesystem::path folder = std::filesystem::temp_directory_path();
+		std::string encoded[2];
+		std::string containers[2];
+		for (const bool parallel : { false, true })
+		{
+			isParallel = parallel;
+			serializer::GraphSaveData saveData = prepareSaveData(parallel);
+			encoded[parallel] = encode(saveData);
+			const std::string containerPath = (folder / "vortexSaveDeterminismTest.vtxc").string();
+			isPassed = check(serializer::writeSceneContainer(containerPath, saveData), "container written") && isPassed;
+			containers[parallel] = readFile(containerPath);
+			std::error_code error;
+			std::filesystem::remove(containerPath, error);
+		}
+		isPassed = check(encoded[0] == encoded[1], "serial and parallel save data archives are byte identical") && isPassed;
+		isPassed = check(!containers[0].empty() && containers[0] == containers[1], "serial and parallel containers are byte identical") && isPassed;
+
+		// Restore, the restored graphs have to be identical and their ids follow the save data order
+		std::string restored[2];
+		for (const bool parallel : { false, true })
+		{
+			isParallel = parallel;
+			serializer::GraphSaveData saveData = decode(encoded[0]);
+			bool isOrdered = false;
+			restored[parallel] = restoreAndDescribe(saveData, isOrdered);
+			isPassed = check(isOrdered, std::string(parallel ? "parallel" : "serial") + " restore creates the nodes in order") && isPassed;
+		}
+		isParallel = wasParallel;
+		isPassed = check(!restored[0].empty() && restored[0] == restored[1], "serial and parallel restores are identical") && isPassed;
+
+		return isPassed;
+	}
+}
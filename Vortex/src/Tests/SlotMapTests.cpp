@@ -0,0 +1,67 @@
+#include "TestCases.h"
+#include <map>
+#include <string>
+#include "Core/SlotMap.h"
+
+namespace vtx::test
+{
+	bool testSlotMap()
+	{
+		utl::SlotMap<std::string> slotMap;
+		std::vector<utl::SlotId>  slotIds;
+		for (uint32_t i = 0; i < 8; ++i)
+		{
+			slotIds.push_back(slotMap.allocate());
+			slotMap.insert(slotIds.back().id, "value" + std::to_string(i));
+		}
+		bool isSequential = true;
+		for (uint32_t i = 0; i < slotIds.size(); ++i)
+		{
+			isSequential = isSequential && slotIds[i].id == i + 1 && slotMap.isAlive(slotIds[i]);
+		}
+		bool isPassed = check(isSequential && !slotMap.isAllocated(0), "indices handed out from 1, 0 stays invalid");
+
+		// Released indices are stale under their old generation, a second release is refused
+		const utl::SlotId released[] = { slotIds[5], slotIds[2] };
+		for (const utl::SlotId slotId : released)
+		{
+			isPassed = check(slotMap.release(slotId), "live index released") && isPassed;
+		}
+		isPassed = check(!slotMap.isAlive(slotIds[2]) && !slotMap.isAlive(slotIds[5]) && !slotMap.release(slotIds[2]), "released index is stale and not released twice") && isPassed;
+		isPassed = check(slotMap.find(slotIds[2].id) == nullptr && slotMap.size() == 6, "release detaches the value") && isPassed;
+		isPassed = check(!slotMap.insert(slotIds[2].id, "stale"), "no value attached to a released index") && isPassed;
+
+		// The lowest free index is handed out first, under a new generation. The old id stays stale after the reuse.
+		const utl::SlotId reused = slotMap.allocate();
+		isPassed = check(reused.id == 3 && reused.generation == slotIds[2].generation + 1, "lowest index reused with the next generation") && isPassed;
+		isPassed = check(slotMap.isAlive(reused) && !slotMap.isAlive(slotIds[2]) && !slotMap.release(slotIds[2]), "old id stale after the reuse") && isPassed;
+		isPassed = check(slotMap.find(reused.id) == nullptr && slotMap.getSlotId(reused.id).generation == reused.generation, "reused index starts without a value") && isPassed;
+		slotMap.insert(reused.id, "reused");
+		isPassed = check(slotMap.allocate().id == 6 && slotMap.allocate().id == 9, "free indices exhausted before growing") && isPassed;
+
+		// Released again, the generation keeps counting
+		isPassed = check(slotMap.release(reused) && slotMap.allocate().generation == reused.generation + 1, "generation bumped on every release") && isPassed;
+
+		// Dense storage matches the attached values after the swaps of the releases
+		std::map<uint32_t, std::string> expected;
+		for (uint32_t i = 0; i < slotIds.size(); ++i)
+		{
+			if (i != 2 && i != 5)
+			{
+				expected[slotIds[i].id] = "value" + std::to_string(i);
+			}
+		}
+		bool isDense = slotMap.size() == expected.size() && slotMap.getIds().size() == slotMap.getValues().size();
+		for (size_t i = 0; isDense && i < slotMap.getIds().size(); ++i)
+		{
+			const uint32_t     id    = slotMap.getIds()[i];
+			const std::string* value = slotMap.find(id);
+			isDense = expected.count(id) != 0 && value == &slotMap.getValues()[i] && *value == expected[id];
+		}
+		isPassed = check(isDense, "dense values and indices agree") && isPassed;
+
+		// Erasing a value keeps the index allocated
+		isPassed = check(slotMap.erase(slotIds[0].id) && slotMap.isAlive(slotIds[0]) && slotMap.find(slotIds[0].id) == nullptr, "erase keeps the index") && isPassed;
+		return isPassed;
+	}
+}
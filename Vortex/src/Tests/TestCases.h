@@ -0,0 +1,69 @@
+#pragma once
+#include <string>
+#include <vector>
+
+namespace vtx::test
+{
+	// Logs the failure and returns the condition
+	bool check(bool condition, const std::string& what);
+
+	// Logs the failure and returns false when value is further than tolerance from expected
+	bool checkNear(double value, double expected, double tolerance, const std::string& what);
+
+	// Environment map sampling: exact texel probabilities of the alias map and histogram of sampled texels against the importance
+	bool testEnvironmentSampling();
+
+	// Mesh lights under a non-uniform scale: area pdf of every triangle and sampled integral against brute force
+	bool testMeshLightAreaPdf();
+
+	// Scene change journal: listing, deduplication, deleted and reused ids, epochs and the retry of failed synchronizations
+	bool testChangeJournal();
+
+	// Block pool: chunks without live blocks are released by trim while other chunks are in use
+	bool testBlockPoolTrim();
+
+	// Scene container: serial and parallel round trips, identical files and rejection of truncated or corrupt containers
+	bool testSceneContainer();
+
+	// Scene save data: serial and parallel preparation, encoding and restore give byte identical results
+	bool testSceneSaveDeterminism();
+
+	// Autosave: deltas of a changing graph replayed over the base and folded into a new base give back the graph
+	bool testAutosave();
+
+	// Partial scene: table of contents, restore of chosen subtrees and types, deferred meshes saved without being loaded
+	bool testPartialScene();
+
+	// Mesh instancing: exact and rigidly transformed copies share one mesh, copies just over the tolerance don't
+	bool testMeshInstancing();
+
+	// Prepared data: sampling tables round trip through a container, a changed source key, older version or wrong size rebuilds them
+	bool testPreparedData();
+
+	// Parallel traversal: every node visited once, in the order and tree positions of the serial traversal, concurrent initialization
+	bool testParallelTraversal();
+
+	// Assimp mesh conversion: the parallel conversion gives the same meshes as a serial one, with and without the y to z swap
+	bool testMeshConversion();
+
+	// Mesh welding: copies within tolerance welded across cell boundaries, the reordered triangles keep their corners, winding and face attributes
+	bool testMeshWelding();
+
+	// Material merge: materials differing in any value or texture stay apart, names are ignored
+	bool testMaterialMerge();
+
+	// Round trip error bounds of the compact vertex layout and the 16 bit index threshold
+	bool testCompactVertices();
+
+	// Generations, stale ids and lowest first reuse of the slot map indices
+	bool testSlotMap();
+
+	// World matrices of the transform hierarchy against the recursive traversal, after full and partial updates
+	bool testTransformHierarchy();
+
+	// nodeCast against dynamic_pointer_cast and the type ranges against the class hierarchy, for every node type
+	bool testNodeCasts();
+
+	// Light selection: pdfs of the alias table and of the light bvh against brute force enumeration and sampling
+	bool testLightSelection();
+}
@@ -0,0 +1,275 @@
+#include "Tests.h"
+#include <cmath>
+#include <functional>
+#include "TestCases.h"
+#include "Core/Log.h"
+#include "Core/Timer.h"
+#include "Scene/SceneIndexManager.h"
+#include "Scene/Traversal.h"
+#include "Scene/TransformHierarchy.h"
+#include "Scene/Utility/GltfLoader.h"
+#include "Scene/Utility/ObjLoader.h"
+#include "Scene/Utility/Operations.h"
+#include "Serialization/Autosave.h"
+#include "Serialization/SceneContainer.h"
+
+namespace vtx::test
+{
+	struct TestCase
+	{
+		const char*           name;
+		std::function<bool()> run;
+	};
+
+	struct BenchmarkCase
+	{
+		const char*                                          name;
+		const char*                                          usage;
+		std::function<bool(const std::vector<std::string>&)> run;
+	};
+
+	static const std::vector<TestCase>& getTests()
+	{
+		static const std::vector<TestCase> tests = {
+			{ "lightSelection", testLightSelection },
+			{ "environmentSampling", testEnvironmentSampling },
+			{ "meshLightAreaPdf", testMeshLightAreaPdf },
+			{ "changeJournal", testChangeJournal },
+			{ "blockPoolTrim", testBlockPoolTrim },
+			{ "sceneContainer", testSceneContainer },
+			{ "sceneSaveDeterminism", testSceneSaveDeterminism },
+			{ "autosave", testAutosave },
+			{ "partialScene", testPartialScene },
+			{ "meshInstancing", testMeshInstancing },
+			{ "preparedData", testPreparedData },
+			{ "parallelTraversal", testParallelTraversal },
+			{ "meshConversion", testMeshConversion },
+			{ "meshWelding", testMeshWelding },
+			{ "materialMerge", testMaterialMerge },
+			{ "compactVertices", testCompactVertices },
+			{ "slotMap", testSlotMap },
+			{ "transformHierarchy", testTransformHierarchy },
+			{ "nodeCasts", testNodeCasts },
+		};
+		return tests;
+	}
+
+	// Optional numeric argument of a benchmark, false if it is given but isn't a number
+	template<typename T>
+	static bool parseArgument(const std::vector<std::string>& arguments, const size_t index, T& value)
+	{
+		if (index >= arguments.size())
+		{
+			return true;
+		}
+		try
+		{
+			if constexpr (std::is_floating_point_v<T>)
+			{
+				value = static_cast<T>(std::stod(arguments[index]));
+			}
+			else
+			{
+				value = static_cast<T>(std::stoull(arguments[index]));
+			}
+		}
+		catch (const std::exception&)
+		{
+			return false;
+		}
+		return true;
+	}
+
+	static const std::vector<BenchmarkCase>& getBenchmarks()
+	{
+		static const std::vector<BenchmarkCase> benchmarks = {
+			{ "gltfImport", "<file.gltf|file.glb>", [](const std::vector<std::string>& arguments)
+			{
+				if (arguments.empty())
+				{
+					return false;
+				}
+				importer::benchmarkGltfImport(arguments[0]);
+				return true;
+			} },
+			{ "objImport", "<file.obj>", [](const std::vector<std::string>& arguments)
+			{
+				if (arguments.empty())
+				{
+					return false;
+				}
+				importer::benchmarkObjImport(arguments[0]);
+				return true;
+			} },
+			{ "sceneIndex", "[numNodes]", [](const std::vector<std::string>& arguments)
+			{
+				size_t numNodes = 1000000;
+				if (!parseArgument(arguments, 0, numNodes))
+				{
+					return false;
+				}
+				graph::SceneIndexManager::benchmark(numNodes);
+				return true;
+			} },
+			{ "transformHierarchy", "[numTransforms] [animatedFraction]", [](const std::vector<std::string>& arguments)
+			{
+				size_t numTransforms    = 1000000;
+				float  animatedFraction = 0.01f;
+				if (!parseArgument(arguments, 0, numTransforms) || !parseArgument(arguments, 1, animatedFraction))
+				{
+					return false;
+				}
+				graph::TransformHierarchy::benchmark(numTransforms, animatedFraction);
+				return true;
+			} },
+			{ "nodeCasts", "[numNodes]", [](const std::vector<std::string>& arguments)
+			{
+				size_t numNodes = 500000;
+				if (!parseArgument(arguments, 0, numNodes))
+				{
+					return false;
+				}
+				benchmarkNodeCasts(numNodes);
+				return true;
+			} },
+			{ "nodeAllocation", "[numNodes]", [](const std::vector<std::string>& arguments)
+			{
+				size_t numNodes = 2000000;
+				if (!parseArgument(arguments, 0, numNodes))
+				{
+					return false;
+				}
+				ops::benchmarkNodeAllocation(numNodes);
+				return true;
+			} },
+			{ "sceneContainer", "[numMeshes] [verticesPerMesh]", [](const std::vector<std::string>& arguments)
+			{
+				size_t numMeshes       = 32;
+				size_t verticesPerMesh = 1 << 18;
+				if (!parseArgument(arguments, 0, numMeshes) || !parseArgument(arguments, 1, verticesPerMesh))
+				{
+					return false;
+				}
+				serializer::benchmarkSceneContainer(numMeshes, verticesPerMesh);
+				return true;
+			} },
+			{ "autosave", "[numNodes] [changedFraction]", [](const std::vector<std::string>& arguments)
+			{
+				size_t numNodes        = 200000;
+				float  changedFraction = 0.01f;
+				if (!parseArgument(arguments, 0, numNodes) || !parseArgument(arguments, 1, changedFraction))
+				{
+					return false;
+				}
+				serializer::Autosave::benchmark(numNodes, changedFraction);
+				return true;
+			} },
+		};
+		return benchmarks;
+	}
+
+	bool check(const bool condition, const std::string& what)
+	{
+		if (!condition)
+		{
+			VTX_ERROR("    check failed: {}", what);
+		}
+		return condition;
+	}
+
+	bool checkNear(const double value, const double expected, const double tolerance, const std::string& what)
+	{
+		// Written so that nan values fail
+		if (!(std::abs(value - expected) <= tolerance))
+		{
+			VTX_ERROR("    check failed: {}, {} instead of {} (tolerance {})", what, value, expected, tolerance);
+			return false;
+		}
+		return true;
+	}
+
+	bool isTestCommand(const std::string& argument)
+	{
+		return argument == "--test" || argument == "--benchmark";
+	}
+
+	int runCommand(const int argc, char** argv)
+	{
+		const std::string        command = argv[1];
+		std::vector<std::string> arguments(argv + 2, argv + argc);
+		if (command == "--test")
+		{
+			return runTests(arguments.empty() ? std::string() : arguments[0]);
+		}
+		if (arguments.empty())
+		{
+			VTX_ERROR("Benchmarks:");
+			for (const BenchmarkCase& benchmark : getBenchmarks())
+			{
+				VTX_ERROR("    --benchmark {} {}", benchmark.name, benchmark.usage);
+			}
+			return 1;
+		}
+		const std::string name = arguments[0];
+		arguments.erase(arguments.begin());
+		return runBenchmark(name, arguments);
+	}
+
+	int runTests(const std::string& filter)
+	{
+		int numRun    = 0;
+		int numFailed = 0;
+		for (const TestCase& test : getTests())
+		{
+			if (std::string(test.name).rfind(filter, 0) != 0)
+			{
+				continue;
+			}
+			Timer timer;
+			bool  isPassed = false;
+			try
+			{
+				isPassed = test.run();
+			}
+			catch (const std::exception& e)
+			{
+				VTX_ERROR("Test {}: exception {}", test.name, e.what());
+			}
+			++numRun;
+			if (isPassed)
+			{
+				VTX_INFO("Test {} passed in {} ms", test.name, timer.elapsedMillis());
+			}
+			else
+			{
+				++numFailed;
+				VTX_ERROR("Test {} FAILED in {} ms", test.name, timer.elapsedMillis());
+			}
+		}
+		if (numRun == 0)
+		{
+			VTX_ERROR("No test matches {}", filter);
+			return 1;
+		}
+		VTX_INFO("{} tests run, {} failed", numRun, numFailed);
+		return numFailed;
+	}
+
+	int runBenchmark(const std::string& name, const std::vector<std::string>& arguments)
+	{
+		for (const BenchmarkCase& benchmark : getBenchmarks())
+		{
+			if (name == benchmark.name)
+			{
+				if (!benchmark.run(arguments))
+				{
+					VTX_ERROR("Usage: --benchmark {} {}", benchmark.name, benchmark.usage);
+					return 1;
+				}
+				return 0;
+			}
+		}
+		VTX_ERROR("Unknown benchmark {}", name);
+		return 1;
+	}
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <string>
+#include <vector>
+
+namespace vtx::test
+{
+	// Cpu side checks and benchmarks. They run from the command line without a window, a device or the MDL sdk:
+	//     Vortex --test [name]                   runs the tests whose name starts with name, the exit code is the number of failures
+	//     Vortex --benchmark name [arguments]    runs a benchmark and logs its timings
+	bool isTestCommand(const std::string& argument);
+
+	int runCommand(int argc, char** argv);
+
+	int runTests(const std::string& filter);
+
+	int runBenchmark(const std::string& name, const std::vector<std::string>& arguments);
+}
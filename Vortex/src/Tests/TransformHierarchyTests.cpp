@@ -0,0 +1,144 @@
+#include "TestCases.h"
+#include <cmath>
+#include <random>
+#include "Scene/HostVisitor.h"
+#include "Scene/TransformHierarchy.h"
+#include "Scene/Nodes/Group.h"
+#include "Scene/Nodes/Instance.h"
+#include "Scene/Nodes/Transform.h"
+#include "Scene/Utility/Operations.h"
+
+namespace vtx::test
+{
+	static bool isAffineNear(const math::affine3f& a, const math::affine3f& b)
+	{
+		const math::vec3f differences[] = { a.l.vx - b.l.vx, a.l.vy - b.l.vy, a.l.vz - b.l.vz, a.p - b.p };
+		for (const math::vec3f& difference : differences)
+		{
+			if (std::fabs(difference.x) > 1e-4f || std::fabs(difference.y) > 1e-4f || std::fabs(difference.z) > 1e-4f)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static std::vector<math::affine3f> getWorlds(const std::vector<std::shared_ptr<graph::Transform>>& transforms)
+	{
+		std::vector<math::affine3f> worlds;
+		for (const std::shared_ptr<graph::Transform>& transform : transforms)
+		{
+			worlds.push_back(transform->globalTransform);
+		}
+		return worlds;
+	}
+
+	// Compares the world matrices written by the transform hierarchy with the ones of the recursive traversal the host
+	// visitor did before it, which overwrites them
+	static bool isMatchingRecursiveTraversal(const std::shared_ptr<graph::Group>& root, const std::vector<std::shared_ptr<graph::Transform>>& transforms)
+	{
+		const std::vector<math::affine3f> worlds = getWorlds(transforms);
+		HostVisitor                       visitor;
+		visitor.collectTransforms = true;
+		root->traverse(visitor);
+		const std::vector<math::affine3f> recursiveWorlds = getWorlds(transforms);
+		bool                              isMatching      = true;
+		for (size_t i = 0; i < transforms.size(); ++i)
+		{
+			isMatching = isMatching && isAffineNear(worlds[i], recursiveWorlds[i]);
+		}
+		return isMatching;
+	}
+
+	bool testTransformHierarchy()
+	{
+		std::mt19937                          generator(11);
+		std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+		const auto randomLocal = [&]()
+		{
+			const math::vec3f axis = math::normalize(math::vec3f(distribution(generator), distribution(generator), 1.0f));
+			return math::affine3f::translate(math::vec3f(distribution(generator), distribution(generator), distribution(generator)))
+				* math::affine3f::rotate(axis, distribution(generator)) * math::affine3f::scale(math::vec3f(1.0f + 0.2f * distribution(generator)));
+		};
+
+		// Groups under random earlier groups, every fifth one below an instance. The transforms enclosing each group are
+		// counted to know how many a local change recomputes.
+		const std::shared_ptr<graph::Group>            root       = ops::createNode<graph::Group>();
+		std::vector<std::shared_ptr<graph::Group>>     groups     = { root };
+		std::vector<size_t>                            parents    = { 0 };
+		std::vector<size_t>                            enclosing  = { 1 };
+		std::vector<std::shared_ptr<graph::Transform>> transforms = { root->transform };
+		root->transform->setAffine(randomLocal());
+		for (size_t i = 1; i < 400; ++i)
+		{
+			const size_t                        parent = std::uniform_int_distribution<size_t>(0, groups.size() - 1)(generator);
+			const std::shared_ptr<graph::Group> group  = ops::createNode<graph::Group>();
+			group->transform->setAffine(randomLocal());
+			transforms.push_back(group->transform);
+			if (i % 5 == 0)
+			{
+				const std::shared_ptr<graph::Instance> instance = ops::createNode<graph::Instance>();
+				instance->transform->setAffine(randomLocal());
+				instance->setChild(group);
+				groups[parent]->addChild(instance);
+				transforms.push_back(instance->transform);
+			}
+			else
+			{
+				groups[parent]->addChild(group);
+			}
+			groups.push_back(group);
+			parents.push_back(parent);
+			enclosing.push_back(i % 5 == 0 ? 2 : 1);
+		}
+
+		graph::TransformHierarchy* hierarchy = graph::TransformHierarchy::get();
+		hierarchy->update({ root });
+		bool isPassed = check(hierarchy->getNumberOfTransforms() == transforms.size() && hierarchy->getNumberOfUpdatedTransforms() == transforms.size(),
+							  "every transform computed by the first update");
+		isPassed = check(isMatchingRecursiveTraversal(root, transforms), "world matrices match the recursive traversal") && isPassed;
+
+		// A local change recomputes the transforms below the changed one, its own included
+		const size_t moved              = 7;
+		size_t       expectedRecomputed = 1;
+		for (size_t i = moved + 1; i < groups.size(); ++i)
+		{
+			size_t ancestor = parents[i];
+			while (ancestor != moved && ancestor != 0)
+			{
+				ancestor = parents[ancestor];
+			}
+			expectedRecomputed += ancestor == moved ? enclosing[i] : 0;
+		}
+		groups[moved]->transform->translate(math::vec3f(0.5f, -2.0f, 1.0f));
+		hierarchy->update({ root });
+		isPassed = check(hierarchy->getNumberOfUpdatedTransforms() == expectedRecomputed, "local change recomputes its subtree only") && isPassed;
+		isPassed = check(isMatchingRecursiveTraversal(root, transforms), "world matrices after a local change match the recursive traversal") && isPassed;
+
+		// A change of the root moves everything
+		root->transform->rotate(math::vec3f(0.0f, 0.0f, 1.0f), 0.3f);
+		hierarchy->update({ root });
+		isPassed = check(hierarchy->getNumberOfUpdatedTransforms() == transforms.size(), "root change recomputes every transform") && isPassed;
+		isPassed = check(isMatchingRecursiveTraversal(root, transforms), "world matrices after a root change match the recursive traversal") && isPassed;
+
+		// A group shared under two transforms keeps the world matrix of its first path
+		const std::shared_ptr<graph::Group> first  = ops::createNode<graph::Group>();
+		const std::shared_ptr<graph::Group> second = ops::createNode<graph::Group>();
+		const std::shared_ptr<graph::Group> shared = ops::createNode<graph::Group>();
+		first->transform->setAffine(randomLocal());
+		second->transform->setAffine(randomLocal());
+		shared->transform->setAffine(randomLocal());
+		root->addChild(first);
+		root->addChild(second);
+		first->addChild(shared);
+		second->addChild(shared);
+		hierarchy->update({ root });
+		isPassed = check(hierarchy->getNumberOfTransforms() == transforms.size() + 3, "shared transform placed once") && isPassed;
+		isPassed = check(isAffineNear(shared->transform->globalTransform, first->transform->globalTransform * shared->transform->affineTransform) &&
+						 isAffineNear(shared->transform->parentGlobalTransform, first->transform->globalTransform), "shared transform keeps its first path") && isPassed;
+
+		// The hierarchy of the application is rebuilt by its next update
+		hierarchy->markTopologyChanged();
+		return isPassed;
+	}
+}
@@ -0,0 +1,120 @@
+#include "TestCases.h"
+#include <map>
+#include <set>
+#include <tuple>
+#include "Core/Options.h"
+#include "Core/ThreadPool.h"
+#include "Scene/Traversal.h"
+#include "Scene/Nodes/Group.h"
+#include "Scene/Utility/Operations.h"
+
+namespace vtx::test
+{
+	// Records the nodes in the order they are accepted. Nodes accepted by the traversal thread and by the subtree visitors
+	// are kept apart, the parallel traversal accepts the top levels after the subtrees below them.
+	class RecordingVisitor : public NodeVisitor
+	{
+	public:
+		RecordingVisitor()
+		{
+			collectWidthsAndDepths = true;
+		}
+
+		void visit(const std::shared_ptr<graph::Node>& node) override
+		{
+			(isSubtreeVisitor ? subtreeOrder : order).push_back(node->getUID());
+		}
+
+		bool isThreadSafe() const override
+		{
+			return true;
+		}
+
+		std::unique_ptr<NodeVisitor> createSubtreeVisitor() const override
+		{
+			return std::make_unique<RecordingVisitor>();
+		}
+
+		void mergeSubtreeVisitor(NodeVisitor& subtreeVisitor) override
+		{
+			NodeVisitor::mergeSubtreeVisitor(subtreeVisitor);
+			const RecordingVisitor& recording = static_cast<RecordingVisitor&>(subtreeVisitor);
+			subtreeOrder.insert(subtreeOrder.end(), recording.subtreeOrder.begin(), recording.subtreeOrder.end());
+		}
+
+		std::vector<vtxID> order;
+		std::vector<vtxID> subtreeOrder;
+	};
+
+	static std::vector<vtxID> filterOrder(const std::vector<vtxID>& order, const std::set<vtxID>& UIDs, const bool isKept)
+	{
+		std::vector<vtxID> filtered;
+		for (const vtxID UID : order)
+		{
+			if ((UIDs.count(UID) != 0) == isKept)
+			{
+				filtered.push_back(UID);
+			}
+		}
+		return filtered;
+	}
+
+	bool testParallelTraversal()
+	{
+		bool&      isParallel  = getOptions()->parallelTraversal;
+		const bool wasParallel = isParallel;
+		isParallel             = true;
+
+		// Groups attached three per parent, deep enough to leave subtrees below the top levels
+		constexpr size_t                           branching = 3;
+		constexpr size_t                           numGroups = 3280;
+		std::vector<std::shared_ptr<graph::Group>> groups(numGroups);
+		for (size_t i = 0; i < numGroups; ++i)
+		{
+			groups[i] = ops::createNode<graph::Group>();
+			if (i > 0)
+			{
+				groups[(i - 1) / branching]->addChild(groups[i]);
+			}
+		}
+
+		RecordingVisitor serial;
+		groups[0]->traverse(serial);
+		RecordingVisitor parallel;
+		groups[0]->traverseParallel(parallel);
+
+		const std::set<vtxID> serialNodes(serial.order.begin(), serial.order.end());
+		const std::set<vtxID> topLevelNodes(parallel.order.begin(), parallel.order.end());
+		bool                  isPassed = check(serialNodes.size() == serial.order.size() && serial.order.size() == 2 * numGroups, "serial traversal visits every node once");
+		std::vector<vtxID>    parallelOrder = parallel.order;
+		parallelOrder.insert(parallelOrder.end(), parallel.subtreeOrder.begin(), parallel.subtreeOrder.end());
+		const std::set<vtxID> parallelNodes(parallelOrder.begin(), parallelOrder.end());
+		isPassed = check(parallelNodes.size() == parallelOrder.size() && parallelNodes == serialNodes, "parallel traversal visits every node once") && isPassed;
+		isPassed = check(!parallel.subtreeOrder.empty() && !parallel.order.empty(), "parallel traversal forks subtrees") && isPassed;
+
+		// The subtrees are merged in traversal order and the top levels are accepted in the order of the serial traversal
+		isPassed = check(filterOrder(serial.order, topLevelNodes, false) == parallel.subtreeOrder, "subtrees merged in serial order") && isPassed;
+		isPassed = check(filterOrder(serial.order, topLevelNodes, true) == parallel.order, "top levels accepted in serial order") && isPassed;
+		isPassed = check(serial.nodesDepthsAndWidths == parallel.nodesDepthsAndWidths && serial.nodesParents == parallel.nodesParents, "tree positions match the serial traversal") && isPassed;
+
+		// Concurrent initialization of the same nodes, each one is initialized once by one of the callers
+		std::vector<std::shared_ptr<graph::Group>> fresh(64);
+		for (std::shared_ptr<graph::Group>& group : fresh)
+		{
+			group = ops::createNode<graph::Group>();
+		}
+		utl::parallelFor(fresh.size() * 8, [&fresh](const size_t i)
+		{
+			fresh[i % fresh.size()]->initialize(true);
+		});
+		bool isInitialized = true;
+		for (const std::shared_ptr<graph::Group>& group : fresh)
+		{
+			isInitialized = isInitialized && group->state.isInitialized;
+		}
+		isPassed = check(isInitialized, "concurrently initialized nodes are initialized") && isPassed;
+
+		isParallel = wasParallel;
+		return isPassed;
+	}
+}